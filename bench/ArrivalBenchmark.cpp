@@ -0,0 +1,134 @@
+// Arrival engine microbenchmark: P/S times at a few thousand random stations
+// and tsunami travel times at coastal points, per hypocenter. With a
+// bathymetry grid the tsunami paths are integrated over it and full
+// travel-time maps are solved too; without one a uniform ocean depth is used.
+//   arrival_benchmark [bathymetry.asc]
+#include "ArrivalEngine.h"
+#include "BathymetryGrid.h"
+#include "TravelTimeMap.h"
+#include "TravelTimeTable.h"
+#include <QTemporaryFile>
+#include <QTextStream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+constexpr int kStations = 5000;
+constexpr int kPoints = 200;
+constexpr int kHypocenters = 50;
+constexpr int kMaps = 3;
+
+template <typename Fn>
+double bestOfMs(int runs, Fn &&fn) {
+    double best = 1e300;
+    for (int r = 0; r < runs; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+}
+
+int main(int argc, char **argv) {
+    TravelTimeTable table;
+    QString error;
+    if (!table.load(QStringLiteral(TSUNAMI_SOURCE_DIR "/data/traveltimes.txt"), &error)) {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return 1;
+    }
+    
+    // Random receivers over the Indonesian region
+    std::mt19937_64 rng(20241218);
+    std::uniform_real_distribution<double> latDist(-13.0, 8.0);
+    std::uniform_real_distribution<double> lonDist(92.0, 141.0);
+    QTemporaryFile receivers;
+    if (!receivers.open()) return 1;
+    {
+        QTextStream out(&receivers);
+        for (int i = 0; i < kStations; ++i) {
+            out << "station XX.S" << i << ' ' << latDist(rng) << ' ' << lonDist(rng) << '\n';
+        }
+        for (int i = 0; i < kPoints; ++i) {
+            out << "point " << latDist(rng) << ' ' << lonDist(rng) << " P" << i << '\n';
+        }
+    }
+    receivers.close();
+    
+    ArrivalEngine engine;
+    engine.setTravelTimes(&table);
+    if (!engine.loadReceivers(receivers.fileName(), &error)) {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return 1;
+    }
+    
+    BathymetryGrid grid;
+    if (argc > 1) {
+        auto start = std::chrono::steady_clock::now();
+        if (!grid.load(QString::fromLocal8Bit(argv[1]), &error)) {
+            std::fprintf(stderr, "%s\n", qPrintable(error));
+            return 1;
+        }
+        auto end = std::chrono::steady_clock::now();
+        std::printf("grid    : %d x %d cells, loaded in %.0f ms\n", grid.columns(), grid.rows(),
+                    std::chrono::duration<double, std::milli>(end - start).count());
+        engine.setBathymetry(&grid);
+    }
+    
+    std::vector<double> lat(kHypocenters), lon(kHypocenters), depth(kHypocenters);
+    std::uniform_real_distribution<double> depthDist(0.0, 600.0);
+    for (int i = 0; i < kHypocenters; ++i) {
+        lat[i] = latDist(rng);
+        lon[i] = lonDist(rng);
+        depth[i] = depthDist(rng);
+    }
+    
+    // Stations only, then the full computation
+    std::vector<float> distances(kStations), times(kStations);
+    std::uniform_real_distribution<float> distanceDist(0.0f, 60.0f);
+    for (float &d : distances) d = distanceDist(rng);
+    const double tableMs = bestOfMs(5, [&]() {
+        for (int i = 0; i < kHypocenters; ++i) {
+            table.times(TravelTimeTable::P, depth[i], distances.data(), kStations, times.data());
+        }
+    });
+    
+    double checksum = 0.0;
+    const double computeMs = bestOfMs(5, [&]() {
+        for (int i = 0; i < kHypocenters; ++i) {
+            const Arrivals arrivals = engine.compute(lat[i], lon[i], depth[i]);
+            checksum += arrivals.stations.first().p + arrivals.points.first().travelTime;
+        }
+    });
+    
+    std::printf("table   : %8.3f ms per hypocenter (%d station P lookups)\n", tableMs / kHypocenters, kStations);
+    std::printf("compute : %8.3f ms per hypocenter (%d stations P+S, %d tsunami points, %s)\n",
+                computeMs / kHypocenters, kStations, kPoints,
+                grid.isEmpty() ? "uniform depth" : "bathymetry");
+    if (!grid.isEmpty()) {
+        TravelTimeSolver solver;
+        solver.setGrid(&grid);
+        for (int i = 0; i < kMaps; ++i) {
+            // Centre of the grid, then two random hypocenters
+            const double mapLat = i == 0 ? grid.latitudeOf(grid.rows() / 2) : lat[i];
+            const double mapLon = i == 0 ? grid.longitudeOf(grid.columns() / 2) : lon[i];
+            const TravelTimeMap map = solver.solve(mapLat, mapLon, &error);
+            if (map.isEmpty()) {
+                std::printf("map     : %.2f, %.2f: %s\n", mapLat, mapLon, qPrintable(error));
+                continue;
+            }
+            int vertices = 0;
+            for (const TravelTimeMap::Isochrone &isochrone : map.isochrones) {
+                for (const QVector<QPointF> &line : isochrone.lines) vertices += line.size();
+            }
+            std::printf("map     : %8.0f ms from %.2f, %.2f (%d isochrones, %d vertices)\n", map.elapsedMs,
+                        mapLat, mapLon, int(map.isochrones.size()), vertices);
+        }
+    }
+    std::printf("checksum %.1f\n", checksum);
+    return 0;
+}
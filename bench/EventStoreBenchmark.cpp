@@ -0,0 +1,81 @@
+// Catalog filter microbenchmark: EventStore bitmap filters vs CatalogFilter::matches
+// on every row, over half a million random events.
+#include "EventStore.h"
+#include "CatalogFilter.h"
+#include <QTimeZone>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+namespace {
+template <typename Fn>
+double bestOfUs(int runs, Fn &&fn) {
+    double best = 1e300;
+    for (int r = 0; r < runs; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::micro>(end - start).count());
+    }
+    return best;
+}
+}
+
+int main() {
+    const int n = 500000;
+    const int runs = 25;
+    
+    std::mt19937_64 rng(20241218);
+    std::uniform_real_distribution<double> latDist(-15.0, 10.0);
+    std::uniform_real_distribution<double> lonDist(90.0, 145.0);
+    std::exponential_distribution<double> magDist(1.2);
+    std::uniform_int_distribution<int> depthDist(0, 650);
+    std::uniform_int_distribution<qint64> timeDist(0, 20LL * 365 * 86400 * 1000);
+    const qint64 epochMs = QDateTime(QDate(2005, 1, 1), QTime(0, 0), QTimeZone::UTC).toMSecsSinceEpoch();
+    
+    QVector<SeismicEvent> events(n);
+    for (int i = 0; i < n; ++i) {
+        SeismicEvent &event = events[i];
+        event.id = i + 1;
+        event.eventId = QString("bench%1").arg(i, 7, 10, QChar('0'));
+        event.originTime = QDateTime::fromMSecsSinceEpoch(epochMs + timeDist(rng), QTimeZone::UTC);
+        event.magnitude = float(std::min(9.5, 3.0 + magDist(rng)));
+        event.latitude = latDist(rng);
+        event.longitude = lonDist(rng);
+        event.depth = depthDist(rng);
+    }
+    
+    EventStore store;
+    store.assign(events);
+    
+    struct Case {
+        const char *name;
+        CatalogFilter filter;
+    };
+    QVector<Case> cases;
+    cases.append({"magnitude m6+", CatalogFilter::parse("m6+")});
+    cases.append({"year 2015 + m5", CatalogFilter::parse("2015 m5+")});
+    cases.append({"depth d<70", CatalogFilter::parse("d<70")});
+    cases.append({"box + depth", CatalogFilter::parse("box:-11,95,6,141 d0-100")});
+    cases.append({"all predicates", CatalogFilter::parse("2010..2019 m4.5-7 d<300 box:-11,95,6,141")});
+    
+    std::printf("events          : %d\n", n);
+    for (const Case &c : std::as_const(cases)) {
+        int storeCount = 0;
+        int scalarCount = 0;
+        double storeUs = bestOfUs(runs, [&]() {
+            storeCount = EventStore::count(store.filter(c.filter));
+        });
+        double scalarUs = bestOfUs(3, [&]() {
+            scalarCount = 0;
+            for (const SeismicEvent &event : std::as_const(events)) {
+                scalarCount += c.filter.matches(event) ? 1 : 0;
+            }
+        });
+        std::printf("%-16s: %8.1f us  (matches() %9.1f us, %6.1fx)  %d rows%s\n",
+                    c.name, storeUs, scalarUs, scalarUs / storeUs, storeCount,
+                    storeCount == scalarCount ? "" : "  MISMATCH");
+    }
+    return 0;
+}
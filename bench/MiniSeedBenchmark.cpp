@@ -0,0 +1,160 @@
+// miniSEED decode microbenchmark. Without arguments: Steim1/Steim2 throughput
+// on synthetic 4096-byte records of broadband-like data. With an archive
+// path: index and decode everything in it. Either way the rate is compared
+// with what a regional network produces in real time.
+//   miniseed_benchmark [archive]
+#include "MiniSeedArchive.h"
+#include "MiniSeedFile.h"
+#include <QtEndian>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+// 300 stations x 3 components at 100 Hz
+constexpr double kNetworkSamplesPerSecond = 300 * 3 * 100.0;
+constexpr int kFramesPerRecord = 63;
+
+template <typename Fn>
+double bestOfMs(int runs, Fn &&fn) {
+    double best = 1e300;
+    for (int r = 0; r < runs; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+bool fits(qint64 value, int bits) {
+    return value >= -(qint64(1) << (bits - 1)) && value < (qint64(1) << (bits - 1));
+}
+
+// Greedy Steim encoder for the synthetic records: frames of 16 big-endian
+// words, control nibbles in word 0, X0/Xn in words 1-2 of frame 0.
+// Returns the number of samples that fit.
+int encodeSteim(const qint32 *samples, int count, bool steim2, uchar *out) {
+    struct Packing { int count; int bits; int nibble; int dnib; };
+    static const Packing steim1[] = {{4, 8, 1, -1}, {2, 16, 2, -1}, {1, 32, 3, -1}};
+    static const Packing steim2Packings[] = {{7, 4, 3, 2}, {6, 5, 3, 1}, {5, 6, 3, 0}, {4, 8, 1, -1},
+                                             {3, 10, 2, 3}, {2, 15, 2, 2}, {1, 30, 2, 1}};
+    const Packing *packings = steim2 ? steim2Packings : steim1;
+    const int packingCount = steim2 ? 7 : 3;
+    
+    std::fill(out, out + kFramesPerRecord * 64, uchar(0));
+    int i = 0;
+    for (int f = 0; f < kFramesPerRecord && i < count; ++f) {
+        quint32 words[16] = {};
+        quint32 nibbles = 0;
+        for (int w = f == 0 ? 3 : 1; w < 16 && i < count; ++w) {
+            for (int p = 0; p < packingCount; ++p) {
+                const Packing &packing = packings[p];
+                if (count - i < packing.count) continue;
+                bool ok = true;
+                for (int k = 0; k < packing.count && ok; ++k) {
+                    const qint64 diff = i + k == 0 ? 0 : qint64(samples[i + k]) - samples[i + k - 1];
+                    ok = fits(diff, packing.bits);
+                }
+                if (!ok) continue;
+                
+                quint32 word = 0;
+                for (int k = 0; k < packing.count; ++k) {
+                    const qint64 diff = i + k == 0 ? 0 : qint64(samples[i + k]) - samples[i + k - 1];
+                    word = (word << packing.bits) | (quint32(diff) & ((quint64(1) << packing.bits) - 1));
+                }
+                if (packing.dnib >= 0) word |= quint32(packing.dnib) << 30;
+                words[w] = word;
+                nibbles |= quint32(packing.nibble) << (30 - 2 * w);
+                i += packing.count;
+                break;
+            }
+        }
+        words[0] = nibbles;
+        for (int w = 0; w < 16; ++w) qToBigEndian(words[w], out + f * 64 + w * 4);
+    }
+    qToBigEndian(quint32(samples[0]), out + 4);
+    qToBigEndian(quint32(samples[i - 1]), out + 8);
+    return i;
+}
+
+void syntheticBenchmark() {
+    // Microseism-like noise plus a few large arrivals
+    std::mt19937 rng(20241218);
+    std::normal_distribution<double> noise(0.0, 300.0);
+    const int total = 4000000;
+    std::vector<qint32> samples(total);
+    double value = 0.0;
+    for (int i = 0; i < total; ++i) {
+        value = 0.97 * value + noise(rng);
+        const double event = (i % 200000) < 4000 ? 60000.0 * std::sin(i * 0.05) : 0.0;
+        samples[i] = qint32(value + event);
+    }
+    
+    for (bool steim2 : {false, true}) {
+        std::vector<uchar> records;
+        std::vector<int> counts;
+        for (int i = 0; i < total;) {
+            records.resize(records.size() + kFramesPerRecord * 64);
+            const int n = encodeSteim(samples.data() + i, std::min(total - i, 8192), steim2,
+                                      records.data() + records.size() - kFramesPerRecord * 64);
+            counts.push_back(n);
+            i += n;
+        }
+        
+        std::vector<float> out(8192);
+        int failed = 0;
+        const double ms = bestOfMs(5, [&]() {
+            failed = 0;
+            for (size_t r = 0; r < counts.size(); ++r) {
+                if (MiniSeedFile::decodeSteim(records.data() + r * kFramesPerRecord * 64, kFramesPerRecord * 64,
+                                              counts[r], steim2, out.data()) < 0) ++failed;
+            }
+        });
+        const double rate = total / (ms / 1000.0);
+        std::printf("%s : %zu records, %.1f samples/record, %7.1f Msamples/s, %6.0fx real time%s\n",
+                    steim2 ? "Steim2" : "Steim1", counts.size(), double(total) / counts.size(),
+                    rate / 1e6, rate / kNetworkSamplesPerSecond, failed ? "  (DECODE ERRORS)" : "");
+    }
+}
+
+int archiveBenchmark(const QString &path) {
+    MiniSeedArchive archive;
+    qint64 samples = 0;
+    auto start = std::chrono::steady_clock::now();
+    if (!archive.open(path)) {
+        std::fprintf(stderr, "%s\n", qPrintable(archive.errorString()));
+        return 1;
+    }
+    auto indexed = std::chrono::steady_clock::now();
+    for (const QString &id : archive.streamIds()) {
+        qint64 first = 0;
+        qint64 last = 0;
+        archive.timeSpan(id, &first, &last);
+        for (const MiniSeedArchive::Segment &segment : archive.read(id, first, last)) {
+            samples += segment.samples.size();
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    
+    const double indexMs = std::chrono::duration<double, std::milli>(indexed - start).count();
+    const double decodeMs = std::chrono::duration<double, std::milli>(end - indexed).count();
+    const double rate = samples / (decodeMs / 1000.0);
+    std::printf("archive : %d files, %d records, %d streams\n", archive.fileCount(), archive.recordCount(),
+                int(archive.streamIds().size()));
+    std::printf("index   : %8.1f ms\n", indexMs);
+    std::printf("decode  : %8.1f ms, %lld samples, %.1f Msamples/s, %.0fx real time\n", decodeMs,
+                static_cast<long long>(samples), rate / 1e6, rate / kNetworkSamplesPerSecond);
+    return 0;
+}
+}
+
+int main(int argc, char **argv) {
+    std::printf("real time = %.0f samples/s (300 stations x 3 components x 100 Hz)\n\n", kNetworkSamplesPerSecond);
+    if (argc > 1) return archiveBenchmark(QString::fromLocal8Bit(argv[1]));
+    syntheticBenchmark();
+    return 0;
+}
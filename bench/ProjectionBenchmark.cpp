@@ -0,0 +1,60 @@
+// Web Mercator microbenchmark: batch (vectorized) kernel vs the scalar libm path
+// that MapView used inline, on one million random epicenters.
+#include "WebMercator.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+template <typename Fn>
+double bestOfMs(int runs, Fn &&fn) {
+    double best = 1e300;
+    for (int r = 0; r < runs; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+}
+
+int main() {
+    const std::size_t n = 1000000;
+    const int runs = 15;
+    
+    std::mt19937_64 rng(20241218);
+    std::uniform_real_distribution<double> latDist(-85.0, 85.0);
+    std::uniform_real_distribution<double> lonDist(-180.0, 180.0);
+    
+    std::vector<double> lat(n), lon(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        lat[i] = latDist(rng);
+        lon[i] = lonDist(rng);
+    }
+    
+    std::vector<double> xScalar(n), yScalar(n), xBatch(n), yBatch(n);
+    
+    double scalarMs = bestOfMs(runs, [&]() {
+        WebMercator::forwardNormalizedScalar(lat.data(), lon.data(), xScalar.data(), yScalar.data(), n);
+    });
+    double batchMs = bestOfMs(runs, [&]() {
+        WebMercator::forwardNormalized(lat.data(), lon.data(), xBatch.data(), yBatch.data(), n);
+    });
+    
+    double maxError = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        maxError = std::max(maxError, std::fabs(yBatch[i] - yScalar[i]));
+        maxError = std::max(maxError, std::fabs(xBatch[i] - xScalar[i]));
+    }
+    
+    std::printf("points          : %zu\n", n);
+    std::printf("scalar (libm)   : %8.3f ms  (%6.1f Mpts/s)\n", scalarMs, n / scalarMs / 1000.0);
+    std::printf("batch (SIMD)    : %8.3f ms  (%6.1f Mpts/s)\n", batchMs, n / batchMs / 1000.0);
+    std::printf("speedup         : %8.2fx\n", scalarMs / batchMs);
+    std::printf("max |error|     : %.3e (normalized world units)\n", maxError);
+    return 0;
+}
@@ -0,0 +1,62 @@
+// Reverse geocoding microbenchmark: RegionLookup region() and nearestPlace() on
+// random epicenters over the Indonesian region.
+//   region_lookup_benchmark [regions.txt]
+#include "RegionLookup.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+template <typename Fn>
+double bestOfMs(int runs, Fn &&fn) {
+    double best = 1e300;
+    for (int r = 0; r < runs; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+}
+
+int main(int argc, char **argv) {
+    const QString path = argc > 1 ? QString::fromLocal8Bit(argv[1])
+                                   : QStringLiteral(TSUNAMI_SOURCE_DIR "/data/regions.txt");
+    RegionLookup lookup;
+    QString error;
+    if (!lookup.load(path, &error)) {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return 1;
+    }
+    
+    const int n = 200000;
+    const int runs = 5;
+    std::mt19937_64 rng(20241218);
+    std::uniform_real_distribution<double> latDist(-13.0, 8.0);
+    std::uniform_real_distribution<double> lonDist(92.0, 141.0);
+    std::vector<double> lat(n), lon(n);
+    for (int i = 0; i < n; ++i) {
+        lat[i] = latDist(rng);
+        lon[i] = lonDist(rng);
+    }
+    
+    int named = 0;
+    int nearby = 0;
+    double regionMs = bestOfMs(runs, [&]() {
+        named = 0;
+        for (int i = 0; i < n; ++i) named += lookup.region(lat[i], lon[i]).isEmpty() ? 0 : 1;
+    });
+    double nearestMs = bestOfMs(runs, [&]() {
+        nearby = 0;
+        for (int i = 0; i < n; ++i) nearby += lookup.nearestPlace(lat[i], lon[i]).isValid() ? 1 : 0;
+    });
+    
+    std::printf("dataset         : %d regions, %d places\n", lookup.regionCount(), lookup.placeCount());
+    std::printf("lookups         : %d\n", n);
+    std::printf("region()        : %8.3f us/call  (%d inside a region)\n", regionMs * 1000.0 / n, named);
+    std::printf("nearestPlace()  : %8.3f us/call  (%d within 500 km)\n", nearestMs * 1000.0 / n, nearby);
+    return 0;
+}
@@ -0,0 +1,110 @@
+// Trace decimation microbenchmark: per-frame cost of building the min/max
+// column envelopes the Traces tab draws, against channel count and zoom, with
+// a day of 20 Hz data per channel. The naive line scans every sample of the
+// window instead of asking the MinMaxPyramid.
+//   trace_render_benchmark [columns]
+#include "MinMaxPyramid.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+template <typename Fn>
+double bestOfMs(int runs, Fn &&fn) {
+    double best = 1e300;
+    for (int r = 0; r < runs; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+void naiveEnvelope(const std::vector<float> &samples, double first, double samplesPerColumn, int columns,
+                   float *columnMin, float *columnMax) {
+    std::fill(columnMin, columnMin + columns, std::numeric_limits<float>::max());
+    std::fill(columnMax, columnMax + columns, -std::numeric_limits<float>::max());
+    const size_t begin = size_t(std::max(0.0, std::ceil(first)));
+    const size_t end = std::min(samples.size(), size_t(std::ceil(first + samplesPerColumn * columns)));
+    for (size_t i = begin; i < end; ++i) {
+        const int c = std::min(columns - 1, int((double(i) - first) / samplesPerColumn));
+        columnMin[c] = std::min(columnMin[c], samples[i]);
+        columnMax[c] = std::max(columnMax[c], samples[i]);
+    }
+}
+}
+
+int main(int argc, char **argv) {
+    const int columns = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1920;
+    const double rate = 20.0;
+    const quint64 day = quint64(rate * 86400.0);
+    const int runs = 5;
+    const int channelCounts[] = {1, 10, 50, 100, 200};
+    const double windows[] = {86400.0, 3600.0, 60.0};
+    
+    // Noise with a few "events" so the envelope is not flat
+    std::mt19937 rng(20241218);
+    std::normal_distribution<float> noise(0.0f, 50.0f);
+    std::vector<float> samples(day);
+    for (quint64 i = 0; i < day; ++i) {
+        const double t = double(i % 360000) / rate;
+        samples[i] = noise(rng) + float(4000.0 * std::exp(-t / 60.0) * std::sin(t * 6.0));
+    }
+    
+    // Ingest in one-second packets, a typical miniSEED record's worth
+    const int packet = int(rate);
+    std::vector<std::unique_ptr<MinMaxPyramid>> pyramids;
+    double ingestMs = 0.0;
+    int levels = 0;
+    std::vector<float> columnMin(columns), columnMax(columns);
+    
+    std::printf("channels: 20 Hz, 24 h each; %d columns; best of %d frames\n\n", columns, runs);
+    std::printf("%8s  %12s", "channels", "ns/sample");
+    for (double window : windows) std::printf("  %9.0fs ms", window);
+    std::printf("  %12s\n", "naive 1d ms");
+    
+    for (int channels : channelCounts) {
+        while (int(pyramids.size()) < channels) {
+            auto pyramid = std::make_unique<MinMaxPyramid>(day);
+            auto start = std::chrono::steady_clock::now();
+            for (quint64 i = 0; i < day; i += quint64(packet)) {
+                const int count = int(std::min<quint64>(quint64(packet), day - i));
+                pyramid->append(i, samples.data() + i, count);
+            }
+            auto end = std::chrono::steady_clock::now();
+            ingestMs += std::chrono::duration<double, std::milli>(end - start).count();
+            levels = pyramid->levelCount();
+            pyramids.push_back(std::move(pyramid));
+        }
+        std::printf("%8d  %12.2f", channels, ingestMs * 1e6 / (double(day) * pyramids.size()));
+        
+        for (double window : windows) {
+            const double samplesPerColumn = window * rate / columns;
+            const double first = double(day) - window * rate;
+            const double ms = bestOfMs(runs, [&]() {
+                for (int c = 0; c < channels; ++c) {
+                    pyramids[c]->envelope(first, samplesPerColumn, columns, columnMin.data(), columnMax.data());
+                }
+            });
+            std::printf("  %12.3f", ms);
+        }
+        
+        const double naiveMs = bestOfMs(runs, [&]() {
+            for (int c = 0; c < channels; ++c) {
+                naiveEnvelope(samples, 0.0, double(day) / columns, columns, columnMin.data(), columnMax.data());
+            }
+        });
+        std::printf("  %12.3f\n", naiveMs);
+    }
+    
+    std::printf("\npyramid levels: %d (bucket %d samples, fanout %d)\n", levels,
+                MinMaxPyramid::kBaseBucket, MinMaxPyramid::kFanout);
+    return 0;
+}
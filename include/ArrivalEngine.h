@@ -0,0 +1,106 @@
+#ifndef ARRIVALENGINE_H
+#define ARRIVALENGINE_H
+
+#include <QDateTime>
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+
+class TravelTimeTable;
+class BathymetryGrid;
+
+// Predicted arrivals of one hypocenter at every receiver
+struct Arrivals {
+    struct Station {
+        QString id;
+        double latitude = 0.0;
+        double longitude = 0.0;
+        // Epicentral distance in degrees, azimuth from the epicenter
+        float distance = 0.0f;
+        float azimuth = 0.0f;
+        // Seconds after origin; NaN past the tables
+        float p = 0.0f;
+        float s = 0.0f;
+    };
+    
+    struct ForecastPoint {
+        QString name;
+        double latitude = 0.0;
+        double longitude = 0.0;
+        float distanceKm = 0.0f;
+        // Seconds after origin
+        float travelTime = 0.0f;
+        // Part of the great-circle path that crosses land in the bathymetry
+        float overLandKm = 0.0f;
+    };
+    
+    QString eventId;
+    QDateTime originTime;
+    double latitude = 0.0;
+    double longitude = 0.0;
+    double depthKm = 0.0;
+    QVector<Station> stations;
+    QVector<ForecastPoint> points;
+    // False: tsunami speed from a uniform ocean depth
+    bool bathymetry = false;
+    double elapsedMs = 0.0;
+};
+
+Q_DECLARE_METATYPE(Arrivals)
+
+// Seismic phase and tsunami arrival times at a fixed set of receivers.
+//
+// Stations: first P and S from a TravelTimeTable at the great-circle
+// distance. Station trigonometry is precomputed, so a hypocenter costs a
+// handful of flops per station plus one table row blend per phase.
+//
+// Forecast points: the tsunami is integrated along the great circle from
+// the epicenter at the shallow-water speed sqrt(g*h), h read from a
+// BathymetryGrid every few kilometres (a uniform ocean depth without one).
+// The path does not bend around land or refract over slopes; overLandKm
+// flags the points where that matters.
+//
+// Not thread-safe to load; compute() may run concurrently with itself.
+class ArrivalEngine {
+public:
+    // Ocean depth used without a grid, and where the grid has no data
+    static constexpr double kUniformDepthM = 3000.0;
+    
+    ArrivalEngine();
+    
+    // Dataset format is described in data/receivers.txt
+    bool loadReceivers(const QString &path, QString *error = nullptr);
+    int stationCount() const;
+    int pointCount() const;
+    
+    // Not owned; TravelTimeTable::shared() by default
+    void setTravelTimes(const TravelTimeTable *table);
+    // Not owned, may be null
+    void setBathymetry(const BathymetryGrid *grid);
+    
+    Arrivals compute(double lat, double lon, double depthKm) const;
+    
+    // Tsunami travel time in seconds along the great circle
+    float tsunamiTravelTime(double lat1, double lon1, double lat2, double lon2, float *distanceKm = nullptr,
+                            float *overLandKm = nullptr) const;
+
+private:
+    struct Receiver {
+        double latitude;
+        double longitude;
+        double sinLat;
+        double cosLat;
+    };
+    
+    static Receiver receiverAt(double lat, double lon);
+    
+    QVector<QString> m_stationIds;
+    QVector<Receiver> m_stations;
+    QVector<QString> m_pointNames;
+    QVector<Receiver> m_points;
+    
+    const TravelTimeTable *m_travelTimes;
+    const BathymetryGrid *m_bathymetry;
+};
+
+#endif // ARRIVALENGINE_H
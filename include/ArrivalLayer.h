@@ -0,0 +1,40 @@
+#ifndef ARRIVALLAYER_H
+#define ARRIVALLAYER_H
+
+#include <QGraphicsItem>
+#include <QColor>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+#include "ArrivalEngine.h"
+#include "WebMercator.h"
+
+// Scene layer with the arrivals of the selected event: stations as triangles
+// shaded by P time, forecast points as dots colored by tsunami travel time.
+// Travel times are written next to the forecast points once few enough of
+// them are in view to stay readable.
+class ArrivalLayer : public QGraphicsItem {
+public:
+    explicit ArrivalLayer(const QRectF &worldRect, QGraphicsItem *parent = nullptr);
+    
+    void setWorldRect(const QRectF &worldRect);
+    void setArrivals(const Arrivals &arrivals);
+    void clear();
+    
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+    
+    // Warna titik pantai menurut waktu tiba tsunami
+    static QColor tsunamiColor(double seconds);
+
+private:
+    void project();
+    
+    QRectF m_worldRect;
+    WebMercator m_projection;
+    Arrivals m_arrivals;
+    QVector<QPointF> m_stationPositions;
+    QVector<QPointF> m_pointPositions;
+};
+
+#endif // ARRIVALLAYER_H
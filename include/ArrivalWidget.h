@@ -0,0 +1,55 @@
+#ifndef ARRIVALWIDGET_H
+#define ARRIVALWIDGET_H
+
+#include <QWidget>
+#include <QDateTime>
+#include <QThread>
+#include "ArrivalEngine.h"
+#include "TravelTimeMap.h"
+
+class QLabel;
+class QTableWidget;
+class ArrivalWorker;
+
+// "Arrival" tab: predicted P and S times at every station and tsunami
+// arrival times at the coastal forecast points for the selected event,
+// earliest first. The engine runs on an ArrivalWorker thread; results are
+// also handed on through arrivalsChanged() for the map, and with a
+// bathymetry grid the isochrones through travelTimesChanged().
+class ArrivalWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit ArrivalWidget(QWidget *parent = nullptr);
+    ~ArrivalWidget();
+    
+    // Receivers file (data/receivers.txt format) and an optional bathymetry
+    // grid; both load on the worker thread
+    void open(const QString &receiversPath, const QString &bathymetryPath);
+    void setEvent(const QString &eventId, const QDateTime &originTime, double lat, double lon, double depthKm);
+    const Arrivals &arrivals() const;
+
+signals:
+    void arrivalsChanged(const Arrivals &arrivals);
+    // Empty map when the event changes, until the new one is solved
+    void travelTimesChanged(const TravelTimeMap &map);
+
+private:
+    void showArrivals(const Arrivals &arrivals);
+    void showTravelTimes(const TravelTimeMap &map, const QString &error);
+    void updateSummary();
+    
+    QThread m_workerThread;
+    ArrivalWorker *m_worker;
+    
+    QLabel *m_summary;
+    QTableWidget *m_stationTable;
+    QTableWidget *m_pointTable;
+    
+    QString m_receiverInfo;
+    QString m_travelTimeInfo;
+    QString m_eventId;
+    Arrivals m_arrivals;
+};
+
+#endif // ARRIVALWIDGET_H
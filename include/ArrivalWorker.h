@@ -0,0 +1,48 @@
+#ifndef ARRIVALWORKER_H
+#define ARRIVALWORKER_H
+
+#include <QDateTime>
+#include <QObject>
+#include <QString>
+#include "ArrivalEngine.h"
+#include "BathymetryGrid.h"
+#include "TravelTimeMap.h"
+#include <atomic>
+
+// Owns the ArrivalEngine and its bathymetry on a thread of their own, so
+// loading a large grid never blocks the GUI. Slots are invoked queued; a
+// compute() sent while open() is still loading simply runs after it.
+//
+// With a grid, compute() answers twice: great-circle arrivals right away,
+// then a TravelTimeMap and the forecast points re-read from it a second or
+// so later.
+class ArrivalWorker : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ArrivalWorker(QObject *parent = nullptr);
+    
+    // Thread-safe; call once for every compute() queued, so a travel-time map
+    // still being solved for an older event gives up
+    void noteQueued();
+
+public slots:
+    // Receivers from receiversPath; the bathymetry grid is optional
+    void open(const QString &receiversPath, const QString &bathymetryPath);
+    void compute(const QString &eventId, const QDateTime &originTime, double lat, double lon, double depthKm);
+
+signals:
+    // bathymetry: grid file name, empty without one; error: what failed to load
+    void opened(int stations, int points, const QString &bathymetry, const QString &error);
+    void arrivalsReady(const Arrivals &arrivals);
+    // map is empty when it could not be solved; error says why
+    void travelTimesReady(const TravelTimeMap &map, const QString &error);
+
+private:
+    ArrivalEngine m_engine;
+    BathymetryGrid m_bathymetry;
+    TravelTimeSolver m_solver;
+    std::atomic_int m_queued;
+};
+
+#endif // ARRIVALWORKER_H
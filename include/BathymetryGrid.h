@@ -0,0 +1,46 @@
+#ifndef BATHYMETRYGRID_H
+#define BATHYMETRYGRID_H
+
+#include <QString>
+#include <QVector>
+
+// Regular latitude/longitude elevation grid (GEBCO, ETOPO, SRTM15+ exported
+// as an ESRI ASCII grid, .asc). The file is memory-mapped and parsed in one
+// pass; a regional 1-arc-minute grid of a few million cells loads in about a
+// second. Values are metres, positive up, so the sea floor is negative and
+// NODATA cells are NaN. Regional grids only: longitudes do not wrap.
+// Read-only after load(), safe to share between threads.
+class BathymetryGrid {
+public:
+    bool load(const QString &path, QString *error = nullptr);
+    void clear();
+    bool isEmpty() const;
+    QString fileName() const;
+    
+    int columns() const;
+    int rows() const;
+    // Degrees
+    double cellSize() const;
+    // Cell centres; row 0 is the northernmost row
+    double latitudeOf(int row) const;
+    double longitudeOf(int column) const;
+    bool contains(double lat, double lon) const;
+    
+    float elevation(int row, int column) const;
+    // Bilinear between cell centres; NaN outside the grid or next to NODATA
+    float elevationAt(double lat, double lon) const;
+    // rows() x columns(), row-major, north row first
+    const float *data() const;
+
+private:
+    QString m_fileName;
+    int m_columns = 0;
+    int m_rows = 0;
+    double m_cellSize = 0.0;
+    // Centre of the north-west cell
+    double m_north = 0.0;
+    double m_west = 0.0;
+    QVector<float> m_elevation;
+};
+
+#endif // BATHYMETRYGRID_H
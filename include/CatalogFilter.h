@@ -0,0 +1,66 @@
+#ifndef CATALOGFILTER_H
+#define CATALOGFILTER_H
+
+#include <QDate>
+#include <QMetaType>
+#include <QPointF>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+#include <optional>
+#include "SeismicEvent.h"
+
+// Event catalog filter. Every field is optional; whereClause() only emits
+// predicates the indexes on sumber_tsunami can serve (btree on origintime and
+// magnitudo, GiST on geom_source, text_pattern_ops btree on event_id for the
+// prefix LIKE), plus depth as a check on the rows they return, and takes its
+// values as typed '?' parameters from bindValues().
+struct CatalogFilter {
+    struct GeoBox {
+        double south = 0.0;
+        double west = 0.0;
+        double north = 0.0;
+        double east = 0.0;
+    };
+    
+    // Local calendar days, both ends inclusive
+    QDate startDate;
+    QDate endDate;
+    std::optional<double> minMagnitude;
+    std::optional<double> maxMagnitude;
+    // Kilometres, both ends inclusive
+    std::optional<int> minDepth;
+    std::optional<int> maxDepth;
+    // west > east crosses the antimeridian
+    std::optional<GeoBox> box;
+    // Set by intersected() when two boxes overlap in more than one piece, as
+    // a wide view and a box across the antimeridian do; both must hold
+    std::optional<GeoBox> secondBox;
+    // Region drawn on the map, x = longitude, y = latitude; empty means none
+    QVector<QPointF> polygon;
+    QString eventIdPrefix;
+    // Set by intersected() when no event can satisfy both filters
+    bool matchesNothing = false;
+    
+    // Search box syntax, terms separated by spaces:
+    //   m6.5  m>=6.5  m6.5+  m<7  m6-7     magnitude
+    //   d<70  d>=300  d0-70               depth in km
+    //   lat:-11..6  lon:95..141           latitude/longitude range
+    //   box:S,W,N,E                       bounding box
+    //   2024  2024-12  2024-12-18  2024-12-01..2024-12-31
+    //   id:ujicoba  or a bare word        event id prefix
+    static CatalogFilter parse(const QString &text, QString *error = nullptr);
+    
+    // Both filters must hold
+    CatalogFilter intersected(const CatalogFilter &other) const;
+    
+    QString whereClause() const;
+    QVariantList bindValues() const;
+    // Which predicates are present; statements are prepared once per shape
+    QString shape() const;
+    bool matches(const SeismicEvent &event) const;
+};
+
+Q_DECLARE_METATYPE(CatalogFilter)
+
+#endif // CATALOGFILTER_H
@@ -0,0 +1,85 @@
+#ifndef CATALOGIMPORTER_H
+#define CATALOGIMPORTER_H
+
+#include <QByteArray>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QtGlobal>
+#include <functional>
+
+class QIODevice;
+
+// Bulk load of event catalogs (USGS/ISC style CSV, or CSV exported from
+// QuakeML) into sumber_tsunami. Rows are encoded straight into PostgreSQL's
+// binary COPY format, geom_source included as EWKB, and streamed with
+// COPY ... FROM STDIN over the libpq handle of a QPSQL connection. The whole
+// file is one transaction; live listeners get a single "BULK" notification
+// instead of one per row.
+//
+// The first line is the header (a leading '#' is dropped, so FDSN text
+// exports work too); fields are separated by ',' or '|'. Columns are found by
+// name, case-insensitive:
+//   event_id | eventid | id            origintime | time | datetime
+//   latitude | lat                     longitude | lon | long
+//   depth_km | depth | depth/km        magnitudo | magnitude | mag
+//   strike, dip, slip | rake (optional)
+// Times are ISO 8601 (UTC unless an offset is given). Rows that do not parse
+// are skipped and counted.
+class CatalogImporter {
+public:
+    struct Options {
+        // Existing event ids are left alone instead of failing the import.
+        // Goes through a temporary table, roughly half the speed
+        bool skipExisting = false;
+        int progressInterval = 16384;
+    };
+    
+    struct Result {
+        bool ok = false;
+        qint64 rows = 0;
+        qint64 skipped = 0;
+        qint64 elapsedMs = 0;
+        QString error;
+        // First few rejected lines, "line N: reason"
+        QStringList rejected;
+    };
+    
+    // Rows encoded so far, input bytes consumed and total (0 if unknown).
+    // Returning false cancels the import and rolls it back.
+    using Progress = std::function<bool(qint64 rows, qint64 bytesRead, qint64 totalBytes)>;
+    
+    explicit CatalogImporter(const QSqlDatabase &db, const Options &options = Options());
+    
+    Result importFile(const QString &path, const Progress &progress = Progress());
+    Result import(QIODevice *input, const Progress &progress = Progress());
+
+private:
+    enum Field {
+        EventIdField,
+        TimeField,
+        LatitudeField,
+        LongitudeField,
+        DepthField,
+        MagnitudeField,
+        StrikeField,
+        DipField,
+        SlipField,
+        kFieldCount
+    };
+    
+    bool mapHeader(const QVector<QByteArray> &header, QString *error);
+    // Appends one binary COPY tuple to m_buffer; false with a reason if the
+    // row cannot be loaded
+    bool encodeRow(const QVector<QByteArray> &fields, QString *reason);
+    
+    QSqlDatabase m_db;
+    Options m_options;
+    char m_delimiter;
+    // Input column of each field, -1 if the file does not have it
+    int m_column[kFieldCount];
+    QByteArray m_buffer;
+};
+
+#endif // CATALOGIMPORTER_H
@@ -0,0 +1,103 @@
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+
+#include <QMutex>
+#include <QSemaphore>
+#include <QSqlDatabase>
+#include <QString>
+#include <QThreadStorage>
+#include <atomic>
+
+struct ConnectionSettings {
+    QString host = "localhost";
+    QString database = "tsunami_data";
+    QString user = "farhan";
+    QString password = "farhan";
+    int port = 5432;
+    
+    // TSUNAMI_DB_HOST, _PORT, _NAME, _USER, _PASSWORD override the defaults
+    static ConnectionSettings fromEnvironment();
+};
+
+// Process-wide PostgreSQL connections. Qt SQL connections belong to the thread
+// that opened them, so the pool keeps one connection per thread and hands it
+// out as a Lease; at most maxConnections leases are out at once and acquire()
+// gives up after its timeout instead of blocking the caller indefinitely.
+// A connection idle for a while is pinged on checkout and reopened if dead.
+// A lease must be used and released on the thread that acquired it.
+class ConnectionPool {
+public:
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease &&other) noexcept;
+        Lease &operator=(Lease &&other) noexcept;
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+        ~Lease();
+        
+        bool isValid() const { return m_pool != nullptr; }
+        QSqlDatabase database() const;
+        
+        // Pings after kHealthCheckIdleMs of inactivity and reopens a dead
+        // connection. reconnected tells the caller that server-side state
+        // (prepared statements, LISTEN) is gone.
+        bool ensureHealthy(bool *reconnected = nullptr);
+        void release();
+    
+    private:
+        friend class ConnectionPool;
+        Lease(ConnectionPool *pool, const QString &name);
+        
+        ConnectionPool *m_pool = nullptr;
+        QString m_name;
+    };
+    
+    struct Stats {
+        int openConnections = 0;
+        int leasesOut = 0;
+        int reconnects = 0;
+        int timeouts = 0;
+        qint64 maxWaitUs = 0;
+    };
+    
+    static constexpr int kHealthCheckIdleMs = 30000;
+    
+    static ConnectionPool &instance();
+    
+    void configure(const ConnectionSettings &settings, int maxConnections = 4);
+    bool isDriverAvailable() const;
+    
+    Lease acquire(int timeoutMs = 2000, QString *error = nullptr);
+    Stats stats() const;
+
+private:
+    // Owned by QThreadStorage: the connection is removed when its thread ends
+    struct ThreadConnection {
+        QString name;
+        int leases = 0;
+        qint64 lastUsedMs = 0;
+        ConnectionPool *pool = nullptr;
+        ~ThreadConnection();
+    };
+    
+    ConnectionPool();
+    ThreadConnection *threadConnection(QString *error);
+    bool openConnection(QSqlDatabase &db, QString *error);
+    void releaseLease();
+    
+    mutable QMutex m_mutex;
+    ConnectionSettings m_settings;
+    QSemaphore m_permits;
+    int m_maxConnections;
+    QThreadStorage<ThreadConnection*> m_threadConnections;
+    std::atomic<int> m_nextId;
+    
+    std::atomic<int> m_openConnections;
+    std::atomic<int> m_leasesOut;
+    std::atomic<int> m_reconnects;
+    std::atomic<int> m_timeouts;
+    std::atomic<qint64> m_maxWaitUs;
+};
+
+#endif // CONNECTIONPOOL_H
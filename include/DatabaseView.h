@@ -3,12 +3,23 @@
 
 #include <QWidget>
 #include <QTableView>
-#include <QSqlDatabase>
-#include <QSqlQueryModel>
+#include <QThread>
 #include <QPushButton>
+#include <QProgressBar>
 #include <QLabel>
 #include <QDateEdit>
+#include <QDoubleSpinBox>
+#include <QCheckBox>
+#include <QLineEdit>
+#include <QTimer>
 #include <QItemSelection>
+#include <QSet>
+#include "SeismicEvent.h"
+#include "DatabaseWorker.h"
+#include "EventSnapshot.h"
+#include "EventStore.h"
+
+class EventTableModel;
 
 class DatabaseView : public QWidget {
     Q_OBJECT
@@ -20,34 +31,105 @@ public:
     bool connectToDatabase();
     void loadData();
     void loadDataWithDateFilter(const QDate &startDate, const QDate &endDate);
+    // Map viewport and drawn region. The map layer gets the events inside the
+    // viewport through catalogLoaded; with "Map area only" the table follows too.
+    void setMapView(const CatalogFilter::GeoBox &view);
+    void setMapRegion(const QVector<QPointF> &polygon);
     QString getSelectedEventId() const;
 
 signals:
     void eventSelected(const QString &eventId, double lat, double lon, double magnitude, 
                       int depth, int strike, int dip, int slip, const QString &eventInfo);
+    void catalogLoaded(const QVector<SeismicEvent> &events);
 
 private slots:
     void onSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected);
     void onSelectEvent();
     void onDateRangeChanged();
+    void onSearchTextChanged();
     void onTableDoubleClicked(const QModelIndex &index);
+    void onCancelQuery();
+    void onDatabaseOpened(bool ok, const QString &error);
+    void onWindowReady(quint64 requestId, int totalRows, const QVector<EventKey> &anchors);
+    void onLiveUpdatesInterrupted(quint64 requestId);
+    void onStatementStats(const QVector<StatementCache::Stats> &stats);
+    void onQueryCanceled(quint64 requestId);
+    void onQueryFailed(quint64 requestId, const QString &error);
+    void onRegionLoaded(quint64 requestId, const QVector<SeismicEvent> &events, bool truncated);
+    void onConnectionLost();
+    void onSnapshotSynced(const QVector<SeismicEvent> &changed, const QVector<int> &removed, bool replaced);
+    void onCatalogChanged();
+    void onImportClicked();
+    void onImportProgress(qint64 rows, qint64 bytesRead, qint64 totalBytes);
+    void onImportFinished(bool ok, qint64 rows, qint64 skipped, qint64 elapsedMs, const QString &error);
+    void syncSnapshot();
 
 private:
     void setupUI();
     void setupDatabase();
+    void setQueryRunning(bool running);
+    void loadMapRegion();
+    // With changedIds the store was just updated by a sync and the table is
+    // diffed against it instead of reset
+    void loadFromStore(const QSet<int> *changedIds = nullptr);
+    
+    // Batas marker di peta; box yang lebih padat hanya menampilkan magnitudo terbesar
+    static constexpr int kMaxMapEvents = 20000;
+    static constexpr int kReconnectIntervalMs = 15000;
+    static constexpr int kSnapshotSyncIntervalMs = 10 * 60 * 1000;
+    // Live changes are batched into one snapshot sync; a sync only appends
+    // a delta, so a short delay is enough to coalesce a burst
+    static constexpr int kChangeSyncDelayMs = 250;
     
     QTableView *m_tableView;
-    QSqlQueryModel *m_model;
-    QSqlDatabase m_db;
+    EventTableModel *m_model;
+    
+    // Semua query jalan di thread database, GUI tidak pernah menunggu server
+    QThread m_dbThread;
+    DatabaseWorker *m_worker;
+    quint64 m_activeRequest;
+    CatalogFilter m_requestFilter;
+    bool m_explainQueries;
     
     QPushButton *m_btnSelect;
     QLabel *m_statusLabel;
+    QProgressBar *m_progressBar;
+    QPushButton *m_btnCancel;
+    QPushButton *m_btnImport;
+    bool m_importing;
     QDateEdit *m_startDateEdit;
     QDateEdit *m_endDateEdit;
+    QDoubleSpinBox *m_minMagnitudeEdit;
+    QLineEdit *m_searchEdit;
+    QTimer *m_searchTimer;
+    QCheckBox *m_mapAreaCheck;
     QPushButton *m_btnFilter;
     
     bool m_isConnected;
     QString m_selectedEventId;
+    
+    // Salinan lokal katalog: tampil seketika saat startup dan saat database mati
+    EventSnapshot m_snapshot;
+    QString m_snapshotPath;
+    QTimer *m_reconnectTimer;
+    QTimer *m_snapshotTimer;
+    
+    // Katalog di memori; filter dijawab di sini tanpa query selama m_storeCurrent
+    // (sinkron dengan server) atau saat offline
+    EventStore m_store;
+    bool m_storeCurrent;
+    QTimer *m_changeTimer;
+    
+    // Map layer region. m_regionEvents covers m_loadedBox; a viewport that
+    // leaves it only fetches the rows outside it (complete loads only)
+    std::optional<CatalogFilter::GeoBox> m_mapView;
+    QVector<QPointF> m_mapPolygon;
+    quint64 m_regionRequest;
+    CatalogFilter::GeoBox m_pendingBox;
+    std::optional<CatalogFilter::GeoBox> m_pendingExclude;
+    std::optional<CatalogFilter::GeoBox> m_loadedBox;
+    bool m_loadedComplete;
+    QVector<SeismicEvent> m_regionEvents;
 };
 
 #endif // DATABASEVIEW_H
@@ -0,0 +1,146 @@
+#ifndef DATABASEWORKER_H
+#define DATABASEWORKER_H
+
+#include <QObject>
+#include <QSet>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "SeismicEvent.h"
+#include "CatalogFilter.h"
+#include "StatementCache.h"
+#include "ConnectionPool.h"
+
+class QTimer;
+
+// Position of a row in the (origintime, id) ordering. The time is kept as the
+// server's text form so keyset comparisons keep full microsecond precision.
+struct EventKey {
+    QString originTime;
+    int id = 0;
+};
+
+Q_DECLARE_METATYPE(EventKey)
+
+// Runs catalog queries on its own thread with a private connection. Slots are
+// invoked queued from the GUI thread; results come back as signals tagged with
+// the request id so stale batches can be dropped by the receiver.
+//
+// The worker also LISTENs on sumber_tsunami_changes. Each change to a row of
+// the open window is turned into a row-level diff (row index in the window's
+// newest-first order) so the model never has to re-select.
+class DatabaseWorker : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DatabaseWorker(QObject *parent = nullptr);
+    ~DatabaseWorker();
+    
+    // Thread-safe. Every new request id makes all older ones stale; a running
+    // query notices at its next batch and stops fetching.
+    quint64 nextRequestId();
+    void cancelAll();
+    // Map region loads have their own sequence so they never cancel the table
+    quint64 nextRegionRequestId();
+    // Thread-safe. Cancels the server-side query of openWindow(requestId) if it
+    // is still executing, with a libpq cancel request; no pool lease is taken.
+    void interrupt(quint64 requestId);
+    // Thread-safe. Rolls back a running importCatalog() at its next progress step
+    void cancelImport();
+
+public slots:
+    // Borrows this thread's connection from ConnectionPool
+    void open();
+    // Counts the matching rows and collects the key of every pageSize-th row,
+    // newest first. The keys let fetchPage() seek straight to any page.
+    void openWindow(quint64 requestId, const CatalogFilter &filter, int pageSize);
+    void fetchPage(quint64 requestId, int page, const EventKey &anchor,
+                   const CatalogFilter &filter, int pageSize);
+    // Brings the local snapshot at path up to date: rows changed or deleted
+    // since its version are fetched and appended as a delta, or everything
+    // written if there is none
+    void syncSnapshot(const QString &path);
+    // Events matching filter (a map box, optionally a drawn region), largest
+    // magnitude first, at most limit rows. With exclude set only rows outside
+    // that box are returned: the caller already holds those.
+    void loadRegion(quint64 requestId, const CatalogFilter &filter,
+                    const std::optional<CatalogFilter::GeoBox> &exclude, int limit);
+    // Emits statementStats; with explain set also logs each statement's plan
+    void reportStatements(bool explain);
+    // Bulk loads a catalog file with CatalogImporter (binary COPY). Other
+    // requests queue behind it; listeners are told once, by a BULK notification.
+    void importCatalog(const QString &path, bool skipExisting);
+
+signals:
+    void opened(bool ok, const QString &error);
+    void windowReady(quint64 requestId, int totalRows, const QVector<EventKey> &anchors);
+    void pageReady(quint64 requestId, int page, const QVector<SeismicEvent> &rows);
+    void queryCanceled(quint64 requestId);
+    void queryFailed(quint64 requestId, const QString &error);
+    void regionLoaded(quint64 requestId, const QVector<SeismicEvent> &events, bool truncated);
+    void statementStats(const QVector<StatementCache::Stats> &stats);
+    
+    // Live diffs against the window of requestId, applied in emission order
+    void rowInserted(quint64 requestId, int row, const SeismicEvent &event, const EventKey &key);
+    void rowUpdated(quint64 requestId, int row, const SeismicEvent &event);
+    void rowRemoved(quint64 requestId, int row, int eventId);
+    // The connection was re-established; the window may have missed changes
+    void liveUpdatesInterrupted(quint64 requestId);
+    // The server stopped answering; the pool keeps trying to reconnect
+    void connectionLost();
+    // Any row of sumber_tsunami changed, whether or not a window is open
+    void catalogChanged();
+    // The rows and ids the sync found; replaced when the file was written
+    // from scratch rather than extended
+    void snapshotSynced(const QVector<SeismicEvent> &changed, const QVector<int> &removed, bool replaced);
+    void importProgress(qint64 rows, qint64 bytesRead, qint64 totalBytes);
+    void importFinished(bool ok, qint64 rows, qint64 skipped, qint64 elapsedMs, const QString &error);
+
+private slots:
+    void onNotification(const QString &name, QSqlDriver::NotificationSource source,
+                        const QVariant &payload);
+    bool ensureConnected();
+
+private:
+    // txid_current_snapshot() of the window: changes it already saw are skipped
+    struct TxSnapshot {
+        quint64 xmin = 0;
+        quint64 xmax = 0;
+        QSet<quint64> inProgress;
+        
+        static TxSnapshot parse(const QString &text);
+        bool sees(quint64 txid) const;
+    };
+    
+    struct CancelTarget;
+    
+    bool isStale(quint64 requestId) const;
+    void prepareStatements();
+    // Window statements are prepared per filter shape, on first use
+    QString windowStatement(const QString &kind, const CatalogFilter &filter);
+    void subscribe();
+    // Cancel key of the current session, refetched after a reconnect
+    void updateCancelKey();
+    // The window request interrupt() may cancel, 0 for none
+    void setCancelableRequest(quint64 requestId);
+    bool fetchEvent(int id, SeismicEvent &event, EventKey &key);
+    int rankOf(const QString &originTime, int id);
+    
+    ConnectionPool::Lease m_lease;
+    QSqlDatabase m_db;
+    StatementCache m_statements;
+    CatalogFilter m_lastFilter;
+    int m_lastPageSize;
+    quint64 m_windowRequest;
+    TxSnapshot m_windowSnapshot;
+    QTimer *m_healthTimer;
+    std::atomic<quint64> m_latestRequest;
+    std::atomic<quint64> m_latestRegion;
+    std::atomic<bool> m_importCanceled;
+    const std::shared_ptr<CancelTarget> m_cancel;
+};
+
+#endif // DATABASEWORKER_H
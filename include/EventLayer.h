@@ -0,0 +1,81 @@
+#ifndef EVENTLAYER_H
+#define EVENTLAYER_H
+
+#include <QGraphicsItem>
+#include <QColor>
+#include <QDateTime>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+#include "SeismicEvent.h"
+#include "WebMercator.h"
+
+class GlyphAtlas;
+
+// Scene layer holding every epicenter of the catalog as a single item.
+// Events are bucketed per clustering level (quadtree cells over the world
+// rect) and each level is kept sorted by cell, so painting only visits the
+// visible cells and hit-testing is a binary search. Single events with a
+// focal mechanism are drawn as beach balls from a GlyphAtlas.
+class EventLayer : public QGraphicsItem {
+public:
+    explicit EventLayer(const QRectF &worldRect, QGraphicsItem *parent = nullptr);
+
+    void setWorldRect(const QRectF &worldRect);
+    void setEvents(const QVector<SeismicEvent> &events);
+    const QVector<SeismicEvent> &events() const;
+    int eventCount() const;
+
+    // Not owned; the layer requests the glyphs its events need
+    void setGlyphAtlas(GlyphAtlas *atlas);
+    // Ratio of the screen the view is on; a new one re-renders the atlas
+    void setDevicePixelRatio(qreal ratio);
+    void setShowMechanisms(bool show);
+    bool showMechanisms() const;
+
+    void setHighlight(const QPointF &scenePos);
+    void clearHighlight();
+
+    // Index into events() of the marker under scenePos, or -1. Clusters of more
+    // than one event are not hits; zooming in splits them.
+    int hitTest(const QPointF &scenePos, double viewScale) const;
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    struct Cluster {
+        quint64 cell;
+        int count;
+        int firstEvent;     // representative (largest magnitude) event
+        float sumX;
+        float sumY;
+        float maxMagnitude;
+    };
+
+    int levelForScale(double viewScale) const;
+    const QVector<Cluster> &clustersForLevel(int level) const;
+    void clusterRange(int level, const QRectF &sceneRect,
+                      QVector<const Cluster *> &out) const;
+    static QColor ageColor(const QDateTime &originTime, const QDateTime &now);
+    static double markerRadius(double magnitude);
+    void requestGlyphs();
+
+    QRectF m_worldRect;
+    WebMercator m_projection;
+    QVector<SeismicEvent> m_events;
+    QVector<QPointF> m_positions;
+    // GlyphAtlas::keyFor per event, 0 without a mechanism
+    QVector<quint32> m_glyphKeys;
+    GlyphAtlas *m_glyphAtlas;
+    bool m_showMechanisms;
+
+    // Lazily built, one entry per clustering level
+    mutable QVector<QVector<Cluster>> m_levels;
+    mutable QVector<bool> m_levelBuilt;
+
+    bool m_hasHighlight;
+    QPointF m_highlight;
+};
+
+#endif // EVENTLAYER_H
@@ -0,0 +1,114 @@
+#ifndef EVENTSNAPSHOT_H
+#define EVENTSNAPSHOT_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include "SeismicEvent.h"
+
+// Local copy of sumber_tsunami ("events.snapshot") so the catalog is usable
+// before the database answers and through an outage. Layout, little-endian:
+//   header  : magic "TSEVSNP1", u32 version, u32 rowCount, i64 maxId,
+//             i64 syncedMs, u64 columnOffset[kColumnCount]
+//   columns : one array per field, rowCount entries each, 8-byte aligned;
+//             event ids as u32 offsets[rowCount + 1] into a UTF-8 blob
+//   deltas  : one per sync since the last write(), 8-byte aligned: magic
+//             "TSEVDLT1", u32 changedCount, u32 removedCount, i64 maxId,
+//             i64 syncedMs, u64 bytes, u64 columnOffset[kColumnCount],
+//             u64 removedOffset, then the changed rows in the column layout
+//             and the removed ids as i32; offsets are from the delta's start
+// Base rows are sorted by (origin time, id). A sync appends a delta instead
+// of rewriting the file; a torn one at the end is ignored and overwritten.
+// The file is memory-mapped; EventStore::assign() copies the base columns
+// straight from the mapping and applies the deltas on top.
+class EventSnapshot {
+public:
+    // Server time up to which the snapshot has seen changes, and its highest id
+    struct Version {
+        qint64 maxId = 0;
+        QDateTime syncedAt;
+    };
+    
+    EventSnapshot();
+    ~EventSnapshot();
+    
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const;
+    QString errorString() const;
+    
+    // Rows of the base section, without the deltas
+    int rowCount() const;
+    // As of the last delta
+    Version version() const;
+    SeismicEvent event(int row) const;
+    // Base rows with every delta applied
+    QVector<SeismicEvent> events() const;
+    
+    // Net effect of the deltas: rows added or changed, ids deleted
+    const QVector<SeismicEvent> &changedEvents() const;
+    const QVector<int> &removedIds() const;
+    // Rows and ids written in deltas, the cost of reading them back
+    int deltaRows() const;
+    
+    // Replaces the file atomically, deltas folded in; readers keep their old
+    // mapping
+    static bool write(const QString &path, QVector<SeismicEvent> events,
+                      const Version &version, QString *error = nullptr);
+    // Adds one sync's changes to an existing snapshot without rewriting it
+    static bool append(const QString &path, const QVector<SeismicEvent> &changed,
+                       const QVector<int> &removed, const Version &version,
+                       QString *error = nullptr);
+    static QString defaultPath();
+
+private:
+    // Copies the base columns in place
+    friend class EventStore;
+    
+    enum Column {
+        IdColumn,
+        OriginColumn,
+        MagnitudeColumn,
+        LatitudeColumn,
+        LongitudeColumn,
+        DepthColumn,
+        StrikeColumn,
+        DipColumn,
+        SlipColumn,
+        EventIdOffsetColumn,
+        EventIdTextColumn,
+        kColumnCount
+    };
+    
+    template <typename T>
+    const T *column(Column c) const {
+        return reinterpret_cast<const T *>(m_data + m_offsets[c]);
+    }
+    QString eventId(int row) const;
+    
+    // A column block (the base, or the rows of one delta) at data, size bytes
+    // long. columnsEnd() is -1 when the columns do not fit
+    static qint64 columnsEnd(const uchar *data, qint64 size, const quint64 *offsets, qint64 rows);
+    static SeismicEvent readRow(const uchar *data, qint64 size, const quint64 *offsets, int row);
+    static QString readEventId(const uchar *data, qint64 size, const quint64 *offsets, int row);
+    // headerBytes of zeros, then the columns of events; fills offsets
+    static QByteArray columnBlock(const QVector<SeismicEvent> &events, int headerBytes, quint64 *offsets);
+    
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_size;
+    int m_rowCount;
+    Version m_version;
+    quint64 m_offsets[kColumnCount];
+    // Where the next delta goes: past the last complete one
+    qint64 m_end;
+    QVector<SeismicEvent> m_changed;
+    QVector<int> m_removed;
+    int m_deltaRows;
+    QString m_error;
+};
+
+#endif // EVENTSNAPSHOT_H
@@ -0,0 +1,75 @@
+#ifndef EVENTSTORE_H
+#define EVENTSTORE_H
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <vector>
+#include "SeismicEvent.h"
+#include "CatalogFilter.h"
+
+class EventSnapshot;
+
+// The whole catalog in memory as one array per field, rows sorted by
+// (origin time, id). filter() finds the date range with two binary searches
+// and tests magnitude, depth and the bounding box with branch-free loops over
+// 64 rows at a time, which the compiler vectorizes; the result is a bitmap
+// with one bit per row. A drawn region and an id prefix are checked
+// afterwards, on the rows still set only.
+class EventStore {
+public:
+    // Bit (row % 64) of word (row / 64) is set when the row matches
+    using Bitmap = std::vector<quint64>;
+    
+    EventStore();
+    
+    void assign(QVector<SeismicEvent> events);
+    // Base columns copied straight from the mapping, then its deltas applied
+    void assign(const EventSnapshot &snapshot);
+    // Rows with the id of a changed event are replaced by it (or it is
+    // added), removed ids dropped; one merge pass, the order is kept
+    void apply(const QVector<SeismicEvent> &changed, const QVector<int> &removed);
+    void clear();
+    int rowCount() const;
+    bool isEmpty() const;
+    
+    Bitmap filter(const CatalogFilter &filter) const;
+    static int count(const Bitmap &bitmap);
+    // Rows set in bitmap newest first, at most limit (0 = all)
+    QVector<int> rows(const Bitmap &bitmap, int limit = 0) const;
+    // Rows set in bitmap with the largest magnitude first, at most limit
+    QVector<int> largest(const Bitmap &bitmap, int limit) const;
+    
+    SeismicEvent event(int row) const;
+    int id(int row) const { return m_id[row]; }
+    const QString &eventId(int row) const { return m_eventId[row]; }
+    qint64 originMs(int row) const { return m_originMs[row]; }
+    float magnitude(int row) const { return m_magnitude[row]; }
+    double latitude(int row) const { return m_latitude[row]; }
+    double longitude(int row) const { return m_longitude[row]; }
+    int depth(int row) const { return m_depth[row]; }
+    int strike(int row) const { return m_strike[row]; }
+    int dip(int row) const { return m_dip[row]; }
+    int slip(int row) const { return m_slip[row]; }
+
+private:
+    void resize(int rows);
+    void setRow(int row, const SeismicEvent &event);
+    void copyRow(int row, const EventStore &from, int fromRow);
+    
+    int m_rowCount;
+    // Numeric columns are padded to a multiple of 64 rows so the filter
+    // kernels always work on whole blocks
+    std::vector<qint64> m_originMs;
+    std::vector<float> m_magnitude;
+    std::vector<double> m_latitude;
+    std::vector<double> m_longitude;
+    std::vector<qint32> m_depth;
+    std::vector<qint32> m_strike;
+    std::vector<qint32> m_dip;
+    std::vector<qint32> m_slip;
+    std::vector<qint32> m_id;
+    QVector<QString> m_eventId;
+};
+
+#endif // EVENTSTORE_H
@@ -0,0 +1,108 @@
+#ifndef EVENTTABLEMODEL_H
+#define EVENTTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QVector>
+#include "SeismicEvent.h"
+#include "DatabaseWorker.h"
+#include "EventStore.h"
+
+// Table model for the event list. Only the row count and one key per page are
+// known up front; rows are fetched from DatabaseWorker a page at a time as the
+// view asks for them, and at most kMaxResidentPages pages are kept in memory.
+// Live inserts and deletes change a page's row count rather than shifting the
+// page boundaries, so page keys stay valid without re-selecting.
+// With setLocalRows() the model is instead a view of rows of an EventStore;
+// updateLocalRows() follows a change to the store with row inserts, removes
+// and dataChanged, like the live updates of a server window.
+class EventTableModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum Column {
+        EventIdColumn,
+        OriginTimeColumn,
+        MagnitudeColumn,
+        LatitudeColumn,
+        LongitudeColumn,
+        DepthColumn,
+        StrikeColumn,
+        DipColumn,
+        SlipColumn,
+        // Computed from the epicenter by RegionLookup, not stored
+        RegionColumn,
+        ColumnCount
+    };
+    
+    static constexpr int kPageSize = 256;
+    static constexpr int kMaxResidentPages = 32;
+    // More inserted plus removed rows than this and updateLocalRows() resets
+    static constexpr int kMaxLocalRowDiffs = 1000;
+    
+    explicit EventTableModel(DatabaseWorker *worker, QObject *parent = nullptr);
+    
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+    
+    void clear();
+    void setWindow(quint64 requestId, int totalRows, const QVector<EventKey> &anchors,
+                   const CatalogFilter &filter);
+    // Rows of store, which must outlive the view; nothing is fetched
+    void setLocalRows(const EventStore *store, const QVector<int> &rows);
+    // After the store changed: rows is the new list, newest first as from
+    // EventStore::rows(), and changedIds the events whose values changed
+    void updateLocalRows(const QVector<int> &rows, const QSet<int> &changedIds);
+    bool isLocal() const;
+    
+    // False when the row's page is not resident (a fetch is then queued)
+    bool eventAt(int row, SeismicEvent &event) const;
+
+private slots:
+    void onPageReady(quint64 requestId, int page, const QVector<SeismicEvent> &rows);
+    void onRowInserted(quint64 requestId, int row, const SeismicEvent &event, const EventKey &key);
+    void onRowUpdated(quint64 requestId, int row, const SeismicEvent &event);
+    void onRowRemoved(quint64 requestId, int row, int eventId);
+
+private:
+    struct Page {
+        QVector<SeismicEvent> rows;
+        quint64 lastUsed = 0;
+    };
+    
+    const SeismicEvent *rowPointer(int row) const;
+    int pageOf(int row) const;
+    void updatePageStarts();
+    void requestPage(int page) const;
+    void evictPages();
+    void touchPage(int page);
+    void emitPageChanged(int page);
+    
+    DatabaseWorker *m_worker;
+    quint64 m_requestId;
+    int m_totalRows;
+    // Page i holds m_pageCounts[i] rows starting at key m_anchors[i]
+    QVector<EventKey> m_anchors;
+    QVector<int> m_pageCounts;
+    QVector<int> m_pageStarts;
+    CatalogFilter m_filter;
+    
+    // Cache halaman; diakses dari data() yang const, jadi mutable
+    mutable QHash<int, Page> m_pages;
+    mutable QSet<int> m_requestedPages;
+    QSet<int> m_dirtyPages;
+    mutable quint64 m_useClock;
+    
+    const EventStore *m_store;
+    QVector<int> m_storeRows;
+    // (origin ms, id) of each local row, to diff against once the store
+    // rows have moved
+    QVector<QPair<qint64, int>> m_storeKeys;
+};
+
+#endif // EVENTTABLEMODEL_H
@@ -0,0 +1,77 @@
+#ifndef FOCALMECHANISM_H
+#define FOCALMECHANISM_H
+
+#include <QImage>
+#include <QPixmap>
+#include <QPointF>
+#include <QVector>
+#include <QtGlobal>
+
+// Double-couple source from strike/dip/rake (Aki & Richards convention,
+// degrees). Computes both nodal planes and the P, T and B axes, and draws the
+// lower-hemisphere equal-area (Schmidt) projection: every pixel is shaded by
+// the sign of the P-wave radiation pattern, nodal planes are drawn as their
+// projected great circles.
+class FocalMechanism {
+public:
+    struct NodalPlane {
+        double strike = 0.0;
+        double dip = 0.0;
+        double rake = 0.0;
+    };
+    
+    // Trend clockwise from north, plunge down from horizontal, degrees
+    struct Axis {
+        double trend = 0.0;
+        double plunge = 0.0;
+    };
+    
+    enum Theme {
+        // Black compressional quadrants on white, for dark panels
+        DarkTheme,
+        // Red on white with dark outlines, for the map
+        MapTheme,
+        kThemeCount
+    };
+    
+    FocalMechanism(double strike, double dip, double rake);
+    
+    NodalPlane plane1() const { return m_plane1; }
+    // The auxiliary plane: normal and slip of plane1 swapped
+    NodalPlane plane2() const { return m_plane2; }
+    Axis pAxis() const { return m_p; }
+    Axis tAxis() const { return m_t; }
+    Axis bAxis() const { return m_b; }
+    
+    // Positive (compression) where a ray leaving in direction (north, east,
+    // down) gets a first motion away from the source
+    double radiation(double north, double east, double down) const;
+    
+    // Beach ball of size x size pixels on a transparent background, 2x2
+    // supersampled. Safe to call from any thread
+    QImage render(int size, Theme theme = DarkTheme) const;
+    
+    // GUI thread only. render() through a cache keyed by (strike, dip, rake,
+    // size, theme, device pixel ratio); repeated calls are a lookup
+    static QPixmap pixmap(int strike, int dip, int rake, int size, Theme theme = DarkTheme,
+                          qreal devicePixelRatio = 1.0);
+    
+    // Equal-area position in the unit disc (x east, y south as on screen) of a
+    // lower-hemisphere direction
+    static QPointF project(double north, double east, double down);
+
+private:
+    static NodalPlane planeFrom(const double normal[3], const double slip[3]);
+    static Axis axisFrom(const double v[3]);
+    
+    NodalPlane m_plane1;
+    NodalPlane m_plane2;
+    Axis m_p;
+    Axis m_t;
+    Axis m_b;
+    // Fault normal and slip vector in (north, east, down)
+    double m_normal[3];
+    double m_slip[3];
+};
+
+#endif // FOCALMECHANISM_H
@@ -31,6 +31,7 @@ private:
     int m_depth;
     QString m_originTime;
     QString m_location;
+    QString m_nearestPlace;
     bool m_hasData;
 };
 
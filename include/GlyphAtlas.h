@@ -0,0 +1,91 @@
+#ifndef GLYPHATLAS_H
+#define GLYPHATLAS_H
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QPixmap>
+#include <QRectF>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include "FocalMechanism.h"
+
+// Beach-ball glyphs for the map layer, packed into shared atlas pages.
+// Mechanisms are quantized to kAngleStep degrees in strike, dip and rake so
+// similar ones share a glyph. Missing glyphs are rendered in batches on a
+// worker pool and copied into their slot on the GUI thread; a glyph is then a
+// sub-rect of a page pixmap, so thousands can be drawn with one
+// QPainter::drawPixmapFragments call per page.
+// All public methods must be called from the thread that owns the atlas.
+class GlyphAtlas : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int kAngleStep = 10;
+    
+    struct Glyph {
+        int page = -1;
+        // Device pixels within the page
+        QRectF source;
+    };
+    
+    explicit GlyphAtlas(int glyphSize, FocalMechanism::Theme theme = FocalMechanism::MapTheme,
+                        QObject *parent = nullptr);
+    ~GlyphAtlas();
+    
+    // Quantized mechanism key, never 0 (0 is free for "no mechanism")
+    static quint32 keyFor(int strike, int dip, int rake);
+    
+    // Logical size; pages hold glyphSize() * devicePixelRatio() pixel glyphs
+    int glyphSize() const;
+    qreal devicePixelRatio() const;
+    // Drops every glyph if the ratio changes; callers request them again
+    void setDevicePixelRatio(qreal ratio);
+    
+    // Schedules the keys that are neither rendered nor pending
+    void request(const QVector<quint32> &keys);
+    // False until the glyph has been rendered
+    bool glyph(quint32 key, Glyph *out) const;
+    const QPixmap &page(int index);
+    int pageCount() const;
+    int glyphCount() const;
+    void clear();
+
+signals:
+    void glyphsReady();
+
+private:
+    using CancelFlag = std::shared_ptr<std::atomic_bool>;
+    
+    struct Job {
+        quint32 key;
+        int slot;
+    };
+    
+    int allocateSlot();
+    QRect slotRect(int slot) const;
+    void startBatch(const QVector<Job> &batch);
+    void onBatchFinished(const QVector<Job> &batch, const QVector<QImage> &images,
+                         const CancelFlag &canceled);
+    
+    QThreadPool m_pool;
+    CancelFlag m_canceled;
+    int m_glyphSize;
+    FocalMechanism::Theme m_theme;
+    qreal m_devicePixelRatio;
+    int m_deviceSize;
+    int m_perRow;
+    
+    // Key -> slot, for pending and rendered glyphs alike
+    QHash<quint32, int> m_slots;
+    QVector<bool> m_slotReady;
+    int m_readyCount;
+    
+    QVector<QImage> m_pageImages;
+    QVector<QPixmap> m_pages;
+    QVector<bool> m_pageDirty;
+};
+
+#endif // GLYPHATLAS_H
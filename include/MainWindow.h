@@ -5,11 +5,14 @@
 #include <QTabWidget>
 #include <QSplitter>
 #include <QLabel>
+#include "SeismicEvent.h"
 
 class MenuBar;
 class MapView;
 class DatabaseView;
 class FocalMechanismWidget;
+class TraceWidget;
+class ArrivalWidget;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -27,6 +30,7 @@ private:
     void loadTheme(const QString &themeName);
     void animatePanelVisibility(bool show);
     void updateMainPanelHeight();
+    void updateBulletin(const QString &originTime, double lat, double lon, double magnitude, int depth);
 
     MenuBar *m_menuBar;
     QTabWidget *m_mainTabs;
@@ -35,7 +39,11 @@ private:
     QSplitter *m_overallSplitter;
     FocalMechanismWidget *m_focalMechWidget;
     MapView *m_mapView;
+    TraceWidget *m_traceWidget;
+    ArrivalWidget *m_arrivalWidget;
     DatabaseView *m_databaseView;
+    QLabel *m_coordinateLabel;
+    QLabel *m_bulletinText;
 
 private slots:
     void onTabChanged(int index);
@@ -43,6 +51,8 @@ private slots:
     void onThemeChanged(const QString &themeName);
     void onEventSelected(const QString &eventId, double lat, double lon, double magnitude,
                         int depth, int strike, int dip, int slip, const QString &eventInfo);
+    void onMapEventClicked(const SeismicEvent &event);
+    void onMapCursorMoved(double lat, double lon);
 };
 
 #endif // MAINWINDOW_H
@@ -7,27 +7,102 @@
 #include <QGraphicsPixmapItem>
 #include <QWheelEvent>
 #include <QMouseEvent>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "TileCache.h"
+#include "TileArchive.h"
+#include "SeismicEvent.h"
+#include "CatalogFilter.h"
+#include "WebMercator.h"
+#include "ArrivalEngine.h"
+#include "TravelTimeMap.h"
+
+class QGraphicsPathItem;
+class TileLoader;
+class EventLayer;
+class ArrivalLayer;
+class TravelTimeLayer;
+class GlyphAtlas;
 
 class MapView : public QGraphicsView {
     Q_OBJECT
 
 public:
     explicit MapView(QWidget *parent = nullptr);
+    ~MapView();
     
     void setMapDirectory(const QString &dirPath);
     void setZoomLevel(int level);
+    void setMaxZoomLevel(int level);
+    int zoomLevel() const;
+    void setTileMargin(int pixels);
+    void setTileCacheBudget(qint64 bytes);
+    TileCache::Stats tileCacheStats() const;
     void centerOnCoordinate(double lat, double lon);
+    void setEvents(const QVector<SeismicEvent> &events);
+    // Beach balls instead of dots for events with a focal mechanism
+    void setShowMechanisms(bool show);
+    // Stations and forecast points of the selected event
+    void setArrivals(const Arrivals &arrivals);
+    void clearArrivals();
+    // Tsunami isochrones of the selected event; an empty map clears them
+    void setTravelTimes(const TravelTimeMap &map);
+    CatalogFilter::GeoBox visibleBox() const;
+    void clearRegion();
+
+signals:
+    void eventClicked(const SeismicEvent &event);
+    void cursorCoordinateChanged(double lat, double lon);
+    // Debounced; emitted once panning or zooming settles
+    void viewportChanged(const CatalogFilter::GeoBox &view);
+    // Ctrl+click adds a vertex, double-click closes the region, Esc clears it.
+    // Points are (longitude, latitude); empty when the region was cleared.
+    void regionChanged(const QVector<QPointF> &polygon);
 
 protected:
     void wheelEvent(QWheelEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+
+private slots:
+    void onTileDecoded(quint64 key, const QImage &image);
+    void onTileFailed(quint64 key);
+    void onFadeTick();
 
 private:
+    struct TileFade {
+        QGraphicsPixmapItem *item;
+        qint64 startMs;
+        // Non-null for a sharpening overlay: on completion its pixmap is moved
+        // into target and the overlay item is deleted
+        QGraphicsPixmapItem *target;
+    };
+    
     void loadTiles();
     void updateVisibleTiles();
+    void updateZoomLevelFromScale();
+    void switchZoomLevel(int level);
+    int levelForScale(double scale) const;
+    double nativeScaleForLevel(int level) const;
     QString getTilePath(int zoom, int x, int y);
+    QRectF tileRect(int zoom, int x, int y) const;
+    QPixmap placeholderPixmap(int zoom, int x, int y);
+    QGraphicsPixmapItem *createTileItem(quint64 key, const QPixmap &cached);
+    void removeTileItem(QGraphicsPixmapItem *item);
+    void clearBackdrop();
+    void startFade(QGraphicsPixmapItem *item, QGraphicsPixmapItem *target = nullptr);
+    int tilePriority(int zoom, int x, int y, const QPointF &viewCenter) const;
+    void updateRegionItem();
+    void updateDevicePixelRatio();
     
     QGraphicsScene *m_scene;
     QString m_mapDirectory;
@@ -35,10 +110,48 @@ private:
     int m_maxZoom;
     double m_scale;
     
+    // World extent in scene coordinates (ukuran world.png), tetap untuk semua zoom level
+    QPixmap m_basePixmap;
+    QRectF m_worldRect;
+    WebMercator m_projection;
+    int m_tilePixelWidth;
+    int m_tileMargin;
+    
     bool m_isPanning;
     QPoint m_lastPanPoint;
+    QPoint m_pressPos;
+    
+    EventLayer *m_eventLayer;
+    ArrivalLayer *m_arrivalLayer;
+    TravelTimeLayer *m_travelTimeLayer;
+    GlyphAtlas *m_glyphAtlas;
+    // Follows the window to other screens for the glyph device pixel ratio
+    QMetaObject::Connection m_screenConnection;
+    int m_hoverEvent;
+    QTimer m_viewportTimer;
+    
+    // Region being drawn or closed, in geographic coordinates
+    QVector<QPointF> m_regionPoints;
+    bool m_regionClosed;
+    QGraphicsPathItem *m_regionItem;
+    
+    // Hanya tile yang terlihat (viewport + margin) yang ada di scene
+    QHash<quint64, QGraphicsPixmapItem*> m_tileItems;
+    
+    // Tiles of the previous level, kept underneath while the new level fades in
+    QList<QGraphicsPixmapItem*> m_backdropItems;
+    QList<TileFade> m_fades;
+    QTimer m_fadeTimer;
+    QElapsedTimer m_fadeClock;
+    
+    // Decoded pixmaps survive zoom changes; missing tiles are remembered so
+    // they are not looked up on disk again
+    TileCache m_pixmapCache;
+    QSet<quint64> m_missingTiles;
+    TileLoader *m_tileLoader;
     
-    QMap<QString, QGraphicsPixmapItem*> m_tileCache;
+    // Packed world.tiles bila tersedia; loose world<quadkey>.png sebagai fallback
+    TileArchive m_archive;
 };
 
 #endif // MAPVIEW_H
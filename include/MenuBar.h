@@ -13,6 +13,7 @@ public:
     QAction *actionOpenFile;
     QAction *actionSaveSettings;
     QAction *actionToggleFullscreen;
+    QAction *actionShowMechanisms;
     QAction *actionAbout;
 
     QActionGroup *themeGroup;
@@ -0,0 +1,68 @@
+#ifndef MINMAXPYRAMID_H
+#define MINMAXPYRAMID_H
+
+#include <QtGlobal>
+#include <QVector>
+
+// Multi-resolution min/max envelope of one waveform channel, for drawing
+// traces at any zoom in O(columns) instead of O(samples). Level 0 folds
+// kBaseBucket samples per bucket, each level above folds kFanout buckets of
+// the one below; a day at 100 Hz is ~540k level-0 buckets and a few dozen at
+// the top. Samples are appended incrementally (the 16-sample leaf reduction is
+// SSE2 where available) and addressed by absolute sample index like
+// SampleRing. Each level keeps historySamples worth of buckets; its storage
+// grows with the data up to that, so an idle channel costs next to nothing.
+//
+// Not thread-safe: one owner appends and queries.
+class MinMaxPyramid {
+public:
+    static constexpr int kBaseBucket = 16;
+    static constexpr int kFanout = 4;
+    
+    explicit MinMaxPyramid(quint64 historySamples);
+    
+    // Samples first .. first + count - 1; a jump past sampleCount() leaves an
+    // empty gap, anything before it is ignored
+    void append(quint64 first, const float *samples, int count);
+    void clear();
+    
+    // Index one past the newest sample
+    quint64 sampleCount() const;
+    // Oldest sample still summarized
+    quint64 firstSample() const;
+    int levelCount() const;
+    quint64 bucketSamples(int level) const;
+    // Coarsest level whose buckets still fit in samplesPerColumn
+    int levelFor(double samplesPerColumn) const;
+    
+    // Envelope of columns 0 .. columns - 1, column c covering samples
+    // [first + c * samplesPerColumn, first + (c + 1) * samplesPerColumn).
+    // Columns without data get min > max. Returns the level used
+    int envelope(double first, double samplesPerColumn, int columns,
+                 float *columnMin, float *columnMax) const;
+
+private:
+    struct Level {
+        // Circular by bucket index; capacity is a multiple of kFanout so the
+        // children of one parent are always contiguous. min and max hold the
+        // slots up to the highest one written, slots beyond them are empty
+        QVector<float> min;
+        QVector<float> max;
+        int capacity = 0;
+        quint64 count = 0;
+        
+        void growTo(int slot);
+    };
+    
+    void skipTo(quint64 sample);
+    void pushBucket(int level, float low, float high);
+    
+    quint64 m_history;
+    QVector<Level> m_levels;
+    quint64 m_samples;
+    // Running envelope of the incomplete level-0 bucket
+    float m_partialMin;
+    float m_partialMax;
+};
+
+#endif // MINMAXPYRAMID_H
@@ -0,0 +1,86 @@
+#ifndef MINISEEDARCHIVE_H
+#define MINISEEDARCHIVE_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+#include <vector>
+#include "MiniSeedFile.h"
+
+// Station archive of miniSEED files (an SDS tree, a day-file directory, or a
+// single file), indexed per NET.STA.LOC.CHA stream by record start time so a
+// time window decodes only the records that overlap it. Files stay mapped;
+// nothing is decoded until read().
+//
+// Tailing: refresh() indexes records appended to the open files since the
+// last call (and, when asked, files that appeared in the directory) and
+// returns their samples.
+//
+// Not thread-safe; const members may run concurrently with each other.
+class MiniSeedArchive {
+public:
+    struct Segment {
+        QString id;
+        double sampleRate = 0.0;
+        qint64 startNs = 0;
+        QVector<float> samples;
+        
+        qint64 endNs() const;
+    };
+    
+    MiniSeedArchive();
+    ~MiniSeedArchive();
+    
+    // Files that are not miniSEED are skipped; false only if none is
+    bool open(const QString &path);
+    void close();
+    QString errorString() const;
+    
+    int fileCount() const;
+    int recordCount() const;
+    QStringList streamIds() const;
+    bool timeSpan(const QString &id, qint64 *startNs, qint64 *endNs) const;
+    
+    // Samples of id in [startNs, endNs), cut to the window and merged into
+    // contiguous segments; records that fail to decode are left out as gaps
+    QVector<Segment> read(const QString &id, qint64 startNs, qint64 endNs, QString *error = nullptr) const;
+    
+    QVector<Segment> refresh(bool rescanDirectory = false);
+
+private:
+    struct Entry {
+        qint64 startNs;
+        qint64 endNs;
+        int stream;
+        int file;
+        int record;
+    };
+    
+    struct Stream {
+        QString id;
+        // Sorted by startNs
+        QVector<Entry> entries;
+        qint64 longestNs = 0;
+    };
+    
+    // Both return the entries they indexed
+    QVector<Entry> addFile(const QString &path);
+    // Records [from, recordCount) of file
+    QVector<Entry> indexRecords(int file, int from);
+    // Appends the entry's samples inside [startNs, endNs) to segments
+    bool appendSamples(const Entry &entry, const QString &id, qint64 startNs, qint64 endNs,
+                       QVector<Segment> *segments, QString *error) const;
+    
+    QString m_path;
+    std::vector<std::unique_ptr<MiniSeedFile>> m_files;
+    QSet<QString> m_fileNames;
+    QVector<Stream> m_streams;
+    QHash<QString, int> m_streamIndex;
+    int m_recordCount;
+    QString m_error;
+};
+
+#endif // MINISEEDARCHIVE_H
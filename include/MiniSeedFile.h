@@ -0,0 +1,104 @@
+#ifndef MINISEEDFILE_H
+#define MINISEEDFILE_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QtGlobal>
+
+// One miniSEED file (format 2 with blockette 1000, or format 3), memory-mapped
+// and read in place. open() walks only the fixed record headers to build a
+// record index; sample data is decoded on request straight from the mapping
+// (Steim1, Steim2, int16, int32, float32, float64). A header is only taken
+// when its blockette and data offsets and sample count fit the record length
+// it claims and no other record starts inside that span; format 3 records
+// must also match their CRC.
+//
+// Streaming: refresh() picks up records appended to a growing file since the
+// last open()/refresh(); a record still being written is left for the next
+// call, unless the file stops growing for kStallMs without completing it, in
+// which case its header is taken as corrupt and skipped. Times are UTC
+// nanoseconds since the epoch.
+//
+// Const members may be called from several threads; open(), close() and
+// refresh() may not run concurrently with anything else.
+class MiniSeedFile {
+public:
+    enum Encoding {
+        Int16 = 1,
+        Int32 = 3,
+        Float32 = 4,
+        Float64 = 5,
+        Steim1 = 10,
+        Steim2 = 11
+    };
+    
+    struct Record {
+        qint64 offset = 0;
+        quint32 length = 0;
+        // Index into streamIds()
+        int stream = -1;
+        qint64 startNs = 0;
+        double sampleRate = 0.0;
+        int sampleCount = 0;
+        // Payload, relative to offset
+        quint32 dataOffset = 0;
+        quint32 dataLength = 0;
+        quint8 encoding = 0;
+        bool bigEndian = true;
+        
+        // One sample period past the last sample
+        qint64 endNs() const;
+    };
+    
+    static constexpr int kStallMs = 10000;
+    
+    MiniSeedFile();
+    ~MiniSeedFile();
+    
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const;
+    QString errorString() const;
+    QString fileName() const;
+    
+    // Indexes records appended since the last call; returns how many
+    int refresh();
+    
+    int recordCount() const;
+    const Record &record(int index) const;
+    // NET.STA.LOC.CHA of every stream seen, in order of appearance
+    QStringList streamIds() const;
+    
+    // Decodes the record's samples into out (room for record.sampleCount);
+    // returns the number written, or -1 with a reason
+    int decode(const Record &record, float *out, QString *error = nullptr) const;
+    
+    // Exposed for the benchmark and for other containers of Steim frames:
+    // decodes count samples from frames (a multiple of 64 bytes)
+    static int decodeSteim(const uchar *frames, int length, int count, bool steim2,
+                           float *out, QString *error = nullptr);
+
+private:
+    // 0 when more bytes are needed, -1 when data at offset is not a record
+    int parseRecord(qint64 offset, Record *record);
+    // Where to look for a record after junk at offset
+    qint64 nextCandidate(qint64 offset) const;
+    bool remap();
+    
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_size;
+    // Everything before this is indexed
+    qint64 m_scanned;
+    // Incomplete record at m_scanned, waiting since the file was last this size
+    QElapsedTimer m_pendingSince;
+    qint64 m_pendingSize;
+    QVector<Record> m_records;
+    QStringList m_streamIds;
+    QString m_error;
+};
+
+#endif // MINISEEDFILE_H
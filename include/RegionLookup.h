@@ -0,0 +1,81 @@
+#ifndef REGIONLOOKUP_H
+#define REGIONLOOKUP_H
+
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <QVector>
+
+// Offline reverse geocoding for epicenters: Flinn-Engdahl style region names
+// from a compact polygon set, and the nearest named place with distance and
+// azimuth. Polygons and places are bucketed on a one-degree grid, so a lookup
+// only tests the few candidates of one cell (microseconds, no allocation).
+// Read-only after load(), safe to share between threads.
+class RegionLookup {
+public:
+    struct Nearest {
+        QString name;
+        double distanceKm = -1.0;
+        // From the place to the point, degrees clockwise from north
+        double azimuth = 0.0;
+        
+        bool isValid() const { return distanceKm >= 0.0; }
+    };
+    
+    // Dataset format is described in data/regions.txt
+    bool load(const QString &path, QString *error = nullptr);
+    bool isEmpty() const;
+    int regionCount() const;
+    int placeCount() const;
+    
+    // The bundled dataset (:/data/regions.txt), loaded on first use
+    static const RegionLookup &shared();
+    
+    // Smallest region containing the point, empty outside every polygon
+    QString region(double lat, double lon) const;
+    // Invalid if no place is within maxKm
+    Nearest nearestPlace(double lat, double lon, double maxKm = 500.0) const;
+    // Region name, else "123 km SW of Padang", else the coordinates
+    QString describe(double lat, double lon) const;
+    
+    // "45 km SW of Padang"
+    static QString relativeTo(const Nearest &nearest);
+    // 16-point compass name of an azimuth, "N", "NNE", ...
+    static QString compassPoint(double azimuth);
+
+private:
+    struct Polygon {
+        QString name;
+        QRectF bounds;
+        int firstVertex;
+        int vertexCount;
+        double area;
+    };
+    
+    struct Place {
+        QString name;
+        double latitude;
+        double longitude;
+    };
+    
+    void buildIndex();
+    bool cellOf(double lat, double lon, int *row, int *col) const;
+    bool contains(const Polygon &polygon, double lat, double lon) const;
+    
+    // Sorted by area, smallest first, so the first hit is the most specific
+    QVector<Polygon> m_polygons;
+    // x = longitude, y = latitude
+    QVector<QPointF> m_vertices;
+    QVector<Place> m_places;
+    
+    // Grid over m_bounds; cell i lists m_*Items[m_*Start[i] .. m_*Start[i + 1])
+    QRectF m_bounds;
+    int m_rows = 0;
+    int m_cols = 0;
+    QVector<int> m_polygonStart;
+    QVector<int> m_polygonItems;
+    QVector<int> m_placeStart;
+    QVector<int> m_placeItems;
+};
+
+#endif // REGIONLOOKUP_H
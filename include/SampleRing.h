@@ -0,0 +1,46 @@
+#ifndef SAMPLERING_H
+#define SAMPLERING_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+
+// Lock-free ring of waveform samples for one channel: a single producer (the
+// ingest thread) appends, any number of readers copy out concurrently without
+// blocking it. Samples are addressed by their absolute index since the ring
+// was created; a reader keeps its own cursor and only ever loses samples it
+// fell more than capacity() behind on.
+//
+// Readers validate a copy seqlock-style: the producer announces the range it
+// is about to overwrite before writing, and a reader drops whatever part of
+// its copy that range reached.
+class SampleRing {
+public:
+    // Capacity is rounded up to a power of two
+    explicit SampleRing(int capacity);
+    
+    int capacity() const;
+    
+    // Producer only. Appends count samples and advances head() by count; more
+    // than capacity() keeps only the last ones
+    void append(const float *samples, int count);
+    
+    // Index one past the newest sample (the number ever appended)
+    quint64 head() const;
+    // Index of the oldest sample still held
+    quint64 tail() const;
+    
+    // Any thread. Copies up to maxCount samples starting at index from, or at
+    // the oldest one still held if from has been overwritten. Returns the
+    // number copied; *first receives the index of out[0].
+    int read(quint64 from, float *out, int maxCount, quint64 *first) const;
+
+private:
+    std::unique_ptr<std::atomic<float>[]> m_samples;
+    quint64 m_mask;
+    // Published end of the data, and end of the range being written
+    std::atomic<quint64> m_head;
+    std::atomic<quint64> m_reserved;
+};
+
+#endif // SAMPLERING_H
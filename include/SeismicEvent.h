@@ -0,0 +1,25 @@
+#ifndef SEISMICEVENT_H
+#define SEISMICEVENT_H
+
+#include <QDateTime>
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+
+// One row of sumber_tsunami, shared by the catalog views and map layers
+struct SeismicEvent {
+    int id = 0;
+    QString eventId;
+    QDateTime originTime;
+    double magnitude = 0.0;
+    double latitude = 0.0;
+    double longitude = 0.0;
+    int depth = 0;
+    int strike = 0;
+    int dip = 0;
+    int slip = 0;
+};
+
+Q_DECLARE_METATYPE(SeismicEvent)
+
+#endif // SEISMICEVENT_H
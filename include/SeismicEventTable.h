@@ -8,6 +8,9 @@
 #include <QPushButton>
 #include <QLineEdit>
 #include <QLabel>
+#include "ConnectionPool.h"
+
+class QTimer;
 
 class SeismicEventTable : public QWidget {
     Q_OBJECT
@@ -28,12 +31,14 @@ private:
 
     QTableView *m_tableView;
     QSqlTableModel *m_model;
+    ConnectionPool::Lease m_lease;
     QSqlDatabase m_database;
     
     QPushButton *m_refreshButton;
     QPushButton *m_addButton;
     QPushButton *m_deleteButton;
     QLineEdit *m_searchBox;
+    QTimer *m_searchTimer;
     QLabel *m_statusLabel;
 
 private slots:
@@ -41,6 +46,7 @@ private slots:
     void onAddClicked();
     void onDeleteClicked();
     void onSearchTextChanged(const QString &text);
+    void onSearchTimeout();
     void onRowClicked(const QModelIndex &index);
 
 signals:
@@ -0,0 +1,68 @@
+#ifndef STATEMENTCACHE_H
+#define STATEMENTCACHE_H
+
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+#include <functional>
+#include <memory>
+
+// Named server-side prepared statements for one connection. Each statement is
+// prepared on first use and its QSqlQuery reused afterwards, so PostgreSQL
+// parses it once per connection. Not thread-safe; lives with its connection.
+class StatementCache {
+public:
+    struct Stats {
+        QString name;
+        int calls = 0;
+        qint64 prepareUs = 0;
+        qint64 lastUs = 0;
+        qint64 totalUs = 0;
+        qint64 maxUs = 0;
+    };
+    
+    StatementCache();
+    
+    // Drops all prepared statements; they belong to the previous connection
+    void setDatabase(const QSqlDatabase &db);
+    
+    // Parameters are positional '?' placeholders; cast them in the SQL
+    // (?::timestamptz, ?::real) so the server plans with the right types
+    void add(const QString &name, const QString &sql, bool forwardOnly = true);
+    bool contains(const QString &name) const;
+    
+    // Binds values, executes and hands the active query to consume. Timing
+    // covers execution and whatever fetching consume does.
+    bool run(const QString &name, const QVariantList &values,
+             const std::function<void(QSqlQuery &)> &consume);
+    
+    // EXPLAIN (ANALYZE, BUFFERS) of a registered statement with the given values
+    QString explain(const QString &name, const QVariantList &values);
+    
+    QString lastError() const;
+    QVector<Stats> stats() const;
+    
+    // Replaces each '?' in sql with the driver-quoted literal of the next value,
+    // for places that can only take a filter string (QSqlTableModel)
+    static QString inlineValues(const QSqlDatabase &db, const QString &sql,
+                                const QVariantList &values);
+
+private:
+    struct Statement {
+        QString sql;
+        bool forwardOnly = true;
+        std::unique_ptr<QSqlQuery> query;
+        Stats stats;
+    };
+    
+    Statement *prepared(const QString &name);
+    
+    QSqlDatabase m_db;
+    QHash<QString, std::shared_ptr<Statement>> m_statements;
+    QString m_lastError;
+};
+
+#endif // STATEMENTCACHE_H
@@ -0,0 +1,62 @@
+#ifndef TILEARCHIVE_H
+#define TILEARCHIVE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+
+// Single-file tile pyramid ("world.tiles"). Layout, all little-endian:
+//   header  : magic "TSTILES1", u32 version, u32 tileCount, u32 maxZoom,
+//             u32 reserved, u64 indexOffset
+//   index   : tileCount x { u64 key, u64 offset, u32 length, u32 reserved },
+//             sorted by key (TileCache::key of the tile's quadkey)
+//   payload : the original PNG bytes, back to back
+// The file is memory-mapped and tile bytes are returned without copying.
+class TileArchive {
+public:
+    // Deepest zoom level packed or shown; TileCache::key has room for more,
+    // but the map has no use for it
+    static constexpr int kMaxZoom = 20;
+    
+    TileArchive();
+    ~TileArchive();
+    
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const;
+    QString errorString() const;
+    
+    int tileCount() const;
+    int maxZoom() const;
+    bool contains(quint64 key) const;
+    
+    // Raw (still encoded) tile bytes backed by the mapping; only valid while
+    // the archive stays open. Safe to call from any thread.
+    QByteArray tileData(quint64 key) const;
+    
+    // Packs world.png and world<quadkey>.png from a loose tile directory
+    static bool build(const QString &tileDir, const QString &archivePath, QString *error = nullptr);
+    // False for anything but digits 0-3, or deeper than kMaxZoom
+    static bool parseQuadKey(const QString &quadKey, int *zoom, int *x, int *y);
+
+private:
+    struct IndexEntry {
+        quint64 key;
+        quint64 offset;
+        quint32 length;
+        quint32 reserved;
+    };
+    
+    const IndexEntry *findEntry(quint64 key) const;
+    
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_size;
+    const IndexEntry *m_index;
+    int m_tileCount;
+    int m_maxZoom;
+    QString m_error;
+};
+
+#endif // TILEARCHIVE_H
@@ -0,0 +1,50 @@
+#ifndef TILECACHE_H
+#define TILECACHE_H
+
+#include <QCache>
+#include <QPixmap>
+#include <QtGlobal>
+
+// LRU cache of decoded tile pixmaps shared by all zoom levels. Cost is
+// accounted in bytes, so the budget bounds pixmap memory rather than tile count.
+class TileCache {
+public:
+    struct Stats {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 evictions = 0;
+        qint64 bytes = 0;
+        int tiles = 0;
+    };
+    
+    explicit TileCache(qint64 budgetBytes = 128 * 1024 * 1024);
+    
+    // Packed (zoom, x, y): 6 bits zoom, 29 bits each for x and y
+    static quint64 key(int zoom, int x, int y) {
+        return (quint64(zoom) << 58) | (quint64(x) << 29) | quint64(y);
+    }
+    static int zoomOf(quint64 key) { return int(key >> 58); }
+    static int xOf(quint64 key) { return int((key >> 29) & 0x1FFFFFFF); }
+    static int yOf(quint64 key) { return int(key & 0x1FFFFFFF); }
+    
+    // Returns a null pixmap on miss. A hit marks the tile as most recently used.
+    QPixmap find(quint64 key);
+    bool contains(quint64 key) const;
+    void insert(quint64 key, const QPixmap &pixmap);
+    void clear();
+    
+    void setBudget(qint64 budgetBytes);
+    qint64 budget() const;
+    Stats stats() const;
+    void resetStats();
+
+private:
+    static qint64 pixmapBytes(const QPixmap &pixmap);
+    
+    QCache<quint64, QPixmap> m_cache;
+    quint64 m_hits;
+    quint64 m_misses;
+    quint64 m_evictions;
+};
+
+#endif // TILECACHE_H
@@ -0,0 +1,64 @@
+#ifndef TILELOADER_H
+#define TILELOADER_H
+
+#include <QObject>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+
+class TileArchive;
+
+// Decodes map tiles on a worker pool and hands the QImage back to the GUI thread.
+// All public methods must be called from the thread that owns the loader.
+class TileLoader : public QObject {
+    Q_OBJECT
+
+public:
+    explicit TileLoader(QObject *parent = nullptr);
+    ~TileLoader();
+    
+    // Tiles present in the archive are decoded straight from its mapping; the
+    // loose file path passed to request() is the fallback. Waits for running
+    // jobs, so the previous archive may be closed once this returns.
+    void setArchive(const TileArchive *archive);
+    
+    // Higher priority is decoded first. Requesting a pending key again only
+    // updates its priority.
+    void request(quint64 key, const QString &path, int priority);
+    void cancel(quint64 key);
+    void cancelAll();
+    bool isPending(quint64 key) const;
+    int pendingCount() const;
+
+signals:
+    void tileDecoded(quint64 key, const QImage &image);
+    void tileFailed(quint64 key);
+
+private:
+    using CancelFlag = std::shared_ptr<std::atomic_bool>;
+    
+    struct Job {
+        quint64 key;
+        QString path;
+        int priority;
+        CancelFlag canceled;
+    };
+    
+    void decodeNext();
+    void onJobFinished(quint64 key, const CancelFlag &canceled, const QImage &image);
+    
+    QThreadPool m_pool;
+    const TileArchive *m_archive;
+    QHash<quint64, CancelFlag> m_pending;
+    
+    // Antrian dibagi dengan worker thread, dilindungi m_queueMutex
+    QMutex m_queueMutex;
+    QList<Job> m_queue;
+};
+
+#endif // TILELOADER_H
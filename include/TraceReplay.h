@@ -0,0 +1,82 @@
+#ifndef TRACEREPLAY_H
+#define TRACEREPLAY_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include "WaveformChannel.h"
+
+class QTimer;
+class MiniSeedArchive;
+
+// Waveform feed for the trace view, streaming into per-channel SampleRings.
+// Lives on its own thread; slots are invoked queued.
+//
+// start() replays recorded traces at the rate they were recorded, as if they
+// were arriving now. Reads miniSEED and the IRIS ASCII timeseries formats
+// (SLIST and TSPAIR; one file may hold several segments):
+//   TIMESERIES IU_ANMO_00_BHZ_M, 1200 samples, 20 sps, 2024-01-01T00:00:00.000000, SLIST, FLOAT, COUNTS
+//
+// follow() tails a miniSEED archive that a data logger or SeedLink client is
+// writing: the last few minutes are loaded at once, then records stream in
+// as they are appended, in their real time.
+class TraceReplay : public QObject {
+    Q_OBJECT
+
+public:
+    struct Recording {
+        QString id;
+        double sampleRate = 0.0;
+        qint64 startMs = 0;
+        QVector<float> samples;
+    };
+    
+    explicit TraceReplay(QObject *parent = nullptr);
+    ~TraceReplay();
+    
+    // Appends the recordings in path to out; segments of the same channel are
+    // concatenated, gaps closed. False with a reason if the file cannot be used
+    static bool readFile(const QString &path, QVector<Recording> *out, QString *error);
+
+public slots:
+    // Replays every trace file in directory, speed times real time, from the
+    // beginning again at the end when loop is set
+    void start(const QString &directory, double speed, bool loop);
+    void follow(const QString &directory);
+    void stop();
+
+signals:
+    // Every (re)start; the rings stay valid for as long as a receiver holds them
+    void channelsChanged(const QVector<WaveformChannel> &channels);
+    void replayFailed(const QString &error);
+
+private:
+    struct Stream {
+        WaveformChannel channel;
+        // Replay: the whole recording and how much of it went out
+        QVector<float> samples;
+        quint64 position = 0;
+        // Follow: time of the next sample the ring expects
+        qint64 nextNs = 0;
+    };
+    
+    static bool readAscii(const QString &path, QVector<Recording> *out, QString *error);
+    static WaveformChannel makeChannel(const QString &id, double sampleRate, qint64 startMs);
+    void startTicking();
+    QVector<WaveformChannel> channels() const;
+    void onTick();
+    // Follow mode: appends a segment to its stream, adding the stream if new
+    bool pushSegment(const QString &id, double sampleRate, qint64 startNs, const QVector<float> &samples);
+    
+    QTimer *m_timer;
+    QElapsedTimer m_clock;
+    double m_speed;
+    bool m_loop;
+    QVector<Stream> m_streams;
+    std::unique_ptr<MiniSeedArchive> m_archive;
+    int m_ticksSinceRescan;
+};
+
+#endif // TRACEREPLAY_H
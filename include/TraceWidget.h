@@ -0,0 +1,80 @@
+#ifndef TRACEWIDGET_H
+#define TRACEWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include "MinMaxPyramid.h"
+#include "WaveformChannel.h"
+
+class TraceReplay;
+
+// Live helicorder-style view of every waveform channel, one row each, newest
+// data at the right edge. A 60 fps frame timer pulls only the samples that
+// arrived since the last frame from each channel's SampleRing (never waiting
+// on the ingest thread) into a per-channel MinMaxPyramid holding a day of
+// history. Each repaint asks the pyramid level matching the zoom for one
+// envelope per pixel column and writes the spans straight into a QImage, so a
+// frame costs O(pixels) whether the window is a second or a day. Windows
+// finer than the pyramid's base bucket are folded from the raw ring samples.
+//
+// The mouse wheel zooms. The feed is a TraceReplay running on its own thread.
+class TraceWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    // Envelope history kept per channel
+    static constexpr int kHistorySeconds = 24 * 3600;
+    
+    explicit TraceWidget(QWidget *parent = nullptr);
+    ~TraceWidget();
+    
+    // Streams the trace files in directory as live channels
+    void replayDirectory(const QString &directory, double speed = 1.0);
+    // Tails the miniSEED archive under directory as it is written
+    void followDirectory(const QString &directory);
+    // Time span across the widget, 1 s up to kHistorySeconds
+    void setWindowSeconds(double seconds);
+    double windowSeconds() const;
+    QVector<WaveformChannel> channels() const;
+
+public slots:
+    void setChannels(const QVector<WaveformChannel> &channels);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+
+private:
+    struct Trace {
+        WaveformChannel channel;
+        // Next ring index to read
+        quint64 cursor = 0;
+        MinMaxPyramid pyramid{0};
+    };
+    
+    void onFrame();
+    void ingest(Trace &trace);
+    // Fills m_columnMin/m_columnMax from the ring; false if it no longer
+    // holds the start of the window
+    bool rawEnvelope(const Trace &trace, double first, double samplesPerColumn, int columns);
+    void renderFrame();
+    
+    QThread m_replayThread;
+    TraceReplay *m_replay;
+    QString m_replayError;
+    
+    QVector<Trace> m_traces;
+    QTimer m_frameTimer;
+    double m_windowSeconds;
+    QVector<float> m_scratch;
+    QVector<float> m_columnMin;
+    QVector<float> m_columnMax;
+    
+    QImage m_frame;
+    double m_frameMs;
+};
+
+#endif // TRACEWIDGET_H
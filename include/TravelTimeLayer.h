@@ -0,0 +1,44 @@
+#ifndef TRAVELTIMELAYER_H
+#define TRAVELTIMELAYER_H
+
+#include <QGraphicsItem>
+#include <QColor>
+#include <QPainterPath>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+#include "TravelTimeMap.h"
+#include "WebMercator.h"
+
+// Scene layer with the tsunami isochrones of the selected event, colored
+// like the forecast points of ArrivalLayer and labeled with their time.
+// Lines are projected once per map and drawn with a cosmetic pen.
+class TravelTimeLayer : public QGraphicsItem {
+public:
+    explicit TravelTimeLayer(const QRectF &worldRect, QGraphicsItem *parent = nullptr);
+    
+    void setWorldRect(const QRectF &worldRect);
+    void setTravelTimes(const TravelTimeMap &map);
+    void clear();
+    
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    struct Isochrone {
+        float seconds;
+        QColor color;
+        QPainterPath path;
+        // Middle of the longest line, in scene coordinates
+        QPointF labelPosition;
+    };
+    
+    void project();
+    
+    QRectF m_worldRect;
+    WebMercator m_projection;
+    TravelTimeMap m_map;
+    QVector<Isochrone> m_isochrones;
+};
+
+#endif // TRAVELTIMELAYER_H
@@ -0,0 +1,83 @@
+#ifndef TRAVELTIMEMAP_H
+#define TRAVELTIMEMAP_H
+
+#include <QMetaType>
+#include <QPointF>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <functional>
+
+class BathymetryGrid;
+
+// Tsunami travel times from one source to every sea cell of a bathymetry
+// grid, plus isochrones traced from them
+struct TravelTimeMap {
+    struct Isochrone {
+        float seconds = 0.0f;
+        // Polylines in degrees: x longitude, y latitude
+        QVector<QVector<QPointF>> lines;
+    };
+    
+    QString eventId;
+    double latitude = 0.0;
+    double longitude = 0.0;
+    
+    // Same cells as the grid: row 0 north, centre of the north-west cell
+    int columns = 0;
+    int rows = 0;
+    double north = 0.0;
+    double west = 0.0;
+    double cellSize = 0.0;
+    // Seconds after origin, row-major; NaN on land and where the wave never gets
+    QVector<float> seconds;
+    
+    QVector<Isochrone> isochrones;
+    double elapsedMs = 0.0;
+    
+    bool isEmpty() const;
+    // Bilinear over the sea corners of the cell; a point on land takes the
+    // nearest sea cell within a few cells, otherwise NaN
+    float timeAt(double lat, double lon) const;
+};
+
+Q_DECLARE_METATYPE(TravelTimeMap)
+
+// Eikonal solver for the shallow-water wave: |grad T| = 1 / sqrt(g*h) on the
+// grid's own cells, first-order upwind, with land as a barrier so the front
+// bends around islands and through straits.
+//
+// Fast sweeping in 32x32 cell tiles. A tile sweeps until it settles and then
+// wakes the neighbours whose border it changed, so only tiles near the
+// moving front do work, roughly in arrival order. Tiles are coloured in a
+// 2x2 pattern; tiles of one colour never touch and run in parallel on the
+// pool. arrival_benchmark <grid> times solves on a real grid.
+//
+// The slowness field is derived from the grid once per setGrid(). Not
+// thread-safe; one solve() at a time.
+class TravelTimeSolver {
+public:
+    TravelTimeSolver();
+    ~TravelTimeSolver();
+    
+    // Not owned, may be null
+    void setGrid(const BathymetryGrid *grid);
+    bool hasGrid() const;
+    
+    // canceled is polled between sweeps; a canceled solve returns an empty map
+    TravelTimeMap solve(double lat, double lon, QString *error = nullptr,
+                        const std::function<bool()> &canceled = {});
+
+private:
+    void prepare();
+    
+    const BathymetryGrid *m_grid;
+    // s/km, +inf on land
+    QVector<float> m_slowness;
+    // Cell width in km per row; cell height is the same everywhere
+    QVector<double> m_cellWidthKm;
+    double m_cellHeightKm;
+    QThreadPool m_pool;
+};
+
+#endif // TRAVELTIMEMAP_H
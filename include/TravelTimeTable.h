@@ -0,0 +1,49 @@
+#ifndef TRAVELTIMETABLE_H
+#define TRAVELTIMETABLE_H
+
+#include <QString>
+#include <QVector>
+
+// First-arrival seismic travel times, tabulated over epicentral distance and
+// source depth and interpolated bilinearly. A batch lookup blends the two
+// depth rows around the source once and then only interpolates in distance,
+// so thousands of stations cost a few microseconds.
+// Read-only after load(), safe to share between threads.
+class TravelTimeTable {
+public:
+    enum Phase {
+        P = 0,
+        S = 1,
+        PhaseCount
+    };
+    
+    // Dataset format is described in data/traveltimes.txt
+    bool load(const QString &path, QString *error = nullptr);
+    bool isEmpty() const;
+    double maxDistance() const;
+    double maxDepth() const;
+    
+    // The bundled iasp91 tables (:/data/traveltimes.txt), loaded on first use
+    static const TravelTimeTable &shared();
+    
+    // Seconds after origin; NaN past the last distance. Depths outside the
+    // table are clamped to it.
+    double time(Phase phase, double distanceDegrees, double depthKm) const;
+    // out[i] = time(phase, distanceDegrees[i], depthKm)
+    void times(Phase phase, double depthKm, const float *distanceDegrees, int count, float *out) const;
+    
+    static const char *phaseName(Phase phase);
+
+private:
+    // Row of phase at depthKm, blended from the neighbouring table depths
+    void depthRow(Phase phase, double depthKm, float *row) const;
+    
+    double m_firstDistance = 0.0;
+    double m_distanceStep = 1.0;
+    int m_distanceCount = 0;
+    QVector<double> m_depths;
+    // Per phase, depth-major: [depth * m_distanceCount + distance]
+    QVector<float> m_times[PhaseCount];
+};
+
+#endif // TRAVELTIMETABLE_H
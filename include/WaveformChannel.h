@@ -0,0 +1,27 @@
+#ifndef WAVEFORMCHANNEL_H
+#define WAVEFORMCHANNEL_H
+
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include "SampleRing.h"
+
+// One live trace: its samples stream into ring, sample i was recorded at
+// startMs + i * 1000 / sampleRate (UTC, ms since epoch). Shared by the ingest
+// thread (the only writer) and the views reading it.
+struct WaveformChannel {
+    // NET.STA.LOC.CHA
+    QString id;
+    double sampleRate = 0.0;
+    qint64 startMs = 0;
+    std::shared_ptr<SampleRing> ring;
+    
+    double timeOfSample(quint64 index) const {
+        return startMs + double(index) * 1000.0 / sampleRate;
+    }
+};
+
+Q_DECLARE_METATYPE(WaveformChannel)
+
+#endif // WAVEFORMCHANNEL_H
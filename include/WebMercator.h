@@ -0,0 +1,50 @@
+#ifndef WEBMERCATOR_H
+#define WEBMERCATOR_H
+
+#include <cstddef>
+
+// Web Mercator (EPSG:3857) between lat/lon degrees and a world rectangle in
+// scene coordinates (y grows downwards, like the tile pyramid). The batch
+// functions use branch-free polynomial kernels the compiler vectorizes, so
+// whole layers can be projected in one pass.
+class WebMercator {
+public:
+    static constexpr double kMaxLatitude = 85.051128779806592;
+    static constexpr double kEarthRadius = 6378137.0;
+    static constexpr int kMaxZoom = 30;
+
+    WebMercator();
+    WebMercator(double left, double top, double width, double height);
+
+    void setWorldRect(double left, double top, double width, double height);
+    double worldLeft() const { return m_left; }
+    double worldTop() const { return m_top; }
+    double worldWidth() const { return m_width; }
+    double worldHeight() const { return m_height; }
+
+    // Single point, using the libm reference formula
+    void toScene(double lat, double lon, double &x, double &y) const;
+    void toGeo(double x, double y, double &lat, double &lon) const;
+
+    // Batch forward projection; lat/lon and x/y may not alias each other
+    void toScene(const double *lat, const double *lon, double *x, double *y, std::size_t n) const;
+    void toGeo(const double *x, const double *y, double *lat, double *lon, std::size_t n) const;
+
+    // Normalized [0,1] world coordinates without the scene transform
+    static void forwardNormalized(const double *lat, const double *lon,
+                                  double *x, double *y, std::size_t n);
+    static void forwardNormalizedScalar(const double *lat, const double *lon,
+                                        double *x, double *y, std::size_t n);
+
+    // Cached per-zoom factors for a tileSize-pixel pyramid (default 256)
+    static double worldPixels(int zoom);
+    static double metersPerPixel(int zoom, double lat);
+
+private:
+    double m_left;
+    double m_top;
+    double m_width;
+    double m_height;
+};
+
+#endif // WEBMERCATOR_H
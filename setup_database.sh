@@ -37,6 +37,7 @@ sudo -u postgres psql -d tsunami_data -c "GRANT ALL ON SCHEMA public TO farhan;"
 PGPASSWORD=farhan psql -h localhost -U farhan -d tsunami_data << 'EOF'
 -- Drop table if exists for clean setup
 DROP TABLE IF EXISTS sumber_tsunami CASCADE;
+DROP TABLE IF EXISTS sumber_tsunami_deleted;
 
 -- Create table with proper column order
 CREATE TABLE sumber_tsunami (
@@ -49,16 +50,37 @@ CREATE TABLE sumber_tsunami (
     depth_km INTEGER NOT NULL,
     strike INTEGER,
     dip INTEGER,
-    slip INTEGER
+    slip INTEGER,
+    updated_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT now()
 );
 
+-- Ids of deleted rows, so local snapshots can drop them when they sync
+CREATE TABLE sumber_tsunami_deleted (
+    id INTEGER PRIMARY KEY,
+    deleted_at TIMESTAMP WITH TIME ZONE NOT NULL DEFAULT now()
+);
+CREATE INDEX idx_sumber_tsunami_deleted_at ON sumber_tsunami_deleted (deleted_at);
+
 -- Add geometry column
 SELECT AddGeometryColumn('public', 'sumber_tsunami', 'geom_source', 4326, 'POINT', 2);
 
 -- Create spatial index
 CREATE INDEX idx_sumber_tsunami_geom ON sumber_tsunami USING GIST(geom_source);
 
+-- Keyset paging index: DatabaseView seeks on (origintime, id) newest first;
+-- magnitudo is included so the filtered count stays an index-only scan
+CREATE INDEX idx_sumber_tsunami_origintime_id ON sumber_tsunami (origintime, id) INCLUDE (magnitudo);
+
+-- Catalog search (CatalogFilter): magnitude ranges without a date range, and
+-- event id prefixes (LIKE 'abc%' needs pattern_ops under a non-C collation)
+CREATE INDEX idx_sumber_tsunami_magnitudo ON sumber_tsunami (magnitudo);
+CREATE INDEX idx_sumber_tsunami_event_id_prefix ON sumber_tsunami (event_id text_pattern_ops);
+
+-- Snapshot sync fetches rows changed since its last version
+CREATE INDEX idx_sumber_tsunami_updated_at ON sumber_tsunami (updated_at);
+
 -- Insert sample data dengan event_id format ujicoba#### dan depth
+-- (whole catalogs: catimport <catalog.csv>, see tools/catimport.cpp)
 INSERT INTO sumber_tsunami (event_id, origintime, magnitudo, latitude, longitude, depth_km, strike, dip, slip, geom_source)
 VALUES 
     ('ujicoba0001', '2024-12-18 08:30:00+07', 7.5, -6.2088, 106.8456, 10, 90, 45, 90, ST_SetSRID(ST_MakePoint(106.8456, -6.2088), 4326)),
@@ -67,9 +89,57 @@ VALUES
     ('ujicoba0004', '2024-12-18 03:20:00+07', 8.1, 3.5952, 98.6722, 8, 100, 35, 80, ST_SetSRID(ST_MakePoint(98.6722, 3.5952), 4326)),
     ('ujicoba0005', '2024-12-19 19:05:00+07', 6.5, -0.9471, 119.8707, 20, 88, 42, 92, ST_SetSRID(ST_MakePoint(119.8707, -0.9471), 4326));
 
+-- Live updates: every row change is announced on sumber_tsunami_changes.
+-- The old_* fields let listeners find where an updated or deleted row was and
+-- whether it matched their filter; txid lets them skip changes their snapshot
+-- already contains.
+CREATE OR REPLACE FUNCTION notify_sumber_tsunami() RETURNS trigger AS $$
+DECLARE
+    payload json;
+BEGIN
+    -- CatalogImporter sends one 'BULK' notification for the whole COPY
+    IF current_setting('tsunami.bulk_import', true) = 'on' THEN
+        RETURN NULL;
+    END IF;
+    IF TG_OP = 'INSERT' THEN
+        payload := json_build_object('op', TG_OP, 'id', NEW.id, 'txid', txid_current());
+    ELSE
+        payload := json_build_object('op', TG_OP, 'id', OLD.id, 'txid', txid_current(),
+            'old_time', to_char(OLD.origintime AT TIME ZONE 'UTC', 'YYYY-MM-DD"T"HH24:MI:SS.US"Z"'),
+            'old_mag', OLD.magnitudo, 'old_lat', OLD.latitude, 'old_lon', OLD.longitude,
+            'old_depth', OLD.depth_km, 'old_event_id', OLD.event_id);
+    END IF;
+    PERFORM pg_notify('sumber_tsunami_changes', payload::text);
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TRIGGER trg_sumber_tsunami_notify
+    AFTER INSERT OR UPDATE OR DELETE ON sumber_tsunami
+    FOR EACH ROW EXECUTE FUNCTION notify_sumber_tsunami();
+
+-- Change tracking for local snapshots: updated_at on every update, a
+-- tombstone for every delete
+CREATE OR REPLACE FUNCTION track_sumber_tsunami() RETURNS trigger AS $$
+BEGIN
+    IF TG_OP = 'UPDATE' THEN
+        NEW.updated_at := now();
+        RETURN NEW;
+    END IF;
+    INSERT INTO sumber_tsunami_deleted (id) VALUES (OLD.id)
+        ON CONFLICT (id) DO UPDATE SET deleted_at = now();
+    RETURN OLD;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TRIGGER trg_sumber_tsunami_track
+    BEFORE UPDATE OR DELETE ON sumber_tsunami
+    FOR EACH ROW EXECUTE FUNCTION track_sumber_tsunami();
+
 -- Grant permissions
 ALTER TABLE sumber_tsunami OWNER TO farhan;
 GRANT ALL PRIVILEGES ON TABLE sumber_tsunami TO farhan;
+GRANT ALL PRIVILEGES ON TABLE sumber_tsunami_deleted TO farhan;
 GRANT USAGE, SELECT ON SEQUENCE sumber_tsunami_id_seq TO farhan;
 
 -- Verify data
@@ -0,0 +1,226 @@
+#include "ArrivalEngine.h"
+#include "BathymetryGrid.h"
+#include "TravelTimeTable.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <cmath>
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kDegToRad = kPi / 180.0;
+constexpr double kEarthRadiusKm = 6371.0;
+constexpr double kGravity = 9.81;
+// Jarak antar sampel batimetri di sepanjang lintasan
+constexpr double kPathStepKm = 5.0;
+// Floor for shallow water and land, so a path over land is slow, not infinite
+constexpr double kMinDepthM = 10.0;
+}
+
+ArrivalEngine::ArrivalEngine()
+    : m_travelTimes(&TravelTimeTable::shared())
+    , m_bathymetry(nullptr)
+{
+}
+
+ArrivalEngine::Receiver ArrivalEngine::receiverAt(double lat, double lon) {
+    return Receiver{lat, lon, std::sin(lat * kDegToRad), std::cos(lat * kDegToRad)};
+}
+
+bool ArrivalEngine::loadReceivers(const QString &path, QString *error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (error) *error = QString("%1: %2").arg(path, file.errorString());
+        return false;
+    }
+    
+    QVector<QString> stationIds;
+    QVector<Receiver> stations;
+    QVector<QString> pointNames;
+    QVector<Receiver> points;
+    
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        
+        auto fail = [&](const QString &reason) {
+            if (error) *error = QString("%1:%2: %3").arg(path).arg(lineNumber).arg(reason);
+            return false;
+        };
+        
+        const QStringList parts = line.split(' ', Qt::SkipEmptyParts);
+        bool latOk = false, lonOk = false;
+        if (parts[0] == "station") {
+            if (parts.size() < 4 || parts.size() > 5) {
+                return fail("expected: station <NET.STA> <lat> <lon> [elevation]");
+            }
+            const double lat = parts[2].toDouble(&latOk);
+            const double lon = parts[3].toDouble(&lonOk);
+            if (!latOk || !lonOk) return fail("bad station coordinates");
+            stationIds.append(parts[1]);
+            stations.append(receiverAt(lat, lon));
+        } else if (parts[0] == "point") {
+            if (parts.size() < 4) return fail("expected: point <lat> <lon> <name>");
+            const double lat = parts[1].toDouble(&latOk);
+            const double lon = parts[2].toDouble(&lonOk);
+            if (!latOk || !lonOk) return fail("bad point coordinates");
+            pointNames.append(parts.mid(3).join(' '));
+            points.append(receiverAt(lat, lon));
+        } else {
+            return fail(QString("unknown record %1").arg(parts[0]));
+        }
+    }
+    
+    m_stationIds = stationIds;
+    m_stations = stations;
+    m_pointNames = pointNames;
+    m_points = points;
+    return true;
+}
+
+int ArrivalEngine::stationCount() const {
+    return m_stations.size();
+}
+
+int ArrivalEngine::pointCount() const {
+    return m_points.size();
+}
+
+void ArrivalEngine::setTravelTimes(const TravelTimeTable *table) {
+    m_travelTimes = table;
+}
+
+void ArrivalEngine::setBathymetry(const BathymetryGrid *grid) {
+    m_bathymetry = grid;
+}
+
+Arrivals ArrivalEngine::compute(double lat, double lon, double depthKm) const {
+    QElapsedTimer timer;
+    timer.start();
+    
+    Arrivals arrivals;
+    arrivals.latitude = lat;
+    arrivals.longitude = lon;
+    arrivals.depthKm = depthKm;
+    arrivals.bathymetry = m_bathymetry && !m_bathymetry->isEmpty();
+    
+    // Distance and azimuth share the terms of the Vincenty form of the
+    // great-circle angle, which stays accurate at short range
+    const Receiver source = receiverAt(lat, lon);
+    const int stationCount = m_stations.size();
+    QVector<float> distance(stationCount);
+    QVector<float> azimuth(stationCount);
+    for (int i = 0; i < stationCount; ++i) {
+        const Receiver &r = m_stations[i];
+        const double dLon = (r.longitude - lon) * kDegToRad;
+        const double sinDLon = std::sin(dLon);
+        const double cosDLon = std::cos(dLon);
+        const double east = r.cosLat * sinDLon;
+        const double north = source.cosLat * r.sinLat - source.sinLat * r.cosLat * cosDLon;
+        const double along = source.sinLat * r.sinLat + source.cosLat * r.cosLat * cosDLon;
+        distance[i] = float(std::atan2(std::sqrt(east * east + north * north), along) / kDegToRad);
+        const double az = std::atan2(east, north) / kDegToRad;
+        azimuth[i] = float(az < 0.0 ? az + 360.0 : az);
+    }
+    
+    QVector<float> p(stationCount);
+    QVector<float> s(stationCount);
+    m_travelTimes->times(TravelTimeTable::P, depthKm, distance.constData(), stationCount, p.data());
+    m_travelTimes->times(TravelTimeTable::S, depthKm, distance.constData(), stationCount, s.data());
+    
+    arrivals.stations.resize(stationCount);
+    for (int i = 0; i < stationCount; ++i) {
+        Arrivals::Station &station = arrivals.stations[i];
+        station.id = m_stationIds[i];
+        station.latitude = m_stations[i].latitude;
+        station.longitude = m_stations[i].longitude;
+        station.distance = distance[i];
+        station.azimuth = azimuth[i];
+        station.p = p[i];
+        station.s = s[i];
+    }
+    
+    arrivals.points.resize(m_points.size());
+    for (int i = 0; i < m_points.size(); ++i) {
+        Arrivals::ForecastPoint &point = arrivals.points[i];
+        point.name = m_pointNames[i];
+        point.latitude = m_points[i].latitude;
+        point.longitude = m_points[i].longitude;
+        point.travelTime = tsunamiTravelTime(lat, lon, point.latitude, point.longitude,
+                                             &point.distanceKm, &point.overLandKm);
+    }
+    
+    arrivals.elapsedMs = timer.nsecsElapsed() / 1e6;
+    return arrivals;
+}
+
+float ArrivalEngine::tsunamiTravelTime(double lat1, double lon1, double lat2, double lon2, float *distanceKm,
+                                       float *overLandKm) const {
+    // Unit vectors of both ends
+    const double a[3] = {std::cos(lat1 * kDegToRad) * std::cos(lon1 * kDegToRad),
+                         std::cos(lat1 * kDegToRad) * std::sin(lon1 * kDegToRad),
+                         std::sin(lat1 * kDegToRad)};
+    const double b[3] = {std::cos(lat2 * kDegToRad) * std::cos(lon2 * kDegToRad),
+                         std::cos(lat2 * kDegToRad) * std::sin(lon2 * kDegToRad),
+                         std::sin(lat2 * kDegToRad)};
+    const double dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    const double cross[3] = {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+    const double angle = std::atan2(std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]), dot);
+    const double km = angle * kEarthRadiusKm;
+    if (distanceKm) *distanceKm = float(km);
+    if (overLandKm) *overLandKm = 0.0f;
+    
+    const double uniformSpeed = std::sqrt(kGravity * kUniformDepthM);
+    if (!m_bathymetry || m_bathymetry->isEmpty() || km < kPathStepKm) {
+        return float(km * 1000.0 / uniformSpeed);
+    }
+    
+    // Unit tangent at a pointing along the path; the sample point is rotated
+    // through the great-circle plane one step at a time
+    double tangent[3] = {b[0] - a[0] * dot, b[1] - a[1] * dot, b[2] - a[2] * dot};
+    const double norm = std::sqrt(tangent[0] * tangent[0] + tangent[1] * tangent[1] + tangent[2] * tangent[2]);
+    for (double &t : tangent) t /= norm;
+    
+    const int steps = int(std::ceil(km / kPathStepKm));
+    const double stepKm = km / steps;
+    const double stepAngle = angle / steps;
+    const double cosStep = std::cos(stepAngle);
+    const double sinStep = std::sin(stepAngle);
+    
+    // Midpoint of the first step
+    double point[3], direction[3];
+    for (int k = 0; k < 3; ++k) {
+        point[k] = a[k] * std::cos(stepAngle / 2) + tangent[k] * std::sin(stepAngle / 2);
+        direction[k] = tangent[k] * std::cos(stepAngle / 2) - a[k] * std::sin(stepAngle / 2);
+    }
+    
+    double seconds = 0.0;
+    double land = 0.0;
+    for (int i = 0; i < steps; ++i) {
+        const double lat = std::asin(qBound(-1.0, point[2], 1.0)) / kDegToRad;
+        const double lon = std::atan2(point[1], point[0]) / kDegToRad;
+        const float elevation = m_bathymetry->elevationAt(lat, lon);
+        
+        double depth = kUniformDepthM;
+        if (elevation >= 0.0f) {
+            land += stepKm;
+            depth = kMinDepthM;
+        } else if (elevation < 0.0f) {
+            depth = qMax(double(-elevation), kMinDepthM);
+        }
+        seconds += stepKm * 1000.0 / std::sqrt(kGravity * depth);
+        
+        for (int k = 0; k < 3; ++k) {
+            const double p = point[k];
+            point[k] = p * cosStep + direction[k] * sinStep;
+            direction[k] = direction[k] * cosStep - p * sinStep;
+        }
+    }
+    
+    if (overLandKm) *overLandKm = float(land);
+    return float(seconds);
+}
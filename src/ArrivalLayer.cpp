@@ -0,0 +1,132 @@
+#include "ArrivalLayer.h"
+#include <QFont>
+#include <QPainter>
+#include <QPolygonF>
+#include <QStyleOptionGraphicsItem>
+#include <cmath>
+
+namespace {
+constexpr double kMarkerRadius = 5.0;
+// Label waktu tiba hanya digambar kalau titik yang terlihat tidak terlalu banyak
+constexpr int kMaxLabels = 40;
+// P later than this is drawn in the coldest color
+constexpr double kPColorSpanSeconds = 600.0;
+
+QColor stationColor(double seconds) {
+    if (std::isnan(seconds)) return QColor(160, 160, 170);
+    // Red at origin time to blue at kPColorSpanSeconds
+    const double t = qBound(0.0, seconds / kPColorSpanSeconds, 1.0);
+    return QColor::fromHsvF(float(t * 240.0 / 360.0), 0.85f, 1.0f);
+}
+}
+
+ArrivalLayer::ArrivalLayer(const QRectF &worldRect, QGraphicsItem *parent)
+    : QGraphicsItem(parent)
+    , m_worldRect(worldRect)
+    , m_projection(worldRect.left(), worldRect.top(), worldRect.width(), worldRect.height())
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    setAcceptHoverEvents(false);
+    // Under the epicenters, above the tiles and the drawn region
+    setZValue(50);
+}
+
+void ArrivalLayer::setWorldRect(const QRectF &worldRect) {
+    prepareGeometryChange();
+    m_worldRect = worldRect;
+    m_projection.setWorldRect(worldRect.left(), worldRect.top(), worldRect.width(), worldRect.height());
+    project();
+}
+
+void ArrivalLayer::setArrivals(const Arrivals &arrivals) {
+    m_arrivals = arrivals;
+    project();
+}
+
+void ArrivalLayer::clear() {
+    setArrivals(Arrivals());
+}
+
+void ArrivalLayer::project() {
+    m_stationPositions.resize(m_arrivals.stations.size());
+    for (int i = 0; i < m_arrivals.stations.size(); ++i) {
+        double x, y;
+        m_projection.toScene(m_arrivals.stations[i].latitude, m_arrivals.stations[i].longitude, x, y);
+        m_stationPositions[i] = QPointF(x, y);
+    }
+    m_pointPositions.resize(m_arrivals.points.size());
+    for (int i = 0; i < m_arrivals.points.size(); ++i) {
+        double x, y;
+        m_projection.toScene(m_arrivals.points[i].latitude, m_arrivals.points[i].longitude, x, y);
+        m_pointPositions[i] = QPointF(x, y);
+    }
+    update();
+}
+
+QRectF ArrivalLayer::boundingRect() const {
+    return m_worldRect;
+}
+
+QColor ArrivalLayer::tsunamiColor(double seconds) {
+    const double minutes = seconds / 60.0;
+    if (minutes < 30.0) return QColor(255, 59, 48);
+    if (minutes < 60.0) return QColor(255, 149, 0);
+    if (minutes < 120.0) return QColor(255, 214, 10);
+    return QColor(52, 199, 89);
+}
+
+void ArrivalLayer::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) {
+    Q_UNUSED(widget);
+    if (m_stationPositions.isEmpty() && m_pointPositions.isEmpty()) return;
+    
+    const QTransform transform = painter->worldTransform();
+    const double viewScale = transform.m11();
+    if (viewScale <= 0.0) return;
+    
+    const double margin = 4.0 * kMarkerRadius / viewScale;
+    const QRectF exposed = option->exposedRect.adjusted(-margin, -margin, margin, margin);
+    
+    // Fixed on-screen size, like EventLayer
+    painter->save();
+    painter->resetTransform();
+    painter->setRenderHint(QPainter::Antialiasing);
+    
+    painter->setPen(QPen(QColor(20, 20, 20), 1));
+    for (int i = 0; i < m_stationPositions.size(); ++i) {
+        if (!exposed.contains(m_stationPositions[i])) continue;
+        const QPointF c = transform.map(m_stationPositions[i]);
+        const QPolygonF triangle({QPointF(c.x(), c.y() - kMarkerRadius * 1.2),
+                                  QPointF(c.x() + kMarkerRadius, c.y() + kMarkerRadius * 0.8),
+                                  QPointF(c.x() - kMarkerRadius, c.y() + kMarkerRadius * 0.8)});
+        painter->setBrush(stationColor(m_arrivals.stations[i].p));
+        painter->drawPolygon(triangle);
+    }
+    
+    QVector<int> visible;
+    for (int i = 0; i < m_pointPositions.size(); ++i) {
+        if (exposed.contains(m_pointPositions[i])) visible.append(i);
+    }
+    painter->setPen(QPen(Qt::white, 1.5));
+    for (int i : std::as_const(visible)) {
+        painter->setBrush(tsunamiColor(m_arrivals.points[i].travelTime));
+        painter->drawEllipse(transform.map(m_pointPositions[i]), kMarkerRadius, kMarkerRadius);
+    }
+    
+    if (visible.size() <= kMaxLabels) {
+        QFont font("Arial", 8, QFont::Bold);
+        painter->setFont(font);
+        for (int i : std::as_const(visible)) {
+            const Arrivals::ForecastPoint &point = m_arrivals.points[i];
+            const QPointF c = transform.map(m_pointPositions[i]);
+            const QString text = QString("%1 %2'").arg(point.name).arg(point.travelTime / 60.0, 0, 'f', 0);
+            const QPointF origin(c.x() + kMarkerRadius + 3, c.y() + 4);
+            // Dark halo so the label reads on any tile
+            painter->setPen(QColor(0, 0, 0, 200));
+            painter->drawText(origin + QPointF(1, 1), text);
+            painter->setPen(Qt::white);
+            painter->drawText(origin, text);
+        }
+    }
+    
+    painter->restore();
+}
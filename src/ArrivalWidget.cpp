@@ -0,0 +1,178 @@
+#include "ArrivalWidget.h"
+#include "ArrivalWorker.h"
+#include "ArrivalLayer.h"
+#include <QHeaderView>
+#include <QLabel>
+#include <QSplitter>
+#include <QTableWidget>
+#include <QVBoxLayout>
+#include <cmath>
+
+namespace {
+// Bagian lintasan di atas daratan yang masih dianggap wajar (titik dekat pantai)
+constexpr double kLandToleranceKm = 20.0;
+
+QTableWidgetItem *numberItem(double value, int decimals) {
+    auto *item = new QTableWidgetItem();
+    if (std::isnan(value)) {
+        item->setText("-");
+    } else {
+        // Numeric data so columns sort by value
+        const double scale = std::pow(10.0, decimals);
+        item->setData(Qt::DisplayRole, std::round(value * scale) / scale);
+    }
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+QTableWidgetItem *clockItem(const QDateTime &originTime, double seconds) {
+    auto *item = new QTableWidgetItem();
+    if (originTime.isValid() && !std::isnan(seconds)) {
+        item->setText(originTime.addMSecs(qint64(seconds * 1000.0)).toString("HH:mm:ss"));
+    }
+    return item;
+}
+
+QTableWidget *makeTable(const QStringList &headers) {
+    auto *table = new QTableWidget(0, headers.size());
+    table->setHorizontalHeaderLabels(headers);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->verticalHeader()->setVisible(false);
+    table->horizontalHeader()->setStretchLastSection(true);
+    table->setSortingEnabled(true);
+    return table;
+}
+}
+
+ArrivalWidget::ArrivalWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_worker(nullptr)
+{
+    m_summary = new QLabel("Pilih event untuk menghitung waktu tiba");
+    m_summary->setWordWrap(true);
+    
+    m_stationTable = makeTable({"Station", "Dist (°)", "Az (°)", "P (s)", "S (s)", "P (UTC)"});
+    m_pointTable = makeTable({"Forecast point", "Dist (km)", "Tsunami (min)", "ETA (UTC)", "Note"});
+    
+    auto *splitter = new QSplitter(Qt::Horizontal);
+    splitter->addWidget(m_stationTable);
+    splitter->addWidget(m_pointTable);
+    
+    auto *layout = new QVBoxLayout(this);
+    layout->addWidget(m_summary);
+    layout->addWidget(splitter, 1);
+    
+    m_worker = new ArrivalWorker();
+    m_worker->moveToThread(&m_workerThread);
+    connect(&m_workerThread, &QThread::finished, m_worker, &QObject::deleteLater);
+    connect(m_worker, &ArrivalWorker::opened, this,
+            [this](int stations, int points, const QString &bathymetry, const QString &error) {
+        m_receiverInfo = QString("%1 stations, %2 forecast points | tsunami: %3")
+                         .arg(stations).arg(points)
+                         .arg(bathymetry.isEmpty()
+                              ? QString("uniform %1 m ocean").arg(ArrivalEngine::kUniformDepthM, 0, 'f', 0)
+                              : bathymetry);
+        if (!error.isEmpty()) m_receiverInfo += " | " + error;
+        updateSummary();
+    });
+    connect(m_worker, &ArrivalWorker::arrivalsReady, this, &ArrivalWidget::showArrivals);
+    connect(m_worker, &ArrivalWorker::travelTimesReady, this, &ArrivalWidget::showTravelTimes);
+    m_workerThread.setObjectName("ArrivalThread");
+    m_workerThread.start();
+}
+
+ArrivalWidget::~ArrivalWidget() {
+    m_workerThread.quit();
+    m_workerThread.wait();
+}
+
+void ArrivalWidget::open(const QString &receiversPath, const QString &bathymetryPath) {
+    QMetaObject::invokeMethod(m_worker, [worker = m_worker, receiversPath, bathymetryPath]() {
+        worker->open(receiversPath, bathymetryPath);
+    }, Qt::QueuedConnection);
+}
+
+void ArrivalWidget::setEvent(const QString &eventId, const QDateTime &originTime, double lat, double lon,
+                             double depthKm) {
+    m_eventId = eventId;
+    // Isochron event sebelumnya tidak berlaku lagi
+    m_travelTimeInfo.clear();
+    emit travelTimesChanged(TravelTimeMap());
+    
+    m_worker->noteQueued();
+    QMetaObject::invokeMethod(m_worker, [worker = m_worker, eventId, originTime, lat, lon, depthKm]() {
+        worker->compute(eventId, originTime, lat, lon, depthKm);
+    }, Qt::QueuedConnection);
+}
+
+const Arrivals &ArrivalWidget::arrivals() const {
+    return m_arrivals;
+}
+
+void ArrivalWidget::showArrivals(const Arrivals &arrivals) {
+    // Event lain sudah dipilih sementara ini dihitung
+    if (arrivals.eventId != m_eventId) return;
+    m_arrivals = arrivals;
+    const QDateTime origin = arrivals.originTime.toUTC();
+    
+    m_stationTable->setSortingEnabled(false);
+    m_stationTable->setRowCount(arrivals.stations.size());
+    for (int row = 0; row < arrivals.stations.size(); ++row) {
+        const Arrivals::Station &station = arrivals.stations[row];
+        m_stationTable->setItem(row, 0, new QTableWidgetItem(station.id));
+        m_stationTable->setItem(row, 1, numberItem(station.distance, 2));
+        m_stationTable->setItem(row, 2, numberItem(station.azimuth, 0));
+        m_stationTable->setItem(row, 3, numberItem(station.p, 1));
+        m_stationTable->setItem(row, 4, numberItem(station.s, 1));
+        m_stationTable->setItem(row, 5, clockItem(origin, station.p));
+    }
+    m_stationTable->setSortingEnabled(true);
+    m_stationTable->sortByColumn(3, Qt::AscendingOrder);
+    
+    m_pointTable->setSortingEnabled(false);
+    m_pointTable->setRowCount(arrivals.points.size());
+    for (int row = 0; row < arrivals.points.size(); ++row) {
+        const Arrivals::ForecastPoint &point = arrivals.points[row];
+        m_pointTable->setItem(row, 0, new QTableWidgetItem(point.name));
+        m_pointTable->setItem(row, 1, numberItem(point.distanceKm, 0));
+        QTableWidgetItem *minutes = numberItem(point.travelTime / 60.0, 1);
+        // Warna sama dengan titik di peta
+        minutes->setForeground(ArrivalLayer::tsunamiColor(point.travelTime));
+        m_pointTable->setItem(row, 2, minutes);
+        m_pointTable->setItem(row, 3, clockItem(origin, point.travelTime));
+        m_pointTable->setItem(row, 4, new QTableWidgetItem(point.overLandKm > kLandToleranceKm
+            ? QString("path crosses %1 km of land").arg(point.overLandKm, 0, 'f', 0) : QString()));
+    }
+    m_pointTable->setSortingEnabled(true);
+    m_pointTable->sortByColumn(2, Qt::AscendingOrder);
+    
+    updateSummary();
+    emit arrivalsChanged(arrivals);
+}
+
+void ArrivalWidget::showTravelTimes(const TravelTimeMap &map, const QString &error) {
+    if (map.eventId != m_eventId) return;
+    if (map.isEmpty()) {
+        m_travelTimeInfo = "no travel-time map: " + error;
+    } else {
+        m_travelTimeInfo = QString("travel-time map with %1 isochrones in %2 ms")
+                           .arg(map.isochrones.size()).arg(map.elapsedMs, 0, 'f', 0);
+    }
+    updateSummary();
+    if (!map.isEmpty()) emit travelTimesChanged(map);
+}
+
+void ArrivalWidget::updateSummary() {
+    if (m_arrivals.eventId.isEmpty()) {
+        m_summary->setText("Pilih event untuk menghitung waktu tiba | " + m_receiverInfo);
+        return;
+    }
+    m_summary->setText(QString("Event %1 | %2, %3 | depth %4 km | %5 | computed in %6 ms")
+                       .arg(m_arrivals.eventId)
+                       .arg(m_arrivals.latitude, 0, 'f', 3).arg(m_arrivals.longitude, 0, 'f', 3)
+                       .arg(m_arrivals.depthKm, 0, 'f', 0)
+                       .arg(m_receiverInfo)
+                       .arg(m_arrivals.elapsedMs, 0, 'f', 2)
+                       + (m_travelTimeInfo.isEmpty() ? QString() : " | " + m_travelTimeInfo));
+}
@@ -0,0 +1,60 @@
+#include "ArrivalWorker.h"
+#include <QStringList>
+#include <cmath>
+
+ArrivalWorker::ArrivalWorker(QObject *parent)
+    : QObject(parent)
+    , m_queued(0)
+{
+}
+
+void ArrivalWorker::noteQueued() {
+    ++m_queued;
+}
+
+void ArrivalWorker::open(const QString &receiversPath, const QString &bathymetryPath) {
+    QStringList errors;
+    QString error;
+    if (!m_engine.loadReceivers(receiversPath, &error)) errors.append(error);
+    
+    m_engine.setBathymetry(nullptr);
+    m_solver.setGrid(nullptr);
+    m_bathymetry.clear();
+    if (!bathymetryPath.isEmpty()) {
+        if (m_bathymetry.load(bathymetryPath, &error)) {
+            m_engine.setBathymetry(&m_bathymetry);
+            m_solver.setGrid(&m_bathymetry);
+        } else {
+            errors.append(error);
+        }
+    }
+    
+    emit opened(m_engine.stationCount(), m_engine.pointCount(), m_bathymetry.fileName(), errors.join("; "));
+}
+
+void ArrivalWorker::compute(const QString &eventId, const QDateTime &originTime, double lat, double lon,
+                            double depthKm) {
+    Arrivals arrivals = m_engine.compute(lat, lon, depthKm);
+    arrivals.eventId = eventId;
+    arrivals.originTime = originTime;
+    emit arrivalsReady(arrivals);
+    
+    // Event yang lebih baru sudah antre: peta waktu tempuh dilewati
+    if (m_solver.hasGrid() && m_queued.load() <= 1) {
+        QString error;
+        TravelTimeMap map = m_solver.solve(lat, lon, &error, [this]() { return m_queued.load() > 1; });
+        map.eventId = eventId;
+        if (!map.isEmpty()) {
+            // The map goes around land where the great circle crosses it
+            for (Arrivals::ForecastPoint &point : arrivals.points) {
+                const float seconds = map.timeAt(point.latitude, point.longitude);
+                if (std::isnan(seconds)) continue;
+                point.travelTime = seconds;
+                point.overLandKm = 0.0f;
+            }
+            emit arrivalsReady(arrivals);
+        }
+        if (m_queued.load() <= 1) emit travelTimesReady(map, error);
+    }
+    --m_queued;
+}
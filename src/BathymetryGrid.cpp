@@ -0,0 +1,209 @@
+#include "BathymetryGrid.h"
+#include <QByteArray>
+#include <QFile>
+#include <QFileInfo>
+#include <cmath>
+#include <limits>
+
+namespace {
+constexpr float kNaN = std::numeric_limits<float>::quiet_NaN();
+
+// Whitespace-separated tokens of the mapped file, without copying
+struct Scanner {
+    const char *pos;
+    const char *end;
+    
+    bool skipSpace() {
+        while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n')) ++pos;
+        return pos < end;
+    }
+    
+    QByteArray word() {
+        skipSpace();
+        const char *start = pos;
+        while (pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r' && *pos != '\n') ++pos;
+        return QByteArray(start, int(pos - start));
+    }
+    
+    // Decimal number with optional sign, fraction and exponent. QByteArray::
+    // toDouble would cost an allocation per cell on multi-million cell grids.
+    bool number(double *value) {
+        if (!skipSpace()) return false;
+        bool negative = false;
+        if (*pos == '-' || *pos == '+') negative = *pos++ == '-';
+        
+        double mantissa = 0.0;
+        int digits = 0;
+        while (pos < end && *pos >= '0' && *pos <= '9') {
+            mantissa = mantissa * 10.0 + (*pos++ - '0');
+            ++digits;
+        }
+        int exponent = 0;
+        if (pos < end && *pos == '.') {
+            ++pos;
+            while (pos < end && *pos >= '0' && *pos <= '9') {
+                mantissa = mantissa * 10.0 + (*pos++ - '0');
+                --exponent;
+                ++digits;
+            }
+        }
+        if (digits == 0) return false;
+        if (pos < end && (*pos == 'e' || *pos == 'E')) {
+            ++pos;
+            bool negativeExponent = false;
+            if (pos < end && (*pos == '-' || *pos == '+')) negativeExponent = *pos++ == '-';
+            int e = 0;
+            while (pos < end && *pos >= '0' && *pos <= '9') e = e * 10 + (*pos++ - '0');
+            exponent += negativeExponent ? -e : e;
+        }
+        if (pos < end && *pos != ' ' && *pos != '\t' && *pos != '\r' && *pos != '\n') return false;
+        
+        *value = (negative ? -mantissa : mantissa) * (exponent ? std::pow(10.0, exponent) : 1.0);
+        return true;
+    }
+};
+}
+
+bool BathymetryGrid::load(const QString &path, QString *error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = QString("%1: %2").arg(path, file.errorString());
+        return false;
+    }
+    const qint64 size = file.size();
+    const uchar *data = size > 0 ? file.map(0, size) : nullptr;
+    if (!data) {
+        if (error) *error = QString("%1: cannot map file").arg(path);
+        return false;
+    }
+    
+    auto fail = [&](const QString &reason) {
+        if (error) *error = QString("%1: %2").arg(path, reason);
+        file.unmap(const_cast<uchar *>(data));
+        return false;
+    };
+    
+    Scanner in{reinterpret_cast<const char *>(data), reinterpret_cast<const char *>(data) + size};
+    
+    // Header: keyword/value pairs until the first number
+    int columns = 0;
+    int rows = 0;
+    double x = NAN, y = NAN, cellSize = 0.0, noData = NAN;
+    bool centred = false;
+    for (;;) {
+        in.skipSpace();
+        if (in.pos >= in.end) return fail("no grid values");
+        const char c = *in.pos;
+        if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.') break;
+        
+        const QByteArray key = in.word().toLower();
+        double value = 0.0;
+        if (!in.number(&value)) return fail(QString("bad value for %1").arg(QString::fromLatin1(key)));
+        if (key == "ncols") {
+            columns = int(value);
+        } else if (key == "nrows") {
+            rows = int(value);
+        } else if (key == "xllcorner" || key == "xllcenter") {
+            x = value;
+            centred = key == "xllcenter";
+        } else if (key == "yllcorner" || key == "yllcenter") {
+            y = value;
+        } else if (key == "cellsize") {
+            cellSize = value;
+        } else if (key == "nodata_value") {
+            noData = value;
+        } else {
+            return fail(QString("unknown header field %1 (only ESRI ASCII grids are read)")
+                        .arg(QString::fromLatin1(key)));
+        }
+    }
+    if (columns < 2 || rows < 2 || std::isnan(x) || std::isnan(y) || cellSize <= 0.0) {
+        return fail("incomplete header, needs ncols, nrows, xllcorner, yllcorner and cellsize");
+    }
+    
+    QVector<float> elevation(qsizetype(columns) * rows);
+    float *out = elevation.data();
+    for (qsizetype i = 0; i < elevation.size(); ++i) {
+        double value = 0.0;
+        if (!in.number(&value)) {
+            return fail(QString("bad or missing value at row %1, column %2").arg(i / columns).arg(i % columns));
+        }
+        out[i] = value == noData ? kNaN : float(value);
+    }
+    file.unmap(const_cast<uchar *>(data));
+    
+    m_fileName = QFileInfo(path).fileName();
+    m_columns = columns;
+    m_rows = rows;
+    m_cellSize = cellSize;
+    const double half = centred ? 0.0 : cellSize / 2.0;
+    m_west = x + half;
+    m_north = y + half + (rows - 1) * cellSize;
+    m_elevation = elevation;
+    return true;
+}
+
+void BathymetryGrid::clear() {
+    m_fileName.clear();
+    m_columns = m_rows = 0;
+    m_elevation.clear();
+}
+
+bool BathymetryGrid::isEmpty() const {
+    return m_elevation.isEmpty();
+}
+
+QString BathymetryGrid::fileName() const {
+    return m_fileName;
+}
+
+int BathymetryGrid::columns() const {
+    return m_columns;
+}
+
+int BathymetryGrid::rows() const {
+    return m_rows;
+}
+
+double BathymetryGrid::cellSize() const {
+    return m_cellSize;
+}
+
+double BathymetryGrid::latitudeOf(int row) const {
+    return m_north - row * m_cellSize;
+}
+
+double BathymetryGrid::longitudeOf(int column) const {
+    return m_west + column * m_cellSize;
+}
+
+bool BathymetryGrid::contains(double lat, double lon) const {
+    const double row = (m_north - lat) / m_cellSize;
+    const double column = (lon - m_west) / m_cellSize;
+    return !isEmpty() && row >= 0.0 && row <= m_rows - 1 && column >= 0.0 && column <= m_columns - 1;
+}
+
+float BathymetryGrid::elevation(int row, int column) const {
+    return m_elevation[qsizetype(row) * m_columns + column];
+}
+
+float BathymetryGrid::elevationAt(double lat, double lon) const {
+    if (!contains(lat, lon)) return kNaN;
+    
+    const double row = (m_north - lat) / m_cellSize;
+    const double column = (lon - m_west) / m_cellSize;
+    const int r = qMin(int(row), m_rows - 2);
+    const int c = qMin(int(column), m_columns - 2);
+    const float fr = float(row - r);
+    const float fc = float(column - c);
+    
+    const float *top = m_elevation.constData() + qsizetype(r) * m_columns + c;
+    const float *bottom = top + m_columns;
+    const float north = top[0] + (top[1] - top[0]) * fc;
+    const float south = bottom[0] + (bottom[1] - bottom[0]) * fc;
+    return north + (south - north) * fr;
+}
+
+const float *BathymetryGrid::data() const {
+    return m_elevation.constData();
+}
@@ -0,0 +1,328 @@
+#include "CatalogFilter.h"
+#include <QPolygonF>
+#include <QRegularExpression>
+#include <QStringList>
+#include <algorithm>
+
+namespace {
+const QString kNumber = "(-?\\d+(?:\\.\\d+)?)";
+
+// YYYY, YYYY-MM or YYYY-MM-DD as the first and last day it covers
+bool parseDateTerm(const QString &term, QDate &first, QDate &last) {
+    static const QRegularExpression re("^(\\d{4})(?:-(\\d{1,2})(?:-(\\d{1,2}))?)?$");
+    QRegularExpressionMatch m = re.match(term);
+    if (!m.hasMatch()) return false;
+    
+    int year = m.captured(1).toInt();
+    if (m.captured(2).isEmpty()) {
+        first = QDate(year, 1, 1);
+        last = QDate(year, 12, 31);
+    } else if (m.captured(3).isEmpty()) {
+        first = QDate(year, m.captured(2).toInt(), 1);
+        last = first.addMonths(1).addDays(-1);
+    } else {
+        first = QDate(year, m.captured(2).toInt(), m.captured(3).toInt());
+        last = first;
+    }
+    return first.isValid() && last.isValid();
+}
+
+QString likePrefix(const QString &prefix) {
+    // Wildcards typed by the user are matched literally
+    QString escaped = prefix;
+    escaped.replace('\\', "\\\\").replace('%', "\\%").replace('_', "\\_");
+    return escaped + '%';
+}
+
+struct LonRange {
+    double west;
+    double east;
+};
+
+// One range, or two for a box split at the antimeridian
+QVector<LonRange> lonRanges(const CatalogFilter::GeoBox &box) {
+    if (box.west <= box.east) return {{box.west, box.east}};
+    return {{box.west, 180.0}, {-180.0, box.east}};
+}
+
+QString boxPredicate(const CatalogFilter::GeoBox &box) {
+    if (box.west <= box.east) {
+        return "geom_source && ST_MakeEnvelope(?::float8, ?::float8, ?::float8, ?::float8, 4326)";
+    }
+    return "(geom_source && ST_MakeEnvelope(?::float8, ?::float8, 180, ?::float8, 4326) "
+           "OR geom_source && ST_MakeEnvelope(-180, ?::float8, ?::float8, ?::float8, 4326))";
+}
+
+void appendBoxValues(QVariantList &values, const CatalogFilter::GeoBox &box) {
+    if (box.west <= box.east) {
+        values << box.west << box.south << box.east << box.north;
+    } else {
+        values << box.west << box.south << box.north
+               << box.south << box.east << box.north;
+    }
+}
+
+bool boxContains(const CatalogFilter::GeoBox &box, double latitude, double longitude) {
+    if (latitude < box.south || latitude > box.north) return false;
+    return box.west <= box.east
+           ? longitude >= box.west && longitude <= box.east
+           : longitude >= box.west || longitude <= box.east;
+}
+
+// Closed WKT ring for ST_GeomFromText
+QString polygonWkt(const QVector<QPointF> &polygon) {
+    QStringList points;
+    points.reserve(polygon.size() + 1);
+    for (const QPointF &p : polygon) {
+        points << QString("%1 %2").arg(p.x(), 0, 'g', 10).arg(p.y(), 0, 'g', 10);
+    }
+    if (polygon.first() != polygon.last()) points << points.first();
+    return QString("POLYGON((%1))").arg(points.join(", "));
+}
+}
+
+CatalogFilter CatalogFilter::parse(const QString &text, QString *error) {
+    static const QRegularExpression magnitudeRe(
+        "^m(?:ag)?(>=|>|<=|<)?" + kNumber + "(?:(\\+)|-" + kNumber + ")?$",
+        QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression depthRe(
+        "^d(?:epth)?(>=|>|<=|<)?(\\d+)(?:(\\+)|-(\\d+))?$",
+        QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression rangeRe(
+        "^(lat|lon):" + kNumber + "\\.\\." + kNumber + "$",
+        QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression boxRe(
+        "^box:" + kNumber + "," + kNumber + "," + kNumber + "," + kNumber + "$",
+        QRegularExpression::CaseInsensitiveOption);
+    static const QRegularExpression numberRe("^\\d+(?:\\.\\d+)?$");
+    // Ids start with a letter or digit, so "-5" is never taken for one
+    static const QRegularExpression idRe("^(?:id:)?([A-Za-z0-9][A-Za-z0-9_#.-]*)$",
+                                         QRegularExpression::CaseInsensitiveOption);
+    
+    CatalogFilter filter;
+    std::optional<std::pair<double, double>> latRange;
+    std::optional<std::pair<double, double>> lonRange;
+    
+    const QStringList terms = text.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+    for (const QString &term : terms) {
+        QRegularExpressionMatch m;
+        QDate first, last, rangeFirst, rangeLast;
+        
+        if ((m = magnitudeRe.match(term)).hasMatch()) {
+            QString op = m.captured(1);
+            double value = m.captured(2).toDouble();
+            if (!m.captured(4).isEmpty()) {
+                filter.minMagnitude = value;
+                filter.maxMagnitude = m.captured(4).toDouble();
+            } else if (op.startsWith('<')) {
+                filter.maxMagnitude = value;
+            } else {
+                filter.minMagnitude = value;
+            }
+        } else if ((m = depthRe.match(term)).hasMatch()) {
+            QString op = m.captured(1);
+            int value = m.captured(2).toInt();
+            if (!m.captured(4).isEmpty()) {
+                filter.minDepth = value;
+                filter.maxDepth = m.captured(4).toInt();
+            } else if (op.startsWith('<')) {
+                // depth_km is an integer, so d<70 is d<=69
+                filter.maxDepth = op == "<" ? value - 1 : value;
+            } else {
+                filter.minDepth = op == ">" ? value + 1 : value;
+            }
+        } else if ((m = rangeRe.match(term)).hasMatch()) {
+            double a = m.captured(2).toDouble();
+            double b = m.captured(3).toDouble();
+            auto range = std::make_pair(qMin(a, b), qMax(a, b));
+            if (m.captured(1).toLower() == "lat") {
+                latRange = range;
+            } else {
+                // Kept in order so lon:170..-170 crosses the antimeridian
+                lonRange = std::make_pair(a, b);
+            }
+        } else if ((m = boxRe.match(term)).hasMatch()) {
+            latRange = std::make_pair(qMin(m.captured(1).toDouble(), m.captured(3).toDouble()),
+                                      qMax(m.captured(1).toDouble(), m.captured(3).toDouble()));
+            lonRange = std::make_pair(m.captured(2).toDouble(), m.captured(4).toDouble());
+        } else if (parseDateTerm(term, first, last)) {
+            filter.startDate = first;
+            filter.endDate = last;
+        } else if (term.contains("..")
+                   && parseDateTerm(term.section("..", 0, 0), rangeFirst, first)
+                   && parseDateTerm(term.section("..", 1), last, rangeLast)) {
+            filter.startDate = rangeFirst;
+            filter.endDate = rangeLast;
+        } else if (numberRe.match(term).hasMatch()) {
+            // Bare number: minimum magnitude, like the old text search on magnitudo
+            filter.minMagnitude = term.toDouble();
+        } else if ((m = idRe.match(term)).hasMatch()) {
+            filter.eventIdPrefix = m.captured(1);
+        } else {
+            if (error) *error = QString("Unrecognized search term '%1'").arg(term);
+            return CatalogFilter();
+        }
+    }
+    
+    if (latRange || lonRange) {
+        GeoBox box;
+        box.south = latRange ? latRange->first : -90.0;
+        box.north = latRange ? latRange->second : 90.0;
+        box.west = lonRange ? lonRange->first : -180.0;
+        box.east = lonRange ? lonRange->second : 180.0;
+        filter.box = box;
+    }
+    
+    if (error) error->clear();
+    return filter;
+}
+
+CatalogFilter CatalogFilter::intersected(const CatalogFilter &other) const {
+    CatalogFilter result = *this;
+    
+    if (other.startDate.isValid() && (!startDate.isValid() || other.startDate > startDate)) {
+        result.startDate = other.startDate;
+    }
+    if (other.endDate.isValid() && (!endDate.isValid() || other.endDate < endDate)) {
+        result.endDate = other.endDate;
+    }
+    if (other.minMagnitude && (!minMagnitude || *other.minMagnitude > *minMagnitude)) {
+        result.minMagnitude = other.minMagnitude;
+    }
+    if (other.maxMagnitude && (!maxMagnitude || *other.maxMagnitude < *maxMagnitude)) {
+        result.maxMagnitude = other.maxMagnitude;
+    }
+    if (other.minDepth && (!minDepth || *other.minDepth > *minDepth)) {
+        result.minDepth = other.minDepth;
+    }
+    if (other.maxDepth && (!maxDepth || *other.maxDepth < *maxDepth)) {
+        result.maxDepth = other.maxDepth;
+    }
+    
+    // Filters from parse() and the map view hold one box each
+    if (other.box && !box) {
+        result.box = other.box;
+        result.secondBox = other.secondBox;
+    } else if (other.box && box) {
+        GeoBox common;
+        common.south = qMax(box->south, other.box->south);
+        common.north = qMin(box->north, other.box->north);
+        
+        // The longitude overlap is whatever the ranges of the two boxes share
+        QVector<LonRange> overlap;
+        for (const LonRange &a : lonRanges(*box)) {
+            for (const LonRange &b : lonRanges(*other.box)) {
+                LonRange range{qMax(a.west, b.west), qMin(a.east, b.east)};
+                if (range.west <= range.east) overlap.append(range);
+            }
+        }
+        std::sort(overlap.begin(), overlap.end(),
+                  [](const LonRange &a, const LonRange &b) { return a.west < b.west; });
+        
+        if (common.south > common.north || overlap.isEmpty()) {
+            result.matchesNothing = true;
+        } else if (overlap.size() == 1) {
+            common.west = overlap.first().west;
+            common.east = overlap.first().east;
+            result.box = common;
+        } else if (overlap.size() == 2 && overlap.first().west == -180.0 && overlap.last().east == 180.0) {
+            // Pieces meeting at the antimeridian are one box across it
+            common.west = overlap.last().west;
+            common.east = overlap.first().east;
+            result.box = common;
+        } else {
+            result.box = common;
+            result.box->west = box->west;
+            result.box->east = box->east;
+            result.secondBox = common;
+            result.secondBox->west = other.box->west;
+            result.secondBox->east = other.box->east;
+        }
+    }
+    
+    if (!other.polygon.isEmpty() && polygon.isEmpty()) {
+        result.polygon = other.polygon;
+    }
+    
+    // One prefix has to extend the other, or no id starts with both
+    if (other.eventIdPrefix.startsWith(eventIdPrefix)) {
+        result.eventIdPrefix = other.eventIdPrefix;
+    } else if (!eventIdPrefix.startsWith(other.eventIdPrefix)) {
+        result.matchesNothing = true;
+    }
+    result.matchesNothing = result.matchesNothing || other.matchesNothing;
+    return result;
+}
+
+QString CatalogFilter::whereClause() const {
+    if (matchesNothing) return QString("FALSE");
+    
+    QStringList predicates;
+    if (startDate.isValid()) predicates << "origintime >= ?::timestamptz";
+    if (endDate.isValid()) predicates << "origintime < ?::timestamptz";
+    if (minMagnitude) predicates << "magnitudo >= ?::real";
+    if (maxMagnitude) predicates << "magnitudo <= ?::real";
+    if (minDepth) predicates << "depth_km >= ?::integer";
+    if (maxDepth) predicates << "depth_km <= ?::integer";
+    if (box) predicates << boxPredicate(*box);
+    if (secondBox) predicates << boxPredicate(*secondBox);
+    if (polygon.size() >= 3) {
+        predicates << "ST_Intersects(geom_source, ST_GeomFromText(?::text, 4326))";
+    }
+    if (!eventIdPrefix.isEmpty()) predicates << "event_id LIKE ?::text ESCAPE '\\'";
+    
+    return predicates.isEmpty() ? QString("TRUE") : predicates.join(" AND ");
+}
+
+QVariantList CatalogFilter::bindValues() const {
+    QVariantList values;
+    if (matchesNothing) return values;
+    
+    // Half-open day range, so the last second of endDate is included
+    if (startDate.isValid()) values << startDate.startOfDay();
+    if (endDate.isValid()) values << endDate.addDays(1).startOfDay();
+    if (minMagnitude) values << *minMagnitude;
+    if (maxMagnitude) values << *maxMagnitude;
+    if (minDepth) values << *minDepth;
+    if (maxDepth) values << *maxDepth;
+    if (box) appendBoxValues(values, *box);
+    if (secondBox) appendBoxValues(values, *secondBox);
+    if (polygon.size() >= 3) values << polygonWkt(polygon);
+    if (!eventIdPrefix.isEmpty()) values << likePrefix(eventIdPrefix);
+    return values;
+}
+
+QString CatalogFilter::shape() const {
+    if (matchesNothing) return QString("none");
+    
+    QString key;
+    key += startDate.isValid() ? 's' : '-';
+    key += endDate.isValid() ? 'e' : '-';
+    key += minMagnitude ? 'm' : '-';
+    key += maxMagnitude ? 'M' : '-';
+    key += minDepth ? 'd' : '-';
+    key += maxDepth ? 'D' : '-';
+    key += !box ? '-' : (box->west <= box->east ? 'b' : 'w');
+    key += !secondBox ? '-' : (secondBox->west <= secondBox->east ? 'b' : 'w');
+    key += polygon.size() >= 3 ? 'g' : '-';
+    key += eventIdPrefix.isEmpty() ? '-' : 'p';
+    return key;
+}
+
+bool CatalogFilter::matches(const SeismicEvent &event) const {
+    if (matchesNothing) return false;
+    if (startDate.isValid() && event.originTime < startDate.startOfDay()) return false;
+    if (endDate.isValid() && event.originTime >= endDate.addDays(1).startOfDay()) return false;
+    if (minMagnitude && event.magnitude < *minMagnitude) return false;
+    if (maxMagnitude && event.magnitude > *maxMagnitude) return false;
+    if (minDepth && event.depth < *minDepth) return false;
+    if (maxDepth && event.depth > *maxDepth) return false;
+    if (box && !boxContains(*box, event.latitude, event.longitude)) return false;
+    if (secondBox && !boxContains(*secondBox, event.latitude, event.longitude)) return false;
+    if (polygon.size() >= 3
+        && !QPolygonF(polygon).containsPoint(QPointF(event.longitude, event.latitude), Qt::OddEvenFill)) {
+        return false;
+    }
+    if (!eventIdPrefix.isEmpty() && !event.eventId.startsWith(eventIdPrefix)) return false;
+    return true;
+}
@@ -0,0 +1,455 @@
+#include "CatalogImporter.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSqlDriver>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <libpq-fe.h>
+
+namespace {
+const char kCopyColumns[] =
+    "event_id, origintime, magnitudo, latitude, longitude, depth_km, strike, dip, slip, geom_source";
+constexpr int kCopyFieldCount = 10;
+constexpr int kEventIdMaxLength = 20;
+// Encoded rows are handed to libpq in chunks of about this size
+constexpr int kCopyChunkBytes = 1 << 20;
+constexpr int kMaxRejectedLines = 10;
+
+// PostgreSQL timestamps count microseconds from 2000-01-01 UTC
+constexpr qint64 kPgEpochDays = 10957;
+
+PGconn *connectionHandle(const QSqlDatabase &db) {
+    if (!db.isOpen() || !db.driver()) return nullptr;
+    QVariant handle = db.driver()->handle();
+    if (!handle.isValid() || qstrcmp(handle.typeName(), "PGconn*") != 0) return nullptr;
+    return *static_cast<PGconn *const *>(handle.constData());
+}
+
+// Runs a statement that returns no rows of interest; false with the server's
+// message on failure
+bool execute(PGconn *conn, const char *sql, QString *error, QByteArray *affected = nullptr) {
+    PGresult *result = PQexec(conn, sql);
+    ExecStatusType status = PQresultStatus(result);
+    bool ok = status == PGRES_COMMAND_OK || status == PGRES_TUPLES_OK;
+    if (!ok && error) *error = QString::fromUtf8(PQresultErrorMessage(result)).trimmed();
+    if (ok && affected) *affected = QByteArray(PQcmdTuples(result));
+    PQclear(result);
+    return ok;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's days_from_civil)
+qint64 daysFromCivil(qint64 y, int m, int d) {
+    y -= m <= 2;
+    const qint64 era = (y >= 0 ? y : y - 399) / 400;
+    const qint64 yoe = y - era * 400;
+    const qint64 doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const qint64 doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+bool readDigits(const char *&p, const char *end, int count, int &value) {
+    value = 0;
+    for (int i = 0; i < count; ++i, ++p) {
+        if (p == end || *p < '0' || *p > '9') return false;
+        value = value * 10 + (*p - '0');
+    }
+    return true;
+}
+
+// YYYY-MM-DD[T ]HH:MM[:SS[.ffffff]][Z|±HH[:MM]] to PostgreSQL microseconds.
+// Hand-rolled: QDateTime::fromString costs more than the rest of the row.
+bool parseTimestamp(const QByteArray &text, qint64 &pgMicros) {
+    const char *p = text.constData();
+    const char *end = p + text.size();
+    int year, month, day, hour, minute, second = 0;
+    if (!readDigits(p, end, 4, year) || p == end || *p++ != '-'
+        || !readDigits(p, end, 2, month) || p == end || *p++ != '-'
+        || !readDigits(p, end, 2, day) || p == end || (*p != 'T' && *p != ' ')) {
+        return false;
+    }
+    ++p;
+    if (!readDigits(p, end, 2, hour) || p == end || *p++ != ':' || !readDigits(p, end, 2, minute)) {
+        return false;
+    }
+    if (p != end && *p == ':') {
+        ++p;
+        if (!readDigits(p, end, 2, second)) return false;
+    }
+    qint64 micros = 0;
+    if (p != end && *p == '.') {
+        ++p;
+        qint64 scale = 100000;
+        for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+            micros += (*p - '0') * scale;
+            scale /= 10;
+        }
+    }
+    int offsetMinutes = 0;
+    if (p != end && (*p == 'Z' || *p == 'z')) {
+        ++p;
+    } else if (p != end && (*p == '+' || *p == '-')) {
+        int sign = *p++ == '-' ? -1 : 1;
+        int offsetHours, offsetMins = 0;
+        if (!readDigits(p, end, 2, offsetHours)) return false;
+        if (p != end && *p == ':') ++p;
+        if (p != end && !readDigits(p, end, 2, offsetMins)) return false;
+        offsetMinutes = sign * (offsetHours * 60 + offsetMins);
+    }
+    if (p != end || month < 1 || month > 12 || day < 1 || day > 31
+        || hour > 23 || minute > 59 || second > 60) {
+        return false;
+    }
+    
+    qint64 days = daysFromCivil(year, month, day) - kPgEpochDays;
+    qint64 seconds = days * 86400 + hour * 3600 + minute * 60 + second - offsetMinutes * 60;
+    pgMicros = seconds * 1000000 + micros;
+    return true;
+}
+
+// Splits one line on delimiter; double quotes group fields and "" is a quote
+void splitLine(const QByteArray &line, char delimiter, QVector<QByteArray> &fields) {
+    fields.clear();
+    int size = int(line.size());
+    while (size > 0 && (line[size - 1] == '\n' || line[size - 1] == '\r')) --size;
+    
+    int i = 0;
+    while (true) {
+        QByteArray field;
+        if (i < size && line[i] == '"') {
+            for (++i; i < size; ++i) {
+                if (line[i] != '"') {
+                    field += line[i];
+                } else if (i + 1 < size && line[i + 1] == '"') {
+                    field += '"';
+                    ++i;
+                } else {
+                    ++i;
+                    break;
+                }
+            }
+            // Anything between the closing quote and the delimiter is dropped
+            while (i < size && line[i] != delimiter) ++i;
+        } else {
+            // Unquoted fields are sliced out whole
+            int next = int(line.indexOf(delimiter, i));
+            if (next < 0 || next > size) next = size;
+            field = line.mid(i, next - i);
+            i = next;
+        }
+        fields.append(field.trimmed());
+        if (i >= size) break;
+        ++i;
+    }
+}
+
+// Binary COPY writers: every value is a big-endian length then big-endian data
+void putInt16(QByteArray &out, qint16 value) {
+    value = qToBigEndian(value);
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void putInt32(QByteArray &out, qint32 value) {
+    value = qToBigEndian(value);
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void putInt64(QByteArray &out, qint64 value) {
+    value = qToBigEndian(value);
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void putFloat4Field(QByteArray &out, float value) {
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putInt32(out, 4);
+    putInt32(out, qint32(bits));
+}
+
+void putFloat8Field(QByteArray &out, double value) {
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putInt32(out, 8);
+    putInt64(out, qint64(bits));
+}
+
+void putInt32Field(QByteArray &out, std::optional<qint32> value) {
+    if (!value) {
+        putInt32(out, -1);
+        return;
+    }
+    putInt32(out, 4);
+    putInt32(out, *value);
+}
+
+// geometry_recv takes EWKB: little-endian point with the SRID flag set
+void putPointField(QByteArray &out, double lon, double lat) {
+    putInt32(out, 25);
+    out.append(char(1));
+    quint32 type = qToLittleEndian(quint32(0x20000001));
+    quint32 srid = qToLittleEndian(quint32(4326));
+    double xy[2] = {qToLittleEndian(lon), qToLittleEndian(lat)};
+    out.append(reinterpret_cast<const char *>(&type), sizeof(type));
+    out.append(reinterpret_cast<const char *>(&srid), sizeof(srid));
+    out.append(reinterpret_cast<const char *>(xy), sizeof(xy));
+}
+
+bool toDouble(const QByteArray &text, double &value) {
+    bool ok = false;
+    value = text.toDouble(&ok);
+    return ok && std::isfinite(value);
+}
+}
+
+CatalogImporter::CatalogImporter(const QSqlDatabase &db, const Options &options)
+    : m_db(db)
+    , m_options(options)
+    , m_delimiter(',')
+{
+    std::fill(std::begin(m_column), std::end(m_column), -1);
+}
+
+CatalogImporter::Result CatalogImporter::importFile(const QString &path, const Progress &progress) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        Result result;
+        result.error = QString("Cannot open %1: %2").arg(path, file.errorString());
+        return result;
+    }
+    return import(&file, progress);
+}
+
+bool CatalogImporter::mapHeader(const QVector<QByteArray> &header, QString *error) {
+    static const QVector<QVector<QByteArray>> names = {
+        {"event_id", "eventid", "id", "publicid"},
+        {"origintime", "time", "origin_time", "datetime"},
+        {"latitude", "lat"},
+        {"longitude", "lon", "long"},
+        {"depth_km", "depth", "depth/km"},
+        {"magnitudo", "magnitude", "mag"},
+        {"strike"},
+        {"dip"},
+        {"slip", "rake"},
+    };
+    
+    std::fill(std::begin(m_column), std::end(m_column), -1);
+    for (int column = 0; column < header.size(); ++column) {
+        QByteArray name = header[column].toLower();
+        for (int field = 0; field < kFieldCount; ++field) {
+            if (m_column[field] < 0 && names[field].contains(name)) {
+                m_column[field] = column;
+                break;
+            }
+        }
+    }
+    
+    QStringList missing;
+    for (int field = EventIdField; field <= MagnitudeField; ++field) {
+        if (m_column[field] < 0) missing << QString::fromLatin1(names[field].first());
+    }
+    if (!missing.isEmpty()) {
+        if (error) *error = QString("Header has no column for %1").arg(missing.join(", "));
+        return false;
+    }
+    return true;
+}
+
+bool CatalogImporter::encodeRow(const QVector<QByteArray> &fields, QString *reason) {
+    auto field = [&](Field f) -> QByteArray {
+        int column = m_column[f];
+        return column >= 0 && column < fields.size() ? fields[column] : QByteArray();
+    };
+    auto optionalInt = [&](Field f) -> std::optional<qint32> {
+        double value;
+        if (!toDouble(field(f), value)) return std::nullopt;
+        return qint32(std::lround(value));
+    };
+    
+    QByteArray eventId = field(EventIdField);
+    if (eventId.isEmpty()) {
+        *reason = "empty event id";
+        return false;
+    }
+    if (eventId.size() > kEventIdMaxLength && QString::fromUtf8(eventId).size() > kEventIdMaxLength) {
+        *reason = QString("event id longer than %1 characters").arg(kEventIdMaxLength);
+        return false;
+    }
+    
+    qint64 origin;
+    if (!parseTimestamp(field(TimeField), origin)) {
+        *reason = "unreadable origin time";
+        return false;
+    }
+    
+    double lat, lon, depth, magnitude;
+    if (!toDouble(field(LatitudeField), lat) || !toDouble(field(LongitudeField), lon)
+        || lat < -90.0 || lat > 90.0 || lon < -180.0 || lon > 180.0) {
+        *reason = "missing or out of range coordinates";
+        return false;
+    }
+    if (!toDouble(field(DepthField), depth) || !toDouble(field(MagnitudeField), magnitude)) {
+        *reason = "missing depth or magnitude";
+        return false;
+    }
+    
+    putInt16(m_buffer, kCopyFieldCount);
+    putInt32(m_buffer, qint32(eventId.size()));
+    m_buffer.append(eventId);
+    putInt32(m_buffer, 8);
+    putInt64(m_buffer, origin);
+    putFloat4Field(m_buffer, float(magnitude));
+    putFloat8Field(m_buffer, lat);
+    putFloat8Field(m_buffer, lon);
+    putInt32Field(m_buffer, qint32(std::lround(depth)));
+    putInt32Field(m_buffer, optionalInt(StrikeField));
+    putInt32Field(m_buffer, optionalInt(DipField));
+    putInt32Field(m_buffer, optionalInt(SlipField));
+    putPointField(m_buffer, lon, lat);
+    return true;
+}
+
+CatalogImporter::Result CatalogImporter::import(QIODevice *input, const Progress &progress) {
+    Result result;
+    QElapsedTimer timer;
+    timer.start();
+    
+    PGconn *conn = connectionHandle(m_db);
+    if (!conn) {
+        result.error = "Bulk import needs an open QPSQL connection";
+        return result;
+    }
+    
+    // Header: first non-empty line
+    QVector<QByteArray> fields;
+    QByteArray line;
+    qint64 lineNumber = 0;
+    while (!input->atEnd() && line.trimmed().isEmpty()) {
+        line = input->readLine();
+        ++lineNumber;
+    }
+    if (line.startsWith("\xEF\xBB\xBF")) line.remove(0, 3);
+    if (line.startsWith('#')) line.remove(0, 1);
+    m_delimiter = line.contains('|') ? '|' : ',';
+    splitLine(line, m_delimiter, fields);
+    if (!mapHeader(fields, &result.error)) return result;
+    
+    if (!execute(conn, "BEGIN", &result.error)) return result;
+    auto fail = [&](const QString &error) {
+        result.error = error;
+        result.rows = 0;
+        execute(conn, "ROLLBACK", nullptr);
+        result.elapsedMs = timer.elapsed();
+        return result;
+    };
+    
+    // Keeps notify_sumber_tsunami() quiet for this transaction
+    if (!execute(conn, "SELECT set_config('tsunami.bulk_import', 'on', true)", &result.error)) {
+        return fail(result.error);
+    }
+    
+    QByteArray target = "sumber_tsunami";
+    if (m_options.skipExisting) {
+        target = "sumber_tsunami_import";
+        QByteArray create = QByteArray("CREATE TEMP TABLE sumber_tsunami_import ON COMMIT DROP AS SELECT ")
+                            + kCopyColumns + " FROM sumber_tsunami WITH NO DATA";
+        if (!execute(conn, create.constData(), &result.error)) return fail(result.error);
+    }
+    
+    QByteArray copy = "COPY " + target + " (" + kCopyColumns + ") FROM STDIN (FORMAT binary)";
+    PGresult *copyResult = PQexec(conn, copy.constData());
+    bool copying = PQresultStatus(copyResult) == PGRES_COPY_IN;
+    if (!copying) result.error = QString::fromUtf8(PQresultErrorMessage(copyResult)).trimmed();
+    PQclear(copyResult);
+    if (!copying) return fail(result.error);
+    
+    // Signature, flags and header extension length
+    m_buffer.clear();
+    m_buffer.reserve(kCopyChunkBytes + 4096);
+    m_buffer.append("PGCOPY\n\377\r\n\0", 11);
+    putInt32(m_buffer, 0);
+    putInt32(m_buffer, 0);
+    
+    auto flush = [&]() {
+        if (PQputCopyData(conn, m_buffer.constData(), int(m_buffer.size())) != 1) return false;
+        m_buffer.clear();
+        return true;
+    };
+    auto abortCopy = [&](const char *reason) {
+        PQputCopyEnd(conn, reason);
+        while (PGresult *pending = PQgetResult(conn)) PQclear(pending);
+    };
+    
+    const qint64 totalBytes = input->isSequential() ? 0 : input->size();
+    qint64 encoded = 0;
+    while (!input->atEnd()) {
+        line = input->readLine();
+        ++lineNumber;
+        if (line.trimmed().isEmpty() || line.startsWith('#')) continue;
+        
+        splitLine(line, m_delimiter, fields);
+        QString reason;
+        if (!encodeRow(fields, &reason)) {
+            ++result.skipped;
+            if (result.rejected.size() < kMaxRejectedLines) {
+                result.rejected << QString("line %1: %2").arg(lineNumber).arg(reason);
+            }
+            continue;
+        }
+        ++encoded;
+        
+        if (m_buffer.size() >= kCopyChunkBytes && !flush()) {
+            QString error = QString::fromUtf8(PQerrorMessage(conn)).trimmed();
+            abortCopy("client send failed");
+            return fail(error);
+        }
+        if (progress && encoded % m_options.progressInterval == 0
+            && !progress(encoded, input->pos(), totalBytes)) {
+            abortCopy("import canceled");
+            return fail("Import canceled");
+        }
+    }
+    
+    putInt16(m_buffer, -1);
+    if (!flush() || PQputCopyEnd(conn, nullptr) != 1) {
+        QString error = QString::fromUtf8(PQerrorMessage(conn)).trimmed();
+        abortCopy("client send failed");
+        return fail(error);
+    }
+    
+    // Server-side errors (duplicate event_id, bad values) arrive here
+    QString copyError;
+    while (PGresult *pending = PQgetResult(conn)) {
+        if (PQresultStatus(pending) != PGRES_COMMAND_OK && copyError.isEmpty()) {
+            copyError = QString::fromUtf8(PQresultErrorMessage(pending)).trimmed();
+        }
+        PQclear(pending);
+    }
+    if (!copyError.isEmpty()) return fail(copyError);
+    
+    result.rows = encoded;
+    if (m_options.skipExisting) {
+        // Duplicates inside the file count as existing too
+        QByteArray insert = QByteArray("INSERT INTO sumber_tsunami (") + kCopyColumns + ") "
+                            "SELECT DISTINCT ON (event_id) " + kCopyColumns + " FROM sumber_tsunami_import "
+                            "ORDER BY event_id ON CONFLICT (event_id) DO NOTHING";
+        QByteArray affected;
+        if (!execute(conn, insert.constData(), &result.error, &affected)) return fail(result.error);
+        result.rows = affected.toLongLong();
+        result.skipped += encoded - result.rows;
+    }
+    
+    // One notification for the whole import instead of one per row
+    if (!execute(conn, "SELECT pg_notify('sumber_tsunami_changes', "
+                       "json_build_object('op', 'BULK', 'txid', txid_current())::text)", &result.error)
+        || !execute(conn, "COMMIT", &result.error)) {
+        return fail(result.error);
+    }
+    
+    if (progress) progress(result.rows, input->pos(), totalBytes);
+    result.ok = true;
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
@@ -0,0 +1,229 @@
+#include "ConnectionPool.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QDebug>
+
+namespace {
+qint64 nowMs() {
+    return QDateTime::currentMSecsSinceEpoch();
+}
+}
+
+ConnectionSettings ConnectionSettings::fromEnvironment() {
+    ConnectionSettings settings;
+    if (qEnvironmentVariableIsSet("TSUNAMI_DB_HOST")) settings.host = qEnvironmentVariable("TSUNAMI_DB_HOST");
+    if (qEnvironmentVariableIsSet("TSUNAMI_DB_PORT")) settings.port = qEnvironmentVariableIntValue("TSUNAMI_DB_PORT");
+    if (qEnvironmentVariableIsSet("TSUNAMI_DB_NAME")) settings.database = qEnvironmentVariable("TSUNAMI_DB_NAME");
+    if (qEnvironmentVariableIsSet("TSUNAMI_DB_USER")) settings.user = qEnvironmentVariable("TSUNAMI_DB_USER");
+    if (qEnvironmentVariableIsSet("TSUNAMI_DB_PASSWORD")) settings.password = qEnvironmentVariable("TSUNAMI_DB_PASSWORD");
+    return settings;
+}
+
+ConnectionPool::Lease::Lease(ConnectionPool *pool, const QString &name)
+    : m_pool(pool)
+    , m_name(name)
+{
+}
+
+ConnectionPool::Lease::Lease(Lease &&other) noexcept
+    : m_pool(other.m_pool)
+    , m_name(std::move(other.m_name))
+{
+    other.m_pool = nullptr;
+}
+
+ConnectionPool::Lease &ConnectionPool::Lease::operator=(Lease &&other) noexcept {
+    if (this != &other) {
+        release();
+        m_pool = other.m_pool;
+        m_name = std::move(other.m_name);
+        other.m_pool = nullptr;
+    }
+    return *this;
+}
+
+ConnectionPool::Lease::~Lease() {
+    release();
+}
+
+QSqlDatabase ConnectionPool::Lease::database() const {
+    return m_pool ? QSqlDatabase::database(m_name, false) : QSqlDatabase();
+}
+
+bool ConnectionPool::Lease::ensureHealthy(bool *reconnected) {
+    if (reconnected) *reconnected = false;
+    if (!m_pool) return false;
+    
+    ThreadConnection *connection = m_pool->m_threadConnections.localData();
+    QSqlDatabase db = database();
+    
+    bool healthy = db.isOpen();
+    if (healthy && nowMs() - connection->lastUsedMs >= kHealthCheckIdleMs) {
+        healthy = QSqlQuery(db).exec("SELECT 1");
+    }
+    connection->lastUsedMs = nowMs();
+    if (healthy) return true;
+    
+    // Server restarted or the socket died while idle
+    db.close();
+    QString error;
+    if (!m_pool->openConnection(db, &error)) {
+        qWarning() << "Database reconnect failed:" << error;
+        return false;
+    }
+    ++m_pool->m_reconnects;
+    if (reconnected) *reconnected = true;
+    return true;
+}
+
+void ConnectionPool::Lease::release() {
+    if (!m_pool) return;
+    
+    m_pool->releaseLease();
+    m_pool = nullptr;
+}
+
+ConnectionPool::ThreadConnection::~ThreadConnection() {
+    // Runs on the owning thread as it exits
+    {
+        QSqlDatabase db = QSqlDatabase::database(name, false);
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(name);
+    --pool->m_openConnections;
+}
+
+ConnectionPool &ConnectionPool::instance() {
+    static ConnectionPool pool;
+    return pool;
+}
+
+ConnectionPool::ConnectionPool()
+    : m_settings(ConnectionSettings::fromEnvironment())
+    , m_permits(4)
+    , m_maxConnections(4)
+    , m_nextId(0)
+    , m_openConnections(0)
+    , m_leasesOut(0)
+    , m_reconnects(0)
+    , m_timeouts(0)
+    , m_maxWaitUs(0)
+{
+}
+
+void ConnectionPool::configure(const ConnectionSettings &settings, int maxConnections) {
+    // Only meaningful before the first lease is handed out
+    QMutexLocker locker(&m_mutex);
+    m_settings = settings;
+    int delta = maxConnections - m_maxConnections;
+    if (delta > 0) {
+        m_permits.release(delta);
+    } else if (delta < 0) {
+        m_permits.acquire(-delta);
+    }
+    m_maxConnections = maxConnections;
+}
+
+bool ConnectionPool::isDriverAvailable() const {
+    return QSqlDatabase::isDriverAvailable("QPSQL");
+}
+
+ConnectionPool::Lease ConnectionPool::acquire(int timeoutMs, QString *error) {
+    // Nested leases on one thread share its connection and its permit
+    ThreadConnection *existing = m_threadConnections.hasLocalData()
+                                 ? m_threadConnections.localData() : nullptr;
+    bool needPermit = !existing || existing->leases == 0;
+    
+    if (needPermit) {
+        QElapsedTimer wait;
+        wait.start();
+        if (!m_permits.tryAcquire(1, timeoutMs)) {
+            ++m_timeouts;
+            if (error) *error = QString("No database connection free within %1 ms").arg(timeoutMs);
+            return Lease();
+        }
+        qint64 waitedUs = wait.nsecsElapsed() / 1000;
+        qint64 maxWait = m_maxWaitUs.load();
+        while (waitedUs > maxWait && !m_maxWaitUs.compare_exchange_weak(maxWait, waitedUs)) {
+        }
+    }
+    
+    ThreadConnection *connection = threadConnection(error);
+    if (!connection) {
+        if (needPermit) m_permits.release();
+        return Lease();
+    }
+    
+    ++connection->leases;
+    ++m_leasesOut;
+    Lease lease(this, connection->name);
+    if (!lease.ensureHealthy()) {
+        if (error) *error = lease.database().lastError().text();
+        return Lease();
+    }
+    return lease;
+}
+
+ConnectionPool::ThreadConnection *ConnectionPool::threadConnection(QString *error) {
+    if (m_threadConnections.hasLocalData()) {
+        return m_threadConnections.localData();
+    }
+    
+    QString name = QString("tsunami_pool_%1").arg(m_nextId++);
+    QSqlDatabase db = QSqlDatabase::addDatabase("QPSQL", name);
+    if (!openConnection(db, error)) {
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(name);
+        return nullptr;
+    }
+    
+    auto *connection = new ThreadConnection;
+    connection->name = name;
+    connection->lastUsedMs = nowMs();
+    connection->pool = this;
+    m_threadConnections.setLocalData(connection);
+    ++m_openConnections;
+    return connection;
+}
+
+bool ConnectionPool::openConnection(QSqlDatabase &db, QString *error) {
+    ConnectionSettings settings;
+    {
+        QMutexLocker locker(&m_mutex);
+        settings = m_settings;
+    }
+    
+    db.setHostName(settings.host);
+    db.setPort(settings.port);
+    db.setDatabaseName(settings.database);
+    db.setUserName(settings.user);
+    db.setPassword(settings.password);
+    // Fail fast instead of hanging a worker on an unreachable server
+    db.setConnectOptions("connect_timeout=5");
+    
+    if (!db.open()) {
+        if (error) *error = db.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+void ConnectionPool::releaseLease() {
+    ThreadConnection *connection = m_threadConnections.localData();
+    --m_leasesOut;
+    if (--connection->leases == 0) {
+        m_permits.release();
+    }
+}
+
+ConnectionPool::Stats ConnectionPool::stats() const {
+    Stats stats;
+    stats.openConnections = m_openConnections;
+    stats.leasesOut = m_leasesOut;
+    stats.reconnects = m_reconnects;
+    stats.timeouts = m_timeouts;
+    stats.maxWaitUs = m_maxWaitUs;
+    return stats;
+}
@@ -1,29 +1,80 @@
 #include "DatabaseView.h"
+#include "DatabaseWorker.h"
+#include "EventTableModel.h"
+#include "ConnectionPool.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QHeaderView>
-#include <QSqlError>
-#include <QSqlQuery>
-#include <QSqlRecord>
+#include <QSqlDatabase>
 #include <QMessageBox>
+#include <QFileDialog>
+#include <QFileInfo>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QDate>
 #include <QDebug>
 
+namespace {
+bool boxContains(const CatalogFilter::GeoBox &outer, const CatalogFilter::GeoBox &inner) {
+    return inner.south >= outer.south && inner.north <= outer.north
+        && inner.west >= outer.west && inner.east <= outer.east;
+}
+
+double boxArea(const CatalogFilter::GeoBox &box) {
+    return (box.north - box.south) * (box.east - box.west);
+}
+}
+
 DatabaseView::DatabaseView(QWidget *parent) 
     : QWidget(parent)
     , m_model(nullptr)
+    , m_worker(nullptr)
+    , m_activeRequest(0)
+    , m_explainQueries(qEnvironmentVariableIsSet("TSUNAMI_SQL_EXPLAIN"))
+    , m_importing(false)
+    , m_searchTimer(nullptr)
+    , m_mapAreaCheck(nullptr)
     , m_isConnected(false)
+    , m_snapshotPath(EventSnapshot::defaultPath())
+    , m_reconnectTimer(nullptr)
+    , m_snapshotTimer(nullptr)
+    , m_storeCurrent(false)
+    , m_changeTimer(nullptr)
+    , m_regionRequest(0)
+    , m_loadedComplete(false)
 {
+    m_worker = new DatabaseWorker();
+    m_worker->moveToThread(&m_dbThread);
+    connect(&m_dbThread, &QThread::finished, m_worker, &QObject::deleteLater);
+    
+    connect(m_worker, &DatabaseWorker::opened, this, &DatabaseView::onDatabaseOpened);
+    connect(m_worker, &DatabaseWorker::windowReady, this, &DatabaseView::onWindowReady);
+    connect(m_worker, &DatabaseWorker::queryCanceled, this, &DatabaseView::onQueryCanceled);
+    connect(m_worker, &DatabaseWorker::queryFailed, this, &DatabaseView::onQueryFailed);
+    connect(m_worker, &DatabaseWorker::regionLoaded, this, &DatabaseView::onRegionLoaded);
+    connect(m_worker, &DatabaseWorker::statementStats, this, &DatabaseView::onStatementStats);
+    connect(m_worker, &DatabaseWorker::liveUpdatesInterrupted, this, &DatabaseView::onLiveUpdatesInterrupted);
+    connect(m_worker, &DatabaseWorker::connectionLost, this, &DatabaseView::onConnectionLost);
+    connect(m_worker, &DatabaseWorker::snapshotSynced, this, &DatabaseView::onSnapshotSynced);
+    connect(m_worker, &DatabaseWorker::catalogChanged, this, &DatabaseView::onCatalogChanged);
+    connect(m_worker, &DatabaseWorker::importProgress, this, &DatabaseView::onImportProgress);
+    connect(m_worker, &DatabaseWorker::importFinished, this, &DatabaseView::onImportFinished);
+    m_dbThread.setObjectName("DatabaseThread");
+    m_dbThread.start();
+    
     setupUI();
     setupDatabase();
 }
 
 DatabaseView::~DatabaseView() {
-    if (m_db.isOpen()) {
-        m_db.close();
+    // Running query stops at its next batch; the worker closes its connection
+    // on the database thread before the thread exits
+    if (m_activeRequest != 0) {
+        m_worker->interrupt(m_activeRequest);
     }
-    QSqlDatabase::removeDatabase("tsunami_connection");
+    m_worker->cancelAll();
+    m_dbThread.quit();
+    m_dbThread.wait();
 }
 
 void DatabaseView::setupUI() {
@@ -35,10 +86,18 @@ void DatabaseView::setupUI() {
     m_tableView->setAlternatingRowColors(true);
     m_tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
     m_tableView->setSelectionMode(QAbstractItemView::SingleSelection);
-    m_tableView->setSortingEnabled(true);
     m_tableView->horizontalHeader()->setStretchLastSection(true);
     m_tableView->setEditTriggers(QAbstractItemView::NoEditTriggers);
     
+    // Paged model: rows stay in server order (origintime, id) newest first.
+    // Column sizing only looks at visible rows so it never pulls in the whole window.
+    m_model = new EventTableModel(m_worker, this);
+    m_tableView->setModel(m_model);
+    m_tableView->horizontalHeader()->setResizeContentsPrecision(0);
+    m_tableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    connect(m_tableView->selectionModel(), &QItemSelectionModel::selectionChanged,
+            this, &DatabaseView::onSelectionChanged);
+    
     mainLayout->addWidget(m_tableView);
     
     // Date range filter section
@@ -59,12 +118,37 @@ void DatabaseView::setupUI() {
     m_endDateEdit->setDate(QDate::currentDate());
     dateLayout->addWidget(m_endDateEdit);
     
+    dateLayout->addWidget(new QLabel("Min Mag:"));
+    m_minMagnitudeEdit = new QDoubleSpinBox();
+    m_minMagnitudeEdit->setRange(0.0, 10.0);
+    m_minMagnitudeEdit->setSingleStep(0.1);
+    m_minMagnitudeEdit->setDecimals(1);
+    dateLayout->addWidget(m_minMagnitudeEdit);
+    
     m_btnFilter = new QPushButton("Apply Filter");
     dateLayout->addWidget(m_btnFilter);
     dateLayout->addStretch();
     
     mainLayout->addLayout(dateLayout);
     
+    // Free-text search, narrows the date and magnitude filter above
+    auto *searchLayout = new QHBoxLayout();
+    searchLayout->addWidget(new QLabel("Search:"));
+    m_searchEdit = new QLineEdit();
+    m_searchEdit->setClearButtonEnabled(true);
+    m_searchEdit->setPlaceholderText("m6.5+  m6-7  d<70  lat:-11..6  lon:95..141  box:S,W,N,E  2024-12  id:ujicoba");
+    searchLayout->addWidget(m_searchEdit, 1);
+    m_mapAreaCheck = new QCheckBox("Map area only");
+    m_mapAreaCheck->setToolTip("Only events inside the map viewport and the region drawn on the map");
+    searchLayout->addWidget(m_mapAreaCheck);
+    mainLayout->addLayout(searchLayout);
+    
+    // Query once typing pauses, not on every keystroke
+    m_searchTimer = new QTimer(this);
+    m_searchTimer->setSingleShot(true);
+    m_searchTimer->setInterval(300);
+    connect(m_searchTimer, &QTimer::timeout, this, &DatabaseView::loadData);
+    
     // Bottom toolbar
     auto *bottomLayout = new QHBoxLayout();
     
@@ -72,6 +156,20 @@ void DatabaseView::setupUI() {
     m_statusLabel->setStyleSheet("padding: 5px; background-color: #44444E; border: 1px solid #715A5A;");
     bottomLayout->addWidget(m_statusLabel, 1);
     
+    m_progressBar = new QProgressBar();
+    m_progressBar->setMaximumWidth(200);
+    m_progressBar->setVisible(false);
+    bottomLayout->addWidget(m_progressBar);
+    
+    m_btnCancel = new QPushButton("Cancel");
+    m_btnCancel->setVisible(false);
+    bottomLayout->addWidget(m_btnCancel);
+    
+    m_btnImport = new QPushButton("Import Catalog...");
+    m_btnImport->setToolTip("Bulk load a CSV catalog (USGS, ISC or FDSN text export); "
+                            "event ids already in the database are skipped");
+    bottomLayout->addWidget(m_btnImport);
+    
     m_btnSelect = new QPushButton("Select Event");
     m_btnSelect->setEnabled(false);
     m_btnSelect->setMinimumWidth(120);
@@ -83,19 +181,42 @@ void DatabaseView::setupUI() {
     connect(m_btnSelect, &QPushButton::clicked, this, &DatabaseView::onSelectEvent);
     connect(m_btnFilter, &QPushButton::clicked, this, &DatabaseView::onDateRangeChanged);
     connect(m_tableView, &QTableView::doubleClicked, this, &DatabaseView::onTableDoubleClicked);
+    connect(m_btnCancel, &QPushButton::clicked, this, &DatabaseView::onCancelQuery);
+    connect(m_btnImport, &QPushButton::clicked, this, &DatabaseView::onImportClicked);
+    connect(m_searchEdit, &QLineEdit::textChanged, this, &DatabaseView::onSearchTextChanged);
+    connect(m_searchEdit, &QLineEdit::returnPressed, this, &DatabaseView::loadData);
+    connect(m_mapAreaCheck, &QCheckBox::toggled, this, &DatabaseView::loadData);
+    
+    // While offline the connection is retried in the background
+    m_reconnectTimer = new QTimer(this);
+    m_reconnectTimer->setInterval(kReconnectIntervalMs);
+    connect(m_reconnectTimer, &QTimer::timeout, this, [this]() {
+        QMetaObject::invokeMethod(m_worker, &DatabaseWorker::open, Qt::QueuedConnection);
+    });
+    
+    m_snapshotTimer = new QTimer(this);
+    m_snapshotTimer->setInterval(kSnapshotSyncIntervalMs);
+    connect(m_snapshotTimer, &QTimer::timeout, this, &DatabaseView::syncSnapshot);
+    
+    m_changeTimer = new QTimer(this);
+    m_changeTimer->setSingleShot(true);
+    m_changeTimer->setInterval(kChangeSyncDelayMs);
+    connect(m_changeTimer, &QTimer::timeout, this, &DatabaseView::syncSnapshot);
 }
 
 void DatabaseView::setupDatabase() {
-    if (connectToDatabase()) {
+    // The local snapshot fills the table before the server has answered;
+    // the first sync in onDatabaseOpened brings it up to date
+    if (m_snapshot.open(m_snapshotPath)) {
+        m_store.assign(m_snapshot);
         loadData();
     }
+    connectToDatabase();
 }
 
 bool DatabaseView::connectToDatabase() {
-    QStringList drivers = QSqlDatabase::drivers();
-    qDebug() << "Available SQL drivers:" << drivers;
-    
-    if (!drivers.contains("QPSQL")) {
+    if (!ConnectionPool::instance().isDriverAvailable()) {
+        qDebug() << "Available SQL drivers:" << QSqlDatabase::drivers();
         QString errorMsg = "PostgreSQL driver (QPSQL) not available.\n"
                           "Install: sudo apt-get install libqt6sql6-psql";
         m_statusLabel->setText("Driver not found");
@@ -104,27 +225,160 @@ bool DatabaseView::connectToDatabase() {
         return false;
     }
     
-    m_db = QSqlDatabase::addDatabase("QPSQL", "tsunami_connection");
-    m_db.setHostName("localhost");
-    m_db.setDatabaseName("tsunami_data");
-    m_db.setUserName("farhan");
-    m_db.setPassword("farhan");
-    
-    if (!m_db.open()) {
-        QString errorMsg = QString("Connection failed: %1\n\n"
-                                  "Make sure PostgreSQL is running and database is created.\n"
-                                  "Run: ./setup_database.sh")
-                          .arg(m_db.lastError().text());
-        m_statusLabel->setText("Connection failed");
-        m_statusLabel->setStyleSheet("padding: 5px; background-color: #8B0000; color: white;");
-        QMessageBox::warning(this, "Database Error", errorMsg);
-        return false;
+    // Connection is opened on the database thread; result arrives in onDatabaseOpened
+    if (!m_model->isLocal()) {
+        m_statusLabel->setText("Connecting to tsunami_data...");
+    }
+    QMetaObject::invokeMethod(m_worker, &DatabaseWorker::open, Qt::QueuedConnection);
+    return true;
+}
+
+void DatabaseView::onDatabaseOpened(bool ok, const QString &error) {
+    if (!ok) {
+        // No modal: the snapshot (if any) stays usable and the retry is automatic
+        m_isConnected = false;
+        m_reconnectTimer->start();
+        if (m_snapshot.isOpen()) {
+            m_statusLabel->setToolTip("Connection failed: " + error);
+            loadFromStore();
+        } else {
+            m_statusLabel->setText(QString("Connection failed: %1 (retrying; run ./setup_database.sh "
+                                           "if the database does not exist)").arg(error));
+            m_statusLabel->setStyleSheet("padding: 5px; background-color: #8B0000; color: white;");
+        }
+        return;
     }
     
+    m_reconnectTimer->stop();
+    if (m_isConnected) return;
+    
+    // First connection or back from an outage. With a snapshot the view
+    // refreshes once the sync is in; without one the server serves the view
+    // until the first sync has written it
     m_isConnected = true;
-    m_statusLabel->setText("Connected to tsunami_data");
-    m_statusLabel->setStyleSheet("padding: 5px; background-color: #006400; color: white;");
-    return true;
+    m_statusLabel->setToolTip(QString());
+    if (!m_snapshot.isOpen()) {
+        loadData();
+        m_loadedBox.reset();
+        loadMapRegion();
+    }
+    syncSnapshot();
+    m_snapshotTimer->start();
+}
+
+void DatabaseView::onConnectionLost() {
+    if (!m_isConnected) return;
+    
+    m_isConnected = false;
+    m_storeCurrent = false;
+    m_snapshotTimer->stop();
+    m_changeTimer->stop();
+    m_reconnectTimer->start();
+    if (m_activeRequest != 0) {
+        m_worker->cancelAll();
+        m_activeRequest = 0;
+        setQueryRunning(false);
+    }
+    
+    // Read-only service from the snapshot until the server is back
+    loadData();
+    m_loadedBox.reset();
+    loadMapRegion();
+}
+
+void DatabaseView::syncSnapshot() {
+    if (!m_isConnected) return;
+    
+    QMetaObject::invokeMethod(m_worker, [worker = m_worker, path = m_snapshotPath]() {
+        worker->syncSnapshot(path);
+    }, Qt::QueuedConnection);
+}
+
+void DatabaseView::onSnapshotSynced(const QVector<SeismicEvent> &changed, const QVector<int> &removed,
+                                    bool replaced) {
+    if (!m_isConnected) return;
+    
+    const bool wasOpen = m_snapshot.isOpen();
+    bool stale = replaced || !wasOpen || !changed.isEmpty() || !removed.isEmpty();
+    if (!stale && m_storeCurrent) return;
+    
+    if (m_storeCurrent && wasOpen && !replaced && m_model->isLocal()) {
+        // Live changes: the table follows row by row, keeping its selection
+        // and scroll position, like a server window does
+        m_snapshot.open(m_snapshotPath);
+        m_store.apply(changed, removed);
+        QSet<int> changedIds;
+        for (const SeismicEvent &event : changed) changedIds.insert(event.id);
+        loadFromStore(&changedIds);
+        m_loadedBox.reset();
+        loadMapRegion();
+        return;
+    }
+    
+    if (stale) {
+        // The store takes the sync's rows as they are; the file is only read
+        // again when the store did not start from it. The model indexes into
+        // the store, so it lets go of its rows first
+        if (m_model->isLocal()) m_model->clear();
+        m_snapshot.open(m_snapshotPath);
+        if (replaced || !wasOpen) {
+            m_store.assign(m_snapshot);
+        } else {
+            m_store.apply(changed, removed);
+        }
+    }
+    
+    // From here on filters are answered from memory
+    m_storeCurrent = true;
+    if (m_activeRequest != 0) {
+        m_worker->interrupt(m_activeRequest);
+        m_activeRequest = 0;
+        setQueryRunning(false);
+    }
+    loadData();
+    m_loadedBox.reset();
+    loadMapRegion();
+}
+
+void DatabaseView::onCatalogChanged() {
+    // The server-side window follows changes by itself; the store needs a
+    // sync. The timer is not restarted, so a steady stream still syncs
+    if (m_storeCurrent && !m_changeTimer->isActive()) {
+        m_changeTimer->start();
+    }
+}
+
+void DatabaseView::loadFromStore(const QSet<int> *changedIds) {
+    QElapsedTimer timer;
+    timer.start();
+    EventStore::Bitmap matches = m_store.filter(m_requestFilter);
+    QVector<int> rows = m_store.rows(matches);
+    qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+    
+    if (changedIds && m_model->isLocal()) {
+        m_model->updateLocalRows(rows, *changedIds);
+    } else {
+        m_model->setLocalRows(&m_store, rows);
+        m_btnSelect->setEnabled(false);
+    }
+    
+    if (m_storeCurrent) {
+        m_statusLabel->setText(QString("Loaded %1 of %2 events from %3 to %4 (in memory, %5 µs)")
+                              .arg(rows.size())
+                              .arg(m_store.rowCount())
+                              .arg(m_requestFilter.startDate.toString("dd MMM yyyy"))
+                              .arg(m_requestFilter.endDate.toString("dd MMM yyyy"))
+                              .arg(elapsedUs));
+        m_statusLabel->setStyleSheet("padding: 5px; background-color: #006400; color: white;");
+        return;
+    }
+    
+    QString state = m_reconnectTimer->isActive() ? "database offline" : "connecting";
+    m_statusLabel->setText(QString("%1 events from local snapshot (synced %2, %3)")
+                          .arg(rows.size())
+                          .arg(m_snapshot.version().syncedAt.toLocalTime().toString("dd MMM yyyy HH:mm"))
+                          .arg(state));
+    m_statusLabel->setStyleSheet("padding: 5px; background-color: #7A5C00; color: white;");
 }
 
 void DatabaseView::loadData() {
@@ -134,53 +388,287 @@ void DatabaseView::loadData() {
 }
 
 void DatabaseView::loadDataWithDateFilter(const QDate &startDate, const QDate &endDate) {
-    if (!m_isConnected) {
-        QMessageBox::warning(this, "Database Error", "Not connected to database");
+    // Invalid search text keeps the current window instead of querying
+    QString searchError;
+    CatalogFilter search = CatalogFilter::parse(m_searchEdit->text(), &searchError);
+    if (!searchError.isEmpty()) {
+        m_statusLabel->setText(searchError);
+        m_statusLabel->setStyleSheet("padding: 5px; background-color: #8B0000; color: white;");
         return;
     }
+    m_searchTimer->stop();
     
-    m_model = new QSqlQueryModel(this);
+    CatalogFilter filter;
+    filter.startDate = startDate;
+    filter.endDate = endDate;
+    if (m_minMagnitudeEdit->value() > 0.0) {
+        filter.minMagnitude = m_minMagnitudeEdit->value();
+    }
+    if (m_mapAreaCheck->isChecked() && m_mapView) {
+        filter.box = m_mapView;
+        filter.polygon = m_mapPolygon;
+    }
     
-    QString queryStr = QString(
-        "SELECT event_id, origintime, magnitudo, latitude, longitude, depth_km, strike, dip, slip "
-        "FROM sumber_tsunami "
-        "WHERE origintime BETWEEN '%1 00:00:00' AND '%2 23:59:59' "
-        "ORDER BY origintime DESC"
-    ).arg(startDate.toString("yyyy-MM-dd"))
-     .arg(endDate.toString("yyyy-MM-dd"));
+    if (!m_isConnected || m_storeCurrent) {
+        m_requestFilter = filter.intersected(search);
+        if (m_snapshot.isOpen()) {
+            loadFromStore();
+        } else {
+            m_statusLabel->setText("Not connected to database");
+            m_statusLabel->setStyleSheet("padding: 5px; background-color: #8B0000; color: white;");
+        }
+        return;
+    }
     
-    m_model->setQuery(queryStr, m_db);
+    // A new filter supersedes whatever is still running, on the server too
+    if (m_activeRequest != 0) {
+        m_worker->interrupt(m_activeRequest);
+    }
+    m_activeRequest = m_worker->nextRequestId();
+    m_requestFilter = filter.intersected(search);
     
-    if (m_model->lastError().isValid()) {
-        m_statusLabel->setText("Query error: " + m_model->lastError().text());
-        m_statusLabel->setStyleSheet("padding: 5px; background-color: #8B0000; color: white;");
+    m_model->clear();
+    m_btnSelect->setEnabled(false);
+    setQueryRunning(true);
+    m_progressBar->setRange(0, 0);
+    m_statusLabel->setText(QString("Loading events from %1 to %2...")
+                          .arg(m_requestFilter.startDate.toString("dd MMM yyyy"))
+                          .arg(m_requestFilter.endDate.toString("dd MMM yyyy")));
+    m_statusLabel->setStyleSheet("padding: 5px; background-color: #44444E; border: 1px solid #715A5A;");
+    
+    QMetaObject::invokeMethod(m_worker, [worker = m_worker, requestId = m_activeRequest,
+                                         filter = m_requestFilter]() {
+        worker->openWindow(requestId, filter, EventTableModel::kPageSize);
+    }, Qt::QueuedConnection);
+}
+
+void DatabaseView::setMapView(const CatalogFilter::GeoBox &view) {
+    m_mapView = view;
+    loadMapRegion();
+    if (m_mapAreaCheck->isChecked()) {
+        m_searchTimer->start();
+    }
+}
+
+void DatabaseView::setMapRegion(const QVector<QPointF> &polygon) {
+    m_mapPolygon = polygon;
+    // Rows held for the previous region say nothing about the new one
+    m_loadedBox.reset();
+    loadMapRegion();
+    if (m_mapAreaCheck->isChecked()) {
+        m_searchTimer->start();
+    }
+}
+
+void DatabaseView::loadMapRegion() {
+    if (!m_mapView) return;
+    
+    if (!m_isConnected || m_storeCurrent) {
+        // In memory: cheap enough to redo for every view, no padding needed
+        if (!m_snapshot.isOpen()) return;
+        CatalogFilter filter;
+        filter.box = m_mapView;
+        filter.polygon = m_mapPolygon;
+        QVector<int> rows = m_store.largest(m_store.filter(filter), kMaxMapEvents);
+        m_regionEvents.clear();
+        m_regionEvents.reserve(rows.size());
+        for (int row : std::as_const(rows)) {
+            m_regionEvents.append(m_store.event(row));
+        }
+        m_loadedBox.reset();
+        emit catalogLoaded(m_regionEvents);
         return;
     }
     
-    m_model->setHeaderData(0, Qt::Horizontal, "Event ID");
-    m_model->setHeaderData(1, Qt::Horizontal, "Origin Time (UTC)");
-    m_model->setHeaderData(2, Qt::Horizontal, "Magnitude");
-    m_model->setHeaderData(3, Qt::Horizontal, "Latitude");
-    m_model->setHeaderData(4, Qt::Horizontal, "Longitude");
-    m_model->setHeaderData(5, Qt::Horizontal, "Depth (km)");
-    m_model->setHeaderData(6, Qt::Horizontal, "Strike");
-    m_model->setHeaderData(7, Qt::Horizontal, "Dip");
-    m_model->setHeaderData(8, Qt::Horizontal, "Slip");
+    // Still covered by the last load. A truncated load is redone once the view
+    // is much smaller, so zooming in brings back the smaller events.
+    const CatalogFilter::GeoBox &view = *m_mapView;
+    if (m_loadedBox && boxContains(*m_loadedBox, view)
+        && (m_loadedComplete || boxArea(view) > boxArea(*m_loadedBox) / 4)) {
+        return;
+    }
     
-    m_tableView->setModel(m_model);
-    m_tableView->resizeColumnsToContents();
-    m_tableView->horizontalHeader()->setSortIndicatorShown(true);
-    m_tableView->horizontalHeader()->setSectionsClickable(true);
+    // Half a viewport beyond each edge, so short pans need no query at all
+    double padLat = (view.north - view.south) / 2;
+    double padLon = (view.east - view.west) / 2;
+    CatalogFilter::GeoBox box;
+    box.south = qMax(-90.0, view.south - padLat);
+    box.north = qMin(90.0, view.north + padLat);
+    box.west = qMax(-180.0, view.west - padLon);
+    box.east = qMin(180.0, view.east + padLon);
     
-    // Connect selection model after setting model
-    connect(m_tableView->selectionModel(), &QItemSelectionModel::selectionChanged,
-            this, &DatabaseView::onSelectionChanged);
+    CatalogFilter filter;
+    filter.box = box;
+    filter.polygon = m_mapPolygon;
+    
+    m_pendingBox = box;
+    m_pendingExclude.reset();
+    if (m_loadedBox && m_loadedComplete) {
+        m_pendingExclude = m_loadedBox;
+    }
+    m_regionRequest = m_worker->nextRegionRequestId();
     
-    int rowCount = m_model->rowCount();
+    QMetaObject::invokeMethod(m_worker, [worker = m_worker, requestId = m_regionRequest,
+                                         filter, exclude = m_pendingExclude]() {
+        worker->loadRegion(requestId, filter, exclude, kMaxMapEvents);
+    }, Qt::QueuedConnection);
+}
+
+void DatabaseView::onRegionLoaded(quint64 requestId, const QVector<SeismicEvent> &events, bool truncated) {
+    if (requestId != m_regionRequest) return;
+    
+    if (m_pendingExclude) {
+        // Incremental load: keep the rows of the old box that are still in view
+        CatalogFilter keep;
+        keep.box = m_pendingBox;
+        QVector<SeismicEvent> merged;
+        merged.reserve(m_regionEvents.size() + events.size());
+        for (const SeismicEvent &event : std::as_const(m_regionEvents)) {
+            if (keep.matches(event)) merged.append(event);
+        }
+        merged += events;
+        m_regionEvents = merged;
+    } else {
+        m_regionEvents = events;
+    }
+    m_loadedBox = m_pendingBox;
+    m_loadedComplete = !truncated && m_regionEvents.size() <= kMaxMapEvents;
+    
+    emit catalogLoaded(m_regionEvents);
+}
+
+void DatabaseView::setQueryRunning(bool running) {
+    m_progressBar->setVisible(running);
+    m_btnCancel->setVisible(running);
+    m_btnCancel->setEnabled(running);
+}
+
+void DatabaseView::onCancelQuery() {
+    if (m_importing) {
+        m_worker->cancelImport();
+        m_btnCancel->setEnabled(false);
+        return;
+    }
+    if (m_activeRequest == 0) return;
+    
+    m_worker->interrupt(m_activeRequest);
+    m_worker->cancelAll();
+    m_btnCancel->setEnabled(false);
+}
+
+void DatabaseView::onWindowReady(quint64 requestId, int totalRows, const QVector<EventKey> &anchors) {
+    if (requestId != m_activeRequest) return;
+    
+    // Page fetches keep using the same request id until the next filter
+    m_model->setWindow(requestId, totalRows, anchors, m_requestFilter);
+    m_tableView->resizeColumnsToContents();
+    
+    m_activeRequest = 0;
+    setQueryRunning(false);
     m_statusLabel->setText(QString("Loaded %1 events from %2 to %3")
-                          .arg(rowCount)
-                          .arg(startDate.toString("dd MMM yyyy"))
-                          .arg(endDate.toString("dd MMM yyyy")));
+                          .arg(m_model->rowCount())
+                          .arg(m_requestFilter.startDate.toString("dd MMM yyyy"))
+                          .arg(m_requestFilter.endDate.toString("dd MMM yyyy")));
+    m_statusLabel->setStyleSheet("padding: 5px; background-color: #006400; color: white;");
+    
+    bool explain = m_explainQueries;
+    QMetaObject::invokeMethod(m_worker, [worker = m_worker, explain]() {
+        worker->reportStatements(explain);
+    }, Qt::QueuedConnection);
+}
+
+void DatabaseView::onLiveUpdatesInterrupted(quint64 requestId) {
+    Q_UNUSED(requestId);
+    // Reconnected: changes during the outage were not seen, reload the window
+    if (m_activeRequest == 0) {
+        loadData();
+    }
+}
+
+void DatabaseView::onStatementStats(const QVector<StatementCache::Stats> &stats) {
+    // Waktu eksekusi per statement, lihat tooltip status
+    QStringList lines;
+    for (const auto &stat : stats) {
+        if (stat.calls == 0) continue;
+        lines << QString("%1: %2x, last %3 ms, avg %4 ms, max %5 ms, prepare %6 ms")
+                 .arg(stat.name)
+                 .arg(stat.calls)
+                 .arg(stat.lastUs / 1000.0, 0, 'f', 1)
+                 .arg(stat.totalUs / 1000.0 / stat.calls, 0, 'f', 1)
+                 .arg(stat.maxUs / 1000.0, 0, 'f', 1)
+                 .arg(stat.prepareUs / 1000.0, 0, 'f', 1);
+    }
+    m_statusLabel->setToolTip(lines.join('\n'));
+}
+
+void DatabaseView::onQueryCanceled(quint64 requestId) {
+    if (requestId != m_activeRequest) return;
+    
+    m_activeRequest = 0;
+    setQueryRunning(false);
+    m_statusLabel->setText("Query canceled");
+    m_statusLabel->setStyleSheet("padding: 5px; background-color: #44444E; border: 1px solid #715A5A;");
+}
+
+void DatabaseView::onQueryFailed(quint64 requestId, const QString &error) {
+    if (requestId != m_activeRequest) return;
+    
+    m_activeRequest = 0;
+    setQueryRunning(false);
+    m_statusLabel->setText("Query error: " + error);
+    m_statusLabel->setStyleSheet("padding: 5px; background-color: #8B0000; color: white;");
+}
+
+void DatabaseView::onImportClicked() {
+    if (m_importing) return;
+    if (!m_isConnected) {
+        m_statusLabel->setText("Import needs a database connection");
+        return;
+    }
+    
+    QString path = QFileDialog::getOpenFileName(this, "Import Event Catalog", QString(),
+                                                "Catalog files (*.csv *.txt);;All files (*)");
+    if (path.isEmpty()) return;
+    
+    // Runs on the database thread; the table refreshes from the BULK notification
+    m_importing = true;
+    m_btnImport->setEnabled(false);
+    setQueryRunning(true);
+    m_progressBar->setRange(0, 1000);
+    m_progressBar->setValue(0);
+    m_statusLabel->setText(QString("Importing %1...").arg(QFileInfo(path).fileName()));
+    m_statusLabel->setStyleSheet("padding: 5px; background-color: #44444E; border: 1px solid #715A5A;");
+    
+    QMetaObject::invokeMethod(m_worker, [worker = m_worker, path]() {
+        worker->importCatalog(path, true);
+    }, Qt::QueuedConnection);
+}
+
+void DatabaseView::onImportProgress(qint64 rows, qint64 bytesRead, qint64 totalBytes) {
+    if (!m_importing) return;
+    
+    if (totalBytes > 0) {
+        m_progressBar->setValue(int(bytesRead * 1000 / totalBytes));
+    }
+    m_statusLabel->setText(QString("Importing... %1 events").arg(rows));
+}
+
+void DatabaseView::onImportFinished(bool ok, qint64 rows, qint64 skipped, qint64 elapsedMs,
+                                    const QString &error) {
+    m_importing = false;
+    m_btnImport->setEnabled(true);
+    setQueryRunning(false);
+    
+    if (!ok) {
+        m_statusLabel->setText("Import failed: " + error);
+        m_statusLabel->setStyleSheet("padding: 5px; background-color: #8B0000; color: white;");
+        return;
+    }
+    m_statusLabel->setText(QString("Imported %1 events (%2 skipped) in %3 s, %4 events/s")
+                          .arg(rows)
+                          .arg(skipped)
+                          .arg(elapsedMs / 1000.0, 0, 'f', 1)
+                          .arg(elapsedMs > 0 ? rows * 1000 / elapsedMs : rows));
     m_statusLabel->setStyleSheet("padding: 5px; background-color: #006400; color: white;");
 }
 
@@ -188,6 +676,10 @@ void DatabaseView::onDateRangeChanged() {
     loadData();
 }
 
+void DatabaseView::onSearchTextChanged() {
+    m_searchTimer->start();
+}
+
 void DatabaseView::onSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected) {
     Q_UNUSED(deselected);
     m_btnSelect->setEnabled(!selected.isEmpty());
@@ -205,17 +697,21 @@ void DatabaseView::onSelectEvent() {
         return;
     }
     
-    int row = selected.first().row();
+    SeismicEvent event;
+    if (!m_model->eventAt(selected.first().row(), event)) {
+        // Page was evicted or is still loading
+        return;
+    }
     
-    m_selectedEventId = m_model->data(m_model->index(row, 0)).toString();
-    QDateTime originTime = m_model->data(m_model->index(row, 1)).toDateTime();
-    double mag = m_model->data(m_model->index(row, 2)).toDouble();
-    double lat = m_model->data(m_model->index(row, 3)).toDouble();
-    double lon = m_model->data(m_model->index(row, 4)).toDouble();
-    int depth = m_model->data(m_model->index(row, 5)).toInt();
-    int strike = m_model->data(m_model->index(row, 6)).toInt();
-    int dip = m_model->data(m_model->index(row, 7)).toInt();
-    int slip = m_model->data(m_model->index(row, 8)).toInt();
+    m_selectedEventId = event.eventId;
+    QDateTime originTime = event.originTime;
+    double mag = event.magnitude;
+    double lat = event.latitude;
+    double lon = event.longitude;
+    int depth = event.depth;
+    int strike = event.strike;
+    int dip = event.dip;
+    int slip = event.slip;
     
     QString eventInfo = QString("Event ID: %1\nMagnitude %2 | %3\nLat: %4°, Lon: %5°")
                        .arg(m_selectedEventId)
@@ -0,0 +1,588 @@
+#include "DatabaseWorker.h"
+#include "EventSnapshot.h"
+#include "CatalogImporter.h"
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QThreadPool>
+#include <QTimeZone>
+#include <QTimer>
+#include <QDebug>
+#include <algorithm>
+#include <libpq-fe.h>
+
+namespace {
+const char *kChangeChannel = "sumber_tsunami_changes";
+
+// Changes are re-read this far back: a transaction that started before the
+// last sync may have committed after it with an older updated_at
+constexpr int kSnapshotOverlapSec = 300;
+// Delta rows that make a sync rewrite the snapshot instead of appending,
+// unless an eighth of the base is more
+constexpr int kSnapshotCompactRows = 4096;
+
+const char *kEventColumns =
+    "id, event_id, origintime, magnitudo, latitude, longitude, depth_km, strike, dip, slip";
+
+SeismicEvent eventFromQuery(const QSqlQuery &query) {
+    SeismicEvent event;
+    event.id = query.value(0).toInt();
+    event.eventId = query.value(1).toString();
+    event.originTime = query.value(2).toDateTime();
+    event.magnitude = query.value(3).toDouble();
+    event.latitude = query.value(4).toDouble();
+    event.longitude = query.value(5).toDouble();
+    event.depth = query.value(6).toInt();
+    event.strike = query.value(7).toInt();
+    event.dip = query.value(8).toInt();
+    event.slip = query.value(9).toInt();
+    return event;
+}
+
+PGconn *connectionHandle(const QSqlDatabase &db) {
+    if (!db.isOpen() || !db.driver()) return nullptr;
+    QVariant handle = db.driver()->handle();
+    if (!handle.isValid() || qstrcmp(handle.typeName(), "PGconn*") != 0) return nullptr;
+    return *static_cast<PGconn *const *>(handle.constData());
+}
+}
+
+// Cancel key of the worker's session and the window query it is running.
+// Shared with the pool threads interrupt() sends from, which may outlive the
+// worker
+struct DatabaseWorker::CancelTarget {
+    QMutex mutex;
+    PGcancel *cancel = nullptr;
+    quint64 requestId = 0;
+    
+    ~CancelTarget() {
+        if (cancel) PQfreeCancel(cancel);
+    }
+};
+
+DatabaseWorker::TxSnapshot DatabaseWorker::TxSnapshot::parse(const QString &text) {
+    // Format xmin:xmax:xip1,xip2,...
+    TxSnapshot snapshot;
+    QStringList parts = text.split(':');
+    if (parts.size() != 3) return snapshot;
+    
+    snapshot.xmin = parts[0].toULongLong();
+    snapshot.xmax = parts[1].toULongLong();
+    const QStringList active = parts[2].split(',', Qt::SkipEmptyParts);
+    for (const QString &txid : active) {
+        snapshot.inProgress.insert(txid.toULongLong());
+    }
+    return snapshot;
+}
+
+bool DatabaseWorker::TxSnapshot::sees(quint64 txid) const {
+    if (txid < xmin) return true;
+    return txid < xmax && !inProgress.contains(txid);
+}
+
+DatabaseWorker::DatabaseWorker(QObject *parent)
+    : QObject(parent)
+    , m_lastPageSize(256)
+    , m_windowRequest(0)
+    , m_healthTimer(nullptr)
+    , m_latestRequest(0)
+    , m_latestRegion(0)
+    , m_importCanceled(false)
+    , m_cancel(std::make_shared<CancelTarget>())
+{
+}
+
+DatabaseWorker::~DatabaseWorker() {
+    // Runs on the worker thread (deleteLater on QThread::finished); the lease
+    // goes back to the pool, which drops the connection when the thread ends
+    m_statements.setDatabase(QSqlDatabase());
+    m_db = QSqlDatabase();
+}
+
+quint64 DatabaseWorker::nextRequestId() {
+    return ++m_latestRequest;
+}
+
+void DatabaseWorker::cancelAll() {
+    ++m_latestRequest;
+}
+
+quint64 DatabaseWorker::nextRegionRequestId() {
+    return ++m_latestRegion;
+}
+
+void DatabaseWorker::interrupt(quint64 requestId) {
+    // The worker thread is blocked in the query, so the cancel request goes
+    // out on a pool thread. It carries the session's cancel key and needs no
+    // connection or login of its own
+    std::shared_ptr<CancelTarget> target = m_cancel;
+    QThreadPool::globalInstance()->start([target, requestId]() {
+        // Held until the server has the request, so the worker cannot have
+        // moved on to a newer query by then
+        QMutexLocker locker(&target->mutex);
+        if (!target->cancel || target->requestId != requestId) return;
+        char error[256];
+        if (!PQcancel(target->cancel, error, sizeof(error))) {
+            qWarning() << "Cannot cancel window query:" << error;
+        }
+    });
+}
+
+void DatabaseWorker::cancelImport() {
+    m_importCanceled = true;
+}
+
+bool DatabaseWorker::isStale(quint64 requestId) const {
+    return requestId != m_latestRequest.load();
+}
+
+void DatabaseWorker::open() {
+    // Borrowed on this thread, so the connection belongs to the worker thread
+    QString error;
+    m_lease = ConnectionPool::instance().acquire(5000, &error);
+    if (!m_lease.isValid()) {
+        emit opened(false, error);
+        return;
+    }
+    m_db = m_lease.database();
+    prepareStatements();
+    subscribe();
+    updateCancelKey();
+    
+    // Idle connections are checked periodically so LISTEN does not go silent
+    if (!m_healthTimer) {
+        m_healthTimer = new QTimer(this);
+        m_healthTimer->setInterval(ConnectionPool::kHealthCheckIdleMs);
+        connect(m_healthTimer, &QTimer::timeout, this, &DatabaseWorker::ensureConnected);
+        m_healthTimer->start();
+    }
+    
+    emit opened(true, QString());
+}
+
+bool DatabaseWorker::ensureConnected() {
+    if (!m_lease.isValid()) return false;
+    
+    bool reconnected = false;
+    if (!m_lease.ensureHealthy(&reconnected)) {
+        emit connectionLost();
+        return false;
+    }
+    
+    if (reconnected) {
+        // Prepared statements and LISTEN died with the old session, and any
+        // change made in between was missed
+        prepareStatements();
+        subscribe();
+        updateCancelKey();
+        if (m_windowRequest != 0) {
+            emit liveUpdatesInterrupted(m_windowRequest);
+            m_windowRequest = 0;
+        }
+        emit opened(true, QString());
+    }
+    return true;
+}
+
+void DatabaseWorker::updateCancelKey() {
+    QMutexLocker locker(&m_cancel->mutex);
+    if (m_cancel->cancel) PQfreeCancel(m_cancel->cancel);
+    PGconn *conn = connectionHandle(m_db);
+    m_cancel->cancel = conn ? PQgetCancel(conn) : nullptr;
+}
+
+void DatabaseWorker::setCancelableRequest(quint64 requestId) {
+    QMutexLocker locker(&m_cancel->mutex);
+    m_cancel->requestId = requestId;
+}
+
+void DatabaseWorker::subscribe() {
+    // Notifications arrive through the driver's socket notifier on this thread
+    QSqlDriver *driver = m_db.driver();
+    if (driver->subscribeToNotification(kChangeChannel)) {
+        connect(driver, &QSqlDriver::notification, this, &DatabaseWorker::onNotification,
+                Qt::UniqueConnection);
+    } else {
+        qWarning() << "Live catalog updates disabled:" << driver->lastError().text();
+    }
+}
+
+void DatabaseWorker::prepareStatements() {
+    m_statements.setDatabase(m_db);
+    
+    // Live diffs: the changed row by id; its rank comes from window_rank
+    m_statements.add("event_by_id",
+                     QString("SELECT %1, origintime::text FROM sumber_tsunami WHERE id = ?::int")
+                     .arg(kEventColumns));
+    m_statements.add("window_snapshot", "SELECT txid_current_snapshot()::text");
+    // Snapshot reconciliation, served by idx_sumber_tsunami_updated_at
+    m_statements.add("snapshot_now", "SELECT now()");
+    m_statements.add("snapshot_changes",
+                     QString("SELECT %1 FROM sumber_tsunami WHERE updated_at > ?::timestamptz")
+                     .arg(kEventColumns));
+    m_statements.add("snapshot_deleted",
+                     "SELECT id FROM sumber_tsunami_deleted WHERE deleted_at > ?::timestamptz");
+}
+
+QString DatabaseWorker::windowStatement(const QString &kind, const CatalogFilter &filter) {
+    // One statement per combination of predicates, e.g. window_count#se-m--;
+    // the values change per search, the SQL text does not
+    QString name = kind + '#' + filter.shape();
+    if (m_statements.contains(name)) return name;
+    
+    QString where = filter.whereClause();
+    QString sql;
+    if (kind == "window_count") {
+        sql = QString("SELECT count(*) FROM sumber_tsunami WHERE %1").arg(where);
+    } else if (kind == "window_anchors") {
+        sql = QString("SELECT origintime::text, id FROM ("
+                      "SELECT origintime, id, "
+                      "row_number() OVER (ORDER BY origintime DESC, id DESC) - 1 AS rn "
+                      "FROM sumber_tsunami WHERE %1) w "
+                      "WHERE rn % ?::int = 0 ORDER BY rn").arg(where);
+    } else if (kind == "window_page") {
+        // Keyset seek: start at the page's first key instead of OFFSET
+        sql = QString("SELECT %1 FROM sumber_tsunami WHERE %2 "
+                      "AND (origintime, id) <= (?::timestamptz, ?::int) "
+                      "ORDER BY origintime DESC, id DESC LIMIT ?::int")
+              .arg(kEventColumns, where);
+    } else if (kind == "region" || kind == "region_delta") {
+        // Map layer: GiST on geom_source picks the rows, biggest events kept
+        // when the box holds more than the layer can show
+        sql = QString("SELECT %1 FROM sumber_tsunami WHERE %2 ").arg(kEventColumns, where);
+        if (kind == "region_delta") {
+            sql += "AND NOT geom_source && ST_MakeEnvelope(?::float8, ?::float8, ?::float8, ?::float8, 4326) ";
+        }
+        sql += "ORDER BY magnitudo DESC LIMIT ?::int";
+    } else if (kind == "window_rank") {
+        // Position of a key among the rows of the window, the row itself excluded
+        sql = QString("SELECT count(*) FROM sumber_tsunami WHERE %1 "
+                      "AND (origintime, id) > (?::timestamptz, ?::int) AND id <> ?::int")
+              .arg(where);
+    }
+    m_statements.add(name, sql);
+    return name;
+}
+
+void DatabaseWorker::openWindow(quint64 requestId, const CatalogFilter &filter, int pageSize) {
+    // Superseded while still waiting in the queue
+    if (isStale(requestId)) {
+        emit queryCanceled(requestId);
+        return;
+    }
+    if (!ensureConnected()) {
+        emit queryFailed(requestId, "Not connected to database");
+        return;
+    }
+    m_lastFilter = filter;
+    m_lastPageSize = pageSize;
+    m_windowRequest = 0;
+    
+    // Only this request's queries may be canceled by interrupt(requestId)
+    setCancelableRequest(requestId);
+    
+    // Count, keys and snapshot must agree, so they share one snapshot
+    m_db.transaction();
+    QSqlQuery(m_db).exec("SET TRANSACTION ISOLATION LEVEL REPEATABLE READ READ ONLY");
+    
+    QVariantList values = filter.bindValues();
+    int total = 0;
+    bool ok = m_statements.run(windowStatement("window_count", filter), values,
+                               [&](QSqlQuery &query) {
+        if (query.next()) total = query.value(0).toInt();
+    });
+    if (!ok) {
+        m_db.rollback();
+        setCancelableRequest(0);
+        // A superseded request fails with "canceling statement due to user request"
+        if (isStale(requestId)) {
+            emit queryCanceled(requestId);
+        } else {
+            emit queryFailed(requestId, m_statements.lastError());
+        }
+        return;
+    }
+    
+    QVector<EventKey> anchors;
+    anchors.reserve(total / pageSize + 1);
+    bool canceled = false;
+    ok = m_statements.run(windowStatement("window_anchors", filter), values << pageSize, [&](QSqlQuery &query) {
+        while (query.next()) {
+            EventKey key;
+            key.originTime = query.value(0).toString();
+            key.id = query.value(1).toInt();
+            anchors.append(key);
+            
+            if ((anchors.size() & 1023) == 0 && isStale(requestId)) {
+                canceled = true;
+                return;
+            }
+        }
+    });
+    
+    QString snapshot;
+    if (ok && !canceled) {
+        ok = m_statements.run("window_snapshot", QVariantList(), [&](QSqlQuery &query) {
+            if (query.next()) snapshot = query.value(0).toString();
+        });
+    }
+    m_db.commit();
+    setCancelableRequest(0);
+    
+    if (canceled || (!ok && isStale(requestId))) {
+        emit queryCanceled(requestId);
+    } else if (!ok) {
+        emit queryFailed(requestId, m_statements.lastError());
+    } else {
+        m_windowRequest = requestId;
+        m_windowSnapshot = TxSnapshot::parse(snapshot);
+        emit windowReady(requestId, total, anchors);
+    }
+}
+
+void DatabaseWorker::fetchPage(quint64 requestId, int page, const EventKey &anchor,
+                               const CatalogFilter &filter, int pageSize) {
+    // Pages of an old filter are not worth a round trip
+    if (isStale(requestId) || !ensureConnected()) return;
+    
+    QVector<SeismicEvent> rows;
+    rows.reserve(pageSize);
+    bool ok = m_statements.run(windowStatement("window_page", filter),
+                               filter.bindValues() << anchor.originTime << anchor.id << pageSize,
+                               [&](QSqlQuery &query) {
+        while (query.next()) {
+            rows.append(eventFromQuery(query));
+        }
+    });
+    
+    if (!ok) {
+        qWarning() << "Failed to fetch event page" << page << ":" << m_statements.lastError();
+        // Empty page lets the model request it again later
+        rows.clear();
+    }
+    emit pageReady(requestId, page, rows);
+}
+
+void DatabaseWorker::syncSnapshot(const QString &path) {
+    if (!ensureConnected()) return;
+    
+    EventSnapshot snapshot;
+    EventSnapshot::Version version;
+    const bool replaced = !snapshot.open(path);
+    if (!replaced) version = snapshot.version();
+    QDateTime since = version.syncedAt.isValid()
+                      ? version.syncedAt.addSecs(-kSnapshotOverlapSec)
+                      : QDateTime::fromMSecsSinceEpoch(0, QTimeZone::UTC);
+    
+    // now() and both change lists from one snapshot, so nothing falls between syncs
+    m_db.transaction();
+    QSqlQuery(m_db).exec("SET TRANSACTION ISOLATION LEVEL REPEATABLE READ READ ONLY");
+    
+    QDateTime syncedAt;
+    QVector<SeismicEvent> changed;
+    QVector<int> removed;
+    bool ok = m_statements.run("snapshot_now", QVariantList(), [&](QSqlQuery &query) {
+        if (query.next()) syncedAt = query.value(0).toDateTime();
+    });
+    ok = ok && m_statements.run("snapshot_changes", QVariantList{since}, [&](QSqlQuery &query) {
+        while (query.next()) {
+            changed.append(eventFromQuery(query));
+        }
+    });
+    ok = ok && m_statements.run("snapshot_deleted", QVariantList{since}, [&](QSqlQuery &query) {
+        while (query.next()) {
+            removed.append(query.value(0).toInt());
+        }
+    });
+    m_db.commit();
+    if (!ok) {
+        qWarning() << "Event snapshot sync failed:" << m_statements.lastError();
+        return;
+    }
+    
+    // Nothing new: keep the file, the next sync starts from the same version
+    if (!replaced && changed.isEmpty() && removed.isEmpty()) {
+        emit snapshotSynced(changed, removed, false);
+        return;
+    }
+    
+    for (const SeismicEvent &event : std::as_const(changed)) {
+        version.maxId = qMax(version.maxId, qint64(event.id));
+    }
+    version.syncedAt = syncedAt;
+    
+    // Syncs append a delta; the file is rewritten only when there is none yet
+    // or the deltas have grown past what is cheap to read back on open
+    QString error;
+    bool written;
+    const int deltaRows = snapshot.deltaRows() + changed.size() + removed.size();
+    if (replaced) {
+        written = EventSnapshot::write(path, changed, version, &error);
+    } else if (deltaRows > qMax(kSnapshotCompactRows, snapshot.rowCount() / 8)) {
+        QVector<SeismicEvent> events = snapshot.events();
+        snapshot.close();
+        QSet<int> replacedIds(removed.cbegin(), removed.cend());
+        for (const SeismicEvent &event : std::as_const(changed)) replacedIds.insert(event.id);
+        events.erase(std::remove_if(events.begin(), events.end(),
+                                    [&](const SeismicEvent &e) { return replacedIds.contains(e.id); }),
+                     events.end());
+        events.append(changed);
+        written = EventSnapshot::write(path, events, version, &error);
+    } else {
+        snapshot.close();
+        written = EventSnapshot::append(path, changed, removed, version, &error);
+    }
+    if (!written) {
+        qWarning() << "Cannot write event snapshot:" << error;
+        return;
+    }
+    emit snapshotSynced(changed, removed, replaced);
+}
+
+void DatabaseWorker::loadRegion(quint64 requestId, const CatalogFilter &filter,
+                                const std::optional<CatalogFilter::GeoBox> &exclude, int limit) {
+    if (requestId != m_latestRegion.load() || !ensureConnected()) return;
+    
+    QVariantList values = filter.bindValues();
+    if (exclude) {
+        values << exclude->west << exclude->south << exclude->east << exclude->north;
+    }
+    // One extra row tells whether the limit cut the result
+    values << limit + 1;
+    
+    QVector<SeismicEvent> events;
+    bool ok = m_statements.run(windowStatement(exclude ? "region_delta" : "region", filter), values,
+                               [&](QSqlQuery &query) {
+        while (query.next()) {
+            events.append(eventFromQuery(query));
+        }
+    });
+    if (!ok) {
+        qWarning() << "Failed to load map region:" << m_statements.lastError();
+        return;
+    }
+    
+    bool truncated = events.size() > limit;
+    if (truncated) events.resize(limit);
+    emit regionLoaded(requestId, events, truncated);
+}
+
+void DatabaseWorker::reportStatements(bool explain) {
+    if (explain && ensureConnected()) {
+        // Plan of the window queries for the last filter shown in the table
+        QVariantList values = m_lastFilter.bindValues();
+        QString count = windowStatement("window_count", m_lastFilter);
+        QString anchors = windowStatement("window_anchors", m_lastFilter);
+        qDebug().noquote() << count + ":\n" << m_statements.explain(count, values);
+        qDebug().noquote() << anchors + ":\n"
+                           << m_statements.explain(anchors, QVariantList(values) << m_lastPageSize);
+    }
+    emit statementStats(m_statements.stats());
+}
+
+bool DatabaseWorker::fetchEvent(int id, SeismicEvent &event, EventKey &key) {
+    bool found = false;
+    m_statements.run("event_by_id", QVariantList{id}, [&](QSqlQuery &query) {
+        if (!query.next()) return;
+        event = eventFromQuery(query);
+        key.originTime = query.value(10).toString();
+        key.id = id;
+        found = true;
+    });
+    return found;
+}
+
+int DatabaseWorker::rankOf(const QString &originTime, int id) {
+    // Rows of the window newer than the key, the row itself excluded
+    int rank = -1;
+    bool ok = m_statements.run(windowStatement("window_rank", m_lastFilter),
+                               m_lastFilter.bindValues() << originTime << id << id,
+                               [&](QSqlQuery &query) {
+        if (query.next()) rank = query.value(0).toInt();
+    });
+    return ok ? rank : -1;
+}
+
+void DatabaseWorker::importCatalog(const QString &path, bool skipExisting) {
+    m_importCanceled = false;
+    if (!ensureConnected()) {
+        emit importFinished(false, 0, 0, 0, "Not connected to database");
+        return;
+    }
+    
+    CatalogImporter::Options options;
+    options.skipExisting = skipExisting;
+    CatalogImporter importer(m_db, options);
+    CatalogImporter::Result result = importer.importFile(path,
+        [this](qint64 rows, qint64 bytesRead, qint64 totalBytes) {
+            emit importProgress(rows, bytesRead, totalBytes);
+            return !m_importCanceled.load();
+        });
+    
+    for (const QString &line : std::as_const(result.rejected)) {
+        qWarning() << "Catalog import skipped" << line;
+    }
+    emit importFinished(result.ok, result.rows, result.skipped, result.elapsedMs, result.error);
+}
+
+void DatabaseWorker::onNotification(const QString &name, QSqlDriver::NotificationSource source,
+                                    const QVariant &payload) {
+    Q_UNUSED(source);
+    if (name != kChangeChannel) return;
+    emit catalogChanged();
+    if (m_windowRequest == 0 || isStale(m_windowRequest)) return;
+    
+    // Payload from notify_sumber_tsunami() in setup_database.sh
+    QJsonObject change = QJsonDocument::fromJson(payload.toString().toUtf8()).object();
+    QString op = change.value("op").toString();
+    int id = change.value("id").toInt();
+    quint64 txid = quint64(change.value("txid").toDouble());
+    
+    // Committed before the window was taken, already counted
+    if (m_windowSnapshot.sees(txid)) return;
+    
+    // A bulk import is announced once, not per row: reload instead of diffing
+    if (op == "BULK") {
+        emit liveUpdatesInterrupted(m_windowRequest);
+        m_windowRequest = 0;
+        return;
+    }
+    
+    // Where the row was: old key from the payload, rank on the current table
+    int oldRow = -1;
+    if (op != "INSERT") {
+        QString oldTime = change.value("old_time").toString();
+        SeismicEvent old;
+        old.eventId = change.value("old_event_id").toString();
+        old.originTime = QDateTime::fromString(oldTime, Qt::ISODateWithMs);
+        old.magnitude = change.value("old_mag").toDouble();
+        old.latitude = change.value("old_lat").toDouble();
+        old.longitude = change.value("old_lon").toDouble();
+        old.depth = change.value("old_depth").toInt();
+        if (m_lastFilter.matches(old)) {
+            oldRow = rankOf(oldTime, id);
+        }
+    }
+    
+    // Where the row is now
+    SeismicEvent event;
+    EventKey key;
+    int newRow = -1;
+    if (op != "DELETE" && fetchEvent(id, event, key)
+        && m_lastFilter.matches(event)) {
+        newRow = rankOf(key.originTime, id);
+    }
+    
+    if (oldRow >= 0 && oldRow == newRow) {
+        emit rowUpdated(m_windowRequest, newRow, event);
+        return;
+    }
+    if (oldRow >= 0) {
+        emit rowRemoved(m_windowRequest, oldRow, id);
+    }
+    if (newRow >= 0) {
+        emit rowInserted(m_windowRequest, newRow, event, key);
+    }
+}
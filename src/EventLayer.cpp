@@ -0,0 +1,319 @@
+#include "EventLayer.h"
+#include "GlyphAtlas.h"
+#include <QHash>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+// Ukuran sel cluster di layar (pixel); level dipilih agar satu sel ~ segini
+constexpr double kClusterPixels = 48.0;
+constexpr int kMaxLevel = 20;
+constexpr double kMaxMarkerRadius = 14.0;
+
+quint64 cellKey(int cx, int cy) {
+    return (quint64(cy) << 32) | quint64(cx);
+}
+}
+
+EventLayer::EventLayer(const QRectF &worldRect, QGraphicsItem *parent)
+    : QGraphicsItem(parent)
+    , m_worldRect(worldRect)
+    , m_projection(worldRect.left(), worldRect.top(), worldRect.width(), worldRect.height())
+    , m_glyphAtlas(nullptr)
+    , m_showMechanisms(true)
+    , m_hasHighlight(false)
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    setAcceptHoverEvents(false);
+    setZValue(100);
+}
+
+void EventLayer::setWorldRect(const QRectF &worldRect) {
+    prepareGeometryChange();
+    m_worldRect = worldRect;
+    m_projection.setWorldRect(worldRect.left(), worldRect.top(), worldRect.width(), worldRect.height());
+    setEvents(m_events);
+}
+
+void EventLayer::setEvents(const QVector<SeismicEvent> &events) {
+    m_events = events;
+    
+    // Project the whole catalog in one batch
+    const std::size_t n = std::size_t(m_events.size());
+    std::vector<double> lat(n), lon(n), x(n), y(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        lat[i] = m_events[int(i)].latitude;
+        lon[i] = m_events[int(i)].longitude;
+    }
+    m_projection.toScene(lat.data(), lon.data(), x.data(), y.data(), n);
+    
+    m_positions.resize(m_events.size());
+    m_glyphKeys.resize(m_events.size());
+    for (std::size_t i = 0; i < n; ++i) {
+        m_positions[int(i)] = QPointF(x[i], y[i]);
+        const SeismicEvent &event = m_events[int(i)];
+        // strike/dip/slip semuanya 0 berarti belum ada mekanisme
+        bool hasMechanism = event.strike != 0 || event.dip != 0 || event.slip != 0;
+        m_glyphKeys[int(i)] = hasMechanism ? GlyphAtlas::keyFor(event.strike, event.dip, event.slip) : 0;
+    }
+    requestGlyphs();
+    
+    m_levels = QVector<QVector<Cluster>>(kMaxLevel + 1);
+    m_levelBuilt = QVector<bool>(kMaxLevel + 1, false);
+    update();
+}
+
+const QVector<SeismicEvent> &EventLayer::events() const {
+    return m_events;
+}
+
+int EventLayer::eventCount() const {
+    return m_events.size();
+}
+
+void EventLayer::setGlyphAtlas(GlyphAtlas *atlas) {
+    m_glyphAtlas = atlas;
+    requestGlyphs();
+    update();
+}
+
+void EventLayer::setDevicePixelRatio(qreal ratio) {
+    if (!m_glyphAtlas || qFuzzyCompare(m_glyphAtlas->devicePixelRatio(), ratio)) return;
+    m_glyphAtlas->setDevicePixelRatio(ratio);
+    requestGlyphs();
+    update();
+}
+
+void EventLayer::setShowMechanisms(bool show) {
+    if (show == m_showMechanisms) return;
+    m_showMechanisms = show;
+    requestGlyphs();
+    update();
+}
+
+bool EventLayer::showMechanisms() const {
+    return m_showMechanisms;
+}
+
+void EventLayer::requestGlyphs() {
+    if (!m_glyphAtlas || !m_showMechanisms) return;
+    
+    // Quantization makes most keys repeat; the atlas sees each one once
+    QVector<quint32> keys = m_glyphKeys;
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    m_glyphAtlas->request(keys);
+}
+
+void EventLayer::setHighlight(const QPointF &scenePos) {
+    m_hasHighlight = true;
+    m_highlight = scenePos;
+    update();
+}
+
+void EventLayer::clearHighlight() {
+    m_hasHighlight = false;
+    update();
+}
+
+int EventLayer::levelForScale(double viewScale) const {
+    double cells = m_worldRect.width() * viewScale / kClusterPixels;
+    if (cells <= 1.0) return 0;
+    return qBound(0, int(std::floor(std::log2(cells))), kMaxLevel);
+}
+
+const QVector<EventLayer::Cluster> &EventLayer::clustersForLevel(int level) const {
+    if (m_levelBuilt[level]) return m_levels[level];
+    
+    const int side = 1 << level;
+    QHash<quint64, int> slot;
+    QVector<Cluster> clusters;
+    
+    for (int i = 0; i < m_positions.size(); ++i) {
+        const QPointF &p = m_positions[i];
+        int cx = qBound(0, int((p.x() - m_worldRect.left()) / m_worldRect.width() * side), side - 1);
+        int cy = qBound(0, int((p.y() - m_worldRect.top()) / m_worldRect.height() * side), side - 1);
+        quint64 cell = cellKey(cx, cy);
+        
+        auto it = slot.find(cell);
+        if (it == slot.end()) {
+            slot.insert(cell, clusters.size());
+            clusters.append({cell, 1, i, float(p.x()), float(p.y()), float(m_events[i].magnitude)});
+            continue;
+        }
+        
+        Cluster &c = clusters[it.value()];
+        c.count++;
+        c.sumX += float(p.x());
+        c.sumY += float(p.y());
+        if (m_events[i].magnitude > c.maxMagnitude) {
+            c.maxMagnitude = float(m_events[i].magnitude);
+            c.firstEvent = i;
+        }
+    }
+    
+    std::sort(clusters.begin(), clusters.end(),
+              [](const Cluster &a, const Cluster &b) { return a.cell < b.cell; });
+    
+    m_levels[level] = clusters;
+    m_levelBuilt[level] = true;
+    return m_levels[level];
+}
+
+void EventLayer::clusterRange(int level, const QRectF &sceneRect,
+                              QVector<const Cluster *> &out) const {
+    out.clear();
+    if (m_events.isEmpty()) return;
+    
+    const QVector<Cluster> &clusters = clustersForLevel(level);
+    const int side = 1 << level;
+    const double cellW = m_worldRect.width() / side;
+    const double cellH = m_worldRect.height() / side;
+    
+    const int cx0 = qBound(0, int(std::floor((sceneRect.left() - m_worldRect.left()) / cellW)), side - 1);
+    const int cx1 = qBound(0, int(std::floor((sceneRect.right() - m_worldRect.left()) / cellW)), side - 1);
+    const int cy0 = qBound(0, int(std::floor((sceneRect.top() - m_worldRect.top()) / cellH)), side - 1);
+    const int cy1 = qBound(0, int(std::floor((sceneRect.bottom() - m_worldRect.top()) / cellH)), side - 1);
+    
+    // Clusters are sorted row-major, so each visible row is one contiguous run
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        const quint64 first = cellKey(cx0, cy);
+        const quint64 last = cellKey(cx1, cy);
+        auto it = std::lower_bound(clusters.cbegin(), clusters.cend(), first,
+            [](const Cluster &c, quint64 cell) { return c.cell < cell; });
+        
+        for (; it != clusters.cend() && it->cell <= last; ++it) {
+            out.append(&*it);
+        }
+    }
+}
+
+int EventLayer::hitTest(const QPointF &scenePos, double viewScale) const {
+    if (m_events.isEmpty() || viewScale <= 0.0) return -1;
+    
+    const int level = levelForScale(viewScale);
+    const double reach = (kMaxMarkerRadius + 2.0) / viewScale;
+    QVector<const Cluster *> candidates;
+    clusterRange(level, QRectF(scenePos.x() - reach, scenePos.y() - reach, 2 * reach, 2 * reach),
+                 candidates);
+    
+    int best = -1;
+    double bestDistance = 0.0;
+    for (const Cluster *c : std::as_const(candidates)) {
+        if (c->count != 1) continue;
+        
+        QPointF delta = (m_positions[c->firstEvent] - scenePos) * viewScale;
+        double distance = std::hypot(delta.x(), delta.y());
+        double radius = markerRadius(m_events[c->firstEvent].magnitude);
+        if (m_glyphAtlas && m_showMechanisms && m_glyphKeys[c->firstEvent] != 0) {
+            radius = m_glyphAtlas->glyphSize() / 2.0;
+        }
+        if (distance <= radius + 2.0
+            && (best < 0 || distance < bestDistance)) {
+            best = c->firstEvent;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+QRectF EventLayer::boundingRect() const {
+    return m_worldRect;
+}
+
+QColor EventLayer::ageColor(const QDateTime &originTime, const QDateTime &now) {
+    const qint64 ageHours = originTime.secsTo(now) / 3600;
+    if (ageHours < 24) return QColor(255, 59, 48);        // < 1 hari
+    if (ageHours < 24 * 7) return QColor(255, 149, 0);    // < 1 minggu
+    if (ageHours < 24 * 30) return QColor(255, 214, 10);  // < 1 bulan
+    if (ageHours < 24 * 365) return QColor(100, 180, 255);
+    return QColor(160, 160, 170);
+}
+
+double EventLayer::markerRadius(double magnitude) {
+    return qBound(3.0, 2.0 + (magnitude - 4.0) * 1.5, kMaxMarkerRadius);
+}
+
+void EventLayer::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) {
+    Q_UNUSED(widget);
+    
+    const QTransform transform = painter->worldTransform();
+    const double viewScale = transform.m11();
+    if (viewScale <= 0.0) return;
+    
+    // Markers keep a fixed on-screen size, so draw in device coordinates
+    painter->save();
+    painter->resetTransform();
+    painter->setRenderHint(QPainter::Antialiasing);
+    
+    if (!m_events.isEmpty()) {
+        const double margin = kMaxMarkerRadius * 2.0 / viewScale;
+        QRectF exposed = option->exposedRect.adjusted(-margin, -margin, margin, margin);
+        
+        QVector<const Cluster *> visible;
+        clusterRange(levelForScale(viewScale), exposed, visible);
+        
+        const QDateTime now = QDateTime::currentDateTimeUtc();
+        QFont font("Arial", 8, QFont::Bold);
+        painter->setFont(font);
+        
+        // Beach balls are collected per atlas page and blitted in one call each
+        const bool drawGlyphs = m_glyphAtlas && m_showMechanisms;
+        QVector<QVector<QPainter::PixmapFragment>> fragments;
+        const double glyphScale = drawGlyphs ? 1.0 / m_glyphAtlas->devicePixelRatio() : 1.0;
+        
+        for (const Cluster *c : std::as_const(visible)) {
+            if (c->count == 1) {
+                GlyphAtlas::Glyph glyph;
+                if (drawGlyphs && m_glyphKeys[c->firstEvent] != 0
+                    && m_glyphAtlas->glyph(m_glyphKeys[c->firstEvent], &glyph)) {
+                    if (fragments.size() <= glyph.page) fragments.resize(glyph.page + 1);
+                    fragments[glyph.page].append(QPainter::PixmapFragment::create(
+                        transform.map(m_positions[c->firstEvent]), glyph.source, glyphScale, glyphScale));
+                    continue;
+                }
+                
+                const SeismicEvent &event = m_events[c->firstEvent];
+                const double r = markerRadius(event.magnitude);
+                painter->setPen(QPen(QColor(20, 20, 20), 1));
+                painter->setBrush(ageColor(event.originTime, now));
+                painter->drawEllipse(transform.map(m_positions[c->firstEvent]), r, r);
+                continue;
+            }
+            
+            // Cluster: drawn at the centroid, sized by log(count), colored by the age of its largest event
+            QPointF center = transform.map(QPointF(c->sumX / c->count, c->sumY / c->count));
+            const double r = qMin(22.0, 9.0 + 3.0 * std::log2(double(c->count)));
+            QColor fill = ageColor(m_events[c->firstEvent].originTime, now);
+            fill.setAlpha(190);
+            painter->setPen(QPen(Qt::white, 1.5));
+            painter->setBrush(fill);
+            painter->drawEllipse(center, r, r);
+            
+            painter->setPen(Qt::black);
+            painter->drawText(QRectF(center.x() - r, center.y() - r, 2 * r, 2 * r),
+                              Qt::AlignCenter, QString::number(c->count));
+        }
+        
+        for (int page = 0; page < fragments.size(); ++page) {
+            if (fragments[page].isEmpty()) continue;
+            painter->drawPixmapFragments(fragments[page].constData(), fragments[page].size(),
+                                         m_glyphAtlas->page(page));
+        }
+    }
+    
+    if (m_hasHighlight) {
+        QPointF p = transform.map(m_highlight);
+        painter->setPen(QPen(Qt::white, 2));
+        painter->setBrush(Qt::red);
+        painter->drawEllipse(p, 6.0, 6.0);
+        painter->setPen(QPen(Qt::red, 2));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawEllipse(p, 12.0, 12.0);
+    }
+    
+    painter->restore();
+}
@@ -0,0 +1,384 @@
+#include "EventSnapshot.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QTimeZone>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+const char kMagic[8] = {'T', 'S', 'E', 'V', 'S', 'N', 'P', '1'};
+const char kDeltaMagic[8] = {'T', 'S', 'E', 'V', 'D', 'L', 'T', '1'};
+// 2: deltas after the base columns
+constexpr quint32 kVersion = 2;
+constexpr int kColumns = 11;
+
+struct Header {
+    char magic[8];
+    quint32 version;
+    quint32 rowCount;
+    qint64 maxId;
+    qint64 syncedMs;
+    quint64 columnOffset[kColumns];
+};
+static_assert(sizeof(Header) == 120, "unexpected event snapshot header padding");
+
+struct DeltaHeader {
+    char magic[8];
+    quint32 changedCount;
+    quint32 removedCount;
+    qint64 maxId;
+    qint64 syncedMs;
+    quint64 bytes;
+    quint64 columnOffset[kColumns];
+    quint64 removedOffset;
+};
+static_assert(sizeof(DeltaHeader) == 136, "unexpected event snapshot delta padding");
+
+static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN,
+              "event snapshot is read in place and assumes a little-endian host");
+
+// Bytes per row of each column, in Column order; the text column is variable
+const int kColumnWidth[kColumns] = {4, 8, 4, 8, 8, 4, 4, 4, 4, 4, 1};
+
+quint64 align8(quint64 offset) {
+    return (offset + 7) & ~quint64(7);
+}
+
+void pad8(QByteArray &out) {
+    out.append(QByteArray(int(align8(out.size()) - out.size()), '\0'));
+}
+
+template <typename T>
+void appendColumn(QByteArray &out, const std::vector<T> &values) {
+    pad8(out);
+    out.append(reinterpret_cast<const char *>(values.data()), qsizetype(values.size() * sizeof(T)));
+}
+
+template <typename T>
+T valueAt(const uchar *data, quint64 offset, int row) {
+    return reinterpret_cast<const T *>(data + offset)[row];
+}
+
+bool earlier(const SeismicEvent &a, const SeismicEvent &b) {
+    qint64 ta = a.originTime.toMSecsSinceEpoch();
+    qint64 tb = b.originTime.toMSecsSinceEpoch();
+    return ta != tb ? ta < tb : a.id < b.id;
+}
+}
+
+EventSnapshot::EventSnapshot()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_rowCount(0)
+    , m_offsets{}
+    , m_end(0)
+    , m_deltaRows(0)
+{
+}
+
+EventSnapshot::~EventSnapshot() {
+    close();
+}
+
+bool EventSnapshot::open(const QString &path) {
+    close();
+    
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    
+    m_size = m_file.size();
+    m_data = m_size >= qint64(sizeof(Header)) ? m_file.map(0, m_size) : nullptr;
+    if (!m_data) {
+        m_error = QString("Cannot map event snapshot %1").arg(path);
+        close();
+        return false;
+    }
+    
+    Header header;
+    std::memcpy(&header, m_data, sizeof(Header));
+    qint64 baseEnd = -1;
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion) {
+        baseEnd = columnsEnd(m_data, m_size, header.columnOffset, header.rowCount);
+    }
+    if (baseEnd < 0) {
+        m_error = QString("%1 is not a valid event snapshot").arg(path);
+        close();
+        return false;
+    }
+    
+    m_rowCount = int(header.rowCount);
+    m_version.maxId = header.maxId;
+    m_version.syncedAt = QDateTime::fromMSecsSinceEpoch(header.syncedMs, QTimeZone::UTC);
+    std::memcpy(m_offsets, header.columnOffset, sizeof(m_offsets));
+    
+    // Deltas in sync order, so a later one wins for an id in both
+    QHash<int, SeismicEvent> changed;
+    QSet<int> removed;
+    m_end = qint64(align8(quint64(baseEnd)));
+    while (m_end + qint64(sizeof(DeltaHeader)) <= m_size) {
+        const uchar *data = m_data + m_end;
+        DeltaHeader delta;
+        std::memcpy(&delta, data, sizeof(DeltaHeader));
+        const qint64 bytes = qint64(delta.bytes);
+        if (std::memcmp(delta.magic, kDeltaMagic, sizeof(kDeltaMagic)) != 0
+            || bytes < qint64(sizeof(DeltaHeader)) || bytes % 8 != 0 || bytes > m_size - m_end
+            || columnsEnd(data, bytes, delta.columnOffset, delta.changedCount) < 0
+            || delta.removedOffset % 8 != 0
+            || qint64(delta.removedOffset) + qint64(delta.removedCount) * 4 > bytes) {
+            break;
+        }
+        
+        for (int row = 0; row < int(delta.changedCount); ++row) {
+            SeismicEvent event = readRow(data, bytes, delta.columnOffset, row);
+            removed.remove(event.id);
+            changed.insert(event.id, event);
+        }
+        const qint32 *ids = reinterpret_cast<const qint32 *>(data + delta.removedOffset);
+        for (quint32 i = 0; i < delta.removedCount; ++i) {
+            changed.remove(ids[i]);
+            removed.insert(ids[i]);
+        }
+        m_version.maxId = delta.maxId;
+        m_version.syncedAt = QDateTime::fromMSecsSinceEpoch(delta.syncedMs, QTimeZone::UTC);
+        m_deltaRows += int(delta.changedCount + delta.removedCount);
+        m_end += bytes;
+    }
+    m_changed = changed.values();
+    std::sort(m_changed.begin(), m_changed.end(), earlier);
+    m_removed = removed.values();
+    m_error.clear();
+    return true;
+}
+
+void EventSnapshot::close() {
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+    }
+    m_file.close();
+    m_data = nullptr;
+    m_size = 0;
+    m_rowCount = 0;
+    m_version = Version();
+    m_end = 0;
+    m_changed.clear();
+    m_removed.clear();
+    m_deltaRows = 0;
+}
+
+bool EventSnapshot::isOpen() const {
+    return m_data != nullptr;
+}
+
+QString EventSnapshot::errorString() const {
+    return m_error;
+}
+
+int EventSnapshot::rowCount() const {
+    return m_rowCount;
+}
+
+EventSnapshot::Version EventSnapshot::version() const {
+    return m_version;
+}
+
+SeismicEvent EventSnapshot::event(int row) const {
+    if (row < 0 || row >= m_rowCount) return SeismicEvent();
+    return readRow(m_data, m_size, m_offsets, row);
+}
+
+QString EventSnapshot::eventId(int row) const {
+    return readEventId(m_data, m_size, m_offsets, row);
+}
+
+QVector<SeismicEvent> EventSnapshot::events() const {
+    QSet<int> replaced(m_removed.cbegin(), m_removed.cend());
+    for (const SeismicEvent &event : m_changed) replaced.insert(event.id);
+    
+    QVector<SeismicEvent> result;
+    result.reserve(m_rowCount + m_changed.size());
+    for (int row = 0; row < m_rowCount; ++row) {
+        if (!replaced.contains(column<qint32>(IdColumn)[row])) result.append(event(row));
+    }
+    result.append(m_changed);
+    std::sort(result.begin(), result.end(), earlier);
+    return result;
+}
+
+const QVector<SeismicEvent> &EventSnapshot::changedEvents() const {
+    return m_changed;
+}
+
+const QVector<int> &EventSnapshot::removedIds() const {
+    return m_removed;
+}
+
+int EventSnapshot::deltaRows() const {
+    return m_deltaRows;
+}
+
+qint64 EventSnapshot::columnsEnd(const uchar *data, qint64 size, const quint64 *offsets, qint64 rows) {
+    for (int c = 0; c < kColumns; ++c) {
+        qint64 count = c == EventIdOffsetColumn ? rows + 1 : rows;
+        qint64 bytes = c == EventIdTextColumn ? 0 : count * kColumnWidth[c];
+        if (offsets[c] % 8 != 0 || qint64(offsets[c]) + bytes > size) return -1;
+    }
+    
+    // The last event id offset is the length of the text blob
+    quint32 textBytes;
+    std::memcpy(&textBytes, data + offsets[EventIdOffsetColumn] + quint64(rows) * sizeof(quint32),
+                sizeof(quint32));
+    qint64 end = qint64(offsets[EventIdTextColumn]) + textBytes;
+    return end <= size ? end : -1;
+}
+
+SeismicEvent EventSnapshot::readRow(const uchar *data, qint64 size, const quint64 *offsets, int row) {
+    SeismicEvent event;
+    event.id = valueAt<qint32>(data, offsets[IdColumn], row);
+    event.originTime = QDateTime::fromMSecsSinceEpoch(valueAt<qint64>(data, offsets[OriginColumn], row),
+                                                      QTimeZone::UTC);
+    event.magnitude = valueAt<float>(data, offsets[MagnitudeColumn], row);
+    event.latitude = valueAt<double>(data, offsets[LatitudeColumn], row);
+    event.longitude = valueAt<double>(data, offsets[LongitudeColumn], row);
+    event.depth = valueAt<qint32>(data, offsets[DepthColumn], row);
+    event.strike = valueAt<qint32>(data, offsets[StrikeColumn], row);
+    event.dip = valueAt<qint32>(data, offsets[DipColumn], row);
+    event.slip = valueAt<qint32>(data, offsets[SlipColumn], row);
+    event.eventId = readEventId(data, size, offsets, row);
+    return event;
+}
+
+QString EventSnapshot::readEventId(const uchar *data, qint64 size, const quint64 *offsets, int row) {
+    const quint32 *textOffsets = reinterpret_cast<const quint32 *>(data + offsets[EventIdOffsetColumn]);
+    quint32 begin = textOffsets[row];
+    quint32 end = qMax(begin, textOffsets[row + 1]);
+    if (qint64(offsets[EventIdTextColumn]) + end > size) return QString();
+    return QString::fromUtf8(reinterpret_cast<const char *>(data + offsets[EventIdTextColumn]) + begin,
+                             end - begin);
+}
+
+QByteArray EventSnapshot::columnBlock(const QVector<SeismicEvent> &events, int headerBytes,
+                                      quint64 *offsets) {
+    const size_t n = size_t(events.size());
+    std::vector<qint32> ids(n), depths(n), strikes(n), dips(n), slips(n);
+    std::vector<qint64> origins(n);
+    std::vector<float> magnitudes(n);
+    std::vector<double> latitudes(n), longitudes(n);
+    std::vector<quint32> textOffsets(n + 1);
+    QByteArray text;
+    
+    for (size_t i = 0; i < n; ++i) {
+        const SeismicEvent &event = events[qsizetype(i)];
+        ids[i] = event.id;
+        origins[i] = event.originTime.toMSecsSinceEpoch();
+        magnitudes[i] = float(event.magnitude);
+        latitudes[i] = event.latitude;
+        longitudes[i] = event.longitude;
+        depths[i] = event.depth;
+        strikes[i] = event.strike;
+        dips[i] = event.dip;
+        slips[i] = event.slip;
+        textOffsets[i] = quint32(text.size());
+        text.append(event.eventId.toUtf8());
+    }
+    textOffsets[n] = quint32(text.size());
+    
+    // Columns follow the header in Column order
+    QByteArray body(headerBytes, '\0');
+    auto place = [&](int c, auto &&values) {
+        offsets[c] = align8(body.size());
+        appendColumn(body, values);
+    };
+    place(IdColumn, ids);
+    place(OriginColumn, origins);
+    place(MagnitudeColumn, magnitudes);
+    place(LatitudeColumn, latitudes);
+    place(LongitudeColumn, longitudes);
+    place(DepthColumn, depths);
+    place(StrikeColumn, strikes);
+    place(DipColumn, dips);
+    place(SlipColumn, slips);
+    place(EventIdOffsetColumn, textOffsets);
+    offsets[EventIdTextColumn] = align8(body.size());
+    pad8(body);
+    body.append(text);
+    return body;
+}
+
+bool EventSnapshot::write(const QString &path, QVector<SeismicEvent> events,
+                          const Version &version, QString *error) {
+    std::sort(events.begin(), events.end(), earlier);
+    
+    Header header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.rowCount = quint32(events.size());
+    header.maxId = version.maxId;
+    header.syncedMs = version.syncedAt.toMSecsSinceEpoch();
+    QByteArray body = columnBlock(events, int(sizeof(Header)), header.columnOffset);
+    std::memcpy(body.data(), &header, sizeof(Header));
+    
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+    out.write(body);
+    if (!out.commit()) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool EventSnapshot::append(const QString &path, const QVector<SeismicEvent> &changed,
+                           const QVector<int> &removed, const Version &version, QString *error) {
+    // A torn delta from an interrupted append is cut off and written over
+    qint64 end;
+    {
+        EventSnapshot current;
+        if (!current.open(path)) {
+            if (error) *error = current.errorString();
+            return false;
+        }
+        end = current.m_end;
+    }
+    
+    DeltaHeader delta;
+    std::memcpy(delta.magic, kDeltaMagic, sizeof(kDeltaMagic));
+    delta.changedCount = quint32(changed.size());
+    delta.removedCount = quint32(removed.size());
+    delta.maxId = version.maxId;
+    delta.syncedMs = version.syncedAt.toMSecsSinceEpoch();
+    QByteArray body = columnBlock(changed, int(sizeof(DeltaHeader)), delta.columnOffset);
+    delta.removedOffset = align8(body.size());
+    pad8(body);
+    std::vector<qint32> ids(removed.cbegin(), removed.cend());
+    body.append(reinterpret_cast<const char *>(ids.data()), qsizetype(ids.size() * sizeof(qint32)));
+    pad8(body);
+    delta.bytes = quint64(body.size());
+    std::memcpy(body.data(), &delta, sizeof(DeltaHeader));
+    
+    // One write: a crash leaves a delta shorter than its byte count, which
+    // open() ignores
+    QFile out(path);
+    if (!out.open(QIODevice::ReadWrite) || !out.resize(end) || !out.seek(end)
+        || out.write(body) != body.size() || !out.flush()) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+    return true;
+}
+
+QString EventSnapshot::defaultPath() {
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)
+        + "/events.snapshot";
+}
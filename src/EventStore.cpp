@@ -0,0 +1,319 @@
+#include "EventStore.h"
+#include "EventSnapshot.h"
+#include <QPolygonF>
+#include <QSet>
+#include <QTimeZone>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace {
+constexpr int kBlock = 64;
+
+static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN,
+              "packBits reads the keep bytes as a little-endian word");
+
+// keep[i] &= lo <= values[i] <= hi for one block. Bitwise & instead of && so
+// the loop has no branches and vectorizes
+template <typename T>
+inline void keepInRange(quint8 *keep, const T *values, T lo, T hi) {
+    for (int i = 0; i < kBlock; ++i) {
+        keep[i] &= quint8((values[i] >= lo) & (values[i] <= hi));
+    }
+}
+
+// A box with west > east crosses the antimeridian: outside (east, west)
+inline void keepOutside(quint8 *keep, const double *values, double lo, double hi) {
+    for (int i = 0; i < kBlock; ++i) {
+        keep[i] &= quint8((values[i] <= lo) | (values[i] >= hi));
+    }
+}
+
+// 64 bytes of 0/1 to one word. The multiply moves byte k of an 8-byte group
+// to bit 56 + k, so each group of eight takes one multiply and one shift
+inline quint64 packBits(const quint8 *keep) {
+    quint64 word = 0;
+    for (int group = 0; group < kBlock / 8; ++group) {
+        quint64 bytes;
+        std::memcpy(&bytes, keep + 8 * group, sizeof(bytes));
+        word |= ((bytes * 0x0102040810204080ull) >> 56) << (8 * group);
+    }
+    return word;
+}
+
+template <typename T>
+void padColumn(std::vector<T> &column, int rows) {
+    column.resize(size_t((rows + kBlock - 1) / kBlock * kBlock), T());
+}
+
+bool earlier(const SeismicEvent &a, const SeismicEvent &b) {
+    qint64 ta = a.originTime.toMSecsSinceEpoch();
+    qint64 tb = b.originTime.toMSecsSinceEpoch();
+    return ta != tb ? ta < tb : a.id < b.id;
+}
+}
+
+EventStore::EventStore()
+    : m_rowCount(0)
+{
+}
+
+void EventStore::assign(QVector<SeismicEvent> events) {
+    std::sort(events.begin(), events.end(), earlier);
+    
+    clear();
+    resize(int(events.size()));
+    for (int row = 0; row < m_rowCount; ++row) {
+        setRow(row, events[row]);
+    }
+}
+
+void EventStore::assign(const EventSnapshot &snapshot) {
+    clear();
+    resize(snapshot.rowCount());
+    
+    // The base is sorted like the store; each column is one copy
+    const size_t n = size_t(m_rowCount);
+    auto copy = [&](auto &column, EventSnapshot::Column c) {
+        using T = typename std::decay_t<decltype(column)>::value_type;
+        const T *values = snapshot.column<T>(c);
+        std::copy(values, values + n, column.begin());
+    };
+    copy(m_id, EventSnapshot::IdColumn);
+    copy(m_originMs, EventSnapshot::OriginColumn);
+    copy(m_magnitude, EventSnapshot::MagnitudeColumn);
+    copy(m_latitude, EventSnapshot::LatitudeColumn);
+    copy(m_longitude, EventSnapshot::LongitudeColumn);
+    copy(m_depth, EventSnapshot::DepthColumn);
+    copy(m_strike, EventSnapshot::StrikeColumn);
+    copy(m_dip, EventSnapshot::DipColumn);
+    copy(m_slip, EventSnapshot::SlipColumn);
+    for (int row = 0; row < m_rowCount; ++row) {
+        m_eventId[row] = snapshot.eventId(row);
+    }
+    
+    apply(snapshot.changedEvents(), snapshot.removedIds());
+}
+
+void EventStore::apply(const QVector<SeismicEvent> &changed, const QVector<int> &removed) {
+    if (changed.isEmpty() && removed.isEmpty()) return;
+    
+    QSet<int> dropped(removed.cbegin(), removed.cend());
+    for (const SeismicEvent &event : changed) dropped.insert(event.id);
+    QVector<SeismicEvent> added = changed;
+    std::sort(added.begin(), added.end(), earlier);
+    
+    // Kept rows and added ones are both sorted, so one merge keeps the order
+    EventStore merged;
+    merged.resize(m_rowCount + int(added.size()));
+    int out = 0;
+    int next = 0;
+    for (int row = 0; row <= m_rowCount; ++row) {
+        while (next < added.size()) {
+            const qint64 ms = added[next].originTime.toMSecsSinceEpoch();
+            if (row < m_rowCount && (ms != m_originMs[row] ? ms > m_originMs[row] : added[next].id > m_id[row])) {
+                break;
+            }
+            merged.setRow(out++, added[next++]);
+        }
+        if (row < m_rowCount && !dropped.contains(m_id[row])) merged.copyRow(out++, *this, row);
+    }
+    merged.resize(out);
+    *this = std::move(merged);
+}
+
+void EventStore::resize(int rows) {
+    m_rowCount = rows;
+    padColumn(m_originMs, rows);
+    padColumn(m_magnitude, rows);
+    padColumn(m_latitude, rows);
+    padColumn(m_longitude, rows);
+    padColumn(m_depth, rows);
+    padColumn(m_strike, rows);
+    padColumn(m_dip, rows);
+    padColumn(m_slip, rows);
+    padColumn(m_id, rows);
+    m_eventId.resize(rows);
+}
+
+void EventStore::setRow(int row, const SeismicEvent &event) {
+    m_originMs[row] = event.originTime.toMSecsSinceEpoch();
+    m_magnitude[row] = float(event.magnitude);
+    m_latitude[row] = event.latitude;
+    m_longitude[row] = event.longitude;
+    m_depth[row] = event.depth;
+    m_strike[row] = event.strike;
+    m_dip[row] = event.dip;
+    m_slip[row] = event.slip;
+    m_id[row] = event.id;
+    m_eventId[row] = event.eventId;
+}
+
+void EventStore::copyRow(int row, const EventStore &from, int fromRow) {
+    m_originMs[row] = from.m_originMs[fromRow];
+    m_magnitude[row] = from.m_magnitude[fromRow];
+    m_latitude[row] = from.m_latitude[fromRow];
+    m_longitude[row] = from.m_longitude[fromRow];
+    m_depth[row] = from.m_depth[fromRow];
+    m_strike[row] = from.m_strike[fromRow];
+    m_dip[row] = from.m_dip[fromRow];
+    m_slip[row] = from.m_slip[fromRow];
+    m_id[row] = from.m_id[fromRow];
+    m_eventId[row] = from.m_eventId[fromRow];
+}
+
+void EventStore::clear() {
+    m_rowCount = 0;
+    m_originMs.clear();
+    m_magnitude.clear();
+    m_latitude.clear();
+    m_longitude.clear();
+    m_depth.clear();
+    m_strike.clear();
+    m_dip.clear();
+    m_slip.clear();
+    m_id.clear();
+    m_eventId.clear();
+}
+
+int EventStore::rowCount() const {
+    return m_rowCount;
+}
+
+bool EventStore::isEmpty() const {
+    return m_rowCount == 0;
+}
+
+EventStore::Bitmap EventStore::filter(const CatalogFilter &filter) const {
+    Bitmap bitmap(size_t((m_rowCount + kBlock - 1) / kBlock), 0);
+    if (filter.matchesNothing) return bitmap;
+    
+    // Rows are in time order, so the date range is two binary searches
+    const qint64 *origin = m_originMs.data();
+    int first = 0;
+    int last = m_rowCount;
+    if (filter.startDate.isValid()) {
+        qint64 startMs = filter.startDate.startOfDay().toMSecsSinceEpoch();
+        first = int(std::lower_bound(origin, origin + m_rowCount, startMs) - origin);
+    }
+    if (filter.endDate.isValid()) {
+        qint64 endMs = filter.endDate.addDays(1).startOfDay().toMSecsSinceEpoch();
+        last = int(std::lower_bound(origin, origin + m_rowCount, endMs) - origin);
+    }
+    if (first >= last) return bitmap;
+    
+    // Missing bounds become infinite so each predicate is one range test.
+    // Magnitudes compare as float, like magnitudo >= ?::real on the server
+    const bool byMagnitude = filter.minMagnitude || filter.maxMagnitude;
+    const float magLo = filter.minMagnitude ? float(*filter.minMagnitude)
+                                            : -std::numeric_limits<float>::infinity();
+    const float magHi = filter.maxMagnitude ? float(*filter.maxMagnitude)
+                                            : std::numeric_limits<float>::infinity();
+    const bool byDepth = filter.minDepth || filter.maxDepth;
+    const qint32 depthLo = filter.minDepth ? *filter.minDepth : std::numeric_limits<qint32>::min();
+    const qint32 depthHi = filter.maxDepth ? *filter.maxDepth : std::numeric_limits<qint32>::max();
+    auto keepInBox = [this](quint8 *keep, int base, const CatalogFilter::GeoBox &box) {
+        keepInRange(keep, m_latitude.data() + base, box.south, box.north);
+        if (box.west <= box.east) {
+            keepInRange(keep, m_longitude.data() + base, box.west, box.east);
+        } else {
+            keepOutside(keep, m_longitude.data() + base, box.east, box.west);
+        }
+    };
+    
+    alignas(64) quint8 keep[kBlock];
+    for (int word = first / kBlock; word * kBlock < last; ++word) {
+        const int base = word * kBlock;
+        std::memset(keep, 1, sizeof(keep));
+        
+        if (byMagnitude) keepInRange(keep, m_magnitude.data() + base, magLo, magHi);
+        if (byDepth) keepInRange(keep, m_depth.data() + base, depthLo, depthHi);
+        if (filter.box) keepInBox(keep, base, *filter.box);
+        if (filter.secondBox) keepInBox(keep, base, *filter.secondBox);
+        
+        // The first and last block may stick out of the date range
+        quint64 bits = packBits(keep);
+        if (base < first) bits &= ~quint64(0) << (first - base);
+        if (base + kBlock > last) bits &= ~quint64(0) >> (base + kBlock - last);
+        bitmap[size_t(word)] = bits;
+    }
+    
+    if (filter.polygon.size() < 3 && filter.eventIdPrefix.isEmpty()) return bitmap;
+    
+    // Region and id prefix, on the survivors only
+    const QPolygonF region(filter.polygon);
+    for (size_t word = 0; word < bitmap.size(); ++word) {
+        quint64 bits = bitmap[word];
+        while (bits) {
+            int bit = qCountTrailingZeroBits(bits);
+            bits &= bits - 1;
+            int row = int(word) * kBlock + bit;
+            
+            bool match = true;
+            if (filter.polygon.size() >= 3) {
+                match = region.containsPoint(QPointF(m_longitude[row], m_latitude[row]), Qt::OddEvenFill);
+            }
+            if (match && !filter.eventIdPrefix.isEmpty()) {
+                match = m_eventId[row].startsWith(filter.eventIdPrefix);
+            }
+            if (!match) bitmap[word] &= ~(quint64(1) << bit);
+        }
+    }
+    return bitmap;
+}
+
+int EventStore::count(const Bitmap &bitmap) {
+    int total = 0;
+    for (quint64 word : bitmap) {
+        total += qPopulationCount(word);
+    }
+    return total;
+}
+
+QVector<int> EventStore::rows(const Bitmap &bitmap, int limit) const {
+    QVector<int> result;
+    result.reserve(limit > 0 ? limit : count(bitmap));
+    
+    // Highest row first, like the server's origintime DESC, id DESC
+    for (size_t word = bitmap.size(); word-- > 0;) {
+        quint64 bits = bitmap[word];
+        while (bits) {
+            int bit = 63 - qCountLeadingZeroBits(bits);
+            bits &= ~(quint64(1) << bit);
+            result.append(int(word) * kBlock + bit);
+            if (limit > 0 && result.size() >= limit) return result;
+        }
+    }
+    return result;
+}
+
+QVector<int> EventStore::largest(const Bitmap &bitmap, int limit) const {
+    QVector<int> result = rows(bitmap);
+    auto byMagnitude = [this](int a, int b) {
+        return m_magnitude[a] != m_magnitude[b] ? m_magnitude[a] > m_magnitude[b] : a > b;
+    };
+    if (limit > 0 && result.size() > limit) {
+        std::nth_element(result.begin(), result.begin() + limit, result.end(), byMagnitude);
+        result.resize(limit);
+    }
+    std::sort(result.begin(), result.end(), byMagnitude);
+    return result;
+}
+
+SeismicEvent EventStore::event(int row) const {
+    SeismicEvent event;
+    if (row < 0 || row >= m_rowCount) return event;
+    
+    event.id = m_id[row];
+    event.eventId = m_eventId[row];
+    event.originTime = QDateTime::fromMSecsSinceEpoch(m_originMs[row], QTimeZone::UTC);
+    event.magnitude = m_magnitude[row];
+    event.latitude = m_latitude[row];
+    event.longitude = m_longitude[row];
+    event.depth = m_depth[row];
+    event.strike = m_strike[row];
+    event.dip = m_dip[row];
+    event.slip = m_slip[row];
+    return event;
+}
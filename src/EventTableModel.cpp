@@ -0,0 +1,407 @@
+#include "EventTableModel.h"
+#include "RegionLookup.h"
+#include <QTimeZone>
+#include <algorithm>
+
+EventTableModel::EventTableModel(DatabaseWorker *worker, QObject *parent)
+    : QAbstractTableModel(parent)
+    , m_worker(worker)
+    , m_requestId(0)
+    , m_totalRows(0)
+    , m_useClock(0)
+    , m_store(nullptr)
+{
+    connect(m_worker, &DatabaseWorker::pageReady, this, &EventTableModel::onPageReady);
+    connect(m_worker, &DatabaseWorker::rowInserted, this, &EventTableModel::onRowInserted);
+    connect(m_worker, &DatabaseWorker::rowUpdated, this, &EventTableModel::onRowUpdated);
+    connect(m_worker, &DatabaseWorker::rowRemoved, this, &EventTableModel::onRowRemoved);
+}
+
+int EventTableModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : m_totalRows;
+}
+
+int EventTableModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant EventTableModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= m_totalRows) return QVariant();
+    if (role != Qt::DisplayRole && role != Qt::EditRole) return QVariant();
+    
+    if (m_store) {
+        // Straight from the columns, no row is materialized
+        int row = m_storeRows.at(index.row());
+        if (row < 0) return QVariant();
+        switch (index.column()) {
+        case EventIdColumn:    return m_store->eventId(row);
+        case OriginTimeColumn: return QDateTime::fromMSecsSinceEpoch(m_store->originMs(row), QTimeZone::UTC);
+        case MagnitudeColumn:  return double(m_store->magnitude(row));
+        case LatitudeColumn:   return m_store->latitude(row);
+        case LongitudeColumn:  return m_store->longitude(row);
+        case DepthColumn:      return m_store->depth(row);
+        case StrikeColumn:     return m_store->strike(row);
+        case DipColumn:        return m_store->dip(row);
+        case SlipColumn:       return m_store->slip(row);
+        case RegionColumn:     return RegionLookup::shared().describe(m_store->latitude(row),
+                                                                      m_store->longitude(row));
+        default:               return QVariant();
+        }
+    }
+    
+    const SeismicEvent *event = rowPointer(index.row());
+    if (!event) {
+        return index.column() == EventIdColumn ? QVariant("...") : QVariant();
+    }
+    
+    switch (index.column()) {
+    case EventIdColumn:    return event->eventId;
+    case OriginTimeColumn: return event->originTime;
+    case MagnitudeColumn:  return event->magnitude;
+    case LatitudeColumn:   return event->latitude;
+    case LongitudeColumn:  return event->longitude;
+    case DepthColumn:      return event->depth;
+    case StrikeColumn:     return event->strike;
+    case DipColumn:        return event->dip;
+    case SlipColumn:       return event->slip;
+    case RegionColumn:     return RegionLookup::shared().describe(event->latitude, event->longitude);
+    default:               return QVariant();
+    }
+}
+
+QVariant EventTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    
+    switch (section) {
+    case EventIdColumn:    return "Event ID";
+    case OriginTimeColumn: return "Origin Time (UTC)";
+    case MagnitudeColumn:  return "Magnitude";
+    case LatitudeColumn:   return "Latitude";
+    case LongitudeColumn:  return "Longitude";
+    case DepthColumn:      return "Depth (km)";
+    case StrikeColumn:     return "Strike";
+    case DipColumn:        return "Dip";
+    case SlipColumn:       return "Slip";
+    case RegionColumn:     return "Region";
+    default:               return QVariant();
+    }
+}
+
+void EventTableModel::clear() {
+    beginResetModel();
+    m_requestId = 0;
+    m_totalRows = 0;
+    m_anchors.clear();
+    m_pageCounts.clear();
+    m_pageStarts.clear();
+    m_pages.clear();
+    m_requestedPages.clear();
+    m_dirtyPages.clear();
+    m_store = nullptr;
+    m_storeRows.clear();
+    m_storeKeys.clear();
+    endResetModel();
+}
+
+void EventTableModel::setWindow(quint64 requestId, int totalRows, const QVector<EventKey> &anchors,
+                                const CatalogFilter &filter) {
+    beginResetModel();
+    m_requestId = requestId;
+    m_anchors = anchors;
+    m_filter = filter;
+    
+    // Every page is full except the last
+    m_pageCounts.fill(kPageSize, anchors.size());
+    if (!anchors.isEmpty()) {
+        m_pageCounts.last() = qBound(0, totalRows - (int(anchors.size()) - 1) * kPageSize, kPageSize);
+    }
+    updatePageStarts();
+    
+    m_pages.clear();
+    m_requestedPages.clear();
+    m_dirtyPages.clear();
+    m_store = nullptr;
+    m_storeRows.clear();
+    m_storeKeys.clear();
+    endResetModel();
+}
+
+void EventTableModel::setLocalRows(const EventStore *store, const QVector<int> &rows) {
+    beginResetModel();
+    m_requestId = 0;
+    m_anchors.clear();
+    m_pageCounts.clear();
+    m_pageStarts.clear();
+    m_pages.clear();
+    m_requestedPages.clear();
+    m_dirtyPages.clear();
+    m_store = store;
+    m_storeRows = rows;
+    m_storeKeys.resize(rows.size());
+    for (int i = 0; i < rows.size(); ++i) {
+        m_storeKeys[i] = qMakePair(store->originMs(rows[i]), store->id(rows[i]));
+    }
+    m_totalRows = int(rows.size());
+    endResetModel();
+}
+
+void EventTableModel::updateLocalRows(const QVector<int> &rows, const QSet<int> &changedIds) {
+    if (!m_store) return;
+    
+    QVector<QPair<qint64, int>> keys(rows.size());
+    for (int i = 0; i < rows.size(); ++i) {
+        keys[i] = qMakePair(m_store->originMs(rows[i]), m_store->id(rows[i]));
+    }
+    
+    // Both lists run newest first, so one walk pairs up the rows in both.
+    // Those keep their place and are pointed at their new store row now, so
+    // data() stays right while the others are inserted and removed; rows
+    // that are going away show nothing in the meantime
+    const QVector<QPair<qint64, int>> oldKeys = m_storeKeys;
+    const int oldCount = oldKeys.size();
+    const int newCount = keys.size();
+    int diffs = 0;
+    for (int i = 0, j = 0; i < oldCount || j < newCount;) {
+        if (i < oldCount && j < newCount && oldKeys[i] == keys[j]) {
+            m_storeRows[i++] = rows[j++];
+        } else if (j == newCount || (i < oldCount && keys[j] < oldKeys[i])) {
+            m_storeRows[i++] = -1;
+            ++diffs;
+        } else {
+            ++j;
+            ++diffs;
+        }
+    }
+    if (diffs > kMaxLocalRowDiffs) {
+        setLocalRows(m_store, rows);
+        return;
+    }
+    
+    // Runs of removed and inserted rows, one signal each; m_storeRows holds
+    // the new rows before position and the old ones from there on
+    int changedFirst = -1;
+    auto flushChanged = [&](int end) {
+        if (changedFirst < 0) return;
+        emit dataChanged(index(changedFirst, 0), index(end - 1, ColumnCount - 1));
+        changedFirst = -1;
+    };
+    int position = 0;
+    for (int i = 0, j = 0; i < oldCount || j < newCount;) {
+        if (i < oldCount && j < newCount && oldKeys[i] == keys[j]) {
+            if (changedIds.contains(keys[j].second)) {
+                if (changedFirst < 0) changedFirst = position;
+            } else {
+                flushChanged(position);
+            }
+            ++i;
+            ++j;
+            ++position;
+            continue;
+        }
+        flushChanged(position);
+        
+        int count = 0;
+        if (j == newCount || (i < oldCount && keys[j] < oldKeys[i])) {
+            while (i + count < oldCount && (j == newCount || keys[j] < oldKeys[i + count])) ++count;
+            beginRemoveRows(QModelIndex(), position, position + count - 1);
+            m_storeRows.remove(position, count);
+            m_storeKeys.remove(position, count);
+            m_totalRows -= count;
+            endRemoveRows();
+            i += count;
+        } else {
+            while (j + count < newCount && (i == oldCount || oldKeys[i] < keys[j + count])) ++count;
+            beginInsertRows(QModelIndex(), position, position + count - 1);
+            m_storeRows.insert(position, count, 0);
+            m_storeKeys.insert(position, count, qMakePair(qint64(0), 0));
+            std::copy(rows.cbegin() + j, rows.cbegin() + j + count, m_storeRows.begin() + position);
+            std::copy(keys.cbegin() + j, keys.cbegin() + j + count, m_storeKeys.begin() + position);
+            m_totalRows += count;
+            endInsertRows();
+            j += count;
+            position += count;
+        }
+    }
+    flushChanged(position);
+}
+
+bool EventTableModel::isLocal() const {
+    return m_store != nullptr;
+}
+
+bool EventTableModel::eventAt(int row, SeismicEvent &event) const {
+    if (m_store) {
+        if (row < 0 || row >= m_totalRows || m_storeRows.at(row) < 0) return false;
+        event = m_store->event(m_storeRows.at(row));
+        return true;
+    }
+    
+    const SeismicEvent *found = rowPointer(row);
+    if (!found) return false;
+    
+    event = *found;
+    return true;
+}
+
+void EventTableModel::updatePageStarts() {
+    m_pageStarts.resize(m_pageCounts.size());
+    int start = 0;
+    for (int i = 0; i < m_pageCounts.size(); ++i) {
+        m_pageStarts[i] = start;
+        start += m_pageCounts[i];
+    }
+    m_totalRows = start;
+}
+
+int EventTableModel::pageOf(int row) const {
+    // Last page starting at or before row; empty pages share the next start
+    auto it = std::upper_bound(m_pageStarts.cbegin(), m_pageStarts.cend(), row);
+    return int(it - m_pageStarts.cbegin()) - 1;
+}
+
+const SeismicEvent *EventTableModel::rowPointer(int row) const {
+    if (row < 0 || row >= m_totalRows) return nullptr;
+    
+    int page = pageOf(row);
+    auto it = m_pages.find(page);
+    if (it == m_pages.end()) {
+        requestPage(page);
+        return nullptr;
+    }
+    
+    it->lastUsed = ++m_useClock;
+    int offset = row - m_pageStarts[page];
+    return offset < it->rows.size() ? &it->rows.at(offset) : nullptr;
+}
+
+void EventTableModel::requestPage(int page) const {
+    if (m_requestId == 0 || page >= m_anchors.size() || m_requestedPages.contains(page)) return;
+    m_requestedPages.insert(page);
+    
+    QMetaObject::invokeMethod(m_worker, [worker = m_worker, requestId = m_requestId, page,
+                                         anchor = m_anchors.at(page), count = m_pageCounts.at(page),
+                                         filter = m_filter]() {
+        worker->fetchPage(requestId, page, anchor, filter, count);
+    }, Qt::QueuedConnection);
+}
+
+void EventTableModel::onPageReady(quint64 requestId, int page, const QVector<SeismicEvent> &rows) {
+    if (requestId != m_requestId || !m_requestedPages.remove(page)) return;
+    
+    // A diff touched the page while it was in flight; the rows may predate
+    // it, so drop them and let the view ask again
+    bool dirty = m_dirtyPages.remove(page);
+    if (!dirty && !rows.isEmpty()) {
+        Page &entry = m_pages[page];
+        entry.rows = rows;
+        entry.lastUsed = ++m_useClock;
+        evictPages();
+    }
+    emitPageChanged(page);
+}
+
+void EventTableModel::emitPageChanged(int page) {
+    if (m_pageCounts[page] == 0) return;
+    
+    int first = m_pageStarts[page];
+    int last = first + m_pageCounts[page] - 1;
+    emit dataChanged(index(first, 0), index(last, ColumnCount - 1));
+}
+
+void EventTableModel::touchPage(int page) {
+    if (m_requestedPages.contains(page)) {
+        m_dirtyPages.insert(page);
+    }
+}
+
+void EventTableModel::onRowInserted(quint64 requestId, int row, const SeismicEvent &event,
+                                    const EventKey &key) {
+    if (requestId != m_requestId || row < 0 || row > m_totalRows) return;
+    
+    // The row joins the page holding its predecessor. A new newest row
+    // becomes the first page's key; an empty window gets its first page.
+    int page = 0;
+    if (m_anchors.isEmpty()) {
+        m_anchors.append(key);
+        m_pageCounts.append(0);
+        m_pageStarts.append(0);
+    } else if (row == 0) {
+        m_anchors[0] = key;
+    } else {
+        page = pageOf(row - 1);
+    }
+    int offset = row - m_pageStarts[page];
+    
+    beginInsertRows(QModelIndex(), row, row);
+    ++m_pageCounts[page];
+    updatePageStarts();
+    
+    auto it = m_pages.find(page);
+    if (it != m_pages.end()) {
+        bool present = std::any_of(it->rows.cbegin(), it->rows.cend(),
+                                   [&](const SeismicEvent &e) { return e.id == event.id; });
+        if (present || offset > it->rows.size()) {
+            // Fetched after the change already landed; refetch instead of guessing
+            m_pages.erase(it);
+        } else {
+            it->rows.insert(offset, event);
+        }
+    }
+    touchPage(page);
+    endInsertRows();
+}
+
+void EventTableModel::onRowUpdated(quint64 requestId, int row, const SeismicEvent &event) {
+    if (requestId != m_requestId || row < 0 || row >= m_totalRows) return;
+    
+    int page = pageOf(row);
+    auto it = m_pages.find(page);
+    if (it != m_pages.end()) {
+        auto found = std::find_if(it->rows.begin(), it->rows.end(),
+                                  [&](const SeismicEvent &e) { return e.id == event.id; });
+        if (found != it->rows.end()) {
+            *found = event;
+        } else {
+            m_pages.erase(it);
+        }
+    }
+    touchPage(page);
+    emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+}
+
+void EventTableModel::onRowRemoved(quint64 requestId, int row, int eventId) {
+    if (requestId != m_requestId || row < 0 || row >= m_totalRows) return;
+    
+    // The page key stays: keyset bounds do not need the row to exist
+    int page = pageOf(row);
+    
+    beginRemoveRows(QModelIndex(), row, row);
+    --m_pageCounts[page];
+    updatePageStarts();
+    
+    auto it = m_pages.find(page);
+    if (it != m_pages.end()) {
+        auto found = std::find_if(it->rows.begin(), it->rows.end(),
+                                  [&](const SeismicEvent &e) { return e.id == eventId; });
+        if (found != it->rows.end()) {
+            it->rows.erase(found);
+        } else {
+            m_pages.erase(it);
+        }
+    }
+    touchPage(page);
+    endRemoveRows();
+}
+
+void EventTableModel::evictPages() {
+    // Least recently painted pages go first; the view asks again if it scrolls back
+    while (m_pages.size() > kMaxResidentPages) {
+        auto oldest = m_pages.begin();
+        for (auto it = m_pages.begin(); it != m_pages.end(); ++it) {
+            if (it->lastUsed < oldest->lastUsed) oldest = it;
+        }
+        m_pages.erase(oldest);
+    }
+}
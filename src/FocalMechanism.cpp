@@ -0,0 +1,264 @@
+#include "FocalMechanism.h"
+#include <QCache>
+#include <QColor>
+#include <QFont>
+#include <QPainter>
+#include <QPainterPath>
+#include <cmath>
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kDegToRad = kPi / 180.0;
+constexpr double kRadToDeg = 180.0 / kPi;
+constexpr int kCurveSegments = 90;
+// Rendered beach balls kept by pixmap(); cost is in bytes like TileCache
+constexpr int kPixmapCacheBytes = 8 * 1024 * 1024;
+
+struct ThemeColors {
+    QRgb compression;
+    QRgb dilatation;
+    QColor nodal;
+    QColor outline;
+    QColor axisLabel;
+};
+
+ThemeColors themeColors(FocalMechanism::Theme theme) {
+    switch (theme) {
+    case FocalMechanism::MapTheme:
+        return {qRgb(200, 30, 30), qRgb(255, 255, 255), QColor(40, 40, 40), QColor(40, 40, 40),
+                QColor(40, 40, 40)};
+    case FocalMechanism::DarkTheme:
+    default:
+        return {qRgb(0, 0, 0), qRgb(255, 255, 255), QColor(128, 128, 128), QColor(255, 255, 255),
+                QColor(230, 120, 0)};
+    }
+}
+
+double wrapDegrees(double angle, double low) {
+    angle = std::fmod(angle - low, 360.0);
+    if (angle < 0) angle += 360.0;
+    return angle + low;
+}
+
+void normalize(double v[3]) {
+    double length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (length == 0) return;
+    v[0] /= length;
+    v[1] /= length;
+    v[2] /= length;
+}
+
+// Premultiplied mix of two colours, weight a for the first, alpha for coverage
+QRgb blend(QRgb a, QRgb b, double weightA, double alpha) {
+    auto channel = [&](int ca, int cb) {
+        return int(std::lround((ca * weightA + cb * (1.0 - weightA)) * alpha));
+    };
+    return qRgba(channel(qRed(a), qRed(b)), channel(qGreen(a), qGreen(b)),
+                 channel(qBlue(a), qBlue(b)), int(std::lround(255 * alpha)));
+}
+}
+
+FocalMechanism::FocalMechanism(double strike, double dip, double rake) {
+    m_plane1.strike = wrapDegrees(strike, 0.0);
+    m_plane1.dip = qBound(0.0, dip, 90.0);
+    m_plane1.rake = wrapDegrees(rake, -180.0);
+    
+    // Aki & Richards (4.88): normal and slip in (north, east, down)
+    const double phi = m_plane1.strike * kDegToRad;
+    const double delta = m_plane1.dip * kDegToRad;
+    const double lambda = m_plane1.rake * kDegToRad;
+    m_normal[0] = -std::sin(delta) * std::sin(phi);
+    m_normal[1] = std::sin(delta) * std::cos(phi);
+    m_normal[2] = -std::cos(delta);
+    m_slip[0] = std::cos(lambda) * std::cos(phi) + std::sin(lambda) * std::cos(delta) * std::sin(phi);
+    m_slip[1] = std::cos(lambda) * std::sin(phi) - std::sin(lambda) * std::cos(delta) * std::cos(phi);
+    m_slip[2] = -std::sin(lambda) * std::sin(delta);
+    
+    m_plane2 = planeFrom(m_slip, m_normal);
+    
+    double t[3] = {m_normal[0] + m_slip[0], m_normal[1] + m_slip[1], m_normal[2] + m_slip[2]};
+    double p[3] = {m_normal[0] - m_slip[0], m_normal[1] - m_slip[1], m_normal[2] - m_slip[2]};
+    double b[3] = {m_normal[1] * m_slip[2] - m_normal[2] * m_slip[1],
+                   m_normal[2] * m_slip[0] - m_normal[0] * m_slip[2],
+                   m_normal[0] * m_slip[1] - m_normal[1] * m_slip[0]};
+    normalize(t);
+    normalize(p);
+    normalize(b);
+    m_t = axisFrom(t);
+    m_p = axisFrom(p);
+    m_b = axisFrom(b);
+}
+
+FocalMechanism::NodalPlane FocalMechanism::planeFrom(const double normal[3], const double slip[3]) {
+    // The plane's normal must point up (n_down = -cos(dip) <= 0)
+    double n[3] = {normal[0], normal[1], normal[2]};
+    double d[3] = {slip[0], slip[1], slip[2]};
+    if (n[2] > 0) {
+        for (int i = 0; i < 3; ++i) {
+            n[i] = -n[i];
+            d[i] = -d[i];
+        }
+    }
+    
+    NodalPlane plane;
+    plane.dip = std::acos(qBound(-1.0, -n[2], 1.0)) * kRadToDeg;
+    double sinDip = std::sqrt(n[0] * n[0] + n[1] * n[1]);
+    if (sinDip < 1e-9) {
+        // Horizontal plane: any strike works, take the one with zero rake
+        plane.strike = wrapDegrees(std::atan2(d[1], d[0]) * kRadToDeg, 0.0);
+        plane.rake = 0.0;
+        return plane;
+    }
+    
+    double phi = std::atan2(-n[0], n[1]);
+    double sinRake = -d[2] / sinDip;
+    double cosRake = d[0] * std::cos(phi) + d[1] * std::sin(phi);
+    plane.strike = wrapDegrees(phi * kRadToDeg, 0.0);
+    plane.rake = std::atan2(sinRake, cosRake) * kRadToDeg;
+    return plane;
+}
+
+FocalMechanism::Axis FocalMechanism::axisFrom(const double v[3]) {
+    // Axes are lines; report the end pointing down
+    double sign = v[2] < 0 ? -1.0 : 1.0;
+    Axis axis;
+    axis.trend = wrapDegrees(std::atan2(sign * v[1], sign * v[0]) * kRadToDeg, 0.0);
+    axis.plunge = std::asin(qBound(-1.0, sign * v[2], 1.0)) * kRadToDeg;
+    return axis;
+}
+
+double FocalMechanism::radiation(double north, double east, double down) const {
+    double alongNormal = m_normal[0] * north + m_normal[1] * east + m_normal[2] * down;
+    double alongSlip = m_slip[0] * north + m_slip[1] * east + m_slip[2] * down;
+    return 2.0 * alongNormal * alongSlip;
+}
+
+QPointF FocalMechanism::project(double north, double east, double down) {
+    if (down < 0) {
+        north = -north;
+        east = -east;
+        down = -down;
+    }
+    // Equal-area: r = sqrt(2) sin(i/2) = sqrt(1 - cos i), scaled so the horizon is 1
+    double r = std::sqrt(qMax(0.0, 1.0 - down));
+    double horizontal = std::sqrt(north * north + east * east);
+    if (horizontal < 1e-12) return QPointF(0, 0);
+    return QPointF(r * east / horizontal, -r * north / horizontal);
+}
+
+QImage FocalMechanism::render(int size, Theme theme) const {
+    QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    if (size <= 0) return image;
+    
+    const ThemeColors colors = themeColors(theme);
+    const double lineWidth = qMax(1.0, size / 64.0);
+    const double center = size / 2.0;
+    const double radius = center - lineWidth / 2.0;
+    
+    // Polarity per subsample. For a point (x, y) of the unit disc the ray is
+    // (-y, x) * sqrt(2 - r^2) horizontally and 1 - r^2 down: the inverse of
+    // project() without any trigonometry
+    static const double offsets[2] = {0.25, 0.75};
+    for (int row = 0; row < size; ++row) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(row));
+        for (int col = 0; col < size; ++col) {
+            int inside = 0;
+            int compressional = 0;
+            for (double oy : offsets) {
+                for (double ox : offsets) {
+                    double x = (col + ox - center) / radius;
+                    double y = (row + oy - center) / radius;
+                    double r2 = x * x + y * y;
+                    if (r2 > 1.0) continue;
+                    
+                    double horizontal = std::sqrt(2.0 - r2);
+                    ++inside;
+                    if (radiation(-y * horizontal, x * horizontal, 1.0 - r2) > 0) ++compressional;
+                }
+            }
+            if (inside > 0) {
+                line[col] = blend(colors.compression, colors.dilatation,
+                                  double(compressional) / inside, inside / 4.0);
+            }
+        }
+    }
+    
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.translate(center, center);
+    painter.scale(radius, radius);
+    
+    // Nodal planes: lower half of each great circle, from strike to strike + 180
+    painter.setPen(QPen(colors.nodal, lineWidth / radius));
+    painter.setBrush(Qt::NoBrush);
+    for (const NodalPlane &plane : {m_plane1, m_plane2}) {
+        const double phi = plane.strike * kDegToRad;
+        const double delta = plane.dip * kDegToRad;
+        const double strikeDir[3] = {std::cos(phi), std::sin(phi), 0.0};
+        const double dipDir[3] = {-std::sin(phi) * std::cos(delta), std::cos(phi) * std::cos(delta),
+                                  std::sin(delta)};
+        QPainterPath curve;
+        for (int i = 0; i <= kCurveSegments; ++i) {
+            double t = kPi * i / kCurveSegments;
+            QPointF point = project(std::cos(t) * strikeDir[0] + std::sin(t) * dipDir[0],
+                                    std::cos(t) * strikeDir[1] + std::sin(t) * dipDir[1],
+                                    std::sin(t) * dipDir[2]);
+            if (i == 0) {
+                curve.moveTo(point);
+            } else {
+                curve.lineTo(point);
+            }
+        }
+        painter.drawPath(curve);
+    }
+    
+    painter.setPen(QPen(colors.outline, lineWidth / radius));
+    painter.drawEllipse(QPointF(0, 0), 1.0, 1.0);
+    
+    // P and T labels once they are readable
+    if (size >= 48) {
+        painter.resetTransform();
+        QFont font("Arial");
+        font.setPixelSize(qMax(9, size / 9));
+        font.setBold(true);
+        painter.setFont(font);
+        painter.setPen(colors.axisLabel);
+        const struct {
+            const char *name;
+            Axis axis;
+        } labels[2] = {{"P", m_p}, {"T", m_t}};
+        for (const auto &label : labels) {
+            double trend = label.axis.trend * kDegToRad;
+            double plunge = label.axis.plunge * kDegToRad;
+            QPointF point = project(std::cos(plunge) * std::cos(trend), std::cos(plunge) * std::sin(trend),
+                                    std::sin(plunge));
+            QPointF pixel(center + point.x() * radius, center + point.y() * radius);
+            QRectF box(pixel.x() - size / 10.0, pixel.y() - size / 10.0, size / 5.0, size / 5.0);
+            painter.drawText(box, Qt::AlignCenter, label.name);
+        }
+    }
+    return image;
+}
+
+QPixmap FocalMechanism::pixmap(int strike, int dip, int rake, int size, Theme theme,
+                               qreal devicePixelRatio) {
+    static QCache<quint64, QPixmap> cache(kPixmapCacheBytes);
+    
+    const int deviceSize = qBound(1, qRound(size * devicePixelRatio), 4095);
+    const int ratioKey = qBound(1, qRound(devicePixelRatio * 100), 1023);
+    // 9 bits strike, 7 dip, 9 rake + 180, 12 size, 2 theme, 10 pixel ratio
+    const quint64 key = quint64(int(wrapDegrees(strike, 0.0)) % 360)
+                        | quint64(qBound(0, dip, 90)) << 9
+                        | quint64(int(wrapDegrees(rake, -180.0)) + 180) << 16
+                        | quint64(deviceSize) << 25
+                        | quint64(theme & 3) << 37
+                        | quint64(ratioKey) << 39;
+    
+    if (QPixmap *cached = cache.object(key)) return *cached;
+    
+    QPixmap pixmap = QPixmap::fromImage(FocalMechanism(strike, dip, rake).render(deviceSize, theme));
+    pixmap.setDevicePixelRatio(devicePixelRatio);
+    cache.insert(key, new QPixmap(pixmap), qMax(1, deviceSize * deviceSize * 4));
+    return pixmap;
+}
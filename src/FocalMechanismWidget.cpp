@@ -1,10 +1,10 @@
 #include "FocalMechanismWidget.h"
+#include "FocalMechanism.h"
+#include "RegionLookup.h"
 #include <QPainter>
-#include <QPainterPath>
 #include <QPen>
 #include <QBrush>
 #include <QFont>
-#include <cmath>
 
 FocalMechanismWidget::FocalMechanismWidget(QWidget *parent)
     : QWidget(parent)
@@ -26,19 +26,12 @@ void FocalMechanismWidget::setEventData(const QString &eventId, double lat, doub
     m_depth = depth;
     m_originTime = originTime;
     
-    // Determine location based on coordinates
-    if (lat >= -6.5 && lat <= -5.5 && lon >= 105 && lon <= 107) {
-        m_location = "Southern Sumatra, Indonesia";
-    } else if (lat >= -8.5 && lat <= -7.0 && lon >= 109 && lon <= 111) {
-        m_location = "Central Java, Indonesia";
-    } else if (lat >= -9.0 && lat <= -7.5 && lon >= 114 && lon <= 116) {
-        m_location = "Bali, Indonesia";
-    } else if (lat >= 2.5 && lat <= 4.5 && lon >= 97 && lon <= 99) {
-        m_location = "Aceh, Indonesia";
-    } else if (lat >= -1.5 && lat <= 0.5 && lon >= 119 && lon <= 121) {
-        m_location = "Sulawesi, Indonesia";
-    } else {
-        m_location = "Indonesia Region";
+    // Flinn-Engdahl region and nearest town, from the bundled dataset
+    const RegionLookup &regions = RegionLookup::shared();
+    m_location = regions.describe(lat, lon);
+    m_nearestPlace.clear();
+    if (!regions.region(lat, lon).isEmpty()) {
+        m_nearestPlace = RegionLookup::relativeTo(regions.nearestPlace(lat, lon));
     }
     
     m_hasData = true;
@@ -95,6 +88,13 @@ void FocalMechanismWidget::paintEvent(QPaintEvent *event) {
     painter.setFont(locFont);
     painter.drawText(margin, yPos, m_location);
     
+    if (!m_nearestPlace.isEmpty()) {
+        yPos += 15;
+        painter.setFont(smallFont);
+        painter.setPen(QColor(200, 200, 200));
+        painter.drawText(margin, yPos, m_nearestPlace);
+    }
+    
     yPos += 25;
     
     // Magnitude, Depth, Distance info
@@ -127,65 +127,8 @@ void FocalMechanismWidget::paintEvent(QPaintEvent *event) {
 }
 
 void FocalMechanismWidget::drawBeachBall(QPainter &painter, int centerX, int centerY, int radius) {
-    painter.save();
-    
-    // Draw outer white circle
-    painter.setPen(QPen(Qt::white, 2));
-    painter.setBrush(Qt::white);
-    painter.drawEllipse(QPoint(centerX, centerY), radius, radius);
-    
-    // Calculate angles from strike/dip/slip
-    double strikeRad = m_strike * M_PI / 180.0;
-    
-    // Draw compressional quadrants (black)
-    painter.setBrush(Qt::black);
-    painter.setPen(Qt::NoPen);
-    
-    QPainterPath path;
-    path.moveTo(centerX, centerY);
-    
-    // First quadrant
-    double startAngle = strikeRad - M_PI / 2;
-    double spanAngle = M_PI;
-    
-    QPointF p1(centerX + radius * cos(startAngle), 
-               centerY + radius * sin(startAngle));
-    QPointF p2(centerX + radius * cos(startAngle + spanAngle), 
-               centerY + radius * sin(startAngle + spanAngle));
-    
-    path.lineTo(p1);
-    path.arcTo(centerX - radius, centerY - radius, 
-               radius * 2, radius * 2,
-               startAngle * 180 / M_PI, 
-               spanAngle * 180 / M_PI);
-    path.lineTo(centerX, centerY);
-    
-    painter.drawPath(path);
-    
-    // Draw nodal planes
-    painter.setPen(QPen(Qt::black, 2));
-    
-    // Primary nodal plane
-    painter.drawLine(
-        centerX + radius * cos(strikeRad),
-        centerY + radius * sin(strikeRad),
-        centerX - radius * cos(strikeRad),
-        centerY - radius * sin(strikeRad)
-    );
-    
-    // Auxiliary plane (perpendicular)
-    double auxAngle = strikeRad + M_PI / 2;
-    painter.drawLine(
-        centerX + radius * cos(auxAngle),
-        centerY + radius * sin(auxAngle),
-        centerX - radius * cos(auxAngle),
-        centerY - radius * sin(auxAngle)
-    );
-    
-    // Redraw outer circle
-    painter.setBrush(Qt::NoBrush);
-    painter.setPen(QPen(Qt::white, 2));
-    painter.drawEllipse(QPoint(centerX, centerY), radius, radius);
-    
-    painter.restore();
+    // Rendered once per mechanism and size; a repaint is a blit
+    QPixmap ball = FocalMechanism::pixmap(m_strike, m_dip, m_slip, radius * 2,
+                                          FocalMechanism::DarkTheme, devicePixelRatioF());
+    painter.drawPixmap(centerX - radius, centerY - radius, ball);
 }
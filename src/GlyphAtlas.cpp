@@ -0,0 +1,193 @@
+#include "GlyphAtlas.h"
+#include <QMetaObject>
+#include <QThread>
+#include <cstring>
+
+namespace {
+// Sisi halaman atlas dalam pixel device
+constexpr int kPageSide = 2048;
+// Glyphs per worker task; small enough to spread over every core
+constexpr int kBatchSize = 32;
+
+constexpr int kStrikeSteps = 360 / GlyphAtlas::kAngleStep;
+constexpr int kRakeSteps = 360 / GlyphAtlas::kAngleStep;
+
+int roundedStep(int angle) {
+    // Nearest step, halves away from zero
+    int step = (qAbs(angle) + GlyphAtlas::kAngleStep / 2) / GlyphAtlas::kAngleStep;
+    return angle < 0 ? -step : step;
+}
+}
+
+GlyphAtlas::GlyphAtlas(int glyphSize, FocalMechanism::Theme theme, QObject *parent)
+    : QObject(parent)
+    , m_canceled(std::make_shared<std::atomic_bool>(false))
+    , m_glyphSize(qMax(1, glyphSize))
+    , m_theme(theme)
+    , m_devicePixelRatio(1.0)
+    , m_deviceSize(m_glyphSize)
+    , m_perRow(qMax(1, kPageSide / m_deviceSize))
+    , m_readyCount(0)
+{
+    // Satu core disisakan untuk GUI thread, seperti TileLoader
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+GlyphAtlas::~GlyphAtlas() {
+    m_canceled->store(true);
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+quint32 GlyphAtlas::keyFor(int strike, int dip, int rake) {
+    int s = roundedStep(strike) % kStrikeSteps;
+    if (s < 0) s += kStrikeSteps;
+    int d = qBound(0, roundedStep(dip), 90 / kAngleStep);
+    // Rake -180 and 180 are the same slip
+    int r = (roundedStep(rake) + kRakeSteps / 2) % kRakeSteps;
+    if (r < 0) r += kRakeSteps;
+    return 1u << 16 | quint32(r) << 10 | quint32(d) << 6 | quint32(s);
+}
+
+int GlyphAtlas::glyphSize() const {
+    return m_glyphSize;
+}
+
+qreal GlyphAtlas::devicePixelRatio() const {
+    return m_devicePixelRatio;
+}
+
+void GlyphAtlas::setDevicePixelRatio(qreal ratio) {
+    ratio = qMax(qreal(0.5), ratio);
+    if (qFuzzyCompare(ratio, m_devicePixelRatio)) return;
+    
+    clear();
+    m_devicePixelRatio = ratio;
+    m_deviceSize = qMax(1, qRound(m_glyphSize * ratio));
+    m_perRow = qMax(1, kPageSide / m_deviceSize);
+}
+
+void GlyphAtlas::request(const QVector<quint32> &keys) {
+    QVector<Job> batch;
+    batch.reserve(kBatchSize);
+    for (quint32 key : keys) {
+        if (key == 0 || m_slots.contains(key)) continue;
+        
+        const int slot = allocateSlot();
+        m_slots.insert(key, slot);
+        batch.append({key, slot});
+        if (batch.size() == kBatchSize) {
+            startBatch(batch);
+            batch.clear();
+        }
+    }
+    if (!batch.isEmpty()) startBatch(batch);
+}
+
+bool GlyphAtlas::glyph(quint32 key, Glyph *out) const {
+    auto it = m_slots.constFind(key);
+    if (it == m_slots.cend() || !m_slotReady[it.value()]) return false;
+    
+    const int perPage = m_perRow * m_perRow;
+    out->page = it.value() / perPage;
+    out->source = QRectF(slotRect(it.value()));
+    return true;
+}
+
+const QPixmap &GlyphAtlas::page(int index) {
+    // Converted once per finished batch, not once per glyph
+    if (m_pageDirty[index]) {
+        m_pages[index] = QPixmap::fromImage(m_pageImages[index]);
+        m_pageDirty[index] = false;
+    }
+    return m_pages[index];
+}
+
+int GlyphAtlas::pageCount() const {
+    return m_pages.size();
+}
+
+int GlyphAtlas::glyphCount() const {
+    return m_readyCount;
+}
+
+void GlyphAtlas::clear() {
+    // Running batches see the flag; queued ones never start
+    m_canceled->store(true);
+    m_canceled = std::make_shared<std::atomic_bool>(false);
+    m_pool.clear();
+    
+    m_slots.clear();
+    m_slotReady.clear();
+    m_readyCount = 0;
+    m_pageImages.clear();
+    m_pages.clear();
+    m_pageDirty.clear();
+}
+
+int GlyphAtlas::allocateSlot() {
+    const int slot = m_slotReady.size();
+    const int perPage = m_perRow * m_perRow;
+    if (slot % perPage == 0) {
+        QImage image(m_perRow * m_deviceSize, m_perRow * m_deviceSize,
+                     QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        m_pageImages.append(image);
+        m_pages.append(QPixmap());
+        m_pageDirty.append(true);
+    }
+    m_slotReady.append(false);
+    return slot;
+}
+
+QRect GlyphAtlas::slotRect(int slot) const {
+    const int index = slot % (m_perRow * m_perRow);
+    return QRect((index % m_perRow) * m_deviceSize, (index / m_perRow) * m_deviceSize,
+                 m_deviceSize, m_deviceSize);
+}
+
+void GlyphAtlas::startBatch(const QVector<Job> &batch) {
+    const CancelFlag canceled = m_canceled;
+    const int size = m_deviceSize;
+    const FocalMechanism::Theme theme = m_theme;
+    
+    m_pool.start([this, batch, canceled, size, theme]() {
+        QVector<QImage> images;
+        images.reserve(batch.size());
+        for (const Job &job : batch) {
+            if (canceled->load()) return;
+            
+            const int strike = int(job.key & 0x3f) * kAngleStep;
+            const int dip = int((job.key >> 6) & 0xf) * kAngleStep;
+            const int rake = int((job.key >> 10) & 0x3f) * kAngleStep - 180;
+            images.append(FocalMechanism(strike, dip, rake).render(size, theme));
+        }
+        
+        QMetaObject::invokeMethod(this, [this, batch, images, canceled]() {
+            onBatchFinished(batch, images, canceled);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void GlyphAtlas::onBatchFinished(const QVector<Job> &batch, const QVector<QImage> &images,
+                                 const CancelFlag &canceled) {
+    if (canceled->load()) return;
+    
+    const int perPage = m_perRow * m_perRow;
+    for (int i = 0; i < batch.size(); ++i) {
+        const int slot = batch[i].slot;
+        const QImage &glyph = images[i];
+        QImage &page = m_pageImages[slot / perPage];
+        const QRect rect = slotRect(slot);
+        
+        // Same format and size, so a row copy is enough
+        const std::size_t rowBytes = std::size_t(rect.width()) * 4;
+        for (int y = 0; y < rect.height(); ++y) {
+            std::memcpy(page.scanLine(rect.y() + y) + rect.x() * 4, glyph.constScanLine(y), rowBytes);
+        }
+        m_pageDirty[slot / perPage] = true;
+        m_slotReady[slot] = true;
+        ++m_readyCount;
+    }
+    emit glyphsReady();
+}
@@ -3,6 +3,9 @@
 #include "MapView.h"
 #include "DatabaseView.h"
 #include "FocalMechanismWidget.h"
+#include "RegionLookup.h"
+#include "TraceWidget.h"
+#include "ArrivalWidget.h"
 
 #include <QStatusBar>
 #include <QVBoxLayout>
@@ -15,8 +18,33 @@
 #include <QFile>
 #include <QTextStream>
 #include <QTimer>
+#include <QTimeZone>
 #include <QPropertyAnimation>
 #include <QParallelAnimationGroup>
+#include <cmath>
+
+namespace {
+QString bulletinText(const QString &tanggal, const QString &waktu, const QString &lokasi,
+                     const QString &magnitudo, const QString &kedalaman) {
+    return QString(
+        "INFORMASI TSUNAMI\n\n"
+        "Telah terjadi gempa bumi dengan parameter sebagai berikut:\n\n"
+        "Tanggal: %1\n"
+        "Waktu: %2\n"
+        "Lokasi: %3\n"
+        "Magnitudo: %4\n"
+        "Kedalaman: %5\n\n"
+        "PERINGATAN TSUNAMI:\n"
+        "Berdasarkan hasil analisis mekanisme sumber gempa dan potensi tsunami,\n"
+        "diperkirakan tsunami dapat terjadi di wilayah pesisir terdekat.\n\n"
+        "Masyarakat di wilayah pesisir diimbau untuk:\n"
+        "1. Segera menjauhi pantai\n"
+        "2. Menuju ke tempat yang lebih tinggi\n"
+        "3. Tetap waspada dan ikuti informasi resmi\n\n"
+        "Informasi ini akan diperbarui sesuai perkembangan situasi."
+    ).arg(tanggal, waktu, lokasi, magnitudo, kedalaman);
+}
+}
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     setupUI();
@@ -40,6 +68,12 @@ void MainWindow::setupUI() {
 void MainWindow::setupStatusBar() {
     auto *statusBar = new QStatusBar(this);
     statusBar->showMessage("Ready");
+    
+    // Koordinat kursor di atas peta
+    m_coordinateLabel = new QLabel(this);
+    m_coordinateLabel->setMinimumWidth(180);
+    statusBar->addPermanentWidget(m_coordinateLabel);
+    
     setStatusBar(statusBar);
 }
 
@@ -77,33 +111,40 @@ void MainWindow::setupCentralWidget() {
     // Tab lainnya
     QStringList subTabs = {"Traces", "Arrival", "Forecast Zones", "Bulletin", "Tambahan"};
     for (const QString &tabName : subTabs) {
-        if (tabName == "Bulletin") {
+        if (tabName == "Traces") {
+            // Arsip miniSEED yang sedang ditulis diikuti (TSUNAMI_WAVEFORM_FOLLOW),
+            // selain itu rekaman diputar ulang sebagai feed live
+            m_traceWidget = new TraceWidget();
+            const QString waveformDir = qEnvironmentVariable("TSUNAMI_WAVEFORM_DIR", "waveforms");
+            if (qEnvironmentVariableIsSet("TSUNAMI_WAVEFORM_FOLLOW")) {
+                m_traceWidget->followDirectory(waveformDir);
+            } else {
+                m_traceWidget->replayDirectory(waveformDir);
+            }
+            m_bottomLeftTabs->addTab(m_traceWidget, tabName);
+        } else if (tabName == "Arrival") {
+            // Stasiun dan titik pantai bawaan, kecuali diganti TSUNAMI_RECEIVERS;
+            // batimetri (ESRI ASCII grid) opsional lewat TSUNAMI_BATHYMETRY
+            m_arrivalWidget = new ArrivalWidget();
+            m_arrivalWidget->open(qEnvironmentVariable("TSUNAMI_RECEIVERS", ":/data/receivers.txt"),
+                                  qEnvironmentVariable("TSUNAMI_BATHYMETRY"));
+            connect(m_arrivalWidget, &ArrivalWidget::arrivalsChanged, m_mapView, &MapView::setArrivals);
+            connect(m_arrivalWidget, &ArrivalWidget::travelTimesChanged, m_mapView, &MapView::setTravelTimes);
+            m_bottomLeftTabs->addTab(m_arrivalWidget, tabName);
+        } else if (tabName == "Bulletin") {
             // Special handling untuk Bulletin tab
             auto *bulletinWidget = new QWidget();
             auto *bulletinLayout = new QVBoxLayout(bulletinWidget);
             
-            auto *bulletinText = new QLabel(
-                "INFORMASI TSUNAMI\n\n"
-                "Telah terjadi gempa bumi dengan parameter sebagai berikut:\n\n"
-                "Tanggal: [Akan diisi otomatis]\n"
-                "Waktu: [Akan diisi otomatis]\n"
-                "Lokasi: [Koordinat akan diisi]\n"
-                "Magnitudo: [Akan diisi otomatis]\n"
-                "Kedalaman: [Akan diisi otomatis]\n\n"
-                "PERINGATAN TSUNAMI:\n"
-                "Berdasarkan hasil analisis mekanisme sumber gempa dan potensi tsunami,\n"
-                "diperkirakan tsunami dapat terjadi di wilayah pesisir terdekat.\n\n"
-                "Masyarakat di wilayah pesisir diimbau untuk:\n"
-                "1. Segera menjauhi pantai\n"
-                "2. Menuju ke tempat yang lebih tinggi\n"
-                "3. Tetap waspada dan ikuti informasi resmi\n\n"
-                "Informasi ini akan diperbarui sesuai perkembangan situasi."
-            );
-            bulletinText->setWordWrap(true);
-            bulletinText->setAlignment(Qt::AlignLeft | Qt::AlignTop);
-            bulletinText->setStyleSheet("background-color: #37353E; color: white; padding: 10px;");
+            // Diisi otomatis saat event dipilih (updateBulletin)
+            m_bulletinText = new QLabel(bulletinText("[Akan diisi otomatis]", "[Akan diisi otomatis]",
+                                                     "[Koordinat akan diisi]", "[Akan diisi otomatis]",
+                                                     "[Akan diisi otomatis]"));
+            m_bulletinText->setWordWrap(true);
+            m_bulletinText->setAlignment(Qt::AlignLeft | Qt::AlignTop);
+            m_bulletinText->setStyleSheet("background-color: #37353E; color: white; padding: 10px;");
             
-            bulletinLayout->addWidget(bulletinText, 1);
+            bulletinLayout->addWidget(m_bulletinText, 1);
             
             // Tombol Diseminasi
             auto *btnDiseminasi = new QPushButton("Diseminasi");
@@ -160,6 +201,14 @@ void MainWindow::setupCentralWidget() {
     m_mainTabs->addTab(m_databaseView, "Seismic Event");
     
     connect(m_databaseView, &DatabaseView::eventSelected, this, &MainWindow::onEventSelected);
+    
+    // Peta hanya memuat episenter di dalam viewport (dan region yang digambar)
+    connect(m_databaseView, &DatabaseView::catalogLoaded, m_mapView, &MapView::setEvents);
+    connect(m_mapView, &MapView::viewportChanged, m_databaseView, &DatabaseView::setMapView);
+    connect(m_mapView, &MapView::regionChanged, m_databaseView, &DatabaseView::setMapRegion);
+    connect(m_mapView, &MapView::eventClicked, this, &MainWindow::onMapEventClicked);
+    connect(m_mapView, &MapView::cursorCoordinateChanged, this, &MainWindow::onMapCursorMoved);
+    connect(m_menuBar->actionShowMechanisms, &QAction::toggled, m_mapView, &MapView::setShowMechanisms);
 
     // ===== Tab Simulation =====
     m_mainTabs->addTab(new QLabel("Simulation"), "Simulation");
@@ -248,6 +297,12 @@ void MainWindow::onEventSelected(const QString &eventId, double lat, double lon,
     
     // Update focal mechanism widget
     m_focalMechWidget->setEventData(eventId, lat, lon, magnitude, strike, dip, slip, depth, originTime);
+    updateBulletin(originTime, lat, lon, magnitude, depth);
+    
+    // Waktu tiba dihitung dari origin time (UTC, sama seperti di bulletin)
+    QDateTime origin = QDateTime::fromString(originTime, "dd MMM yyyy HH:mm:ss");
+    origin.setTimeZone(QTimeZone::UTC);
+    m_arrivalWidget->setEvent(eventId, origin, lat, lon, depth);
     
     // Center map pada lokasi event
     m_mapView->centerOnCoordinate(lat, lon);
@@ -262,6 +317,17 @@ void MainWindow::onEventSelected(const QString &eventId, double lat, double lon,
     statusBar()->showMessage(QString("Event %1 selected (Mag %2)").arg(eventId).arg(magnitude, 0, 'f', 1));
 }
 
+void MainWindow::onMapEventClicked(const SeismicEvent &event) {
+    QString originTime = event.originTime.toString("dd MMM yyyy HH:mm:ss");
+    m_focalMechWidget->setEventData(event.eventId, event.latitude, event.longitude, event.magnitude,
+                                    event.strike, event.dip, event.slip, event.depth, originTime);
+    updateBulletin(originTime, event.latitude, event.longitude, event.magnitude, event.depth);
+    m_arrivalWidget->setEvent(event.eventId, event.originTime, event.latitude, event.longitude, event.depth);
+    m_mapView->centerOnCoordinate(event.latitude, event.longitude);
+    
+    statusBar()->showMessage(QString("Event %1 selected (Mag %2)").arg(event.eventId).arg(event.magnitude, 0, 'f', 1));
+}
+
 void MainWindow::onThemeChanged(const QString &themeName) {
     loadTheme(themeName);
 }
@@ -278,3 +344,36 @@ void MainWindow::loadTheme(const QString &themeName) {
         qApp->setStyleSheet("");
     }
 }
+
+void MainWindow::onMapCursorMoved(double lat, double lon) {
+    QString coordinate = QString("%1 %2  %3 %4")
+                         .arg(std::abs(lat), 0, 'f', 4).arg(lat < 0 ? "S" : "N")
+                         .arg(std::abs(lon), 0, 'f', 4).arg(lon < 0 ? "W" : "E");
+    
+    // Lookup cukup cepat untuk tiap gerakan mouse
+    QString region = RegionLookup::shared().region(lat, lon);
+    m_coordinateLabel->setText(region.isEmpty() ? coordinate : coordinate + "  " + region);
+}
+
+void MainWindow::updateBulletin(const QString &originTime, double lat, double lon, double magnitude, int depth) {
+    // originTime: "dd MMM yyyy HH:mm:ss"
+    QString tanggal = originTime.section(' ', 0, 2);
+    QString waktu = originTime.section(' ', 3, 3) + " UTC";
+    
+    const RegionLookup &regions = RegionLookup::shared();
+    QString lokasi = QString("%1 %2 - %3 %4")
+                     .arg(std::abs(lat), 0, 'f', 2).arg(lat < 0 ? "LS" : "LU")
+                     .arg(std::abs(lon), 0, 'f', 2).arg(lon < 0 ? "BB" : "BT");
+    QString region = regions.region(lat, lon);
+    if (!region.isEmpty()) {
+        lokasi += ", " + region;
+    }
+    RegionLookup::Nearest nearest = regions.nearestPlace(lat, lon);
+    if (nearest.isValid()) {
+        lokasi += QString(" (%1)").arg(RegionLookup::relativeTo(nearest));
+    }
+    
+    m_bulletinText->setText(bulletinText(tanggal, waktu, lokasi,
+                                         QString::number(magnitude, 'f', 1),
+                                         QString("%1 km").arg(depth)));
+}
@@ -1,103 +1,409 @@
 #include "MapView.h"
+#include "TileLoader.h"
+#include "EventLayer.h"
+#include "ArrivalLayer.h"
+#include "TravelTimeLayer.h"
+#include "GlyphAtlas.h"
 #include <QDir>
+#include <QGraphicsPathItem>
+#include <QKeyEvent>
+#include <QToolTip>
 #include <QPixmap>
 #include <QScrollBar>
+#include <QShowEvent>
+#include <QWindow>
 #include <QPainter>
 #include <QFont>
 #include <cmath>
 
-MapView::MapView(QWidget *parent) 
+namespace {
+// Durasi crossfade antar level dan saat tile asli menggantikan placeholder
+constexpr int kFadeDurationMs = 250;
+
+// Viewport queries wait until panning or zooming pauses
+constexpr int kViewportSettleMs = 200;
+
+// Ukuran beach ball di peta (pixel logis)
+constexpr int kMechanismGlyphSize = 24;
+}
+
+MapView::MapView(QWidget *parent)
     : QGraphicsView(parent)
     , m_currentZoom(0)
     , m_maxZoom(4)
     , m_scale(1.0)
+    , m_tilePixelWidth(0)
+    , m_tileMargin(256)
     , m_isPanning(false)
+    , m_hoverEvent(-1)
+    , m_regionClosed(false)
 {
     m_scene = new QGraphicsScene(this);
     setScene(m_scene);
     
+    m_eventLayer = new EventLayer(QRectF());
+    m_scene->addItem(m_eventLayer);
+    
+    m_arrivalLayer = new ArrivalLayer(QRectF());
+    m_scene->addItem(m_arrivalLayer);
+    
+    m_travelTimeLayer = new TravelTimeLayer(QRectF());
+    m_scene->addItem(m_travelTimeLayer);
+    
+    m_glyphAtlas = new GlyphAtlas(kMechanismGlyphSize, FocalMechanism::MapTheme, this);
+    m_eventLayer->setGlyphAtlas(m_glyphAtlas);
+    connect(m_glyphAtlas, &GlyphAtlas::glyphsReady, this, [this]() {
+        m_eventLayer->update();
+    });
+    
+    m_regionItem = new QGraphicsPathItem();
+    QPen regionPen(QColor(255, 200, 0));
+    regionPen.setCosmetic(true);
+    regionPen.setWidth(2);
+    m_regionItem->setPen(regionPen);
+    m_regionItem->setBrush(QColor(255, 200, 0, 40));
+    m_regionItem->setZValue(1);
+    m_scene->addItem(m_regionItem);
+    
+    m_viewportTimer.setSingleShot(true);
+    m_viewportTimer.setInterval(kViewportSettleMs);
+    connect(&m_viewportTimer, &QTimer::timeout, this, [this]() {
+        emit viewportChanged(visibleBox());
+    });
+    
+    m_tileLoader = new TileLoader(this);
+    connect(m_tileLoader, &TileLoader::tileDecoded, this, &MapView::onTileDecoded);
+    connect(m_tileLoader, &TileLoader::tileFailed, this, &MapView::onTileFailed);
+    
+    m_fadeTimer.setInterval(16);
+    connect(&m_fadeTimer, &QTimer::timeout, this, &MapView::onFadeTick);
+    m_fadeClock.start();
+    
     setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
     setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
     setDragMode(QGraphicsView::NoDrag);
     setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
     setResizeAnchor(QGraphicsView::AnchorUnderMouse);
+    // Hover tooltip dan readout koordinat butuh move event tanpa tombol ditekan
+    setMouseTracking(true);
     
     setMapDirectory("maps");
 }
 
+MapView::~MapView() {
+    // Workers may still be reading from the archive mapping
+    m_tileLoader->setArchive(nullptr);
+}
+
 void MapView::setMapDirectory(const QString &dirPath) {
     m_mapDirectory = dirPath;
+    
+    m_tileLoader->setArchive(nullptr);
+    m_archive.close();
+    if (m_archive.open(m_mapDirectory + "/world.tiles")) {
+        m_tileLoader->setArchive(&m_archive);
+        m_maxZoom = qBound(0, m_archive.maxZoom(), TileArchive::kMaxZoom);
+    }
+    
+    // Base map dipakai sebagai world extent dan fallback untuk tile yang hilang
+    QString basePath = m_mapDirectory + "/world.png";
+    m_basePixmap = QPixmap();
+    if (m_archive.isOpen()) {
+        m_basePixmap.loadFromData(m_archive.tileData(TileCache::key(0, 0, 0)));
+    }
+    if (m_basePixmap.isNull()) {
+        m_basePixmap = QPixmap(basePath);
+    }
+    
+    if (m_basePixmap.isNull()) {
+        // Create placeholder
+        m_basePixmap = QPixmap(512, 256);
+        m_basePixmap.fill(Qt::darkGray);
+        
+        QPainter painter(&m_basePixmap);
+        painter.setPen(Qt::white);
+        painter.setFont(QFont("Arial", 14));
+        painter.drawText(m_basePixmap.rect(), Qt::AlignCenter,
+                        QString("Map tiles not found\nPlace world.png in '%1' directory").arg(m_mapDirectory));
+    }
+    
+    m_worldRect = QRectF(QPointF(0, 0), m_basePixmap.size());
+    m_scene->setSceneRect(m_worldRect);
+    m_projection.setWorldRect(m_worldRect.left(), m_worldRect.top(),
+                              m_worldRect.width(), m_worldRect.height());
+    m_eventLayer->setWorldRect(m_worldRect);
+    m_arrivalLayer->setWorldRect(m_worldRect);
+    m_travelTimeLayer->setWorldRect(m_worldRect);
+    updateRegionItem();
+    
+    // Assume pyramid tiles share the base map resolution until one is decoded
+    m_tilePixelWidth = m_basePixmap.width();
+    
+    // Tile dari direktori lama tidak berlaku lagi
+    m_pixmapCache.clear();
+    m_missingTiles.clear();
+    
     loadTiles();
 }
 
 void MapView::setZoomLevel(int level) {
     if (level < 0 || level > m_maxZoom) return;
     
-    m_currentZoom = level;
-    loadTiles();
+    // Jump to the scale at which this level is drawn at native resolution
+    const double factor = nativeScaleForLevel(level) / m_scale;
+    scale(factor, factor);
+    m_scale *= factor;
+    
+    updateZoomLevelFromScale();
+    updateVisibleTiles();
+}
+
+void MapView::setMaxZoomLevel(int level) {
+    m_maxZoom = qBound(0, level, TileArchive::kMaxZoom);
+    updateZoomLevelFromScale();
+    updateVisibleTiles();
+}
+
+int MapView::zoomLevel() const {
+    return m_currentZoom;
+}
+
+void MapView::setTileMargin(int pixels) {
+    m_tileMargin = qMax(0, pixels);
+    updateVisibleTiles();
+}
+
+void MapView::setTileCacheBudget(qint64 bytes) {
+    m_pixmapCache.setBudget(bytes);
+}
+
+TileCache::Stats MapView::tileCacheStats() const {
+    return m_pixmapCache.stats();
 }
 
 void MapView::loadTiles() {
-    m_scene->clear();
-    m_tileCache.clear();
+    m_tileLoader->cancelAll();
     
-    // Load tiles based on current zoom level
-    QString basePath = m_mapDirectory + "/world.png";
-    QPixmap basePixmap(basePath);
+    // Only tile items are removed; markers and other layers stay in the scene
+    clearBackdrop();
+    for (QGraphicsPixmapItem *item : std::as_const(m_tileItems)) {
+        removeTileItem(item);
+    }
+    m_tileItems.clear();
     
-    if (basePixmap.isNull()) {
-        // Create placeholder
-        basePixmap = QPixmap(512, 256);
-        basePixmap.fill(Qt::darkGray);
+    // Fit in view on first load
+    resetTransform();
+    fitInView(m_worldRect, Qt::KeepAspectRatio);
+    m_scale = transform().m11();
+    m_currentZoom = levelForScale(m_scale);
+    
+    updateVisibleTiles();
+}
+
+double MapView::nativeScaleForLevel(int level) const {
+    // View pixels per scene unit at which a level-N tile is shown 1:1
+    return m_tilePixelWidth * double(1 << level) / m_worldRect.width();
+}
+
+int MapView::levelForScale(double scale) const {
+    if (m_worldRect.isEmpty() || m_tilePixelWidth <= 0) return 0;
+    
+    // Smallest level whose native resolution covers the screen; the small bias
+    // keeps slightly upscaled tiles instead of switching too eagerly
+    double level = std::log2(scale * m_worldRect.width() / m_tilePixelWidth);
+    return qBound(0, int(std::ceil(level - 0.25)), m_maxZoom);
+}
+
+void MapView::updateZoomLevelFromScale() {
+    int level = levelForScale(m_scale);
+    if (level != m_currentZoom) {
+        switchZoomLevel(level);
+    }
+}
+
+void MapView::switchZoomLevel(int level) {
+    // The current level becomes the backdrop the new level fades in over; it is
+    // dropped once the fade completes, so the scene is never rebuilt from scratch
+    clearBackdrop();
+    for (auto it = m_tileItems.cbegin(); it != m_tileItems.cend(); ++it) {
+        m_tileLoader->cancel(it.key());
+        QGraphicsPixmapItem *item = it.value();
+        for (int i = m_fades.size() - 1; i >= 0; --i) {
+            const TileFade fade = m_fades[i];
+            if (fade.item == item) {
+                m_fades.removeAt(i);
+            } else if (fade.target == item) {
+                m_fades.removeAt(i);
+                m_scene->removeItem(fade.item);
+                delete fade.item;
+            }
+        }
+        item->setOpacity(1.0);
+        item->setZValue(-2);
+        m_backdropItems.append(item);
+    }
+    m_tileItems.clear();
+    
+    m_currentZoom = level;
+    
+    // The fade timer drops the backdrop even if no new tile ends up visible
+    if (!m_fadeTimer.isActive()) {
+        m_fadeTimer.start();
+    }
+}
+
+QRectF MapView::tileRect(int zoom, int x, int y) const {
+    const int tilesPerSide = 1 << zoom;
+    const double tileWidth = m_worldRect.width() / tilesPerSide;
+    const double tileHeight = m_worldRect.height() / tilesPerSide;
+    return QRectF(x * tileWidth, y * tileHeight, tileWidth, tileHeight);
+}
+
+QPixmap MapView::placeholderPixmap(int zoom, int x, int y) {
+    // Nearest cached ancestor, cropped to this tile's quadrant
+    for (int level = zoom - 1; level > 0; level--) {
+        const int shift = zoom - level;
+        const quint64 parentKey = TileCache::key(level, x >> shift, y >> shift);
+        if (!m_pixmapCache.contains(parentKey)) continue;
         
-        QPainter painter(&basePixmap);
-        painter.setPen(Qt::white);
-        painter.setFont(QFont("Arial", 14));
-        painter.drawText(basePixmap.rect(), Qt::AlignCenter, 
-                        QString("Map tiles not found\nPlace world.png in '%1' directory").arg(m_mapDirectory));
+        QPixmap parent = m_pixmapCache.find(parentKey);
+        const int sub = 1 << shift;
+        const int srcW = qMax(1, parent.width() / sub);
+        const int srcH = qMax(1, parent.height() / sub);
+        return parent.copy((x & (sub - 1)) * srcW, (y & (sub - 1)) * srcH, srcW, srcH);
     }
     
-    if (m_currentZoom == 0) {
-        // Zoom level 0: single tile
-        QGraphicsPixmapItem *item = m_scene->addPixmap(basePixmap);
-        item->setPos(0, 0);
-        m_tileCache["world"] = item;
-    } else {
-        // Higher zoom levels: load quadtree tiles
-        int tilesPerSide = std::pow(2, m_currentZoom);
-        int baseTileWidth = basePixmap.width();
-        int baseTileHeight = basePixmap.height();
+    // Use scaled portion of base map as fallback
+    int tilesPerSide = 1 << zoom;
+    int srcX = x * m_basePixmap.width() / tilesPerSide;
+    int srcY = y * m_basePixmap.height() / tilesPerSide;
+    int srcW = qMax(1, m_basePixmap.width() / tilesPerSide);
+    int srcH = qMax(1, m_basePixmap.height() / tilesPerSide);
+    
+    return m_basePixmap.copy(srcX, srcY, srcW, srcH);
+}
+
+QGraphicsPixmapItem *MapView::createTileItem(quint64 key, const QPixmap &cached) {
+    const int zoom = TileCache::zoomOf(key);
+    const int x = TileCache::xOf(key);
+    const int y = TileCache::yOf(key);
+    QPixmap tilePixmap = cached;
+    
+    if (zoom == 0) {
+        tilePixmap = m_basePixmap;
+    } else if (tilePixmap.isNull()) {
+        // Lower-resolution placeholder until the worker pool has decoded the
+        // real tile (or kept if the tile file is missing)
+        tilePixmap = placeholderPixmap(zoom, x, y);
+    }
+    
+    // Tile diletakkan di world coordinates, resolusi asli dipertahankan lewat item scale
+    QRectF rect = tileRect(zoom, x, y);
+    QGraphicsPixmapItem *item = m_scene->addPixmap(tilePixmap);
+    item->setPos(rect.topLeft());
+    item->setScale(rect.width() / tilePixmap.width());
+    item->setTransformationMode(Qt::SmoothTransformation);
+    item->setZValue(-1);
+    
+    if (!m_backdropItems.isEmpty()) {
+        startFade(item);
+    }
+    return item;
+}
+
+void MapView::removeTileItem(QGraphicsPixmapItem *item) {
+    for (int i = m_fades.size() - 1; i >= 0; --i) {
+        const TileFade fade = m_fades[i];
+        if (fade.item == item) {
+            m_fades.removeAt(i);
+        } else if (fade.target == item) {
+            m_fades.removeAt(i);
+            m_scene->removeItem(fade.item);
+            delete fade.item;
+        }
+    }
+    
+    m_scene->removeItem(item);
+    delete item;
+}
+
+void MapView::clearBackdrop() {
+    for (QGraphicsPixmapItem *item : std::as_const(m_backdropItems)) {
+        removeTileItem(item);
+    }
+    m_backdropItems.clear();
+}
+
+void MapView::startFade(QGraphicsPixmapItem *item, QGraphicsPixmapItem *target) {
+    item->setOpacity(0.0);
+    m_fades.append({item, m_fadeClock.elapsed(), target});
+    if (!m_fadeTimer.isActive()) {
+        m_fadeTimer.start();
+    }
+}
+
+void MapView::onFadeTick() {
+    const qint64 now = m_fadeClock.elapsed();
+    
+    for (int i = m_fades.size() - 1; i >= 0; --i) {
+        const TileFade fade = m_fades[i];
+        const double t = double(now - fade.startMs) / kFadeDurationMs;
+        if (t < 1.0) {
+            fade.item->setOpacity(t);
+            continue;
+        }
         
-        for (int y = 0; y < tilesPerSide; y++) {
-            for (int x = 0; x < tilesPerSide; x++) {
-                QString tilePath = getTilePath(m_currentZoom, x, y);
-                QPixmap tilePixmap(tilePath);
-                
-                if (tilePixmap.isNull()) {
-                    // Use scaled portion of base map as fallback
-                    int srcX = x * baseTileWidth / tilesPerSide;
-                    int srcY = y * baseTileHeight / tilesPerSide;
-                    int srcW = baseTileWidth / tilesPerSide;
-                    int srcH = baseTileHeight / tilesPerSide;
-                    
-                    tilePixmap = basePixmap.copy(srcX, srcY, srcW, srcH);
-                }
-                
-                QGraphicsPixmapItem *item = m_scene->addPixmap(tilePixmap);
-                item->setPos(x * tilePixmap.width(), y * tilePixmap.height());
-                
-                QString key = QString("%1_%2_%3").arg(m_currentZoom).arg(x).arg(y);
-                m_tileCache[key] = item;
-            }
+        m_fades.removeAt(i);
+        if (fade.target) {
+            fade.target->setPixmap(fade.item->pixmap());
+            fade.target->setScale(fade.item->scale());
+            m_scene->removeItem(fade.item);
+            delete fade.item;
+        } else {
+            fade.item->setOpacity(1.0);
         }
     }
     
-    m_scene->setSceneRect(m_scene->itemsBoundingRect());
+    if (m_fades.isEmpty()) {
+        m_fadeTimer.stop();
+        clearBackdrop();
+    }
+}
+
+int MapView::tilePriority(int zoom, int x, int y, const QPointF &viewCenter) const {
+    // Tiles nearest the viewport center are decoded first
+    QPointF delta = tileRect(zoom, x, y).center() - viewCenter;
+    double distance = std::hypot(delta.x(), delta.y()) / tileRect(zoom, 0, 0).width();
+    return -int(distance * 1000.0);
+}
+
+void MapView::onTileDecoded(quint64 key, const QImage &image) {
+    QPixmap tilePixmap = QPixmap::fromImage(image);
+    m_pixmapCache.insert(key, tilePixmap);
+    m_tilePixelWidth = tilePixmap.width();
     
-    // Fit in view on first load
-    if (m_currentZoom == 0) {
-        fitInView(m_scene->sceneRect(), Qt::KeepAspectRatio);
+    QGraphicsPixmapItem *item = m_tileItems.value(key);
+    if (!item) return;
+    
+    QRectF rect = tileRect(TileCache::zoomOf(key), TileCache::xOf(key), TileCache::yOf(key));
+    if (item->opacity() < 1.0) {
+        // Still fading in over the previous level, just swap the pixmap
+        item->setPixmap(tilePixmap);
+        item->setScale(rect.width() / tilePixmap.width());
+        return;
     }
+    
+    // Fade the sharp tile in over its placeholder
+    QGraphicsPixmapItem *overlay = m_scene->addPixmap(tilePixmap);
+    overlay->setPos(rect.topLeft());
+    overlay->setScale(rect.width() / tilePixmap.width());
+    overlay->setTransformationMode(Qt::SmoothTransformation);
+    overlay->setZValue(-0.5);
+    startFade(overlay, item);
+}
+
+void MapView::onTileFailed(quint64 key) {
+    m_missingTiles.insert(key);
 }
 
 QString MapView::getTilePath(int zoom, int x, int y) {
@@ -118,49 +424,111 @@ QString MapView::getTilePath(int zoom, int x, int y) {
 }
 
 void MapView::centerOnCoordinate(double lat, double lon) {
-    // Web Mercator projection
-    double x = (lon + 180.0) / 360.0;
-    double latRad = lat * M_PI / 180.0;
-    double mercN = std::log(std::tan((M_PI / 4.0) + (latRad / 2.0)));
-    double y = (1.0 - mercN / M_PI) / 2.0;
-    
-    // Convert to scene coordinates
-    QRectF sceneRect = m_scene->sceneRect();
-    double sceneX = x * sceneRect.width();
-    double sceneY = y * sceneRect.height();
-    
-    // Add marker at location
-    QGraphicsEllipseItem *marker = m_scene->addEllipse(
-        sceneX - 5, sceneY - 5, 10, 10,
-        QPen(Qt::red, 2),
-        QBrush(Qt::red)
-    );
-    marker->setZValue(1000); // Always on top
+    double sceneX, sceneY;
+    m_projection.toScene(lat, lon, sceneX, sceneY);
+    
+    // Satu highlight saja, marker lama tidak menumpuk
+    m_eventLayer->setHighlight(QPointF(sceneX, sceneY));
     
     centerOn(sceneX, sceneY);
 }
 
+void MapView::setEvents(const QVector<SeismicEvent> &events) {
+    m_hoverEvent = -1;
+    m_eventLayer->setEvents(events);
+}
+
+void MapView::setShowMechanisms(bool show) {
+    m_hoverEvent = -1;
+    m_eventLayer->setShowMechanisms(show);
+}
+
+void MapView::setArrivals(const Arrivals &arrivals) {
+    m_arrivalLayer->setArrivals(arrivals);
+}
+
+void MapView::clearArrivals() {
+    m_arrivalLayer->clear();
+    m_travelTimeLayer->clear();
+}
+
+void MapView::setTravelTimes(const TravelTimeMap &map) {
+    m_travelTimeLayer->setTravelTimes(map);
+}
+
+CatalogFilter::GeoBox MapView::visibleBox() const {
+    CatalogFilter::GeoBox box;
+    QRectF visible = mapToScene(viewport()->rect()).boundingRect().intersected(m_worldRect);
+    if (visible.isEmpty()) visible = m_worldRect;
+    
+    // Scene y grows southwards
+    m_projection.toGeo(visible.left(), visible.top(), box.north, box.west);
+    m_projection.toGeo(visible.right(), visible.bottom(), box.south, box.east);
+    return box;
+}
+
+void MapView::clearRegion() {
+    bool hadRegion = m_regionClosed;
+    m_regionPoints.clear();
+    m_regionClosed = false;
+    updateRegionItem();
+    if (hadRegion) {
+        emit regionChanged(QVector<QPointF>());
+    }
+}
+
+void MapView::updateRegionItem() {
+    QPainterPath path;
+    for (int i = 0; i < m_regionPoints.size(); ++i) {
+        double x, y;
+        m_projection.toScene(m_regionPoints[i].y(), m_regionPoints[i].x(), x, y);
+        if (i == 0) {
+            path.moveTo(x, y);
+        } else {
+            path.lineTo(x, y);
+        }
+    }
+    if (m_regionClosed) path.closeSubpath();
+    m_regionItem->setPath(path);
+}
+
 void MapView::wheelEvent(QWheelEvent *event) {
-    // Simple smooth zoom tanpa dynamic tile loading
+    // Continuous zoom; the tile pyramid level follows the accumulated scale
     const double scaleFactor = 1.15;
+    const double minScale = qMin(nativeScaleForLevel(0), viewport()->width() / m_worldRect.width()) * 0.5;
+    const double maxScale = nativeScaleForLevel(m_maxZoom) * 4.0;
     
-    if (event->angleDelta().y() > 0) {
-        // Zoom in
-        scale(scaleFactor, scaleFactor);
-        m_scale *= scaleFactor;
-    } else {
-        // Zoom out
-        scale(1.0 / scaleFactor, 1.0 / scaleFactor);
-        m_scale /= scaleFactor;
+    double factor = event->angleDelta().y() > 0 ? scaleFactor : 1.0 / scaleFactor;
+    factor = qBound(minScale, m_scale * factor, maxScale) / m_scale;
+    
+    if (!qFuzzyCompare(factor, 1.0)) {
+        scale(factor, factor);
+        m_scale *= factor;
+        updateZoomLevelFromScale();
     }
     
+    updateVisibleTiles();
     event->accept();
 }
 
 void MapView::mousePressEvent(QMouseEvent *event) {
+    if (event->button() == Qt::LeftButton && (event->modifiers() & Qt::ControlModifier)) {
+        // Region vertex; a closed region is replaced by a new one
+        if (m_regionClosed) clearRegion();
+        QPointF scenePos = mapToScene(event->pos());
+        if (m_worldRect.contains(scenePos)) {
+            double lat, lon;
+            m_projection.toGeo(scenePos.x(), scenePos.y(), lat, lon);
+            m_regionPoints.append(QPointF(lon, lat));
+            updateRegionItem();
+        }
+        event->accept();
+        return;
+    }
     if (event->button() == Qt::LeftButton) {
         m_isPanning = true;
         m_lastPanPoint = event->pos();
+        m_pressPos = event->pos();
         setCursor(Qt::ClosedHandCursor);
     }
     QGraphicsView::mousePressEvent(event);
@@ -173,18 +541,160 @@ void MapView::mouseMoveEvent(QMouseEvent *event) {
         
         horizontalScrollBar()->setValue(horizontalScrollBar()->value() - delta.x());
         verticalScrollBar()->setValue(verticalScrollBar()->value() - delta.y());
+    } else {
+        // Cursor readout via the inverse projection
+        QPointF scenePos = mapToScene(event->pos());
+        if (m_worldRect.contains(scenePos)) {
+            double lat, lon;
+            m_projection.toGeo(scenePos.x(), scenePos.y(), lat, lon);
+            emit cursorCoordinateChanged(lat, lon);
+        }
+        
+        // Hover readout for the marker under the cursor
+        int hit = m_eventLayer->hitTest(scenePos, m_scale);
+        if (hit != m_hoverEvent) {
+            m_hoverEvent = hit;
+            if (hit >= 0) {
+                const SeismicEvent &ev = m_eventLayer->events().at(hit);
+                QToolTip::showText(event->globalPosition().toPoint(),
+                                   QString("%1\nM %2 | D %3 km\n%4")
+                                   .arg(ev.eventId)
+                                   .arg(ev.magnitude, 0, 'f', 1)
+                                   .arg(ev.depth)
+                                   .arg(ev.originTime.toString("dd MMM yyyy HH:mm:ss")),
+                                   this);
+            } else {
+                QToolTip::hideText();
+            }
+        }
     }
     QGraphicsView::mouseMoveEvent(event);
 }
 
 void MapView::mouseReleaseEvent(QMouseEvent *event) {
-    if (event->button() == Qt::LeftButton) {
+    if (event->button() == Qt::LeftButton && m_isPanning) {
         m_isPanning = false;
         setCursor(Qt::ArrowCursor);
+        
+        // A click without dragging selects the marker under the cursor
+        if ((event->pos() - m_pressPos).manhattanLength() < 4) {
+            int hit = m_eventLayer->hitTest(mapToScene(event->pos()), m_scale);
+            if (hit >= 0) {
+                emit eventClicked(m_eventLayer->events().at(hit));
+            }
+        }
     }
     QGraphicsView::mouseReleaseEvent(event);
 }
 
+void MapView::mouseDoubleClickEvent(QMouseEvent *event) {
+    if (m_regionClosed || m_regionPoints.isEmpty()) {
+        QGraphicsView::mouseDoubleClickEvent(event);
+        return;
+    }
+    
+    // Closes the region drawn with Ctrl+click; fewer than three points is no region
+    if (m_regionPoints.size() < 3) {
+        clearRegion();
+    } else {
+        m_regionClosed = true;
+        updateRegionItem();
+        emit regionChanged(m_regionPoints);
+    }
+    event->accept();
+}
+
+void MapView::keyPressEvent(QKeyEvent *event) {
+    if (event->key() == Qt::Key_Escape && !m_regionPoints.isEmpty()) {
+        clearRegion();
+        event->accept();
+        return;
+    }
+    QGraphicsView::keyPressEvent(event);
+}
+
+void MapView::resizeEvent(QResizeEvent *event) {
+    QGraphicsView::resizeEvent(event);
+    updateVisibleTiles();
+}
+
+void MapView::showEvent(QShowEvent *event) {
+    QGraphicsView::showEvent(event);
+    
+    // The window handle exists once shown; beach balls are rendered for the
+    // screen it is on, and again when it moves to another one
+    if (QWindow *handle = window()->windowHandle()) {
+        disconnect(m_screenConnection);
+        m_screenConnection = connect(handle, &QWindow::screenChanged, this, &MapView::updateDevicePixelRatio);
+    }
+    updateDevicePixelRatio();
+}
+
+void MapView::updateDevicePixelRatio() {
+    m_eventLayer->setDevicePixelRatio(viewport()->devicePixelRatioF());
+}
+
+void MapView::scrollContentsBy(int dx, int dy) {
+    QGraphicsView::scrollContentsBy(dx, dy);
+    updateVisibleTiles();
+}
+
 void MapView::updateVisibleTiles() {
-    // TODO: Implement tile culling for performance
+    if (m_worldRect.isEmpty()) return;
+    m_viewportTimer.start();
+    
+    // Area yang terlihat ditambah margin (dalam pixel viewport)
+    QRect viewRect = viewport()->rect().adjusted(-m_tileMargin, -m_tileMargin,
+                                                 m_tileMargin, m_tileMargin);
+    QRectF visible = mapToScene(viewRect).boundingRect().intersected(m_worldRect);
+    if (visible.isEmpty()) return;
+    
+    const int tilesPerSide = 1 << m_currentZoom;
+    const double tileWidth = m_worldRect.width() / tilesPerSide;
+    const double tileHeight = m_worldRect.height() / tilesPerSide;
+    
+    const int x0 = qBound(0, int(std::floor(visible.left() / tileWidth)), tilesPerSide - 1);
+    const int x1 = qBound(0, int(std::ceil(visible.right() / tileWidth)) - 1, tilesPerSide - 1);
+    const int y0 = qBound(0, int(std::floor(visible.top() / tileHeight)), tilesPerSide - 1);
+    const int y1 = qBound(0, int(std::ceil(visible.bottom() / tileHeight)) - 1, tilesPerSide - 1);
+    
+    // Evict tiles that left the visible range (their pixmaps stay in m_pixmapCache)
+    for (auto it = m_tileItems.begin(); it != m_tileItems.end(); ) {
+        const quint64 key = it.key();
+        const int zoom = TileCache::zoomOf(key);
+        const int x = TileCache::xOf(key);
+        const int y = TileCache::yOf(key);
+        
+        if (zoom != m_currentZoom || x < x0 || x > x1 || y < y0 || y > y1) {
+            m_tileLoader->cancel(key);
+            removeTileItem(it.value());
+            it = m_tileItems.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    
+    // Materialize newly exposed tiles from the cache, or queue their decode
+    // with a priority based on the current viewport center
+    const QPointF viewCenter = mapToScene(viewport()->rect().center());
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            const quint64 key = TileCache::key(m_currentZoom, x, y);
+            bool needsDecode = m_tileLoader->isPending(key);
+            
+            if (!m_tileItems.contains(key)) {
+                QPixmap cached;
+                if (m_currentZoom > 0 && !m_missingTiles.contains(key)) {
+                    cached = m_pixmapCache.find(key);
+                    needsDecode = cached.isNull();
+                }
+                m_tileItems.insert(key, createTileItem(key, cached));
+            }
+            
+            if (needsDecode) {
+                m_tileLoader->request(key, getTilePath(m_currentZoom, x, y),
+                                      tilePriority(m_currentZoom, x, y, viewCenter));
+            }
+        }
+    }
 }
@@ -23,6 +23,10 @@ void MenuBar::setupMenu() {
     actionToggleFullscreen = viewMenu->addAction("Toggle Fullscreen");
     actionToggleFullscreen->setCheckable(true);
 
+    actionShowMechanisms = viewMenu->addAction("Focal Mechanisms on Map");
+    actionShowMechanisms->setCheckable(true);
+    actionShowMechanisms->setChecked(true);
+
     auto *themeMenu = viewMenu->addMenu("Theme");
     themeGroup = new QActionGroup(this);
     themeGroup->setExclusive(true);
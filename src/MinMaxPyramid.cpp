@@ -0,0 +1,288 @@
+#include "MinMaxPyramid.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MINMAXPYRAMID_SSE2 1
+#endif
+
+namespace {
+constexpr float kEmptyMin = std::numeric_limits<float>::max();
+constexpr float kEmptyMax = -std::numeric_limits<float>::max();
+// Level teratas masih punya paling tidak sekian bucket dalam history
+constexpr quint64 kMinTopBuckets = 64;
+
+#ifdef MINMAXPYRAMID_SSE2
+float horizontalMin(__m128 v) {
+    v = _mm_min_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_min_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+float horizontalMax(__m128 v) {
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+#endif
+
+// Envelope of one full level-0 bucket
+void reduceBucket(const float *samples, float *low, float *high) {
+#ifdef MINMAXPYRAMID_SSE2
+    static_assert(MinMaxPyramid::kBaseBucket == 16, "SSE2 path folds 4x4 lanes");
+    const __m128 a = _mm_loadu_ps(samples);
+    const __m128 b = _mm_loadu_ps(samples + 4);
+    const __m128 c = _mm_loadu_ps(samples + 8);
+    const __m128 d = _mm_loadu_ps(samples + 12);
+    *low = horizontalMin(_mm_min_ps(_mm_min_ps(a, b), _mm_min_ps(c, d)));
+    *high = horizontalMax(_mm_max_ps(_mm_max_ps(a, b), _mm_max_ps(c, d)));
+#else
+    float lo = samples[0];
+    float hi = samples[0];
+    for (int i = 1; i < MinMaxPyramid::kBaseBucket; ++i) {
+        lo = std::min(lo, samples[i]);
+        hi = std::max(hi, samples[i]);
+    }
+    *low = lo;
+    *high = hi;
+#endif
+}
+
+// Envelope of kFanout sibling buckets
+void reduceChildren(const float *mins, const float *maxs, float *low, float *high) {
+#ifdef MINMAXPYRAMID_SSE2
+    static_assert(MinMaxPyramid::kFanout == 4, "SSE2 path folds one vector");
+    *low = horizontalMin(_mm_loadu_ps(mins));
+    *high = horizontalMax(_mm_loadu_ps(maxs));
+#else
+    float lo = mins[0];
+    float hi = maxs[0];
+    for (int i = 1; i < MinMaxPyramid::kFanout; ++i) {
+        lo = std::min(lo, mins[i]);
+        hi = std::max(hi, maxs[i]);
+    }
+    *low = lo;
+    *high = hi;
+#endif
+}
+}
+
+MinMaxPyramid::MinMaxPyramid(quint64 historySamples)
+    : m_history(qMax<quint64>(historySamples, kBaseBucket))
+    , m_samples(0)
+    , m_partialMin(kEmptyMin)
+    , m_partialMax(kEmptyMax)
+{
+    quint64 bucket = kBaseBucket;
+    for (;;) {
+        // One spare parent's worth of children for the bucket still filling
+        const quint64 buckets = (m_history + bucket - 1) / bucket;
+        const quint64 capacity = (buckets + kFanout - 1) / kFanout * kFanout + kFanout;
+        Level level;
+        level.capacity = int(capacity);
+        m_levels.append(level);
+        if (buckets < kMinTopBuckets * kFanout) break;
+        bucket *= kFanout;
+    }
+}
+
+void MinMaxPyramid::Level::growTo(int slot) {
+    if (slot < min.size()) return;
+    // Doubling, but never past capacity
+    if (slot >= min.capacity()) {
+        const int reserved = std::min(capacity, std::max(slot + 1, 2 * int(min.capacity())));
+        min.reserve(reserved);
+        max.reserve(reserved);
+    }
+    const int size = min.size();
+    min.resize(slot + 1);
+    max.resize(slot + 1);
+    std::fill(min.begin() + size, min.end(), kEmptyMin);
+    std::fill(max.begin() + size, max.end(), kEmptyMax);
+}
+
+void MinMaxPyramid::clear() {
+    for (Level &level : m_levels) {
+        level.min.clear();
+        level.max.clear();
+        level.count = 0;
+    }
+    m_samples = 0;
+    m_partialMin = kEmptyMin;
+    m_partialMax = kEmptyMax;
+}
+
+quint64 MinMaxPyramid::sampleCount() const {
+    return m_samples;
+}
+
+quint64 MinMaxPyramid::firstSample() const {
+    const Level &base = m_levels.first();
+    const quint64 capacity = quint64(base.capacity);
+    return base.count > capacity ? (base.count - capacity) * kBaseBucket : 0;
+}
+
+int MinMaxPyramid::levelCount() const {
+    return m_levels.size();
+}
+
+quint64 MinMaxPyramid::bucketSamples(int level) const {
+    quint64 samples = kBaseBucket;
+    for (int i = 0; i < level; ++i) samples *= kFanout;
+    return samples;
+}
+
+int MinMaxPyramid::levelFor(double samplesPerColumn) const {
+    int level = 0;
+    while (level + 1 < m_levels.size() && double(bucketSamples(level + 1)) <= samplesPerColumn) ++level;
+    return level;
+}
+
+void MinMaxPyramid::pushBucket(int level, float low, float high) {
+    Level &current = m_levels[level];
+    const int slot = int(current.count % quint64(current.capacity));
+    current.growTo(slot);
+    current.min[slot] = low;
+    current.max[slot] = high;
+    ++current.count;
+    
+    if (current.count % kFanout == 0 && level + 1 < m_levels.size()) {
+        // slot is the last of kFanout contiguous siblings
+        const int firstChild = slot - (kFanout - 1);
+        float parentMin, parentMax;
+        reduceChildren(current.min.constData() + firstChild, current.max.constData() + firstChild,
+                       &parentMin, &parentMax);
+        pushBucket(level + 1, parentMin, parentMax);
+    }
+}
+
+void MinMaxPyramid::skipTo(quint64 sample) {
+    // The partial bucket keeps what it has
+    if (m_samples % kBaseBucket) {
+        const quint64 bucketEnd = (m_samples / kBaseBucket + 1) * kBaseBucket;
+        if (sample < bucketEnd) {
+            m_samples = sample;
+            return;
+        }
+        pushBucket(0, m_partialMin, m_partialMax);
+        m_partialMin = kEmptyMin;
+        m_partialMax = kEmptyMax;
+        m_samples = bucketEnd;
+    }
+    
+    const quint64 target = sample / kBaseBucket;
+    const quint64 current = m_samples / kBaseBucket;
+    if (target - current >= quint64(m_levels.first().capacity)) {
+        // Gap longer than the history: nothing survives it
+        quint64 count = target;
+        for (Level &level : m_levels) {
+            level.min.clear();
+            level.max.clear();
+            level.count = count;
+            count /= kFanout;
+        }
+    } else {
+        for (quint64 i = current; i < target; ++i) pushBucket(0, kEmptyMin, kEmptyMax);
+    }
+    m_samples = sample;
+}
+
+void MinMaxPyramid::append(quint64 first, const float *samples, int count) {
+    if (count <= 0 || first + quint64(count) <= m_samples) return;
+    if (first < m_samples) {
+        const int seen = int(m_samples - first);
+        samples += seen;
+        count -= seen;
+    } else if (first > m_samples) {
+        skipTo(first);
+    }
+    
+    int i = 0;
+    // Finish the partial bucket
+    const int filled = int(m_samples % kBaseBucket);
+    if (filled) {
+        const int n = std::min(count, kBaseBucket - filled);
+        for (; i < n; ++i) {
+            m_partialMin = std::min(m_partialMin, samples[i]);
+            m_partialMax = std::max(m_partialMax, samples[i]);
+        }
+        if (filled + n == kBaseBucket) {
+            pushBucket(0, m_partialMin, m_partialMax);
+            m_partialMin = kEmptyMin;
+            m_partialMax = kEmptyMax;
+        }
+    }
+    
+    for (; i + kBaseBucket <= count; i += kBaseBucket) {
+        float low, high;
+        reduceBucket(samples + i, &low, &high);
+        pushBucket(0, low, high);
+    }
+    
+    for (int j = i; j < count; ++j) {
+        m_partialMin = std::min(m_partialMin, samples[j]);
+        m_partialMax = std::max(m_partialMax, samples[j]);
+    }
+    m_samples += quint64(count);
+}
+
+int MinMaxPyramid::envelope(double first, double samplesPerColumn, int columns,
+                            float *columnMin, float *columnMax) const {
+    std::fill(columnMin, columnMin + columns, kEmptyMin);
+    std::fill(columnMax, columnMax + columns, kEmptyMax);
+    const int level = levelFor(samplesPerColumn);
+    if (columns <= 0 || samplesPerColumn <= 0.0) return level;
+    
+    // Every bucket marks each column its sample range touches
+    const double columnsPerSample = 1.0 / samplesPerColumn;
+    auto fold = [&](quint64 begin, quint64 end, float low, float high) {
+        if (low > high) return;
+        const double c0 = (double(begin) - first) * columnsPerSample;
+        const double c1 = (double(end - 1) - first) * columnsPerSample;
+        if (c1 < 0.0 || c0 >= columns) return;
+        // Truncation is floor here: both are clamped to >= 0 first
+        const int from = c0 > 0.0 ? int(c0) : 0;
+        const int to = std::min(int(c1), columns - 1);
+        for (int c = from; c <= to; ++c) {
+            columnMin[c] = std::min(columnMin[c], low);
+            columnMax[c] = std::max(columnMax[c], high);
+        }
+    };
+    
+    const double last = first + samplesPerColumn * columns;
+    if (last <= 0.0) return level;
+    const quint64 rangeBegin = first > 0.0 ? quint64(first) : 0;
+    const quint64 rangeEnd = quint64(std::ceil(last));
+    
+    // Completed buckets of the chosen level...
+    const Level &coarse = m_levels[level];
+    const quint64 size = bucketSamples(level);
+    const quint64 capacity = quint64(coarse.capacity);
+    const quint64 oldest = coarse.count > capacity ? coarse.count - capacity : 0;
+    const quint64 begin = std::max(oldest, rangeBegin / size);
+    const quint64 end = std::min(coarse.count, (rangeEnd + size - 1) / size);
+    int slot = int(begin % capacity);
+    for (quint64 b = begin; b < end; ++b) {
+        if (slot < coarse.min.size()) fold(b * size, (b + 1) * size, coarse.min[slot], coarse.max[slot]);
+        if (++slot == int(capacity)) slot = 0;
+    }
+    
+    // ...then the newest, not yet folded children below it
+    quint64 covered = coarse.count;
+    for (int l = level - 1; l >= 0; --l) {
+        const Level &fine = m_levels[l];
+        const quint64 fineSize = bucketSamples(l);
+        const quint64 fineCapacity = quint64(fine.capacity);
+        for (quint64 b = covered * kFanout; b < fine.count; ++b) {
+            const int slot = int(b % fineCapacity);
+            if (slot < fine.min.size()) fold(b * fineSize, (b + 1) * fineSize, fine.min[slot], fine.max[slot]);
+        }
+        covered = fine.count;
+    }
+    if (m_samples > covered * kBaseBucket) {
+        fold(covered * kBaseBucket, m_samples, m_partialMin, m_partialMax);
+    }
+    return level;
+}
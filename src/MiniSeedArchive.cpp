@@ -0,0 +1,198 @@
+#include "MiniSeedArchive.h"
+#include <QDirIterator>
+#include <QFileInfo>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr double kNsPerSecond = 1e9;
+}
+
+qint64 MiniSeedArchive::Segment::endNs() const {
+    return startNs + qint64(std::llround(samples.size() * kNsPerSecond / sampleRate));
+}
+
+MiniSeedArchive::MiniSeedArchive()
+    : m_recordCount(0)
+{
+}
+
+MiniSeedArchive::~MiniSeedArchive() {
+    close();
+}
+
+bool MiniSeedArchive::open(const QString &path) {
+    close();
+    m_path = path;
+    
+    if (QFileInfo(path).isFile()) {
+        addFile(path);
+    } else {
+        QDirIterator it(path, QDir::Files | QDir::Readable, QDirIterator::Subdirectories);
+        while (it.hasNext()) addFile(it.next());
+    }
+    
+    if (m_files.empty()) {
+        m_error = QString("No miniSEED data in %1").arg(path);
+        return false;
+    }
+    m_error.clear();
+    return true;
+}
+
+void MiniSeedArchive::close() {
+    m_files.clear();
+    m_fileNames.clear();
+    m_streams.clear();
+    m_streamIndex.clear();
+    m_recordCount = 0;
+}
+
+QString MiniSeedArchive::errorString() const {
+    return m_error;
+}
+
+int MiniSeedArchive::fileCount() const {
+    return int(m_files.size());
+}
+
+int MiniSeedArchive::recordCount() const {
+    return m_recordCount;
+}
+
+QStringList MiniSeedArchive::streamIds() const {
+    QStringList ids;
+    for (const Stream &stream : m_streams) ids.append(stream.id);
+    return ids;
+}
+
+bool MiniSeedArchive::timeSpan(const QString &id, qint64 *startNs, qint64 *endNs) const {
+    const int index = m_streamIndex.value(id, -1);
+    if (index < 0 || m_streams[index].entries.isEmpty()) return false;
+    
+    const QVector<Entry> &entries = m_streams[index].entries;
+    *startNs = entries.first().startNs;
+    *endNs = entries.first().endNs;
+    for (const Entry &entry : entries) *endNs = std::max(*endNs, entry.endNs);
+    return true;
+}
+
+QVector<MiniSeedArchive::Entry> MiniSeedArchive::addFile(const QString &path) {
+    if (m_fileNames.contains(path)) return {};
+    
+    auto file = std::make_unique<MiniSeedFile>();
+    if (!file->open(path)) return {};
+    
+    m_fileNames.insert(path);
+    m_files.push_back(std::move(file));
+    return indexRecords(int(m_files.size()) - 1, 0);
+}
+
+QVector<MiniSeedArchive::Entry> MiniSeedArchive::indexRecords(int file, int from) {
+    const MiniSeedFile &source = *m_files[file];
+    const QStringList ids = source.streamIds();
+    
+    QVector<Entry> added;
+    for (int r = from; r < source.recordCount(); ++r) {
+        const MiniSeedFile::Record &record = source.record(r);
+        // Log and other sample-less records carry no waveform
+        if (record.sampleCount == 0 || record.sampleRate <= 0.0) continue;
+        
+        const QString &id = ids[record.stream];
+        int stream = m_streamIndex.value(id, -1);
+        if (stream < 0) {
+            stream = m_streams.size();
+            m_streamIndex.insert(id, stream);
+            m_streams.append(Stream{id, {}, 0});
+        }
+        
+        const Entry entry{record.startNs, record.endNs(), stream, file, r};
+        Stream &target = m_streams[stream];
+        // Records nearly always arrive in time order; append in that case
+        if (target.entries.isEmpty() || target.entries.last().startNs <= entry.startNs) {
+            target.entries.append(entry);
+        } else {
+            auto it = std::upper_bound(target.entries.begin(), target.entries.end(), entry.startNs,
+                                       [](qint64 value, const Entry &e) { return value < e.startNs; });
+            target.entries.insert(it, entry);
+        }
+        target.longestNs = std::max(target.longestNs, entry.endNs - entry.startNs);
+        added.append(entry);
+        ++m_recordCount;
+    }
+    return added;
+}
+
+bool MiniSeedArchive::appendSamples(const Entry &entry, const QString &id, qint64 startNs, qint64 endNs,
+                                    QVector<Segment> *segments, QString *error) const {
+    const MiniSeedFile &file = *m_files[entry.file];
+    const MiniSeedFile::Record &record = file.record(entry.record);
+    
+    QVector<float> samples(record.sampleCount);
+    if (file.decode(record, samples.data(), error) < 0) return false;
+    
+    // Cut to the window
+    const double nsPerSample = kNsPerSecond / record.sampleRate;
+    int first = 0;
+    int last = samples.size();
+    if (startNs > record.startNs) first = int(std::ceil((startNs - record.startNs) / nsPerSample));
+    if (endNs < entry.endNs) last = int(std::ceil((endNs - record.startNs) / nsPerSample));
+    first = qBound(0, first, samples.size());
+    last = qBound(first, last, samples.size());
+    if (first == last) return true;
+    
+    const qint64 firstNs = record.startNs + qint64(std::llround(first * nsPerSample));
+    // Continues the previous segment if within half a sample of where it ends
+    if (!segments->isEmpty()) {
+        Segment &previous = segments->last();
+        if (previous.id == id && previous.sampleRate == record.sampleRate
+            && std::abs(double(firstNs - previous.endNs())) < nsPerSample / 2) {
+            previous.samples.append(samples.mid(first, last - first));
+            return true;
+        }
+    }
+    segments->append(Segment{id, record.sampleRate, firstNs, samples.mid(first, last - first)});
+    return true;
+}
+
+QVector<MiniSeedArchive::Segment> MiniSeedArchive::read(const QString &id, qint64 startNs, qint64 endNs,
+                                                        QString *error) const {
+    QVector<Segment> segments;
+    const int index = m_streamIndex.value(id, -1);
+    if (index < 0 || endNs <= startNs) return segments;
+    
+    // Only records starting within one record length before the window can
+    // reach into it
+    const Stream &stream = m_streams[index];
+    auto it = std::lower_bound(stream.entries.begin(), stream.entries.end(), startNs - stream.longestNs,
+                               [](const Entry &e, qint64 value) { return e.startNs < value; });
+    for (; it != stream.entries.end() && it->startNs < endNs; ++it) {
+        if (it->endNs <= startNs) continue;
+        appendSamples(*it, id, startNs, endNs, &segments, error);
+    }
+    return segments;
+}
+
+QVector<MiniSeedArchive::Segment> MiniSeedArchive::refresh(bool rescanDirectory) {
+    QVector<Entry> added;
+    for (int f = 0; f < int(m_files.size()); ++f) {
+        const int before = m_files[f]->recordCount();
+        if (m_files[f]->refresh() > 0) added += indexRecords(f, before);
+    }
+    
+    // New day files of an SDS archive, for example
+    if (rescanDirectory && !QFileInfo(m_path).isFile()) {
+        QDirIterator it(m_path, QDir::Files | QDir::Readable, QDirIterator::Subdirectories);
+        while (it.hasNext()) added += addFile(it.next());
+    }
+    
+    // Per stream in time order, so consecutive records merge
+    std::stable_sort(added.begin(), added.end(), [](const Entry &a, const Entry &b) {
+        return a.stream != b.stream ? a.stream < b.stream : a.startNs < b.startNs;
+    });
+    QVector<Segment> segments;
+    for (const Entry &entry : std::as_const(added)) {
+        appendSamples(entry, m_streams[entry.stream].id, entry.startNs, entry.endNs, &segments, nullptr);
+    }
+    return segments;
+}
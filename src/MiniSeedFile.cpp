@@ -0,0 +1,545 @@
+#include "MiniSeedFile.h"
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MINISEED_SSE2 1
+#endif
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+namespace {
+constexpr int kFrameBytes = 64;
+constexpr int kWordsPerFrame = 16;
+// Steim2 packs at most 7 differences per word
+constexpr int kMaxFrameDiffs = 7 * (kWordsPerFrame - 1);
+constexpr qint64 kNsPerSecond = 1000000000LL;
+// Format 2 caps records at 2^20 bytes; format 3 is held to the same
+constexpr qint64 kMaxRecordBytes = qint64(1) << 20;
+
+// CRC-32C (Castagnoli), reflected, as format 3 stores it
+struct Crc32cTable {
+    quint32 entries[256];
+    
+    constexpr Crc32cTable()
+        : entries()
+    {
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+            entries[i] = c;
+        }
+    }
+};
+constexpr Crc32cTable kCrc32c;
+
+quint32 crc32c(quint32 crc, const uchar *p, qint64 length) {
+    qint64 i = 0;
+#ifdef __SSE4_2__
+    quint64 wide = crc;
+    for (; i + 8 <= length; i += 8) {
+        quint64 word;
+        std::memcpy(&word, p + i, sizeof(word));
+        wide = _mm_crc32_u64(wide, word);
+    }
+    crc = quint32(wide);
+#endif
+    for (; i < length; ++i) crc = kCrc32c.entries[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+// Whether count samples of encoding can fit in bytes of payload. Steim
+// frames hold at most kMaxFrameDiffs each
+bool payloadFits(int encoding, qint64 count, qint64 bytes) {
+    switch (encoding) {
+    case MiniSeedFile::Int16: return count * 2 <= bytes;
+    case MiniSeedFile::Int32:
+    case MiniSeedFile::Float32: return count * 4 <= bytes;
+    case MiniSeedFile::Float64: return count * 8 <= bytes;
+    case MiniSeedFile::Steim1:
+    case MiniSeedFile::Steim2: return count <= bytes / kFrameBytes * kMaxFrameDiffs;
+    default: return true;
+    }
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date (Howard Hinnant)
+qint64 daysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    const qint64 era = (year >= 0 ? year : year - 399) / 400;
+    const int yearOfEra = int(year - era * 400);
+    const int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+qint64 epochNs(int year, int dayOfYear, int hour, int minute, int second) {
+    const qint64 days = daysFromCivil(year, 1, 1) + dayOfYear - 1;
+    return ((days * 24 + hour) * 60 + minute) * 60 * kNsPerSecond + qint64(second) * kNsPerSecond;
+}
+
+template <typename T>
+T readValue(const uchar *p, bool bigEndian) {
+    return bigEndian ? qFromBigEndian<T>(p) : qFromLittleEndian<T>(p);
+}
+
+bool validTime(int year, int dayOfYear, int hour, int minute, int second) {
+    return year >= 1900 && year <= 2100 && dayOfYear >= 1 && dayOfYear <= 366
+           && hour <= 23 && minute <= 59 && second <= 60;
+}
+
+// Fixed header fields only, for spotting a record start inside the span a
+// header claims; at least 48 bytes at h
+bool plausibleHeader(const uchar *h) {
+    if (h[0] == 'M' && h[1] == 'S' && h[2] == 3) {
+        return validTime(qFromLittleEndian<quint16>(h + 8), qFromLittleEndian<quint16>(h + 10),
+                         h[12], h[13], h[14]);
+    }
+    // Format 2: sequence number, quality code, then a start time in either order
+    for (int i = 0; i < 6; ++i) {
+        if ((h[i] < '0' || h[i] > '9') && h[i] != ' ') return false;
+    }
+    if (!std::strchr("DRQM", h[6]) || h[6] == 0) return false;
+    return validTime(qFromBigEndian<quint16>(h + 20), qFromBigEndian<quint16>(h + 22), h[24], h[25], h[26])
+           || validTime(qFromLittleEndian<quint16>(h + 20), qFromLittleEndian<quint16>(h + 22),
+                        h[24], h[25], h[26]);
+}
+
+// "FDSN:IU_ANMO_00_B_H_Z" -> "IU.ANMO.00.BHZ"
+QString fromSourceId(const QString &sourceId) {
+    QString id = sourceId.startsWith("FDSN:") ? sourceId.mid(5) : sourceId;
+    QStringList parts = id.split('_');
+    if (parts.size() == 6 && parts[3].size() == 1 && parts[4].size() == 1 && parts[5].size() == 1) {
+        return QStringList{parts[0], parts[1], parts[2], parts[3] + parts[4] + parts[5]}.join('.');
+    }
+    return parts.join('.');
+}
+
+QString fixedField(const uchar *p, int length) {
+    return QString::fromLatin1(reinterpret_cast<const char *>(p), length).trimmed();
+}
+
+// Count signed Bits-wide differences packed into word, most significant first
+template <int Bits, int Count>
+int unpack(quint32 word, qint32 *diffs) {
+    for (int j = 0; j < Count; ++j) {
+        diffs[j] = qint32(word << (32 - Bits * (Count - j))) >> (32 - Bits);
+    }
+    return Count;
+}
+
+// Running sums of diffs starting from *value, written out as floats
+void integrate(const qint32 *diffs, int count, qint32 *value, float *out) {
+    int i = 0;
+#ifdef MINISEED_SSE2
+    __m128i carry = _mm_set1_epi32(*value);
+    for (; i + 4 <= count; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(diffs + i));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, carry);
+        _mm_storeu_ps(out + i, _mm_cvtepi32_ps(x));
+        carry = _mm_shuffle_epi32(x, 0xFF);
+    }
+    *value = _mm_cvtsi128_si32(carry);
+#endif
+    // Steim sums wrap like the encoder's 32-bit arithmetic
+    quint32 running = quint32(*value);
+    for (; i < count; ++i) {
+        running += quint32(diffs[i]);
+        out[i] = float(qint32(running));
+    }
+    *value = qint32(running);
+}
+}
+
+qint64 MiniSeedFile::Record::endNs() const {
+    if (sampleRate <= 0.0) return startNs;
+    return startNs + qint64(sampleCount * (double(kNsPerSecond) / sampleRate) + 0.5);
+}
+
+MiniSeedFile::MiniSeedFile()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_scanned(0)
+    , m_pendingSize(0)
+{
+}
+
+MiniSeedFile::~MiniSeedFile() {
+    close();
+}
+
+bool MiniSeedFile::open(const QString &path) {
+    close();
+    
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    if (!remap()) {
+        m_error = QString("Cannot map %1").arg(path);
+        close();
+        return false;
+    }
+    
+    Record first;
+    if (m_size > 0 && parseRecord(0, &first) < 0) {
+        m_error = QString("%1 is not a miniSEED file").arg(path);
+        close();
+        return false;
+    }
+    refresh();
+    m_error.clear();
+    return true;
+}
+
+void MiniSeedFile::close() {
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+    }
+    m_file.close();
+    m_data = nullptr;
+    m_size = 0;
+    m_scanned = 0;
+    m_pendingSince.invalidate();
+    m_pendingSize = 0;
+    m_records.clear();
+    m_streamIds.clear();
+}
+
+bool MiniSeedFile::isOpen() const {
+    return m_file.isOpen();
+}
+
+QString MiniSeedFile::errorString() const {
+    return m_error;
+}
+
+QString MiniSeedFile::fileName() const {
+    return m_file.fileName();
+}
+
+bool MiniSeedFile::remap() {
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+        m_data = nullptr;
+    }
+    m_size = m_file.size();
+    // An empty file is valid while tailing; it just has nothing mapped yet
+    if (m_size == 0) return true;
+    m_data = m_file.map(0, m_size);
+    return m_data != nullptr;
+}
+
+int MiniSeedFile::refresh() {
+    if (!m_file.isOpen()) return 0;
+    if (m_file.size() != m_size && !remap()) {
+        m_error = QString("Cannot map %1").arg(m_file.fileName());
+        return 0;
+    }
+    
+    const int before = m_records.size();
+    while (m_scanned < m_size) {
+        Record record;
+        int length = parseRecord(m_scanned, &record);
+        if (length == 0) {
+            // Wait for the writer while the file grows; a record it has not
+            // finished after kStallMs of no growth never will be
+            if (!m_pendingSince.isValid() || m_pendingSize != m_size) {
+                m_pendingSince.start();
+                m_pendingSize = m_size;
+                break;
+            }
+            if (m_pendingSince.elapsed() < kStallMs) break;
+            length = -1;
+        }
+        m_pendingSince.invalidate();
+        if (length < 0) {
+            // Junk or a corrupt header: resynchronize on the next record
+            m_scanned = nextCandidate(m_scanned);
+            continue;
+        }
+        m_records.append(record);
+        m_scanned += length;
+    }
+    return m_records.size() - before;
+}
+
+qint64 MiniSeedFile::nextCandidate(qint64 offset) const {
+    // Format 2 records start on 64-byte boundaries, format 3 ones anywhere
+    // with an "MS" 3 signature
+    const qint64 boundary = std::min(m_size, (offset / kFrameBytes + 1) * kFrameBytes);
+    for (qint64 i = offset + 1; i + 2 < boundary; ++i) {
+        if (m_data[i] == 'M' && m_data[i + 1] == 'S' && m_data[i + 2] == 3) return i;
+    }
+    return boundary;
+}
+
+int MiniSeedFile::parseRecord(qint64 offset, Record *record) {
+    const uchar *h = m_data + offset;
+    const qint64 available = m_size - offset;
+    if (available < 48) return 0;
+    
+    QString id;
+    int length = 0;
+    if (h[0] == 'M' && h[1] == 'S' && h[2] == 3) {
+        // Format 3: little-endian, 40-byte fixed header, source identifier,
+        // extra headers, payload
+        const int idLength = h[33];
+        const int extraLength = qFromLittleEndian<quint16>(h + 34);
+        const quint32 dataLength = qFromLittleEndian<quint32>(h + 36);
+        const qint64 total = 40 + qint64(idLength) + extraLength + dataLength;
+        const int year = qFromLittleEndian<quint16>(h + 8);
+        const int dayOfYear = qFromLittleEndian<quint16>(h + 10);
+        if (total > kMaxRecordBytes || !validTime(year, dayOfYear, h[12], h[13], h[14])
+            || !payloadFits(h[15], qFromLittleEndian<quint32>(h + 24), dataLength)) {
+            return -1;
+        }
+        // Whatever has arrived of the identifier and extra headers is checked
+        // too, so a corrupt header is dropped before waiting for its length
+        for (int i = 40; i < 40 + idLength && i < available; ++i) {
+            if (h[i] <= ' ' || h[i] > '~') return -1;
+        }
+        if (extraLength > 0 && 40 + idLength < available && h[40 + idLength] != '{') return -1;
+        if (total > available) {
+            // A record already starting inside the claimed span means the
+            // length is wrong; a complete record is checked by its CRC instead
+            for (qint64 i = 40 + idLength + extraLength; i + 48 <= available; ++i) {
+                if (h[i] == 'M' && plausibleHeader(h + i)) return -1;
+            }
+            return 0;
+        }
+        
+        // The CRC is taken with its own field zeroed
+        static const uchar zeros[4] = {};
+        quint32 crc = crc32c(0xFFFFFFFFu, h, 28);
+        crc = crc32c(crc, zeros, 4);
+        crc = crc32c(crc, h + 32, total - 32);
+        if (~crc != qFromLittleEndian<quint32>(h + 28)) return -1;
+        
+        const double rate = qFromLittleEndian<double>(h + 16);
+        record->startNs = epochNs(year, dayOfYear, h[12], h[13], h[14]) + qFromLittleEndian<quint32>(h + 4);
+        record->encoding = h[15];
+        record->sampleRate = rate < 0.0 ? -1.0 / rate : rate;
+        record->sampleCount = int(qFromLittleEndian<quint32>(h + 24));
+        record->dataOffset = quint32(40 + idLength + extraLength);
+        record->dataLength = dataLength;
+        record->bigEndian = false;
+        id = fromSourceId(QString::fromLatin1(reinterpret_cast<const char *>(h + 40), idLength));
+        length = int(total);
+    } else {
+        // Format 2: 48-byte fixed header, byte order given away by the year
+        if (!std::strchr("DRQM", h[6]) || h[6] == 0) return -1;
+        bool big = true;
+        int year = qFromBigEndian<quint16>(h + 20);
+        if (year < 1900 || year > 2100) {
+            big = false;
+            year = qFromLittleEndian<quint16>(h + 20);
+        }
+        const int dayOfYear = readValue<quint16>(h + 22, big);
+        if (!validTime(year, dayOfYear, h[24], h[25], h[26])) return -1;
+        
+        const int sampleCount = readValue<quint16>(h + 30, big);
+        const qint16 factor = readValue<qint16>(h + 32, big);
+        const qint16 multiplier = readValue<qint16>(h + 34, big);
+        const quint8 activity = h[36];
+        const int blockettes = h[39];
+        const qint32 correction = readValue<qint32>(h + 40, big);
+        const int dataStart = readValue<quint16>(h + 44, big);
+        int next = readValue<quint16>(h + 46, big);
+        
+        int exponent = 0;
+        int encoding = -1;
+        bool dataBig = true;
+        int microseconds = 0;
+        int blocketteEnd = 48;
+        for (int i = 0; i < blockettes && next >= 48; ++i) {
+            // Record still being written
+            if (next + 8 > available) return 0;
+            const int type = readValue<quint16>(h + next, big);
+            if (type == 1000) {
+                encoding = h[next + 4];
+                dataBig = h[next + 5] != 0;
+                exponent = h[next + 6];
+            } else if (type == 1001) {
+                microseconds = qint8(h[next + 5]);
+            }
+            blocketteEnd = std::max(blocketteEnd, next + 8);
+            const int following = readValue<quint16>(h + next + 2, big);
+            if (following == 0) break;
+            if (following <= next) return -1;
+            next = following;
+        }
+        // Without blockette 1000 the record length and encoding are unknown
+        if (encoding < 0 || exponent < 7 || exponent > 20) return -1;
+        length = 1 << exponent;
+        // Blockettes, data and samples must all fit the length blockette 1000
+        // claims, checked before waiting for that many bytes
+        if (blocketteEnd > length) return -1;
+        if (dataStart != 0 && (dataStart < blocketteEnd || dataStart >= length)) return -1;
+        if (!payloadFits(encoding, sampleCount, dataStart > 0 ? length - dataStart : 0)) return -1;
+        // Nor may another record start on a 64-byte boundary inside it
+        for (qint64 at = kFrameBytes; at < length && at + 48 <= available; at += kFrameBytes) {
+            if (plausibleHeader(h + at)) return -1;
+        }
+        if (length > available) return 0;
+        
+        double rate = 0.0;
+        if (factor > 0) rate = factor;
+        else if (factor < 0) rate = -1.0 / factor;
+        if (multiplier > 0) rate *= multiplier;
+        else if (multiplier < 0) rate = -rate / multiplier;
+        
+        qint64 start = epochNs(year, dayOfYear, h[24], h[25], h[26])
+                       + qint64(readValue<quint16>(h + 28, big)) * 100000 + qint64(microseconds) * 1000;
+        // Bit 1: the correction is already applied to the start time
+        if (!(activity & 0x02)) start += qint64(correction) * 100000;
+        
+        record->startNs = start;
+        record->encoding = quint8(encoding);
+        record->sampleRate = rate;
+        record->sampleCount = sampleCount;
+        record->dataOffset = quint32(dataStart);
+        record->dataLength = dataStart > 0 ? quint32(length - dataStart) : 0;
+        record->bigEndian = dataBig;
+        id = QStringList{fixedField(h + 18, 2), fixedField(h + 8, 5), fixedField(h + 13, 2),
+                         fixedField(h + 15, 3)}.join('.');
+    }
+    
+    record->offset = offset;
+    record->length = quint32(length);
+    record->stream = m_streamIds.indexOf(id);
+    if (record->stream < 0) {
+        record->stream = m_streamIds.size();
+        m_streamIds.append(id);
+    }
+    return length;
+}
+
+int MiniSeedFile::recordCount() const {
+    return m_records.size();
+}
+
+const MiniSeedFile::Record &MiniSeedFile::record(int index) const {
+    return m_records[index];
+}
+
+QStringList MiniSeedFile::streamIds() const {
+    return m_streamIds;
+}
+
+int MiniSeedFile::decode(const Record &record, float *out, QString *error) const {
+    if (!m_data || record.offset + record.length > m_size) {
+        if (error) *error = "Record outside the mapped file";
+        return -1;
+    }
+    const uchar *data = m_data + record.offset + record.dataOffset;
+    const int count = record.sampleCount;
+    const bool big = record.bigEndian;
+    
+    auto need = [&](int bytes) {
+        if (qint64(count) * bytes <= qint64(record.dataLength)) return true;
+        if (error) *error = QString("Record at %1 is shorter than its samples").arg(record.offset);
+        return false;
+    };
+    
+    switch (record.encoding) {
+    case Steim1:
+    case Steim2:
+        return decodeSteim(data, int(record.dataLength), count, record.encoding == Steim2, out, error);
+    case Int16:
+        if (!need(2)) return -1;
+        for (int i = 0; i < count; ++i) out[i] = readValue<qint16>(data + 2 * i, big);
+        return count;
+    case Int32:
+        if (!need(4)) return -1;
+        for (int i = 0; i < count; ++i) out[i] = float(readValue<qint32>(data + 4 * i, big));
+        return count;
+    case Float32:
+        if (!need(4)) return -1;
+        for (int i = 0; i < count; ++i) out[i] = readValue<float>(data + 4 * i, big);
+        return count;
+    case Float64:
+        if (!need(8)) return -1;
+        for (int i = 0; i < count; ++i) out[i] = float(readValue<double>(data + 8 * i, big));
+        return count;
+    default:
+        if (error) *error = QString("Unsupported miniSEED encoding %1").arg(record.encoding);
+        return -1;
+    }
+}
+
+int MiniSeedFile::decodeSteim(const uchar *frames, int length, int count, bool steim2,
+                              float *out, QString *error) {
+    if (count <= 0) return 0;
+    const int frameCount = length / kFrameBytes;
+    if (frameCount == 0) {
+        if (error) *error = "Steim record without frames";
+        return -1;
+    }
+    
+    // Frame 0 carries the first and last sample in words 1 and 2; the first
+    // difference is relative to the previous record and is skipped
+    qint32 value = qFromBigEndian<qint32>(frames + 4);
+    const qint32 last = qFromBigEndian<qint32>(frames + 8);
+    out[0] = float(value);
+    int written = 1;
+    bool skipFirst = true;
+    
+    qint32 diffs[kMaxFrameDiffs];
+    for (int f = 0; f < frameCount && written < count; ++f) {
+        const uchar *frame = frames + f * kFrameBytes;
+        const quint32 nibbles = qFromBigEndian<quint32>(frame);
+        int n = 0;
+        for (int w = f == 0 ? 3 : 1; w < kWordsPerFrame; ++w) {
+            const quint32 word = qFromBigEndian<quint32>(frame + 4 * w);
+            const int nibble = (nibbles >> (30 - 2 * w)) & 3;
+            if (nibble == 0) continue;
+            if (nibble == 1) {
+                n += unpack<8, 4>(word, diffs + n);
+            } else if (!steim2) {
+                n += nibble == 2 ? unpack<16, 2>(word, diffs + n) : unpack<32, 1>(word, diffs + n);
+            } else {
+                const int dnib = word >> 30;
+                if (nibble == 2) {
+                    if (dnib == 1) n += unpack<30, 1>(word, diffs + n);
+                    else if (dnib == 2) n += unpack<15, 2>(word, diffs + n);
+                    else if (dnib == 3) n += unpack<10, 3>(word, diffs + n);
+                    else {
+                        if (error) *error = "Invalid Steim2 difference width";
+                        return -1;
+                    }
+                } else {
+                    if (dnib == 0) n += unpack<6, 5>(word, diffs + n);
+                    else if (dnib == 1) n += unpack<5, 6>(word, diffs + n);
+                    else if (dnib == 2) n += unpack<4, 7>(word, diffs + n);
+                    else {
+                        if (error) *error = "Invalid Steim2 difference width";
+                        return -1;
+                    }
+                }
+            }
+        }
+        
+        const qint32 *from = diffs;
+        if (skipFirst && n > 0) {
+            ++from;
+            --n;
+            skipFirst = false;
+        }
+        n = qMin(n, count - written);
+        integrate(from, n, &value, out + written);
+        written += n;
+    }
+    
+    if (written != count || value != last) {
+        if (error) *error = QString("Steim data fails its integrity check (%1 of %2 samples)")
+                                .arg(written).arg(count);
+        return -1;
+    }
+    return count;
+}
@@ -0,0 +1,339 @@
+#include "RegionLookup.h"
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kDegToRad = kPi / 180.0;
+constexpr double kEarthRadiusKm = 6371.0;
+constexpr double kKmPerDegree = kEarthRadiusKm * kDegToRad;
+// Sel grid indeks (derajat)
+constexpr double kCellDegrees = 1.0;
+
+double distanceKm(double lat1, double lon1, double lat2, double lon2) {
+    // Haversine
+    const double dLat = (lat2 - lat1) * kDegToRad;
+    const double dLon = (lon2 - lon1) * kDegToRad;
+    const double a = std::sin(dLat / 2) * std::sin(dLat / 2)
+                     + std::cos(lat1 * kDegToRad) * std::cos(lat2 * kDegToRad)
+                       * std::sin(dLon / 2) * std::sin(dLon / 2);
+    return 2.0 * kEarthRadiusKm * std::asin(std::sqrt(qMin(1.0, a)));
+}
+
+double azimuthDegrees(double lat1, double lon1, double lat2, double lon2) {
+    const double phi1 = lat1 * kDegToRad;
+    const double phi2 = lat2 * kDegToRad;
+    const double dLon = (lon2 - lon1) * kDegToRad;
+    const double y = std::sin(dLon) * std::cos(phi2);
+    const double x = std::cos(phi1) * std::sin(phi2) - std::sin(phi1) * std::cos(phi2) * std::cos(dLon);
+    double azimuth = std::atan2(y, x) / kDegToRad;
+    return azimuth < 0 ? azimuth + 360.0 : azimuth;
+}
+}
+
+bool RegionLookup::load(const QString &path, QString *error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (error) *error = QString("%1: %2").arg(path, file.errorString());
+        return false;
+    }
+    
+    QVector<Polygon> polygons;
+    QVector<QPointF> vertices;
+    QVector<Place> places;
+    
+    auto closePolygon = [&]() {
+        if (polygons.isEmpty()) return true;
+        Polygon &polygon = polygons.last();
+        polygon.vertexCount = vertices.size() - polygon.firstVertex;
+        if (polygon.vertexCount < 3) return false;
+        
+        // Shoelace area in square degrees; only used to rank overlaps
+        double minX = vertices[polygon.firstVertex].x(), maxX = minX;
+        double minY = vertices[polygon.firstVertex].y(), maxY = minY;
+        double twiceArea = 0.0;
+        for (int i = 0; i < polygon.vertexCount; ++i) {
+            const QPointF &a = vertices[polygon.firstVertex + i];
+            const QPointF &b = vertices[polygon.firstVertex + (i + 1) % polygon.vertexCount];
+            twiceArea += a.x() * b.y() - b.x() * a.y();
+            minX = qMin(minX, a.x());
+            maxX = qMax(maxX, a.x());
+            minY = qMin(minY, a.y());
+            maxY = qMax(maxY, a.y());
+        }
+        polygon.area = std::abs(twiceArea) / 2.0;
+        polygon.bounds = QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
+        return true;
+    };
+    
+    QTextStream in(&file);
+    int lineNumber = 0;
+    bool inRegion = false;
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        
+        auto fail = [&](const QString &reason) {
+            if (error) *error = QString("%1:%2: %3").arg(path).arg(lineNumber).arg(reason);
+            return false;
+        };
+        
+        if (line.startsWith("region ")) {
+            if (inRegion && !closePolygon()) return fail("region needs at least 3 vertices");
+            polygons.append({line.mid(7).trimmed(), QRectF(), int(vertices.size()), 0, 0.0});
+            inRegion = true;
+            continue;
+        }
+        
+        if (line.startsWith("place ")) {
+            if (inRegion && !closePolygon()) return fail("region needs at least 3 vertices");
+            inRegion = false;
+            
+            const QStringList parts = line.mid(6).split(' ', Qt::SkipEmptyParts);
+            bool latOk = false, lonOk = false;
+            if (parts.size() < 3) return fail("expected: place <lat> <lon> <name>");
+            double lat = parts[0].toDouble(&latOk);
+            double lon = parts[1].toDouble(&lonOk);
+            if (!latOk || !lonOk) return fail("bad place coordinates");
+            places.append({parts.mid(2).join(' '), lat, lon});
+            continue;
+        }
+        
+        if (!inRegion) return fail("vertices outside a region");
+        const QStringList numbers = line.split(' ', Qt::SkipEmptyParts);
+        if (numbers.size() % 2 != 0) return fail("vertices come in lat lon pairs");
+        for (int i = 0; i < numbers.size(); i += 2) {
+            bool latOk = false, lonOk = false;
+            double lat = numbers[i].toDouble(&latOk);
+            double lon = numbers[i + 1].toDouble(&lonOk);
+            if (!latOk || !lonOk) return fail("bad vertex");
+            vertices.append(QPointF(lon, lat));
+        }
+    }
+    if (inRegion && !closePolygon()) {
+        if (error) *error = QString("%1: last region needs at least 3 vertices").arg(path);
+        return false;
+    }
+    
+    std::stable_sort(polygons.begin(), polygons.end(),
+                     [](const Polygon &a, const Polygon &b) { return a.area < b.area; });
+    m_polygons = polygons;
+    m_vertices = vertices;
+    m_places = places;
+    buildIndex();
+    return true;
+}
+
+void RegionLookup::buildIndex() {
+    // QRectF::united() skips empty rects, and a place is one
+    double minX = 180.0, maxX = -180.0, minY = 90.0, maxY = -90.0;
+    auto extend = [&](double x, double y) {
+        minX = qMin(minX, x);
+        maxX = qMax(maxX, x);
+        minY = qMin(minY, y);
+        maxY = qMax(maxY, y);
+    };
+    for (const Polygon &polygon : std::as_const(m_polygons)) {
+        extend(polygon.bounds.left(), polygon.bounds.top());
+        extend(polygon.bounds.right(), polygon.bounds.bottom());
+    }
+    for (const Place &place : std::as_const(m_places)) {
+        extend(place.longitude, place.latitude);
+    }
+    if (minX > maxX) {
+        m_rows = m_cols = 0;
+        return;
+    }
+    
+    // Whole cells, one spare column and row so points on the far edge fall inside
+    const double left = std::floor(minX / kCellDegrees) * kCellDegrees;
+    const double top = std::floor(minY / kCellDegrees) * kCellDegrees;
+    m_cols = int(std::ceil((maxX - left) / kCellDegrees)) + 1;
+    m_rows = int(std::ceil((maxY - top) / kCellDegrees)) + 1;
+    m_bounds = QRectF(left, top, m_cols * kCellDegrees, m_rows * kCellDegrees);
+    
+    const int cells = m_rows * m_cols;
+    auto cellRange = [&](const QRectF &rect, int *row0, int *row1, int *col0, int *col1) {
+        *col0 = qBound(0, int((rect.left() - left) / kCellDegrees), m_cols - 1);
+        *col1 = qBound(0, int((rect.right() - left) / kCellDegrees), m_cols - 1);
+        *row0 = qBound(0, int((rect.top() - top) / kCellDegrees), m_rows - 1);
+        *row1 = qBound(0, int((rect.bottom() - top) / kCellDegrees), m_rows - 1);
+    };
+    
+    // Two passes (count, then fill) into flat arrays; polygons keep area order
+    // within every cell because they are visited in that order
+    auto fill = [&](int itemCount, auto rectOf, QVector<int> &start, QVector<int> &items) {
+        start.fill(0, cells + 1);
+        for (int pass = 0; pass < 2; ++pass) {
+            QVector<int> cursor = start;
+            for (int i = 0; i < itemCount; ++i) {
+                int row0, row1, col0, col1;
+                cellRange(rectOf(i), &row0, &row1, &col0, &col1);
+                for (int row = row0; row <= row1; ++row) {
+                    for (int col = col0; col <= col1; ++col) {
+                        int cell = row * m_cols + col;
+                        if (pass == 0) {
+                            ++start[cell + 1];
+                        } else {
+                            items[cursor[cell]++] = i;
+                        }
+                    }
+                }
+            }
+            if (pass == 0) {
+                for (int cell = 0; cell < cells; ++cell) start[cell + 1] += start[cell];
+                items.resize(start[cells]);
+            }
+        }
+    };
+    
+    fill(m_polygons.size(), [this](int i) { return m_polygons[i].bounds; },
+         m_polygonStart, m_polygonItems);
+    fill(m_places.size(), [this](int i) {
+        return QRectF(m_places[i].longitude, m_places[i].latitude, 0, 0);
+    }, m_placeStart, m_placeItems);
+}
+
+bool RegionLookup::isEmpty() const {
+    return m_polygons.isEmpty() && m_places.isEmpty();
+}
+
+int RegionLookup::regionCount() const {
+    return m_polygons.size();
+}
+
+int RegionLookup::placeCount() const {
+    return m_places.size();
+}
+
+const RegionLookup &RegionLookup::shared() {
+    static const RegionLookup lookup = []() {
+        RegionLookup loaded;
+        QString error;
+        if (!loaded.load(":/data/regions.txt", &error)) {
+            qWarning("RegionLookup: %s", qPrintable(error));
+        }
+        return loaded;
+    }();
+    return lookup;
+}
+
+bool RegionLookup::cellOf(double lat, double lon, int *row, int *col) const {
+    if (m_rows == 0 || !m_bounds.contains(lon, lat)) return false;
+    *col = qMin(m_cols - 1, int((lon - m_bounds.left()) / kCellDegrees));
+    *row = qMin(m_rows - 1, int((lat - m_bounds.top()) / kCellDegrees));
+    return true;
+}
+
+bool RegionLookup::contains(const Polygon &polygon, double lat, double lon) const {
+    if (!polygon.bounds.contains(lon, lat)) return false;
+    
+    // Even-odd crossing test; regions do not straddle the antimeridian
+    bool inside = false;
+    const QPointF *v = m_vertices.constData() + polygon.firstVertex;
+    for (int i = 0, j = polygon.vertexCount - 1; i < polygon.vertexCount; j = i++) {
+        if ((v[i].y() > lat) != (v[j].y() > lat)
+            && lon < (v[j].x() - v[i].x()) * (lat - v[i].y()) / (v[j].y() - v[i].y()) + v[i].x()) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+QString RegionLookup::region(double lat, double lon) const {
+    int row, col;
+    if (!cellOf(lat, lon, &row, &col)) return QString();
+    
+    const int cell = row * m_cols + col;
+    for (int k = m_polygonStart[cell]; k < m_polygonStart[cell + 1]; ++k) {
+        const Polygon &polygon = m_polygons[m_polygonItems[k]];
+        if (contains(polygon, lat, lon)) return polygon.name;
+    }
+    return QString();
+}
+
+RegionLookup::Nearest RegionLookup::nearestPlace(double lat, double lon, double maxKm) const {
+    int best = -1;
+    double bestKm = maxKm;
+    auto consider = [&](int index) {
+        const Place &place = m_places[index];
+        double km = distanceKm(lat, lon, place.latitude, place.longitude);
+        if (km <= bestKm) {
+            best = index;
+            bestKm = km;
+        }
+    };
+    
+    int row0, col0;
+    if (!cellOf(lat, lon, &row0, &col0)) {
+        // Outside the dataset, rare enough for a plain scan
+        for (int i = 0; i < m_places.size(); ++i) consider(i);
+    } else {
+        // Rings of cells around the point's cell, until the next ring cannot
+        // hold anything closer than the best so far
+        const int maxRing = qMax(m_rows, m_cols);
+        for (int ring = 0; ring <= maxRing; ++ring) {
+            const double edgeLat = qMin(89.0, std::abs(lat) + ring * kCellDegrees);
+            const double nearestKm = (ring - 1) * kCellDegrees * kKmPerDegree * std::cos(edgeLat * kDegToRad);
+            if (nearestKm > bestKm) break;
+            
+            for (int row = row0 - ring; row <= row0 + ring; ++row) {
+                if (row < 0 || row >= m_rows) continue;
+                
+                const bool edgeRow = row == row0 - ring || row == row0 + ring;
+                const int step = edgeRow ? 1 : 2 * ring;
+                for (int col = col0 - ring; col <= col0 + ring; col += qMax(1, step)) {
+                    if (col < 0 || col >= m_cols) continue;
+                    
+                    const int cell = row * m_cols + col;
+                    for (int k = m_placeStart[cell]; k < m_placeStart[cell + 1]; ++k) {
+                        consider(m_placeItems[k]);
+                    }
+                }
+            }
+        }
+    }
+    
+    Nearest nearest;
+    if (best < 0) return nearest;
+    
+    const Place &place = m_places[best];
+    nearest.name = place.name;
+    nearest.distanceKm = bestKm;
+    nearest.azimuth = azimuthDegrees(place.latitude, place.longitude, lat, lon);
+    return nearest;
+}
+
+QString RegionLookup::describe(double lat, double lon) const {
+    QString name = region(lat, lon);
+    if (!name.isEmpty()) return name;
+    
+    Nearest nearest = nearestPlace(lat, lon);
+    if (nearest.isValid()) return relativeTo(nearest);
+    
+    return QString("%1 %2  %3 %4")
+        .arg(std::abs(lat), 0, 'f', 2).arg(lat < 0 ? "S" : "N")
+        .arg(std::abs(lon), 0, 'f', 2).arg(lon < 0 ? "W" : "E");
+}
+
+QString RegionLookup::relativeTo(const Nearest &nearest) {
+    if (!nearest.isValid()) return QString();
+    if (nearest.distanceKm < 1.0) return QString("Near %1").arg(nearest.name);
+    return QString("%1 km %2 of %3")
+        .arg(qRound(nearest.distanceKm))
+        .arg(compassPoint(nearest.azimuth), nearest.name);
+}
+
+QString RegionLookup::compassPoint(double azimuth) {
+    static const char *const points[16] = {
+        "N", "NNE", "NE", "ENE", "E", "ESE", "SE", "SSE",
+        "S", "SSW", "SW", "WSW", "W", "WNW", "NW", "NNW"
+    };
+    double wrapped = std::fmod(azimuth, 360.0);
+    if (wrapped < 0) wrapped += 360.0;
+    return points[int(std::floor(wrapped / 22.5 + 0.5)) % 16];
+}
@@ -0,0 +1,79 @@
+#include "SampleRing.h"
+#include <algorithm>
+#include <cstring>
+
+SampleRing::SampleRing(int capacity)
+    : m_head(0)
+    , m_reserved(0)
+{
+    quint64 size = 1;
+    while (size < quint64(qMax(1, capacity))) size <<= 1;
+    m_samples.reset(new std::atomic<float>[size]);
+    for (quint64 i = 0; i < size; ++i) m_samples[i].store(0.0f, std::memory_order_relaxed);
+    m_mask = size - 1;
+}
+
+int SampleRing::capacity() const {
+    return int(m_mask + 1);
+}
+
+void SampleRing::append(const float *samples, int count) {
+    if (count <= 0) return;
+    
+    // Indices advance by every sample appended, even those that never fit,
+    // so an index keeps mapping to the same time
+    const quint64 size = m_mask + 1;
+    const quint64 head = m_head.load(std::memory_order_relaxed);
+    const quint64 end = head + quint64(count);
+    const quint64 begin = std::max(head, end > size ? end - size : 0);
+    samples += begin - head;
+    
+    // Readers that see any of the new samples also see the reservation
+    m_reserved.store(end, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    
+    for (quint64 i = begin; i < end; ++i) {
+        m_samples[i & m_mask].store(samples[i - begin], std::memory_order_relaxed);
+    }
+    m_head.store(end, std::memory_order_release);
+}
+
+quint64 SampleRing::head() const {
+    return m_head.load(std::memory_order_acquire);
+}
+
+quint64 SampleRing::tail() const {
+    const quint64 head = m_head.load(std::memory_order_acquire);
+    const quint64 size = m_mask + 1;
+    return head > size ? head - size : 0;
+}
+
+int SampleRing::read(quint64 from, float *out, int maxCount, quint64 *first) const {
+    const quint64 size = m_mask + 1;
+    const quint64 head = m_head.load(std::memory_order_acquire);
+    quint64 start = std::max(from, head > size ? head - size : 0);
+    *first = start;
+    if (start >= head || maxCount <= 0) return 0;
+    
+    int count = int(std::min<quint64>(head - start, quint64(maxCount)));
+    for (int i = 0; i < count; ++i) {
+        out[i] = m_samples[(start + quint64(i)) & m_mask].load(std::memory_order_relaxed);
+    }
+    
+    // Anything the producer has started to overwrite since is discarded
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const quint64 reserved = m_reserved.load(std::memory_order_relaxed);
+    const quint64 valid = reserved > size ? reserved - size : 0;
+    if (valid > start) {
+        const quint64 lost = valid - start;
+        if (lost >= quint64(count)) {
+            *first = valid;
+            return 0;
+        }
+        std::memmove(out, out + lost, (count - lost) * sizeof(float));
+        count -= int(lost);
+        start = valid;
+    }
+    *first = start;
+    return count;
+}
@@ -1,4 +1,6 @@
 #include "SeismicEventTable.h"
+#include "StatementCache.h"
+#include "CatalogFilter.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QHeaderView>
@@ -6,18 +8,19 @@
 #include <QSqlQuery>
 #include <QSqlRecord>
 #include <QMessageBox>
+#include <QTimer>
 #include <QDebug>
 
 SeismicEventTable::SeismicEventTable(QWidget *parent) 
-    : QWidget(parent), m_model(nullptr) {
+    : QWidget(parent), m_model(nullptr), m_searchTimer(nullptr) {
     setupUI();
     setupDatabase();
 }
 
 SeismicEventTable::~SeismicEventTable() {
-    if (m_database.isOpen()) {
-        m_database.close();
-    }
+    // The model holds queries on the borrowed connection; drop it first
+    delete m_model;
+    m_model = nullptr;
 }
 
 void SeismicEventTable::setupUI() {
@@ -28,9 +31,15 @@ void SeismicEventTable::setupUI() {
     auto *toolbarLayout = new QHBoxLayout();
     
     m_searchBox = new QLineEdit();
-    m_searchBox->setPlaceholderText("Search by magnitude, location...");
+    m_searchBox->setPlaceholderText("Search: m6.5+  lat:-11..6  lon:95..141  2024-12  id:ujicoba");
     connect(m_searchBox, &QLineEdit::textChanged, this, &SeismicEventTable::onSearchTextChanged);
     
+    // Query once typing pauses, not on every keystroke
+    m_searchTimer = new QTimer(this);
+    m_searchTimer->setSingleShot(true);
+    m_searchTimer->setInterval(300);
+    connect(m_searchTimer, &QTimer::timeout, this, &SeismicEventTable::onSearchTimeout);
+    
     m_refreshButton = new QPushButton("Refresh");
     connect(m_refreshButton, &QPushButton::clicked, this, &SeismicEventTable::onRefreshClicked);
     
@@ -66,12 +75,6 @@ void SeismicEventTable::setupUI() {
 }
 
 void SeismicEventTable::setupDatabase() {
-    m_database = QSqlDatabase::addDatabase("QPSQL", "tsunami_connection");
-    m_database.setHostName("localhost");
-    m_database.setDatabaseName("tsunami_data");
-    m_database.setUserName("farhan");
-    m_database.setPassword("farhan"); // Isi password jika ada
-    
     if (connectToDatabase()) {
         setupTableView();
         loadData();
@@ -79,13 +82,16 @@ void SeismicEventTable::setupDatabase() {
 }
 
 bool SeismicEventTable::connectToDatabase() {
-    if (!m_database.open()) {
-        QString error = m_database.lastError().text();
+    // GUI-thread connection from the shared pool, held for the widget's lifetime
+    QString error;
+    m_lease = ConnectionPool::instance().acquire(2000, &error);
+    if (!m_lease.isValid()) {
         m_statusLabel->setText("Status: Connection failed - " + error);
         QMessageBox::critical(this, "Database Error", 
             "Cannot connect to database:\n" + error);
         return false;
     }
+    m_database = m_lease.database();
     
     m_statusLabel->setText("Status: Connected to tsunami_data");
     return true;
@@ -181,17 +187,30 @@ void SeismicEventTable::onDeleteClicked() {
 }
 
 void SeismicEventTable::onSearchTextChanged(const QString &text) {
+    Q_UNUSED(text);
+    m_searchTimer->start();
+}
+
+void SeismicEventTable::onSearchTimeout() {
+    QString text = m_searchBox->text().trimmed();
     if (text.isEmpty()) {
         applyFilter("");
-    } else {
-        // Search in magnitude or coordinates
-        QString filter = QString(
-            "CAST(magnitudo AS TEXT) LIKE '%%1%' OR "
-            "CAST(latitude AS TEXT) LIKE '%%1%' OR "
-            "CAST(longitude AS TEXT) LIKE '%%1%'"
-        ).arg(text);
-        applyFilter(filter);
+        return;
+    }
+    
+    // Structured terms become indexed predicates (origintime, magnitudo,
+    // geom_source, event_id) instead of CAST(... AS TEXT) LIKE scans
+    QString error;
+    CatalogFilter filter = CatalogFilter::parse(text, &error);
+    if (!error.isEmpty()) {
+        m_statusLabel->setText("Status: " + error);
+        return;
     }
+    
+    // QSqlTableModel only takes a filter string, so values go in as
+    // driver-quoted literals, never raw
+    applyFilter(StatementCache::inlineValues(m_database, filter.whereClause(),
+                                             filter.bindValues()));
 }
 
 void SeismicEventTable::onRowClicked(const QModelIndex &index) {
@@ -0,0 +1,141 @@
+#include "StatementCache.h"
+#include <QElapsedTimer>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlField>
+#include <QStringList>
+
+StatementCache::StatementCache() {
+}
+
+void StatementCache::setDatabase(const QSqlDatabase &db) {
+    for (auto &statement : m_statements) {
+        statement->query.reset();
+        statement->stats = Stats{statement->stats.name};
+    }
+    m_db = db;
+}
+
+void StatementCache::add(const QString &name, const QString &sql, bool forwardOnly) {
+    auto statement = std::make_shared<Statement>();
+    statement->sql = sql;
+    statement->forwardOnly = forwardOnly;
+    statement->stats.name = name;
+    m_statements.insert(name, statement);
+}
+
+StatementCache::Statement *StatementCache::prepared(const QString &name) {
+    auto it = m_statements.find(name);
+    if (it == m_statements.end()) {
+        m_lastError = QString("Unknown statement %1").arg(name);
+        return nullptr;
+    }
+    
+    Statement *statement = it->get();
+    if (statement->query) return statement;
+    
+    QElapsedTimer timer;
+    timer.start();
+    auto query = std::make_unique<QSqlQuery>(m_db);
+    query->setForwardOnly(statement->forwardOnly);
+    if (!query->prepare(statement->sql)) {
+        m_lastError = query->lastError().text();
+        return nullptr;
+    }
+    statement->stats.prepareUs = timer.nsecsElapsed() / 1000;
+    statement->query = std::move(query);
+    return statement;
+}
+
+bool StatementCache::run(const QString &name, const QVariantList &values,
+                         const std::function<void(QSqlQuery &)> &consume) {
+    Statement *statement = prepared(name);
+    if (!statement) return false;
+    
+    QSqlQuery &query = *statement->query;
+    for (int i = 0; i < values.size(); ++i) {
+        query.bindValue(i, values.at(i));
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = query.exec();
+    if (ok && consume) {
+        consume(query);
+        ok = !query.lastError().isValid();
+    }
+    if (!ok) {
+        m_lastError = query.lastError().text();
+    }
+    // Release the portal, the prepared statement itself stays on the server
+    query.finish();
+    
+    Stats &stats = statement->stats;
+    stats.lastUs = timer.nsecsElapsed() / 1000;
+    stats.totalUs += stats.lastUs;
+    stats.maxUs = qMax(stats.maxUs, stats.lastUs);
+    ++stats.calls;
+    return ok;
+}
+
+QString StatementCache::explain(const QString &name, const QVariantList &values) {
+    auto it = m_statements.find(name);
+    if (it == m_statements.end()) return QString();
+    
+    QSqlQuery query(m_db);
+    query.setForwardOnly(true);
+    if (!query.prepare("EXPLAIN (ANALYZE, BUFFERS) " + (*it)->sql)) {
+        return query.lastError().text();
+    }
+    for (int i = 0; i < values.size(); ++i) {
+        query.bindValue(i, values.at(i));
+    }
+    if (!query.exec()) {
+        return query.lastError().text();
+    }
+    
+    QStringList plan;
+    while (query.next()) {
+        plan << query.value(0).toString();
+    }
+    return plan.join('\n');
+}
+
+bool StatementCache::contains(const QString &name) const {
+    return m_statements.contains(name);
+}
+
+QString StatementCache::lastError() const {
+    return m_lastError;
+}
+
+QVector<StatementCache::Stats> StatementCache::stats() const {
+    QVector<Stats> result;
+    result.reserve(m_statements.size());
+    for (const auto &statement : m_statements) {
+        result.append(statement->stats);
+    }
+    return result;
+}
+
+QString StatementCache::inlineValues(const QSqlDatabase &db, const QString &sql,
+                                     const QVariantList &values) {
+    // The driver does the quoting; values never reach the SQL text raw.
+    // Only placeholders outside string literals are replaced.
+    QString result;
+    result.reserve(sql.size() + values.size() * 16);
+    bool inLiteral = false;
+    int next = 0;
+    for (QChar c : sql) {
+        if (c == '\'') inLiteral = !inLiteral;
+        if (c != '?' || inLiteral || next >= values.size()) {
+            result += c;
+            continue;
+        }
+        const QVariant &value = values.at(next++);
+        QSqlField field("value", value.metaType());
+        field.setValue(value);
+        result += db.driver()->formatValue(field);
+    }
+    return result;
+}
@@ -0,0 +1,227 @@
+#include "TileArchive.h"
+#include "TileCache.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+const char kMagic[8] = {'T', 'S', 'T', 'I', 'L', 'E', 'S', '1'};
+constexpr quint32 kVersion = 1;
+
+struct Header {
+    char magic[8];
+    quint32 version;
+    quint32 tileCount;
+    quint32 maxZoom;
+    quint32 reserved;
+    quint64 indexOffset;
+};
+static_assert(sizeof(Header) == 32, "unexpected tile archive header padding");
+
+static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN,
+              "tile archive is read in place and assumes a little-endian host");
+}
+
+TileArchive::TileArchive()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_index(nullptr)
+    , m_tileCount(0)
+    , m_maxZoom(0)
+{
+}
+
+TileArchive::~TileArchive() {
+    close();
+}
+
+bool TileArchive::open(const QString &path) {
+    close();
+    
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+    
+    m_size = m_file.size();
+    m_data = m_file.map(0, m_size);
+    if (!m_data || m_size < qint64(sizeof(Header))) {
+        m_error = QString("Cannot map tile archive %1").arg(path);
+        close();
+        return false;
+    }
+    
+    Header header;
+    std::memcpy(&header, m_data, sizeof(Header));
+    const qint64 indexBytes = qint64(header.tileCount) * qint64(sizeof(IndexEntry));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion
+        || header.indexOffset % alignof(IndexEntry) != 0
+        || qint64(header.indexOffset) + indexBytes > m_size) {
+        m_error = QString("%1 is not a valid tile archive").arg(path);
+        close();
+        return false;
+    }
+    
+    m_index = reinterpret_cast<const IndexEntry *>(m_data + header.indexOffset);
+    m_tileCount = int(header.tileCount);
+    m_maxZoom = int(header.maxZoom);
+    m_error.clear();
+    return true;
+}
+
+void TileArchive::close() {
+    if (m_data) {
+        m_file.unmap(const_cast<uchar *>(m_data));
+    }
+    m_file.close();
+    m_data = nullptr;
+    m_size = 0;
+    m_index = nullptr;
+    m_tileCount = 0;
+    m_maxZoom = 0;
+}
+
+bool TileArchive::isOpen() const {
+    return m_data != nullptr;
+}
+
+QString TileArchive::errorString() const {
+    return m_error;
+}
+
+int TileArchive::tileCount() const {
+    return m_tileCount;
+}
+
+int TileArchive::maxZoom() const {
+    return m_maxZoom;
+}
+
+const TileArchive::IndexEntry *TileArchive::findEntry(quint64 key) const {
+    if (!m_index) return nullptr;
+    
+    const IndexEntry *end = m_index + m_tileCount;
+    const IndexEntry *it = std::lower_bound(m_index, end, key,
+        [](const IndexEntry &entry, quint64 value) { return entry.key < value; });
+    
+    if (it == end || it->key != key) return nullptr;
+    if (qint64(it->offset) + it->length > m_size) return nullptr;
+    return it;
+}
+
+bool TileArchive::contains(quint64 key) const {
+    return findEntry(key) != nullptr;
+}
+
+QByteArray TileArchive::tileData(quint64 key) const {
+    const IndexEntry *entry = findEntry(key);
+    if (!entry) return QByteArray();
+    
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(m_data + entry->offset),
+                                   qsizetype(entry->length));
+}
+
+bool TileArchive::parseQuadKey(const QString &quadKey, int *zoom, int *x, int *y) {
+    if (quadKey.size() > kMaxZoom) return false;
+    
+    int tileX = 0;
+    int tileY = 0;
+    
+    for (QChar ch : quadKey) {
+        int digit = ch.digitValue();
+        if (digit < 0 || digit > 3) return false;
+        
+        tileX = (tileX << 1) | (digit & 1);
+        tileY = (tileY << 1) | (digit >> 1);
+    }
+    
+    *zoom = int(quadKey.size());
+    *x = tileX;
+    *y = tileY;
+    return true;
+}
+
+bool TileArchive::build(const QString &tileDir, const QString &archivePath, QString *error) {
+    struct SourceTile {
+        quint64 key;
+        QString path;
+    };
+    
+    QDir dir(tileDir);
+    std::vector<SourceTile> tiles;
+    int maxZoom = 0;
+    
+    const QStringList files = dir.entryList({"world*.png"}, QDir::Files);
+    for (const QString &fileName : files) {
+        QString quadKey = fileName.mid(5, fileName.size() - 9); // strip "world" and ".png"
+        int zoom, x, y;
+        if (!parseQuadKey(quadKey, &zoom, &x, &y)) continue;
+        
+        tiles.push_back({TileCache::key(zoom, x, y), dir.filePath(fileName)});
+        maxZoom = qMax(maxZoom, zoom);
+    }
+    
+    if (tiles.empty()) {
+        if (error) *error = QString("No world*.png tiles found in %1").arg(tileDir);
+        return false;
+    }
+    
+    std::sort(tiles.begin(), tiles.end(),
+              [](const SourceTile &a, const SourceTile &b) { return a.key < b.key; });
+    
+    QSaveFile out(archivePath);
+    if (!out.open(QIODevice::WriteOnly)) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+    
+    Header header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.tileCount = quint32(tiles.size());
+    header.maxZoom = quint32(maxZoom);
+    header.reserved = 0;
+    header.indexOffset = sizeof(Header);
+    
+    // Payload follows the index, so offsets are known once sizes are
+    std::vector<IndexEntry> index(tiles.size());
+    quint64 offset = sizeof(Header) + tiles.size() * sizeof(IndexEntry);
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        index[i].key = tiles[i].key;
+        index[i].offset = offset;
+        index[i].length = quint32(QFileInfo(tiles[i].path).size());
+        index[i].reserved = 0;
+        offset += index[i].length;
+    }
+    
+    out.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+    out.write(reinterpret_cast<const char *>(index.data()), qint64(index.size() * sizeof(IndexEntry)));
+    
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        QFile tileFile(tiles[i].path);
+        if (!tileFile.open(QIODevice::ReadOnly)) {
+            if (error) *error = QString("%1: %2").arg(tiles[i].path, tileFile.errorString());
+            out.cancelWriting();
+            return false;
+        }
+        
+        QByteArray bytes = tileFile.readAll();
+        if (quint32(bytes.size()) != index[i].length) {
+            if (error) *error = QString("%1 changed while packing").arg(tiles[i].path);
+            out.cancelWriting();
+            return false;
+        }
+        out.write(bytes);
+    }
+    
+    if (!out.commit()) {
+        if (error) *error = out.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+#include "TileCache.h"
+
+TileCache::TileCache(qint64 budgetBytes)
+    : m_cache(budgetBytes)
+    , m_hits(0)
+    , m_misses(0)
+    , m_evictions(0)
+{
+}
+
+QPixmap TileCache::find(quint64 key) {
+    QPixmap *pixmap = m_cache.object(key);
+    if (!pixmap) {
+        ++m_misses;
+        return QPixmap();
+    }
+    
+    ++m_hits;
+    return *pixmap;
+}
+
+bool TileCache::contains(quint64 key) const {
+    return m_cache.contains(key);
+}
+
+void TileCache::insert(quint64 key, const QPixmap &pixmap) {
+    if (pixmap.isNull()) return;
+    
+    // QCache trims least recently used entries itself; evictions are derived
+    // from the entry count before and after the insert
+    const qsizetype before = m_cache.size() + (m_cache.contains(key) ? 0 : 1);
+    if (m_cache.insert(key, new QPixmap(pixmap), pixmapBytes(pixmap))) {
+        m_evictions += quint64(before - m_cache.size());
+    }
+}
+
+void TileCache::clear() {
+    m_cache.clear();
+}
+
+void TileCache::setBudget(qint64 budgetBytes) {
+    const qsizetype before = m_cache.size();
+    m_cache.setMaxCost(budgetBytes);
+    m_evictions += quint64(before - m_cache.size());
+}
+
+qint64 TileCache::budget() const {
+    return m_cache.maxCost();
+}
+
+TileCache::Stats TileCache::stats() const {
+    Stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.evictions = m_evictions;
+    stats.bytes = m_cache.totalCost();
+    stats.tiles = int(m_cache.size());
+    return stats;
+}
+
+void TileCache::resetStats() {
+    m_hits = 0;
+    m_misses = 0;
+    m_evictions = 0;
+}
+
+qint64 TileCache::pixmapBytes(const QPixmap &pixmap) {
+    return qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+}
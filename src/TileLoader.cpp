@@ -0,0 +1,139 @@
+#include "TileLoader.h"
+#include "TileArchive.h"
+#include <QBuffer>
+#include <QImageReader>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QThread>
+
+TileLoader::TileLoader(QObject *parent)
+    : QObject(parent)
+    , m_archive(nullptr)
+{
+    // Satu core disisakan untuk GUI thread
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+TileLoader::~TileLoader() {
+    cancelAll();
+    m_pool.waitForDone();
+}
+
+void TileLoader::setArchive(const TileArchive *archive) {
+    cancelAll();
+    m_pool.waitForDone();
+    m_archive = archive;
+}
+
+void TileLoader::request(quint64 key, const QString &path, int priority) {
+    if (m_pending.contains(key)) {
+        QMutexLocker locker(&m_queueMutex);
+        for (Job &job : m_queue) {
+            if (job.key == key) {
+                job.priority = priority;
+                break;
+            }
+        }
+        return;
+    }
+    
+    auto canceled = std::make_shared<std::atomic_bool>(false);
+    m_pending.insert(key, canceled);
+    {
+        QMutexLocker locker(&m_queueMutex);
+        m_queue.append({key, path, priority, canceled});
+    }
+    
+    // Each pool slot pops whichever job has the highest priority when it starts,
+    // so priorities updated after request() are still honoured.
+    m_pool.start([this]() { decodeNext(); });
+}
+
+void TileLoader::cancel(quint64 key) {
+    auto it = m_pending.find(key);
+    if (it == m_pending.end()) return;
+    
+    // A job that is already decoding sees the flag and its result is dropped
+    it.value()->store(true);
+    m_pending.erase(it);
+    
+    QMutexLocker locker(&m_queueMutex);
+    for (int i = 0; i < m_queue.size(); ++i) {
+        if (m_queue[i].key == key) {
+            m_queue.removeAt(i);
+            break;
+        }
+    }
+}
+
+void TileLoader::cancelAll() {
+    for (const CancelFlag &canceled : std::as_const(m_pending)) {
+        canceled->store(true);
+    }
+    m_pending.clear();
+    
+    QMutexLocker locker(&m_queueMutex);
+    m_queue.clear();
+}
+
+bool TileLoader::isPending(quint64 key) const {
+    return m_pending.contains(key);
+}
+
+int TileLoader::pendingCount() const {
+    return m_pending.size();
+}
+
+void TileLoader::decodeNext() {
+    Job job;
+    {
+        QMutexLocker locker(&m_queueMutex);
+        if (m_queue.isEmpty()) return;
+        
+        int best = 0;
+        for (int i = 1; i < m_queue.size(); ++i) {
+            if (m_queue[i].priority > m_queue[best].priority) {
+                best = i;
+            }
+        }
+        job = m_queue.takeAt(best);
+    }
+    
+    QImage image;
+    if (!job.canceled->load()) {
+        QByteArray packed = m_archive ? m_archive->tileData(job.key) : QByteArray();
+        if (!packed.isEmpty()) {
+            // Zero-copy: the buffer reads directly from the archive mapping
+            QBuffer buffer(&packed);
+            buffer.open(QIODevice::ReadOnly);
+            QImageReader reader(&buffer);
+            image = reader.read();
+        } else {
+            QImageReader reader(job.path);
+            image = reader.read();
+        }
+        
+        // Premultiplied format keeps QPixmap::fromImage on the GUI thread a plain copy
+        if (!image.isNull()) {
+            image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        }
+    }
+    
+    QMetaObject::invokeMethod(this, [this, job, image]() {
+        onJobFinished(job.key, job.canceled, image);
+    }, Qt::QueuedConnection);
+}
+
+void TileLoader::onJobFinished(quint64 key, const CancelFlag &canceled, const QImage &image) {
+    if (canceled->load()) return;
+    
+    auto it = m_pending.find(key);
+    if (it == m_pending.end() || it.value() != canceled) return;
+    m_pending.erase(it);
+    
+    if (image.isNull()) {
+        emit tileFailed(key);
+    } else {
+        emit tileDecoded(key, image);
+    }
+}
@@ -0,0 +1,294 @@
+#include "TraceReplay.h"
+#include "MiniSeedArchive.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTimeZone>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Ingest cadence; the trace view repaints at 60 fps regardless
+constexpr int kTickMs = 20;
+// Seconds of history each ring keeps for late or resizing readers
+constexpr int kRingSeconds = 300;
+constexpr int kMinRingSamples = 4096;
+// Follow mode looks for new files (day rollover) every this many ticks
+constexpr int kRescanTicks = 500;
+constexpr double kNsPerSecond = 1e9;
+
+// "IU_ANMO_00_BHZ_M" -> "IU.ANMO.00.BHZ"; the quality code is dropped
+QString channelId(const QString &field) {
+    QStringList parts = field.split('_');
+    if (parts.size() >= 5) parts = parts.mid(0, 4);
+    return parts.join('.');
+}
+}
+
+TraceReplay::TraceReplay(QObject *parent)
+    : QObject(parent)
+    , m_timer(nullptr)
+    , m_speed(1.0)
+    , m_loop(true)
+    , m_ticksSinceRescan(0)
+{
+}
+
+TraceReplay::~TraceReplay() = default;
+
+bool TraceReplay::readFile(const QString &path, QVector<Recording> *out, QString *error) {
+    // miniSEED is recognized by its record headers; anything else is tried as ASCII
+    MiniSeedArchive archive;
+    if (!archive.open(path)) return readAscii(path, out, error);
+    
+    QString decodeError;
+    for (const QString &id : archive.streamIds()) {
+        qint64 startNs = 0;
+        qint64 endNs = 0;
+        if (!archive.timeSpan(id, &startNs, &endNs)) continue;
+        
+        const QVector<MiniSeedArchive::Segment> segments = archive.read(id, startNs, endNs, &decodeError);
+        for (const MiniSeedArchive::Segment &segment : segments) {
+            auto it = std::find_if(out->begin(), out->end(),
+                                   [&](const Recording &r) { return r.id == id; });
+            if (it == out->end()) {
+                out->append({id, segment.sampleRate, segment.startNs / 1000000, segment.samples});
+            } else {
+                it->samples += segment.samples;
+            }
+        }
+    }
+    // Records that failed to decode are gaps; the rest is still usable
+    if (!decodeError.isEmpty()) {
+        *error = QString("%1: %2").arg(path, decodeError);
+        return false;
+    }
+    return true;
+}
+
+bool TraceReplay::readAscii(const QString &path, QVector<Recording> *out, QString *error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = QString("%1: %2").arg(path, file.errorString());
+        return false;
+    }
+    
+    Recording *current = nullptr;
+    bool pairs = false;
+    int lineNumber = 0;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty()) continue;
+        
+        if (line.startsWith("TIMESERIES ")) {
+            // TIMESERIES <id>, <n> samples, <rate> sps, <start>, SLIST|TSPAIR, <type>, <unit>
+            const QList<QByteArray> fields = line.mid(11).split(',');
+            if (fields.size() < 5) {
+                *error = QString("%1:%2: short TIMESERIES header").arg(path).arg(lineNumber);
+                return false;
+            }
+            const QString id = channelId(QString::fromLatin1(fields[0].trimmed()));
+            const double rate = fields[2].trimmed().split(' ').value(0).toDouble();
+            QDateTime start = QDateTime::fromString(QString::fromLatin1(fields[3].trimmed()), Qt::ISODateWithMs);
+            start.setTimeZone(QTimeZone::UTC);
+            pairs = fields[4].trimmed() == "TSPAIR";
+            if (rate <= 0.0 || !start.isValid()) {
+                *error = QString("%1:%2: bad sample rate or start time").arg(path).arg(lineNumber);
+                return false;
+            }
+            
+            auto it = std::find_if(out->begin(), out->end(),
+                                   [&](const Recording &r) { return r.id == id; });
+            if (it == out->end()) {
+                out->append({id, rate, start.toMSecsSinceEpoch(), {}});
+                current = &out->last();
+            } else {
+                current = &*it;
+            }
+            current->samples.reserve(current->samples.size() + fields[1].trimmed().split(' ').value(0).toInt());
+            continue;
+        }
+        
+        if (!current) {
+            *error = QString("%1: not an ASCII timeseries file").arg(path);
+            return false;
+        }
+        
+        // SLIST: one or more values per line; TSPAIR: "<time> <value>"
+        const QList<QByteArray> values = line.simplified().split(' ');
+        for (int i = pairs ? 1 : 0; i < values.size(); ++i) {
+            bool ok = false;
+            float value = values[i].toFloat(&ok);
+            if (!ok) {
+                *error = QString("%1:%2: bad sample").arg(path).arg(lineNumber);
+                return false;
+            }
+            current->samples.append(value);
+        }
+    }
+    return true;
+}
+
+WaveformChannel TraceReplay::makeChannel(const QString &id, double sampleRate, qint64 startMs) {
+    WaveformChannel channel;
+    channel.id = id;
+    channel.sampleRate = sampleRate;
+    channel.startMs = startMs;
+    const int capacity = qMax(kMinRingSamples, int(std::ceil(sampleRate * kRingSeconds)));
+    channel.ring = std::make_shared<SampleRing>(capacity);
+    return channel;
+}
+
+QVector<WaveformChannel> TraceReplay::channels() const {
+    QVector<WaveformChannel> channels;
+    channels.reserve(m_streams.size());
+    for (const Stream &stream : m_streams) channels.append(stream.channel);
+    return channels;
+}
+
+void TraceReplay::startTicking() {
+    if (!m_timer) {
+        m_timer = new QTimer(this);
+        m_timer->setTimerType(Qt::PreciseTimer);
+        connect(m_timer, &QTimer::timeout, this, &TraceReplay::onTick);
+    }
+    m_clock.start();
+    m_timer->start(kTickMs);
+}
+
+void TraceReplay::start(const QString &directory, double speed, bool loop) {
+    stop();
+    
+    QVector<Recording> recordings;
+    const QFileInfoList files = QDir(directory).entryInfoList(QDir::Files | QDir::Readable, QDir::Name);
+    for (const QFileInfo &info : files) {
+        QString error;
+        if (!readFile(info.filePath(), &recordings, &error)) {
+            emit replayFailed(error);
+        }
+    }
+    
+    m_speed = qMax(0.01, speed);
+    m_loop = loop;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (const Recording &recording : std::as_const(recordings)) {
+        if (recording.samples.isEmpty()) continue;
+        
+        Stream stream;
+        // Presented as live: the first sample is "now"
+        stream.channel = makeChannel(recording.id, recording.sampleRate, now);
+        stream.samples = recording.samples;
+        m_streams.append(stream);
+    }
+    
+    startTicking();
+    emit channelsChanged(channels());
+}
+
+void TraceReplay::follow(const QString &directory) {
+    stop();
+    
+    auto archive = std::make_unique<MiniSeedArchive>();
+    if (!archive->open(directory)) {
+        emit replayFailed(archive->errorString());
+        return;
+    }
+    
+    // Backfill each ring with the newest data the archive has
+    for (const QString &id : archive->streamIds()) {
+        qint64 startNs = 0;
+        qint64 endNs = 0;
+        if (!archive->timeSpan(id, &startNs, &endNs)) continue;
+        const qint64 from = std::max(startNs, endNs - qint64(kRingSeconds * kNsPerSecond));
+        for (const MiniSeedArchive::Segment &segment : archive->read(id, from, endNs)) {
+            pushSegment(segment.id, segment.sampleRate, segment.startNs, segment.samples);
+        }
+    }
+    
+    m_archive = std::move(archive);
+    m_ticksSinceRescan = 0;
+    startTicking();
+    emit channelsChanged(channels());
+}
+
+void TraceReplay::stop() {
+    if (m_timer) m_timer->stop();
+    m_archive.reset();
+    if (m_streams.isEmpty()) return;
+    
+    m_streams.clear();
+    emit channelsChanged({});
+}
+
+bool TraceReplay::pushSegment(const QString &id, double sampleRate, qint64 startNs, const QVector<float> &samples) {
+    if (samples.isEmpty()) return false;
+    
+    const double nsPerSample = kNsPerSecond / sampleRate;
+    const qint64 endNs = startNs + qint64(std::llround(samples.size() * nsPerSample));
+    auto it = std::find_if(m_streams.begin(), m_streams.end(),
+                           [&](const Stream &s) { return s.channel.id == id; });
+    if (it != m_streams.end() && it->channel.sampleRate == sampleRate) {
+        SampleRing &ring = *it->channel.ring;
+        const qint64 offset = std::llround((startNs - it->nextNs) / nsPerSample);
+        if (offset <= 0) {
+            // Overlap: only what the ring has not seen yet
+            const int skip = int(std::min<qint64>(-offset, samples.size()));
+            ring.append(samples.constData() + skip, samples.size() - skip);
+            it->nextNs = std::max(it->nextNs, endNs);
+            return false;
+        }
+        if (offset < ring.capacity()) {
+            // Short gaps hold the last value so ring index and time stay in step
+            float hold = samples.first();
+            quint64 first = 0;
+            if (ring.head() > 0) ring.read(ring.head() - 1, &hold, 1, &first);
+            const QVector<float> fill(int(offset), hold);
+            ring.append(fill.constData(), fill.size());
+            ring.append(samples.constData(), samples.size());
+            it->nextNs = endNs;
+            return false;
+        }
+        // Anything longer starts the channel over
+        m_streams.erase(it);
+    }
+    
+    Stream stream;
+    stream.channel = makeChannel(id, sampleRate, startNs / 1000000);
+    stream.channel.ring->append(samples.constData(), samples.size());
+    stream.nextNs = endNs;
+    m_streams.append(stream);
+    return true;
+}
+
+void TraceReplay::onTick() {
+    if (m_archive) {
+        const bool rescan = ++m_ticksSinceRescan >= kRescanTicks;
+        if (rescan) m_ticksSinceRescan = 0;
+        
+        bool added = false;
+        const QVector<MiniSeedArchive::Segment> segments = m_archive->refresh(rescan);
+        for (const MiniSeedArchive::Segment &segment : segments) {
+            added |= pushSegment(segment.id, segment.sampleRate, segment.startNs, segment.samples);
+        }
+        if (added) emit channelsChanged(channels());
+        return;
+    }
+    
+    const double elapsedMs = m_clock.nsecsElapsed() / 1e6 * m_speed;
+    for (Stream &stream : m_streams) {
+        const quint64 length = quint64(stream.samples.size());
+        quint64 target = quint64(elapsedMs * stream.channel.sampleRate / 1000.0);
+        if (!m_loop) target = std::min(target, length);
+        
+        // Contiguous runs of the recording, wrapping at its end
+        while (stream.position < target) {
+            const quint64 offset = stream.position % length;
+            const quint64 run = std::min(target - stream.position, length - offset);
+            stream.channel.ring->append(stream.samples.constData() + offset, int(run));
+            stream.position += run;
+        }
+    }
+}
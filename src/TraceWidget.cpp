@@ -0,0 +1,274 @@
+#include "TraceWidget.h"
+#include "TraceReplay.h"
+#include <QElapsedTimer>
+#include <QPainter>
+#include <QWheelEvent>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+constexpr int kFrameIntervalMs = 16;
+constexpr int kScratchSamples = 8192;
+// Label baris hanya digambar kalau tinggi baris cukup
+constexpr int kMinLabelRowHeight = 14;
+// Window factor per wheel notch
+constexpr double kZoomStep = 1.25;
+
+const QRgb kBackground[2] = {qRgb(30, 30, 36), qRgb(38, 38, 46)};
+const QRgb kTraceColor = qRgb(120, 220, 140);
+
+QString windowLabel(double seconds) {
+    if (seconds < 120.0) return QString("%1 s").arg(seconds, 0, 'f', seconds < 10.0 ? 1 : 0);
+    if (seconds < 7200.0) return QString("%1 min").arg(seconds / 60.0, 0, 'f', 0);
+    return QString("%1 h").arg(seconds / 3600.0, 0, 'f', 1);
+}
+}
+
+TraceWidget::TraceWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_replay(nullptr)
+    , m_windowSeconds(120.0)
+    , m_scratch(kScratchSamples)
+    , m_frameMs(0.0)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMinimumSize(200, 100);
+    
+    m_replay = new TraceReplay();
+    m_replay->moveToThread(&m_replayThread);
+    connect(&m_replayThread, &QThread::finished, m_replay, &QObject::deleteLater);
+    connect(m_replay, &TraceReplay::channelsChanged, this, &TraceWidget::setChannels);
+    connect(m_replay, &TraceReplay::replayFailed, this, [this](const QString &error) {
+        m_replayError = error;
+        update();
+    });
+    m_replayThread.setObjectName("TraceReplayThread");
+    m_replayThread.start();
+    
+    m_frameTimer.setTimerType(Qt::PreciseTimer);
+    m_frameTimer.setInterval(kFrameIntervalMs);
+    connect(&m_frameTimer, &QTimer::timeout, this, &TraceWidget::onFrame);
+    m_frameTimer.start();
+}
+
+TraceWidget::~TraceWidget() {
+    m_replayThread.quit();
+    m_replayThread.wait();
+}
+
+void TraceWidget::replayDirectory(const QString &directory, double speed) {
+    m_replayError.clear();
+    QMetaObject::invokeMethod(m_replay, [replay = m_replay, directory, speed]() {
+        replay->start(directory, speed, true);
+    }, Qt::QueuedConnection);
+}
+
+void TraceWidget::followDirectory(const QString &directory) {
+    m_replayError.clear();
+    QMetaObject::invokeMethod(m_replay, [replay = m_replay, directory]() {
+        replay->follow(directory);
+    }, Qt::QueuedConnection);
+}
+
+void TraceWidget::setWindowSeconds(double seconds) {
+    m_windowSeconds = qBound(1.0, seconds, double(kHistorySeconds));
+    update();
+}
+
+double TraceWidget::windowSeconds() const {
+    return m_windowSeconds;
+}
+
+QVector<WaveformChannel> TraceWidget::channels() const {
+    QVector<WaveformChannel> channels;
+    channels.reserve(m_traces.size());
+    for (const Trace &trace : m_traces) channels.append(trace.channel);
+    return channels;
+}
+
+void TraceWidget::setChannels(const QVector<WaveformChannel> &channels) {
+    m_traces.clear();
+    m_traces.reserve(channels.size());
+    for (const WaveformChannel &channel : channels) {
+        Trace trace;
+        trace.channel = channel;
+        // Everything the ring still holds goes into the history
+        trace.cursor = channel.ring->tail();
+        trace.pyramid = MinMaxPyramid(quint64(std::ceil(channel.sampleRate * kHistorySeconds)));
+        m_traces.append(trace);
+    }
+    update();
+}
+
+void TraceWidget::wheelEvent(QWheelEvent *event) {
+    const double steps = event->angleDelta().y() / 120.0;
+    if (steps == 0.0) return;
+    setWindowSeconds(m_windowSeconds * std::pow(kZoomStep, -steps));
+    event->accept();
+}
+
+void TraceWidget::ingest(Trace &trace) {
+    const SampleRing &ring = *trace.channel.ring;
+    for (;;) {
+        quint64 first = 0;
+        const int count = ring.read(trace.cursor, m_scratch.data(), m_scratch.size(), &first);
+        if (count == 0) break;
+        
+        // A reader that fell behind the ring leaves a gap
+        trace.pyramid.append(first, m_scratch.constData(), count);
+        trace.cursor = first + quint64(count);
+        if (count < m_scratch.size()) break;
+    }
+}
+
+void TraceWidget::onFrame() {
+    if (m_traces.isEmpty()) return;
+    
+    // History keeps filling while the tab is hidden; only painting stops
+    for (Trace &trace : m_traces) ingest(trace);
+    if (isVisible()) update();
+}
+
+bool TraceWidget::rawEnvelope(const Trace &trace, double first, double samplesPerColumn, int columns) {
+    std::fill(m_columnMin.begin(), m_columnMin.end(), std::numeric_limits<float>::max());
+    std::fill(m_columnMax.begin(), m_columnMax.end(), -std::numeric_limits<float>::max());
+    
+    const SampleRing &ring = *trace.channel.ring;
+    quint64 cursor = quint64(std::max(0.0, std::ceil(first)));
+    if (cursor < ring.tail()) return false;
+    
+    const quint64 end = std::min(trace.cursor, quint64(std::ceil(first + samplesPerColumn * columns)));
+    while (cursor < end) {
+        quint64 start = 0;
+        const int count = ring.read(cursor, m_scratch.data(),
+                                    int(std::min<quint64>(end - cursor, quint64(m_scratch.size()))), &start);
+        if (count == 0 || start != cursor) return false;
+        
+        for (int i = 0; i < count; ++i) {
+            const int column = int((double(start + quint64(i)) - first) / samplesPerColumn);
+            if (column < 0 || column >= columns) continue;
+            m_columnMin[column] = std::min(m_columnMin[column], m_scratch[i]);
+            m_columnMax[column] = std::max(m_columnMax[column], m_scratch[i]);
+        }
+        cursor += quint64(count);
+    }
+    return true;
+}
+
+void TraceWidget::renderFrame() {
+    QElapsedTimer timer;
+    timer.start();
+    
+    const qreal ratio = devicePixelRatioF();
+    const QSize deviceSize(qMax(1, qRound(width() * ratio)), qMax(1, qRound(height() * ratio)));
+    if (m_frame.size() != deviceSize) {
+        m_frame = QImage(deviceSize, QImage::Format_RGB32);
+        m_columnMin.resize(deviceSize.width());
+        m_columnMax.resize(deviceSize.width());
+    }
+    m_frame.setDevicePixelRatio(ratio);
+    
+    const int columns = m_frame.width();
+    const int rows = m_traces.size();
+    const double rowHeight = double(m_frame.height()) / rows;
+    
+    // Right edge is the newest data of any channel
+    double nowMs = 0.0;
+    for (const Trace &trace : std::as_const(m_traces)) {
+        nowMs = std::max(nowMs, trace.channel.timeOfSample(trace.pyramid.sampleCount()));
+    }
+    const double windowStartMs = nowMs - m_windowSeconds * 1000.0;
+    
+    for (int row = 0; row < rows; ++row) {
+        const Trace &trace = m_traces[row];
+        const int top = int(row * rowHeight);
+        const int bottom = qMax(top, int((row + 1) * rowHeight) - 1);
+        const QRgb background = kBackground[row & 1];
+        for (int y = top; y <= bottom; ++y) {
+            QRgb *line = reinterpret_cast<QRgb *>(m_frame.scanLine(y));
+            std::fill(line, line + columns, background);
+        }
+        
+        const double rate = trace.channel.sampleRate;
+        const double first = (windowStartMs - trace.channel.startMs) * rate / 1000.0;
+        const double samplesPerColumn = m_windowSeconds * rate / columns;
+        if (samplesPerColumn >= MinMaxPyramid::kBaseBucket
+            || !rawEnvelope(trace, first, samplesPerColumn, columns)) {
+            trace.pyramid.envelope(first, samplesPerColumn, columns, m_columnMin.data(), m_columnMax.data());
+        }
+        
+        // Per-row autoscale over the visible columns
+        float low = std::numeric_limits<float>::max();
+        float high = -std::numeric_limits<float>::max();
+        for (int x = 0; x < columns; ++x) {
+            if (m_columnMin[x] > m_columnMax[x]) continue;
+            low = std::min(low, m_columnMin[x]);
+            high = std::max(high, m_columnMax[x]);
+        }
+        if (low > high) continue;
+        
+        const double mid = (double(low) + high) / 2.0;
+        const double half = qMax(1e-6, (double(high) - low) / 2.0);
+        const double center = (top + bottom) / 2.0;
+        const double scale = qMax(0.5, (bottom - top) / 2.0) / half;
+        
+        int previousLow = -1;
+        int previousHigh = -1;
+        for (int x = 0; x < columns; ++x) {
+            if (m_columnMin[x] > m_columnMax[x]) {
+                previousLow = previousHigh = -1;
+                continue;
+            }
+            
+            int y0 = qBound(top, int(std::lround(center - (m_columnMax[x] - mid) * scale)), bottom);
+            int y1 = qBound(top, int(std::lround(center - (m_columnMin[x] - mid) * scale)), bottom);
+            // Bridge to the previous column so steep slopes stay connected
+            if (previousLow >= 0) {
+                if (y0 > previousHigh) y0 = previousHigh;
+                if (y1 < previousLow) y1 = previousLow;
+            }
+            previousLow = y0;
+            previousHigh = y1;
+            
+            for (int y = y0; y <= y1; ++y) {
+                reinterpret_cast<QRgb *>(m_frame.scanLine(y))[x] = kTraceColor;
+            }
+        }
+    }
+    
+    m_frameMs = timer.nsecsElapsed() / 1e6;
+}
+
+void TraceWidget::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event);
+    
+    QPainter painter(this);
+    if (m_traces.isEmpty()) {
+        painter.fillRect(rect(), QColor(55, 53, 62));
+        painter.setPen(Qt::gray);
+        painter.setFont(QFont("Arial", 10));
+        QString message = m_replayError.isEmpty() ? "No waveform channels" : m_replayError;
+        painter.drawText(rect(), Qt::AlignCenter | Qt::TextWordWrap, message);
+        return;
+    }
+    
+    renderFrame();
+    painter.drawImage(0, 0, m_frame);
+    
+    // Channel labels and frame cost, in logical pixels
+    const double rowHeight = double(height()) / m_traces.size();
+    painter.setFont(QFont("Arial", 8));
+    painter.setPen(QColor(200, 200, 200));
+    if (rowHeight >= kMinLabelRowHeight) {
+        for (int row = 0; row < m_traces.size(); ++row) {
+            painter.drawText(QPointF(4, row * rowHeight + 11), m_traces[row].channel.id);
+        }
+    }
+    painter.setPen(QColor(255, 165, 0));
+    painter.drawText(rect().adjusted(0, 2, -6, 0), Qt::AlignRight | Qt::AlignTop,
+                     QString("%1 channels  %2  %3 ms")
+                         .arg(m_traces.size())
+                         .arg(windowLabel(m_windowSeconds))
+                         .arg(m_frameMs, 0, 'f', 2));
+}
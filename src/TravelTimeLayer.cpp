@@ -0,0 +1,107 @@
+#include "TravelTimeLayer.h"
+#include "ArrivalLayer.h"
+#include <QFont>
+#include <QPainter>
+#include <QPen>
+#include <QStyleOptionGraphicsItem>
+#include <vector>
+
+TravelTimeLayer::TravelTimeLayer(const QRectF &worldRect, QGraphicsItem *parent)
+    : QGraphicsItem(parent)
+    , m_worldRect(worldRect)
+    , m_projection(worldRect.left(), worldRect.top(), worldRect.width(), worldRect.height())
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    setAcceptHoverEvents(false);
+    // Di bawah marker waktu tiba
+    setZValue(45);
+}
+
+void TravelTimeLayer::setWorldRect(const QRectF &worldRect) {
+    prepareGeometryChange();
+    m_worldRect = worldRect;
+    m_projection.setWorldRect(worldRect.left(), worldRect.top(), worldRect.width(), worldRect.height());
+    project();
+}
+
+void TravelTimeLayer::setTravelTimes(const TravelTimeMap &map) {
+    m_map = map;
+    project();
+}
+
+void TravelTimeLayer::clear() {
+    setTravelTimes(TravelTimeMap());
+}
+
+void TravelTimeLayer::project() {
+    m_isochrones.clear();
+    std::vector<double> lat, lon, x, y;
+    for (const TravelTimeMap::Isochrone &source : std::as_const(m_map.isochrones)) {
+        Isochrone isochrone;
+        isochrone.seconds = source.seconds;
+        // Color of the forecast points just inside this line
+        isochrone.color = ArrivalLayer::tsunamiColor(source.seconds - 1.0);
+        
+        int longest = 0;
+        for (const QVector<QPointF> &line : source.lines) {
+            const std::size_t n = line.size();
+            if (n < 2) continue;
+            lat.resize(n);
+            lon.resize(n);
+            x.resize(n);
+            y.resize(n);
+            for (std::size_t i = 0; i < n; ++i) {
+                lon[i] = line[i].x();
+                lat[i] = line[i].y();
+            }
+            m_projection.toScene(lat.data(), lon.data(), x.data(), y.data(), n);
+            
+            isochrone.path.moveTo(x[0], y[0]);
+            for (std::size_t i = 1; i < n; ++i) isochrone.path.lineTo(x[i], y[i]);
+            if (int(n) > longest) {
+                longest = int(n);
+                isochrone.labelPosition = QPointF(x[n / 2], y[n / 2]);
+            }
+        }
+        if (longest > 1) m_isochrones.append(isochrone);
+    }
+    update();
+}
+
+QRectF TravelTimeLayer::boundingRect() const {
+    return m_worldRect;
+}
+
+void TravelTimeLayer::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) {
+    Q_UNUSED(widget);
+    if (m_isochrones.isEmpty()) return;
+    
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+    painter->setBrush(Qt::NoBrush);
+    for (const Isochrone &isochrone : std::as_const(m_isochrones)) {
+        if (!isochrone.path.controlPointRect().intersects(option->exposedRect)) continue;
+        QPen pen(isochrone.color, 1.5);
+        pen.setCosmetic(true);
+        painter->setPen(pen);
+        painter->drawPath(isochrone.path);
+    }
+    
+    // Labels at a fixed on-screen size, like ArrivalLayer
+    const QTransform transform = painter->worldTransform();
+    painter->resetTransform();
+    painter->setFont(QFont("Arial", 8, QFont::Bold));
+    for (const Isochrone &isochrone : std::as_const(m_isochrones)) {
+        if (!option->exposedRect.contains(isochrone.labelPosition)) continue;
+        const QPointF c = transform.map(isochrone.labelPosition);
+        const QString text = isochrone.seconds < 7200.0f
+            ? QString("%1'").arg(isochrone.seconds / 60.0, 0, 'f', 0)
+            : QString("%1 h").arg(isochrone.seconds / 3600.0, 0, 'f', 0);
+        painter->setPen(QColor(0, 0, 0, 200));
+        painter->drawText(c + QPointF(1, 1), text);
+        painter->setPen(isochrone.color);
+        painter->drawText(c, text);
+    }
+    
+    painter->restore();
+}
@@ -0,0 +1,488 @@
+#include "TravelTimeMap.h"
+#include "ArrivalEngine.h"
+#include "BathymetryGrid.h"
+#include <QElapsedTimer>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kDegToRad = kPi / 180.0;
+constexpr double kEarthRadiusKm = 6371.0;
+constexpr double kGravity = 9.81;
+// Floor for shallow water, same as the great-circle paths in ArrivalEngine
+constexpr double kMinDepthM = 10.0;
+constexpr float kInfinity = std::numeric_limits<float>::infinity();
+
+// Sisi tile dalam sel; cukup kecil supaya front yang sempit tetap terbagi ke banyak core
+constexpr int kTileSize = 32;
+// A cell counts as changed when it drops by more than this (seconds)
+constexpr float kTolerance = 0.01f;
+// Tiles whose incoming front is this much later than the earliest one wait,
+// so a tile is rarely swept again because a faster path reached it later
+constexpr float kBandSeconds = 1200.0f;
+// Cells around the source seeded with straight-line times
+constexpr int kSourceRadiusCells = 4;
+// An epicenter on land starts from the nearest sea cell within this distance
+constexpr double kMaxSourceShiftKm = 50.0;
+// A coastal point on land reads the nearest sea cell this many cells away
+constexpr int kCoastSearchCells = 3;
+// Isochrones every 30 minutes for the first two hours, then hourly
+constexpr float kMaxIsochroneSeconds = 24.0f * 3600.0f;
+
+enum TileEdge { TopEdge, BottomEdge, LeftEdge, RightEdge, EdgeCount };
+
+// Runs fn(0..count-1) on the pool and the calling thread, returns when all are done
+template <typename Fn>
+void parallelFor(QThreadPool &pool, int count, const Fn &fn) {
+    if (count <= 0) return;
+    std::atomic_int next(0);
+    auto drain = [&]() {
+        for (int i = next++; i < count; i = next++) fn(i);
+    };
+    const int helpers = qMin(count, pool.maxThreadCount() + 1) - 1;
+    for (int t = 0; t < helpers; ++t) pool.start(drain);
+    drain();
+    pool.waitForDone();
+}
+
+struct Sweep {
+    float *times;
+    const float *slowness;
+    const double *cellWidthKm;
+    double cellHeightKm;
+    int rows;
+    int columns;
+    
+    // First-order Godunov update of one cell from its four neighbours
+    bool relax(int row, int column) const {
+        const int index = row * columns + column;
+        const float s = slowness[index];
+        if (s == kInfinity) return false;
+        
+        double a = kInfinity, b = kInfinity;
+        if (column > 0) a = times[index - 1];
+        if (column < columns - 1) a = qMin(a, double(times[index + 1]));
+        if (row > 0) b = times[index - columns];
+        if (row < rows - 1) b = qMin(b, double(times[index + columns]));
+        if (a == kInfinity && b == kInfinity) return false;
+        
+        const double hx = cellWidthKm[row];
+        const double hy = cellHeightKm;
+        double t = qMin(a + s * hx, b + s * hy);
+        if (t > qMax(a, b)) {
+            // Both directions upwind: (t-a)^2/hx^2 + (t-b)^2/hy^2 = s^2
+            const double wx = 1.0 / (hx * hx);
+            const double wy = 1.0 / (hy * hy);
+            const double disc = (wx + wy) * double(s) * s - wx * wy * (a - b) * (a - b);
+            t = (wx * a + wy * b + std::sqrt(qMax(disc, 0.0))) / (wx + wy);
+        }
+        if (t >= times[index] - kTolerance) return false;
+        times[index] = float(t);
+        return true;
+    }
+    
+    // Cycles through the four diagonal sweep orders until four in a row
+    // change nothing. edgeTimes[TileEdge]: earliest time along that edge if
+    // any of its cells changed, infinity otherwise
+    void tile(int tileX, int tileY, float *edgeTimes) const {
+        const int r0 = tileY * kTileSize;
+        const int c0 = tileX * kTileSize;
+        const int r1 = qMin(r0 + kTileSize, rows) - 1;
+        const int c1 = qMin(c0 + kTileSize, columns) - 1;
+        
+        bool edgeChanged[EdgeCount] = {false, false, false, false};
+        int quiet = 0;
+        for (int order = 0; quiet < 4; order = (order + 1) & 3) {
+            const int dr = order & 1 ? -1 : 1;
+            const int dc = order & 2 ? -1 : 1;
+            bool changed = false;
+            for (int r = dr > 0 ? r0 : r1; r >= r0 && r <= r1; r += dr) {
+                for (int c = dc > 0 ? c0 : c1; c >= c0 && c <= c1; c += dc) {
+                    if (!relax(r, c)) continue;
+                    changed = true;
+                    edgeChanged[TopEdge] |= r == r0;
+                    edgeChanged[BottomEdge] |= r == r1;
+                    edgeChanged[LeftEdge] |= c == c0;
+                    edgeChanged[RightEdge] |= c == c1;
+                }
+            }
+            quiet = changed ? 0 : quiet + 1;
+        }
+        
+        for (int edge = 0; edge < EdgeCount; ++edge) {
+            float earliest = kInfinity;
+            if (edgeChanged[edge]) {
+                const bool horizontal = edge == TopEdge || edge == BottomEdge;
+                const int fixed = edge == TopEdge ? r0 : edge == BottomEdge ? r1 : edge == LeftEdge ? c0 : c1;
+                for (int k = horizontal ? c0 : r0; k <= (horizontal ? c1 : r1); ++k) {
+                    earliest = qMin(earliest, times[horizontal ? fixed * columns + k : k * columns + fixed]);
+                }
+            }
+            edgeTimes[edge] = earliest;
+        }
+    }
+};
+
+struct Segment {
+    qint64 edge[2];
+    QPointF point[2];
+};
+
+// Marching squares over the cell centres for one level, joined into polylines.
+// Squares with a land corner are skipped, so isochrones stop at the coast.
+QVector<QVector<QPointF>> traceIsochrone(const TravelTimeMap &map, float level) {
+    const int columns = map.columns;
+    const float *t = map.seconds.constData();
+    
+    QVector<Segment> segments;
+    for (int r = 0; r + 1 < map.rows; ++r) {
+        for (int c = 0; c + 1 < columns; ++c) {
+            const float v[4] = {t[r * columns + c], t[r * columns + c + 1],
+                                t[(r + 1) * columns + c + 1], t[(r + 1) * columns + c]};
+            // Cheap range test first; squares with a land corner are dropped after it
+            const float lo = qMin(qMin(v[0], v[1]), qMin(v[2], v[3]));
+            const float hi = qMax(qMax(v[0], v[1]), qMax(v[2], v[3]));
+            if (!(lo < level && hi >= level)) continue;
+            if (std::isnan(v[0]) || std::isnan(v[1]) || std::isnan(v[2]) || std::isnan(v[3])) continue;
+            
+            // Edges 0 top, 1 right, 2 bottom, 3 left; corners clockwise from top-left
+            auto crossing = [&](int edge, qint64 &id, QPointF &point) {
+                static const int from[4] = {0, 1, 3, 0};
+                static const int to[4] = {1, 2, 2, 3};
+                const float f = (level - v[from[edge]]) / (v[to[edge]] - v[from[edge]]);
+                double row = r, column = c;
+                if (edge == 0 || edge == 2) {
+                    if (edge == 2) row += 1;
+                    column += f;
+                    id = (qint64(row) * columns + c) * 2;
+                } else {
+                    if (edge == 1) column += 1;
+                    row += f;
+                    id = (qint64(r) * columns + qint64(column)) * 2 + 1;
+                }
+                point = QPointF(map.west + column * map.cellSize, map.north - row * map.cellSize);
+            };
+            auto add = [&](int e1, int e2) {
+                Segment segment;
+                crossing(e1, segment.edge[0], segment.point[0]);
+                crossing(e2, segment.edge[1], segment.point[1]);
+                segments.append(segment);
+            };
+            
+            const int inside = (v[0] < level) | (v[1] < level) << 1 | (v[2] < level) << 2 | (v[3] < level) << 3;
+            const bool centreInside = (v[0] + v[1] + v[2] + v[3]) / 4.0f < level;
+            switch (inside) {
+            case 1: case 14: add(3, 0); break;
+            case 2: case 13: add(0, 1); break;
+            case 3: case 12: add(3, 1); break;
+            case 4: case 11: add(1, 2); break;
+            case 6: case 9: add(0, 2); break;
+            case 7: case 8: add(3, 2); break;
+            case 5:
+                if (centreInside) { add(0, 1); add(3, 2); } else { add(3, 0); add(1, 2); }
+                break;
+            case 10:
+                if (centreInside) { add(3, 0); add(1, 2); } else { add(0, 1); add(3, 2); }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    
+    // Each edge is shared by at most two squares: pair up segment ends by edge id
+    const int count = segments.size();
+    QVector<QPair<qint64, int>> ends;
+    ends.reserve(count * 2);
+    for (int i = 0; i < count; ++i) {
+        ends.append({segments[i].edge[0], i * 2});
+        ends.append({segments[i].edge[1], i * 2 + 1});
+    }
+    std::sort(ends.begin(), ends.end());
+    QVector<int> partner(count * 2, -1);
+    for (int i = 0; i + 1 < ends.size(); ++i) {
+        if (ends[i].first != ends[i + 1].first) continue;
+        partner[ends[i].second] = ends[i + 1].second;
+        partner[ends[i + 1].second] = ends[i].second;
+        ++i;
+    }
+    
+    QVector<QVector<QPointF>> lines;
+    QVector<char> used(count, 0);
+    for (int i = 0; i < count; ++i) {
+        if (used[i]) continue;
+        // Walk back to the open end of the chain (or all the way round a loop)
+        int entry = i * 2;
+        while (partner[entry] >= 0 && (partner[entry] ^ 1) / 2 != i) entry = partner[entry] ^ 1;
+        
+        QVector<QPointF> line;
+        line.append(segments[entry / 2].point[entry & 1]);
+        while (entry >= 0 && !used[entry / 2]) {
+            used[entry / 2] = 1;
+            const int exit = entry ^ 1;
+            line.append(segments[exit / 2].point[exit & 1]);
+            entry = partner[exit];
+        }
+        lines.append(line);
+    }
+    return lines;
+}
+}
+
+bool TravelTimeMap::isEmpty() const {
+    return seconds.isEmpty();
+}
+
+float TravelTimeMap::timeAt(double lat, double lon) const {
+    if (isEmpty()) return std::nanf("");
+    const double fr = (north - lat) / cellSize;
+    const double fc = (lon - west) / cellSize;
+    if (fr < -0.5 || fc < -0.5 || fr > rows - 0.5 || fc > columns - 0.5) return std::nanf("");
+    
+    const int r0 = qBound(0, int(std::floor(fr)), qMax(0, rows - 2));
+    const int c0 = qBound(0, int(std::floor(fc)), qMax(0, columns - 2));
+    const double wr = qBound(0.0, fr - r0, 1.0);
+    const double wc = qBound(0.0, fc - c0, 1.0);
+    double sum = 0.0, weight = 0.0;
+    for (int k = 0; k < 4; ++k) {
+        const int r = qMin(r0 + (k >> 1), rows - 1);
+        const int c = qMin(c0 + (k & 1), columns - 1);
+        const float t = seconds[r * columns + c];
+        if (std::isnan(t)) continue;
+        const double w = (k >> 1 ? wr : 1.0 - wr) * (k & 1 ? wc : 1.0 - wc);
+        sum += w * t;
+        weight += w;
+    }
+    if (weight > 1e-9) return float(sum / weight);
+    
+    // Titik pantai di sel daratan: pakai sel laut terdekat
+    const int row = qBound(0, int(std::lround(fr)), rows - 1);
+    const int column = qBound(0, int(std::lround(fc)), columns - 1);
+    for (int ring = 1; ring <= kCoastSearchCells; ++ring) {
+        float best = std::nanf("");
+        int bestDistance = std::numeric_limits<int>::max();
+        for (int r = qMax(0, row - ring); r <= qMin(rows - 1, row + ring); ++r) {
+            for (int c = qMax(0, column - ring); c <= qMin(columns - 1, column + ring); ++c) {
+                const float t = seconds[r * columns + c];
+                const int distance = (r - row) * (r - row) + (c - column) * (c - column);
+                if (!std::isnan(t) && distance < bestDistance) {
+                    best = t;
+                    bestDistance = distance;
+                }
+            }
+        }
+        if (!std::isnan(best)) return best;
+    }
+    return std::nanf("");
+}
+
+TravelTimeSolver::TravelTimeSolver()
+    : m_grid(nullptr)
+    , m_cellHeightKm(0.0)
+{
+    // The calling thread works too, so this leaves a core for the GUI
+    m_pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 2));
+}
+
+TravelTimeSolver::~TravelTimeSolver() {
+    m_pool.waitForDone();
+}
+
+void TravelTimeSolver::setGrid(const BathymetryGrid *grid) {
+    m_grid = grid;
+    m_slowness.clear();
+    m_cellWidthKm.clear();
+    if (hasGrid()) prepare();
+}
+
+bool TravelTimeSolver::hasGrid() const {
+    return m_grid && !m_grid->isEmpty();
+}
+
+void TravelTimeSolver::prepare() {
+    const int rows = m_grid->rows();
+    const int columns = m_grid->columns();
+    m_cellHeightKm = kEarthRadiusKm * m_grid->cellSize() * kDegToRad;
+    m_cellWidthKm.resize(rows);
+    m_slowness.resize(rows * columns);
+    
+    float *slowness = m_slowness.data();
+    const float *elevation = m_grid->data();
+    parallelFor(m_pool, rows, [&](int r) {
+        // Keep polar rows from collapsing to zero width
+        m_cellWidthKm[r] = qMax(m_cellHeightKm * std::cos(m_grid->latitudeOf(r) * kDegToRad), 1e-3);
+        for (int c = 0; c < columns; ++c) {
+            const int index = r * columns + c;
+            const float e = elevation[index];
+            if (e >= 0.0f) {
+                slowness[index] = kInfinity;
+                continue;
+            }
+            // NODATA laut dalam, seperti di ArrivalEngine
+            const double depth = std::isnan(e) ? ArrivalEngine::kUniformDepthM : qMax(double(-e), kMinDepthM);
+            // s/km
+            slowness[index] = float(1000.0 / std::sqrt(kGravity * depth));
+        }
+    });
+}
+
+TravelTimeMap TravelTimeSolver::solve(double lat, double lon, QString *error,
+                                      const std::function<bool()> &canceled) {
+    QElapsedTimer timer;
+    timer.start();
+    
+    TravelTimeMap map;
+    if (!hasGrid()) {
+        if (error) *error = "no bathymetry grid";
+        return map;
+    }
+    if (!m_grid->contains(lat, lon)) {
+        if (error) *error = "epicenter outside the bathymetry grid";
+        return map;
+    }
+    
+    const int rows = m_grid->rows();
+    const int columns = m_grid->columns();
+    const double cellSize = m_grid->cellSize();
+    const float *slowness = m_slowness.constData();
+    const double kmPerDegree = kEarthRadiusKm * kDegToRad;
+    auto distanceKm = [&](int r, int c, double fromLat, double fromLon) {
+        const double dy = (m_grid->latitudeOf(r) - fromLat) * kmPerDegree;
+        const double dx = (m_grid->longitudeOf(c) - fromLon) * kmPerDegree * std::cos(fromLat * kDegToRad);
+        return std::sqrt(dx * dx + dy * dy);
+    };
+    
+    int sourceRow = qBound(0, int(std::lround((m_grid->latitudeOf(0) - lat) / cellSize)), rows - 1);
+    int sourceColumn = qBound(0, int(std::lround((lon - m_grid->longitudeOf(0)) / cellSize)), columns - 1);
+    if (slowness[sourceRow * columns + sourceColumn] == kInfinity) {
+        // Epicenter di darat: gelombang mulai dari sel laut terdekat
+        const int radiusRows = int(std::ceil(kMaxSourceShiftKm / m_cellHeightKm));
+        const int radiusColumns = int(std::ceil(kMaxSourceShiftKm / m_cellWidthKm[sourceRow]));
+        double best = kMaxSourceShiftKm;
+        int bestRow = -1, bestColumn = -1;
+        for (int r = qMax(0, sourceRow - radiusRows); r <= qMin(rows - 1, sourceRow + radiusRows); ++r) {
+            for (int c = qMax(0, sourceColumn - radiusColumns); c <= qMin(columns - 1, sourceColumn + radiusColumns);
+                 ++c) {
+                if (slowness[r * columns + c] == kInfinity) continue;
+                const double d = distanceKm(r, c, lat, lon);
+                if (d <= best) {
+                    best = d;
+                    bestRow = r;
+                    bestColumn = c;
+                }
+            }
+        }
+        if (bestRow < 0) {
+            if (error) *error = QString("epicenter more than %1 km from the sea").arg(kMaxSourceShiftKm, 0, 'f', 0);
+            return map;
+        }
+        sourceRow = bestRow;
+        sourceColumn = bestColumn;
+        lat = m_grid->latitudeOf(sourceRow);
+        lon = m_grid->longitudeOf(sourceColumn);
+    }
+    
+    QVector<float> times(rows * columns, kInfinity);
+    const int tilesX = (columns + kTileSize - 1) / kTileSize;
+    const int tilesY = (rows + kTileSize - 1) / kTileSize;
+    // Earliest time the front brings into each tile; infinity once it is settled
+    QVector<float> pending(tilesX * tilesY, kInfinity);
+    
+    // Straight rays near the source, where a first-order front is least accurate
+    const float sourceSlowness = slowness[sourceRow * columns + sourceColumn];
+    for (int r = qMax(0, sourceRow - kSourceRadiusCells); r <= qMin(rows - 1, sourceRow + kSourceRadiusCells); ++r) {
+        for (int c = qMax(0, sourceColumn - kSourceRadiusCells);
+             c <= qMin(columns - 1, sourceColumn + kSourceRadiusCells); ++c) {
+            const float s = slowness[r * columns + c];
+            if (s == kInfinity) continue;
+            const float t = float(distanceKm(r, c, lat, lon) * (s + sourceSlowness) / 2.0);
+            times[r * columns + c] = t;
+            float &key = pending[(r / kTileSize) * tilesX + c / kTileSize];
+            key = qMin(key, t);
+        }
+    }
+    
+    const Sweep sweep{times.data(), slowness, m_cellWidthKm.constData(), m_cellHeightKm, rows, columns};
+    QVector<int> batch;
+    QVector<float> edgeTimes;
+    for (;;) {
+        float earliest = kInfinity;
+        for (float key : std::as_const(pending)) earliest = qMin(earliest, key);
+        if (earliest == kInfinity) break;
+        const float band = earliest + kBandSeconds;
+        
+        for (int colour = 0; colour < 4; ++colour) {
+            if (canceled && canceled()) {
+                if (error) *error = "canceled";
+                return TravelTimeMap();
+            }
+            
+            batch.clear();
+            for (int ty = colour >> 1; ty < tilesY; ty += 2) {
+                for (int tx = colour & 1; tx < tilesX; tx += 2) {
+                    float &key = pending[ty * tilesX + tx];
+                    if (key > band) continue;
+                    key = kInfinity;
+                    batch.append(ty * tilesX + tx);
+                }
+            }
+            if (batch.isEmpty()) continue;
+            
+            edgeTimes.resize(batch.size() * EdgeCount);
+            const int *tiles = batch.constData();
+            float *tileEdgeTimes = edgeTimes.data();
+            parallelFor(m_pool, batch.size(), [&](int i) {
+                sweep.tile(tiles[i] % tilesX, tiles[i] / tilesX, tileEdgeTimes + i * EdgeCount);
+            });
+            
+            // Wake the neighbours across every edge that changed
+            for (int i = 0; i < batch.size(); ++i) {
+                const int tx = batch[i] % tilesX;
+                const int ty = batch[i] / tilesX;
+                const float *t = tileEdgeTimes + i * EdgeCount;
+                if (ty > 0) pending[(ty - 1) * tilesX + tx] = qMin(pending[(ty - 1) * tilesX + tx], t[TopEdge]);
+                if (ty < tilesY - 1) {
+                    pending[(ty + 1) * tilesX + tx] = qMin(pending[(ty + 1) * tilesX + tx], t[BottomEdge]);
+                }
+                if (tx > 0) pending[ty * tilesX + tx - 1] = qMin(pending[ty * tilesX + tx - 1], t[LeftEdge]);
+                if (tx < tilesX - 1) pending[ty * tilesX + tx + 1] = qMin(pending[ty * tilesX + tx + 1], t[RightEdge]);
+            }
+        }
+    }
+    
+    float latest = 0.0f;
+    for (float &t : times) {
+        if (t == kInfinity) {
+            t = std::nanf("");
+        } else {
+            latest = qMax(latest, t);
+        }
+    }
+    
+    map.latitude = lat;
+    map.longitude = lon;
+    map.columns = columns;
+    map.rows = rows;
+    map.north = m_grid->latitudeOf(0);
+    map.west = m_grid->longitudeOf(0);
+    map.cellSize = cellSize;
+    map.seconds = times;
+    
+    for (float level = 1800.0f; level <= qMin(latest, kMaxIsochroneSeconds);
+         level += level < 7200.0f ? 1800.0f : 3600.0f) {
+        TravelTimeMap::Isochrone isochrone;
+        isochrone.seconds = level;
+        map.isochrones.append(isochrone);
+    }
+    TravelTimeMap::Isochrone *isochrones = map.isochrones.data();
+    parallelFor(m_pool, map.isochrones.size(), [&](int i) {
+        isochrones[i].lines = traceIsochrone(map, isochrones[i].seconds);
+    });
+    
+    map.elapsedMs = timer.nsecsElapsed() / 1.0e6;
+    return map;
+}
@@ -0,0 +1,174 @@
+#include "TravelTimeTable.h"
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+constexpr float kNaN = std::numeric_limits<float>::quiet_NaN();
+}
+
+bool TravelTimeTable::load(const QString &path, QString *error) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (error) *error = QString("%1: %2").arg(path, file.errorString());
+        return false;
+    }
+    
+    double firstDistance = 0.0;
+    double distanceStep = 0.0;
+    int distanceCount = 0;
+    QVector<double> depths;
+    QVector<float> times[PhaseCount];
+    int phase = -1;
+    
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while (!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        ++lineNumber;
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        
+        auto fail = [&](const QString &reason) {
+            if (error) *error = QString("%1:%2: %3").arg(path).arg(lineNumber).arg(reason);
+            return false;
+        };
+        
+        const QStringList parts = line.split(' ', Qt::SkipEmptyParts);
+        if (parts[0] == "distances") {
+            bool ok1 = false, ok2 = false, ok3 = false;
+            if (parts.size() == 4) {
+                firstDistance = parts[1].toDouble(&ok1);
+                distanceStep = parts[2].toDouble(&ok2);
+                distanceCount = parts[3].toInt(&ok3);
+            }
+            if (!ok1 || !ok2 || !ok3 || distanceStep <= 0.0 || distanceCount < 2) {
+                return fail("expected: distances <first> <step> <count>");
+            }
+            continue;
+        }
+        
+        if (parts[0] == "depths") {
+            depths.clear();
+            for (int i = 1; i < parts.size(); ++i) {
+                bool ok = false;
+                depths.append(parts[i].toDouble(&ok));
+                if (!ok || (depths.size() > 1 && depths.last() <= depths[depths.size() - 2])) {
+                    return fail("depths must be increasing numbers");
+                }
+            }
+            if (depths.isEmpty()) return fail("no depths");
+            continue;
+        }
+        
+        if (parts[0] == "phase") {
+            if (distanceCount == 0 || depths.isEmpty()) return fail("phase before distances and depths");
+            if (parts.size() != 2 || (parts[1] != "P" && parts[1] != "S")) return fail("expected: phase P|S");
+            phase = parts[1] == "P" ? P : S;
+            times[phase].clear();
+            times[phase].reserve(depths.size() * distanceCount);
+            continue;
+        }
+        
+        if (phase < 0) return fail("times outside a phase");
+        for (const QString &part : parts) {
+            bool ok = false;
+            times[phase].append(part.toFloat(&ok));
+            if (!ok) return fail("bad travel time");
+        }
+        if (times[phase].size() > depths.size() * distanceCount) return fail("too many travel times");
+    }
+    
+    for (int p = 0; p < PhaseCount; ++p) {
+        if (times[p].size() != depths.size() * distanceCount) {
+            if (error) {
+                *error = QString("%1: phase %2 needs %3 times, has %4")
+                         .arg(path, QLatin1String(phaseName(Phase(p))))
+                         .arg(depths.size() * distanceCount).arg(times[p].size());
+            }
+            return false;
+        }
+    }
+    
+    m_firstDistance = firstDistance;
+    m_distanceStep = distanceStep;
+    m_distanceCount = distanceCount;
+    m_depths = depths;
+    for (int p = 0; p < PhaseCount; ++p) m_times[p] = times[p];
+    return true;
+}
+
+bool TravelTimeTable::isEmpty() const {
+    return m_distanceCount == 0;
+}
+
+double TravelTimeTable::maxDistance() const {
+    return m_firstDistance + m_distanceStep * (m_distanceCount - 1);
+}
+
+double TravelTimeTable::maxDepth() const {
+    return m_depths.isEmpty() ? 0.0 : m_depths.last();
+}
+
+const TravelTimeTable &TravelTimeTable::shared() {
+    static const TravelTimeTable table = []() {
+        TravelTimeTable loaded;
+        QString error;
+        if (!loaded.load(":/data/traveltimes.txt", &error)) {
+            qWarning("TravelTimeTable: %s", qPrintable(error));
+        }
+        return loaded;
+    }();
+    return table;
+}
+
+const char *TravelTimeTable::phaseName(Phase phase) {
+    return phase == P ? "P" : "S";
+}
+
+void TravelTimeTable::depthRow(Phase phase, double depthKm, float *row) const {
+    const double depth = qBound(m_depths.first(), depthKm, m_depths.last());
+    const int upper = qMin(int(std::upper_bound(m_depths.begin(), m_depths.end(), depth) - m_depths.begin()),
+                           int(m_depths.size()) - 1);
+    const int lower = qMax(0, upper - 1);
+    const float weight = upper == lower ? 0.0f
+                         : float((depth - m_depths[lower]) / (m_depths[upper] - m_depths[lower]));
+    
+    const float *a = m_times[phase].constData() + lower * m_distanceCount;
+    const float *b = m_times[phase].constData() + upper * m_distanceCount;
+    for (int i = 0; i < m_distanceCount; ++i) row[i] = a[i] + (b[i] - a[i]) * weight;
+}
+
+double TravelTimeTable::time(Phase phase, double distanceDegrees, double depthKm) const {
+    const float distance = float(distanceDegrees);
+    float out = kNaN;
+    times(phase, depthKm, &distance, 1, &out);
+    return out;
+}
+
+void TravelTimeTable::times(Phase phase, double depthKm, const float *distanceDegrees, int count, float *out) const {
+    if (isEmpty()) {
+        std::fill(out, out + count, kNaN);
+        return;
+    }
+    
+    QVarLengthArray<float, 512> row(m_distanceCount);
+    depthRow(phase, depthKm, row.data());
+    
+    const float first = float(m_firstDistance);
+    const float scale = float(1.0 / m_distanceStep);
+    const float last = float(m_distanceCount - 1);
+    for (int i = 0; i < count; ++i) {
+        const float x = qMax(0.0f, (distanceDegrees[i] - first) * scale);
+        if (x > last) {
+            out[i] = kNaN;
+            continue;
+        }
+        const int cell = qMin(int(x), m_distanceCount - 2);
+        const float t = x - cell;
+        out[i] = row[cell] + (row[cell + 1] - row[cell]) * t;
+    }
+}
@@ -0,0 +1,176 @@
+#include "WebMercator.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kDegToRad = kPi / 180.0;
+constexpr double kTileSize = 256.0;
+
+// sin(x) for |x| <= pi/2 from its Taylor series up to x^17, written as
+// sin = x - x^3 * p(x^2); error stays below 1e-12 on that range
+inline double polySin(double x) {
+    const double x2 = x * x;
+    double p = -1.0 / 355687428096000.0;
+    p = p * x2 + 1.0 / 1307674368000.0;
+    p = p * x2 - 1.0 / 6227020800.0;
+    p = p * x2 + 1.0 / 39916800.0;
+    p = p * x2 - 1.0 / 362880.0;
+    p = p * x2 + 1.0 / 5040.0;
+    p = p * x2 - 1.0 / 120.0;
+    p = p * x2 + 1.0 / 6.0;
+    return x - x * x2 * p;
+}
+
+// Natural log for finite positive x. The exponent is split off with integer
+// ops and the mantissa m in [sqrt(1/2), sqrt(2)) goes through
+// log(m) = 2 atanh((m-1)/(m+1)), which converges to double precision by s^21.
+inline double polyLog(double x) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    
+    // Mantissas at or above sqrt(2) are halved so m lands in [sqrt(1/2), sqrt(2)).
+    // The comparison is done with an add that carries into bit 52, keeping
+    // the kernel free of branches and 64-bit compares.
+    const std::uint64_t mantissa = bits & 0x000FFFFFFFFFFFFFull;
+    const std::uint64_t high = (mantissa + (0x0010000000000000ull - 0x0006A09E667F3BCDull)) >> 52;
+    
+    // Exponent field to double without an int64 -> double conversion (which
+    // SSE2/AVX2 lack): place it in the mantissa of 2^52 and subtract 2^52
+    std::uint64_t exponentBits = 0x4330000000000000ull | ((bits >> 52) + high);
+    double exponent;
+    std::memcpy(&exponent, &exponentBits, sizeof(exponent));
+    exponent -= 4503599627370496.0 + 1023.0;
+    
+    bits = mantissa | ((0x3FFull - high) << 52);
+    double m;
+    std::memcpy(&m, &bits, sizeof(m));
+    
+    const double s = (m - 1.0) / (m + 1.0);
+    const double s2 = s * s;
+    double p = 1.0 / 21.0;
+    p = p * s2 + 1.0 / 19.0;
+    p = p * s2 + 1.0 / 17.0;
+    p = p * s2 + 1.0 / 15.0;
+    p = p * s2 + 1.0 / 13.0;
+    p = p * s2 + 1.0 / 11.0;
+    p = p * s2 + 1.0 / 9.0;
+    p = p * s2 + 1.0 / 7.0;
+    p = p * s2 + 1.0 / 5.0;
+    p = p * s2 + 1.0 / 3.0;
+    p = p * s2 + 1.0;
+    
+    return 2.0 * s * p + exponent * 0.69314718055994530942;
+}
+
+struct ZoomTable {
+    std::array<double, WebMercator::kMaxZoom + 1> worldPixels;
+    std::array<double, WebMercator::kMaxZoom + 1> equatorMetersPerPixel;
+    
+    ZoomTable() {
+        for (int z = 0; z <= WebMercator::kMaxZoom; ++z) {
+            worldPixels[z] = kTileSize * double(1ull << z);
+            equatorMetersPerPixel[z] = 2.0 * kPi * WebMercator::kEarthRadius / worldPixels[z];
+        }
+    }
+};
+
+const ZoomTable &zoomTable() {
+    static const ZoomTable table;
+    return table;
+}
+}
+
+WebMercator::WebMercator()
+    : WebMercator(0.0, 0.0, 1.0, 1.0)
+{
+}
+
+WebMercator::WebMercator(double left, double top, double width, double height)
+    : m_left(left)
+    , m_top(top)
+    , m_width(width)
+    , m_height(height)
+{
+}
+
+void WebMercator::setWorldRect(double left, double top, double width, double height) {
+    m_left = left;
+    m_top = top;
+    m_width = width;
+    m_height = height;
+}
+
+void WebMercator::toScene(double lat, double lon, double &x, double &y) const {
+    double nx, ny;
+    forwardNormalizedScalar(&lat, &lon, &nx, &ny, 1);
+    x = m_left + nx * m_width;
+    y = m_top + ny * m_height;
+}
+
+void WebMercator::toGeo(double x, double y, double &lat, double &lon) const {
+    const double nx = (x - m_left) / m_width;
+    const double ny = (y - m_top) / m_height;
+    lon = nx * 360.0 - 180.0;
+    lat = std::atan(std::sinh(kPi * (1.0 - 2.0 * ny))) / kDegToRad;
+}
+
+void WebMercator::toScene(const double *lat, const double *lon, double *x, double *y,
+                          std::size_t n) const {
+    forwardNormalized(lat, lon, x, y, n);
+    
+    const double left = m_left, top = m_top, width = m_width, height = m_height;
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = left + x[i] * width;
+        y[i] = top + y[i] * height;
+    }
+}
+
+void WebMercator::toGeo(const double *x, const double *y, double *lat, double *lon,
+                        std::size_t n) const {
+    for (std::size_t i = 0; i < n; ++i) {
+        toGeo(x[i], y[i], lat[i], lon[i]);
+    }
+}
+
+void WebMercator::forwardNormalized(const double *__restrict lat, const double *__restrict lon,
+                                    double *__restrict x, double *__restrict y, std::size_t n) {
+    // y = (1 - atanh(sin(phi)) / pi) / 2, with atanh(s) = log((1+s)/(1-s)) / 2.
+    // Everything below is branch-free so the loop vectorizes.
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = (lon[i] + 180.0) * (1.0 / 360.0);
+        
+        // clamp(v, -c, c) == (|v + c| - |v - c|) / 2; unlike std::min/max this
+        // cannot be turned into a branch around the polynomials
+        const double lat0 = lat[i];
+        const double clamped = 0.5 * (std::fabs(lat0 + kMaxLatitude) - std::fabs(lat0 - kMaxLatitude));
+        const double s = polySin(clamped * kDegToRad);
+        const double mercN = 0.5 * polyLog((1.0 + s) / (1.0 - s));
+        y[i] = 0.5 - mercN * (0.5 / kPi);
+    }
+}
+
+void WebMercator::forwardNormalizedScalar(const double *lat, const double *lon,
+                                          double *x, double *y, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        x[i] = (lon[i] + 180.0) / 360.0;
+        
+        const double clamped = std::min(std::max(lat[i], -kMaxLatitude), kMaxLatitude);
+        const double latRad = clamped * kDegToRad;
+        const double mercN = std::log(std::tan((kPi / 4.0) + (latRad / 2.0)));
+        y[i] = (1.0 - mercN / kPi) / 2.0;
+    }
+}
+
+double WebMercator::worldPixels(int zoom) {
+    zoom = std::min(std::max(zoom, 0), kMaxZoom);
+    return zoomTable().worldPixels[zoom];
+}
+
+double WebMercator::metersPerPixel(int zoom, double lat) {
+    zoom = std::min(std::max(zoom, 0), kMaxZoom);
+    return zoomTable().equatorMetersPerPixel[zoom] * std::cos(lat * kDegToRad);
+}
@@ -1,9 +1,13 @@
 #include <QApplication>
 #include "MainWindow.h"
+#include "ConnectionPool.h"
 
 int main(int argc, char *argv[]) {
     QApplication app(argc, argv);
 
+    // Satu pool untuk semua view dan worker; kredensial dari environment
+    ConnectionPool::instance().configure(ConnectionSettings::fromEnvironment());
+
     MainWindow window;
     window.show();
 
@@ -0,0 +1,58 @@
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QTextStream>
+#include "CatalogImporter.h"
+#include "ConnectionPool.h"
+
+// Bulk loads CSV event catalogs into sumber_tsunami with binary COPY.
+// Connection settings come from TSUNAMI_DB_HOST, _PORT, _NAME, _USER, _PASSWORD.
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    
+    QStringList args = app.arguments().mid(1);
+    CatalogImporter::Options options;
+    options.skipExisting = args.removeAll("--skip-existing") > 0;
+    if (args.isEmpty() || args.first().startsWith("-")) {
+        err << "Usage: catimport [--skip-existing] <catalog.csv> [more.csv ...]\n"
+            << "Columns are matched by header name (event_id/id, time, latitude, longitude,\n"
+            << "depth, mag, optional strike/dip/slip). --skip-existing leaves event ids that\n"
+            << "are already loaded alone instead of failing the import.\n";
+        return 1;
+    }
+    
+    ConnectionPool::instance().configure(ConnectionSettings::fromEnvironment(), 1);
+    QString error;
+    ConnectionPool::Lease lease = ConnectionPool::instance().acquire(5000, &error);
+    if (!lease.isValid()) {
+        err << "catimport: " << error << "\n";
+        return 1;
+    }
+    
+    CatalogImporter importer(lease.database(), options);
+    for (const QString &path : std::as_const(args)) {
+        const QString name = QFileInfo(path).fileName();
+        CatalogImporter::Result result = importer.importFile(path,
+            [&](qint64 rows, qint64 bytesRead, qint64 totalBytes) {
+                err << "\r" << name << ": " << rows << " events";
+                if (totalBytes > 0) err << " (" << bytesRead * 100 / totalBytes << "%)";
+                err.flush();
+                return true;
+            });
+        err << "\n";
+        
+        for (const QString &line : std::as_const(result.rejected)) {
+            err << "  skipped " << line << "\n";
+        }
+        if (!result.ok) {
+            err << "catimport: " << name << ": " << result.error << "\n";
+            return 1;
+        }
+        out << name << ": imported " << result.rows << " events, skipped " << result.skipped
+            << " in " << QString::number(result.elapsedMs / 1000.0, 'f', 2) << " s ("
+            << (result.elapsedMs > 0 ? result.rows * 1000 / result.elapsedMs : result.rows)
+            << " events/s)\n";
+    }
+    return 0;
+}
@@ -0,0 +1,38 @@
+#include <QCoreApplication>
+#include <QDir>
+#include <QTextStream>
+#include "TileArchive.h"
+
+// Packs a loose tile directory (world.png + world<quadkey>.png) into a single
+// memory-mappable world.tiles archive read by MapView.
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    
+    const QStringList args = app.arguments();
+    if (args.size() < 2 || args.size() > 3) {
+        err << "Usage: tilepack <maps-dir> [output.tiles]\n"
+            << "Default output is <maps-dir>/world.tiles\n";
+        return 1;
+    }
+    
+    const QString tileDir = args.at(1);
+    const QString archivePath = args.size() == 3 ? args.at(2) : QDir(tileDir).filePath("world.tiles");
+    
+    QString error;
+    if (!TileArchive::build(tileDir, archivePath, &error)) {
+        err << "tilepack: " << error << "\n";
+        return 1;
+    }
+    
+    TileArchive archive;
+    if (!archive.open(archivePath)) {
+        err << "tilepack: " << archive.errorString() << "\n";
+        return 1;
+    }
+    
+    out << "Packed " << archive.tileCount() << " tiles (max zoom " << archive.maxZoom()
+        << ") into " << archivePath << "\n";
+    return 0;
+}